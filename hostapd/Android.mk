@@ -177,6 +177,7 @@ L_CFLAGS += -DCONFIG_NO_CTRL_IFACE
 else
 OBJS += ctrl_iface.c
 OBJS += src/ap/ctrl_iface_ap.c
+OBJS += src/common/ctrl_iface_common.c
 endif
 
 OBJS += src/crypto/md5.c
@@ -788,6 +789,10 @@ ifdef NEED_ECC
 L_CFLAGS += -DCONFIG_ECC
 endif
 
+ifdef CONFIG_NO_WPABUF_POOL
+L_CFLAGS += -DCONFIG_NO_WPABUF_POOL
+endif
+
 ifdef CONFIG_NO_RANDOM_POOL
 L_CFLAGS += -DCONFIG_NO_RANDOM_POOL
 else
@@ -862,6 +867,12 @@ OBJS += src/ap/acs.c
 LIBS += -lm
 endif
 
+ifdef CONFIG_STATS_SHM
+L_CFLAGS += -DCONFIG_STATS_SHM
+OBJS += src/utils/stats_shm.c
+OBJS += src/ap/ap_stats.c
+endif
+
 ifdef CONFIG_NO_STDOUT_DEBUG
 L_CFLAGS += -DCONFIG_NO_STDOUT_DEBUG
 endif
@@ -13,6 +13,8 @@
 
 #include "utils/common.h"
 #include "utils/uuid.h"
+#include "crypto/crypto.h"
+#include "crypto/sha1.h"
 #include "common/ieee802_11_defs.h"
 #include "drivers/driver.h"
 #include "eap_server/eap.h"
@@ -2394,6 +2396,18 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 			   bss->ctrl_interface_gid);
 #endif /* CONFIG_NATIVE_WINDOWS */
 #endif /* CONFIG_NO_CTRL_IFACE */
+#ifdef CONFIG_STATS_SHM
+	} else if (os_strcmp(buf, "stats_file") == 0) {
+		os_free(bss->stats_file);
+		bss->stats_file = os_strdup(pos);
+	} else if (os_strcmp(buf, "stats_interval") == 0) {
+		bss->stats_interval = atoi(pos);
+		if (bss->stats_interval < 1) {
+			wpa_printf(MSG_ERROR, "Line %d: invalid stats_interval",
+				   line);
+			return 1;
+		}
+#endif /* CONFIG_STATS_SHM */
 #ifdef RADIUS_SERVER
 	} else if (os_strcmp(buf, "radius_server_clients") == 0) {
 		os_free(bss->radius_server_clients);
@@ -3175,14 +3189,101 @@ static int hostapd_config_fill(struct hostapd_config *conf,
  * @fname: Configuration file name (including path, if needed)
  * Returns: Allocated configuration data structure
  */
+/*
+ * Configuration items that only affect advertised information. Changes to
+ * these are applied on reload without reconfiguring the BSS. This list must
+ * match the fields handled in hostapd_config_swap_bss_info().
+ */
+static const char *info_items[] = {
+	"logger_syslog_level", "logger_stdout_level", "logger_syslog",
+	"logger_stdout", "dtim_period", "ignore_broadcast_ssid",
+	"ap_max_inactivity", "skip_inactivity_poll", "max_listen_interval",
+	"disassoc_low_ack", "time_advertisement", "time_zone",
+	"access_network_type", "internet", "asra", "esr", "uesa",
+	"venue_group", "venue_type", "hessid", "roaming_consortium",
+	"venue_name", "network_auth_type", "ipaddr_type_availability",
+	"domain_name", "anqp_3gpp_cell_net", "nai_realm", "gas_frag_limit",
+	"gas_comeback_delay",
+#ifdef CONFIG_HS20
+	"anqp_domain_id", "hs20_oper_friendly_name", "hs20_wan_metrics",
+	"hs20_conn_capab", "hs20_operating_class", "hs20_icon", "osu_ssid",
+	"osu_server_uri", "osu_friendly_name", "osu_nai", "osu_method_list",
+	"osu_icon", "osu_service_desc", "hs20_deauth_req_timeout",
+	"subscr_remediation_url", "subscr_remediation_method",
+#endif /* CONFIG_HS20 */
+	"vendor_elements",
+	NULL
+};
+
+/* MAC ACL items; these are compared directly on reload */
+static const char *acl_items[] = {
+	"macaddr_acl", "accept_mac_file", "deny_mac_file", NULL
+};
+
+
+static int hostapd_config_item_in(const char *name, const char **list)
+{
+	int i;
+
+	for (i = 0; list[i]; i++) {
+		if (os_strcmp(name, list[i]) == 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+
+static void hostapd_config_hash_update(u8 *hash, const u8 *line_hash)
+{
+	const u8 *addr[2];
+	size_t len[2];
+	u8 res[HOSTAPD_CONF_HASH_LEN];
+
+	addr[0] = hash;
+	len[0] = HOSTAPD_CONF_HASH_LEN;
+	addr[1] = line_hash;
+	len[1] = HOSTAPD_CONF_HASH_LEN;
+	sha1_vector(2, addr, len, res);
+	os_memcpy(hash, res, HOSTAPD_CONF_HASH_LEN);
+}
+
+
+static void hostapd_config_hash_line(const char *name, const char *value,
+				     u8 *line_hash)
+{
+	const u8 *addr[3];
+	size_t len[3];
+	char *data = NULL;
+	size_t data_len = 0;
+
+	/*
+	 * Passphrase file is read when the BSS is configured, so include its
+	 * contents to notice changes to it on reload.
+	 */
+	if (os_strcmp(name, "wpa_psk_file") == 0)
+		data = os_readfile(value, &data_len);
+
+	addr[0] = (const u8 *) name;
+	len[0] = os_strlen(name) + 1;
+	addr[1] = (const u8 *) value;
+	len[1] = os_strlen(value) + 1;
+	addr[2] = (const u8 *) data;
+	len[2] = data_len;
+	sha1_vector(data ? 3 : 2, addr, len, line_hash);
+	bin_clear_free(data, data_len);
+}
+
+
 struct hostapd_config * hostapd_config_read(const char *fname)
 {
-	struct hostapd_config *conf;
+	struct hostapd_config *conf, *prev;
 	FILE *f;
 	char buf[512], *pos;
 	int line = 0;
 	int errors = 0;
 	size_t i;
+	u8 line_hash[HOSTAPD_CONF_HASH_LEN];
 
 	f = fopen(fname, "r");
 	if (f == NULL) {
@@ -3206,6 +3307,13 @@ struct hostapd_config * hostapd_config_read(const char *fname)
 		return NULL;
 	}
 
+	prev = os_malloc(sizeof(*prev));
+	if (prev == NULL) {
+		hostapd_config_free(conf);
+		fclose(f);
+		return NULL;
+	}
+
 	conf->last_bss = conf->bss[0];
 
 	while (fgets(buf, sizeof(buf), f)) {
@@ -3236,9 +3344,31 @@ struct hostapd_config * hostapd_config_read(const char *fname)
 		}
 		*pos = '\0';
 		pos++;
+
+		hostapd_config_hash_line(buf, pos, line_hash);
+		os_memcpy(prev, conf, sizeof(*prev));
 		errors += hostapd_config_fill(conf, bss, buf, pos, line);
-	}
 
+		/*
+		 * Track which part of the configuration each line changed so
+		 * that reloading can be limited to the modified BSSs. A line
+		 * that modified the per-radio parameters is accounted to the
+		 * radio regardless of its location in the file.
+		 */
+		prev->bss = conf->bss;
+		prev->last_bss = conf->last_bss;
+		prev->num_bss = conf->num_bss;
+		if (os_memcmp(prev, conf, sizeof(*prev)) != 0)
+			hostapd_config_hash_update(conf->conf_hash, line_hash);
+		else if (hostapd_config_item_in(buf, info_items))
+			hostapd_config_hash_update(conf->last_bss->info_hash,
+						   line_hash);
+		else if (!hostapd_config_item_in(buf, acl_items))
+			hostapd_config_hash_update(conf->last_bss->conf_hash,
+						   line_hash);
+	}
+
+	os_free(prev);
 	fclose(f);
 
 	for (i = 0; i < conf->num_bss; i++)
@@ -17,6 +17,7 @@
 #include "utils/common.h"
 #include "utils/eloop.h"
 #include "common/version.h"
+#include "common/ctrl_iface_common.h"
 #include "common/ieee802_11_defs.h"
 #include "drivers/driver.h"
 #include "radius/radius_client.h"
@@ -31,6 +32,7 @@
 #include "ap/ctrl_iface_ap.h"
 #include "ap/ap_drv_ops.h"
 #include "ap/hs20.h"
+#include "ap/gas_serv.h"
 #include "ap/wnm_ap.h"
 #include "ap/wpa_auth.h"
 #include "wps/wps_defs.h"
@@ -45,11 +47,15 @@ struct wpa_ctrl_dst {
 	socklen_t addrlen;
 	int debug_level;
 	int errors;
+	struct ctrl_mon_queue queue;
 };
 
 
 static void hostapd_ctrl_iface_send(struct hostapd_data *hapd, int level,
 				    const char *buf, size_t len);
+static void hostapd_ctrl_iface_send_pending(struct hostapd_data *hapd);
+static void hostapd_ctrl_iface_pending_timeout(void *eloop_ctx,
+					       void *timeout_ctx);
 
 
 static int hostapd_ctrl_iface_attach(struct hostapd_data *hapd,
@@ -89,10 +95,14 @@ static int hostapd_ctrl_iface_detach(struct hostapd_data *hapd,
 				    (u8 *) from->sun_path,
 				    fromlen -
 				    offsetof(struct sockaddr_un, sun_path));
+			if (dst->queue.dropped_total)
+				wpa_printf(MSG_DEBUG, "CTRL_IFACE monitor dropped %u events",
+					   dst->queue.dropped_total);
 			if (prev == NULL)
 				hapd->ctrl_dst = dst->next;
 			else
 				prev->next = dst->next;
+			ctrl_mon_queue_clear(&dst->queue);
 			os_free(dst);
 			return 0;
 		}
@@ -1074,6 +1084,8 @@ static int hostapd_ctrl_iface_set(struct hostapd_data *hapd, char *cmd)
 #ifdef CONFIG_TESTING_OPTIONS
 	} else if (os_strcasecmp(cmd, "ext_mgmt_frame_handling") == 0) {
 		hapd->ext_mgmt_frame_handling = atoi(value);
+		if (hapd->ext_mgmt_frame_handling)
+			hostapd_drv_set_probe_req_filter(hapd, NULL);
 #endif /* CONFIG_TESTING_OPTIONS */
 	} else {
 		struct sta_info *sta;
@@ -1083,6 +1095,10 @@ static int hostapd_ctrl_iface_set(struct hostapd_data *hapd, char *cmd)
 		if (ret)
 			return ret;
 
+#ifdef CONFIG_INTERWORKING
+		gas_serv_config_changed(hapd);
+#endif /* CONFIG_INTERWORKING */
+
 		if (os_strcasecmp(cmd, "deny_mac_file") == 0) {
 			for (sta = hapd->sta_list; sta; sta = sta->next) {
 				if (hostapd_maclist_found(
@@ -1350,36 +1366,27 @@ static int hostapd_ctrl_iface_vendor(struct hostapd_data *hapd, char *cmd,
 }
 
 
-static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
-				       void *sock_ctx)
-{
-	struct hostapd_data *hapd = eloop_ctx;
-	char buf[4096];
-	int res;
-	struct sockaddr_un from;
-	socklen_t fromlen = sizeof(from);
-	char *reply;
-	const int reply_size = 4096;
-	int reply_len;
-	int level = MSG_DEBUG;
+/*
+ * Commands that do not change any state; more than one of these can be
+ * processed per wakeup and identical requests are answered from a snapshot
+ */
+static const char * const hostapd_ctrl_read_only_cmds[] = {
+	"PING", "STATUS", "STATUS-DRIVER", "MIB", "MIB ", "STA-FIRST", "STA ",
+	"STA-NEXT ", "STA-DUMP", "STA-DUMP ", "GET_CONFIG", "GET ", NULL
+};
 
-	res = recvfrom(sock, buf, sizeof(buf) - 1, 0,
-		       (struct sockaddr *) &from, &fromlen);
-	if (res < 0) {
-		perror("recvfrom(ctrl_iface)");
-		return;
-	}
-	buf[res] = '\0';
-	if (os_strcmp(buf, "PING") == 0)
-		level = MSG_EXCESSIVE;
-	wpa_hexdump_ascii(level, "RX ctrl_iface", (u8 *) buf, res);
+/* Maximum length of a response */
+#define CTRL_IFACE_REPLY_SIZE 4096
+/* Maximum length of a STA-DUMP response; multiple stations per response */
+#define CTRL_IFACE_STA_DUMP_REPLY_SIZE 32768
 
-	reply = os_malloc(reply_size);
-	if (reply == NULL) {
-		sendto(sock, "FAIL\n", 5, 0, (struct sockaddr *) &from,
-		       fromlen);
-		return;
-	}
+
+static int hostapd_ctrl_iface_process(struct hostapd_data *hapd, char *buf,
+				      char *reply, int reply_size,
+				      struct sockaddr_un *from,
+				      socklen_t fromlen)
+{
+	int reply_len, res;
 
 	os_memcpy(reply, "OK\n", 3);
 	reply_len = 3;
@@ -1436,14 +1443,22 @@ static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
 	} else if (os_strncmp(buf, "STA-NEXT ", 9) == 0) {
 		reply_len = hostapd_ctrl_iface_sta_next(hapd, buf + 9, reply,
 							reply_size);
+	} else if (os_strcmp(buf, "STA-DUMP") == 0) {
+		reply_len = hostapd_ctrl_iface_sta_dump(hapd, "", reply,
+							reply_size,
+							CTRL_IFACE_REPLY_SIZE);
+	} else if (os_strncmp(buf, "STA-DUMP ", 9) == 0) {
+		reply_len = hostapd_ctrl_iface_sta_dump(hapd, buf + 9, reply,
+							reply_size,
+							CTRL_IFACE_REPLY_SIZE);
 	} else if (os_strcmp(buf, "ATTACH") == 0) {
-		if (hostapd_ctrl_iface_attach(hapd, &from, fromlen))
+		if (hostapd_ctrl_iface_attach(hapd, from, fromlen))
 			reply_len = -1;
 	} else if (os_strcmp(buf, "DETACH") == 0) {
-		if (hostapd_ctrl_iface_detach(hapd, &from, fromlen))
+		if (hostapd_ctrl_iface_detach(hapd, from, fromlen))
 			reply_len = -1;
 	} else if (os_strncmp(buf, "LEVEL ", 6) == 0) {
-		if (hostapd_ctrl_iface_level(hapd, &from, fromlen,
+		if (hostapd_ctrl_iface_level(hapd, from, fromlen,
 						    buf + 6))
 			reply_len = -1;
 	} else if (os_strncmp(buf, "NEW_STA ", 8) == 0) {
@@ -1564,12 +1579,104 @@ static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
 		reply_len = 16;
 	}
 
+	return reply_len;
+}
+
+
+/*
+ * Returns 1 if the next pending request can be processed within the same
+ * batch or 0 if the request may have changed the state.
+ */
+static int hostapd_ctrl_iface_request(struct hostapd_data *hapd, int sock,
+				      char *buf, size_t len,
+				      struct sockaddr_un *from,
+				      socklen_t fromlen,
+				      struct ctrl_iface_snapshot *snap)
+{
+	char *reply, *cmd = NULL;
+	int reply_size = CTRL_IFACE_REPLY_SIZE;
+	const struct wpabuf *cached;
+	int reply_len, read_only, batch;
+	int level = MSG_DEBUG;
+
+	if (os_strcmp(buf, "PING") == 0)
+		level = MSG_EXCESSIVE;
+	wpa_hexdump_ascii(level, "RX ctrl_iface", (u8 *) buf, len);
+
+	read_only = ctrl_iface_cmd_match(buf, hostapd_ctrl_read_only_cmds);
+	batch = read_only || os_strcmp(buf, "ATTACH") == 0 ||
+		os_strcmp(buf, "DETACH") == 0 ||
+		os_strncmp(buf, "LEVEL ", 6) == 0;
+
+	cached = read_only ? ctrl_iface_snapshot_get(snap, buf) : NULL;
+	if (cached) {
+		sendto(sock, wpabuf_head(cached), wpabuf_len(cached), 0,
+		       (struct sockaddr *) from, fromlen);
+		return 1;
+	}
+
+	if (os_strncmp(buf, "STA-DUMP", 8) == 0)
+		reply_size = CTRL_IFACE_STA_DUMP_REPLY_SIZE;
+	reply = os_malloc(reply_size);
+	if (reply == NULL) {
+		sendto(sock, "FAIL\n", 5, 0, (struct sockaddr *) from,
+		       fromlen);
+		return 0;
+	}
+
+	/* The command buffer may be modified during processing */
+	if (read_only)
+		cmd = os_strdup(buf);
+
+	reply_len = hostapd_ctrl_iface_process(hapd, buf, reply, reply_size,
+					       from, fromlen);
 	if (reply_len < 0) {
 		os_memcpy(reply, "FAIL\n", 5);
 		reply_len = 5;
+	} else if (cmd) {
+		ctrl_iface_snapshot_add(snap, cmd, reply, reply_len);
 	}
-	sendto(sock, reply, reply_len, 0, (struct sockaddr *) &from, fromlen);
+	os_free(cmd);
+
+	sendto(sock, reply, reply_len, 0, (struct sockaddr *) from, fromlen);
 	os_free(reply);
+
+	return batch;
+}
+
+
+static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
+				       void *sock_ctx)
+{
+	struct hostapd_data *hapd = eloop_ctx;
+	struct ctrl_iface_snapshot snap;
+	char buf[4096];
+	int res, count = 0;
+	struct sockaddr_un from;
+	socklen_t fromlen;
+
+	/*
+	 * Process pending requests in a batch for as long as they do not
+	 * change the state so that a burst of status queries from monitoring
+	 * programs does not need a separate eloop iteration for each request.
+	 */
+	os_memset(&snap, 0, sizeof(snap));
+	do {
+		fromlen = sizeof(from);
+		res = recvfrom(sock, buf, sizeof(buf) - 1,
+			       count ? MSG_DONTWAIT : 0,
+			       (struct sockaddr *) &from, &fromlen);
+		if (res < 0) {
+			if (count == 0)
+				perror("recvfrom(ctrl_iface)");
+			break;
+		}
+		buf[res] = '\0';
+		count++;
+	} while (hostapd_ctrl_iface_request(hapd, sock, buf, res, &from,
+					    fromlen, &snap) &&
+		 count < CTRL_IFACE_MAX_BATCH);
+	ctrl_iface_snapshot_clear(&snap);
 }
 
 
@@ -1751,9 +1858,11 @@ void hostapd_ctrl_iface_deinit(struct hostapd_data *hapd)
 {
 	struct wpa_ctrl_dst *dst, *prev;
 
+	eloop_cancel_timeout(hostapd_ctrl_iface_pending_timeout, hapd, NULL);
 	if (hapd->ctrl_sock > -1) {
 		char *fname;
 		eloop_unregister_read_sock(hapd->ctrl_sock);
+		hostapd_ctrl_iface_send_pending(hapd);
 		close(hapd->ctrl_sock);
 		hapd->ctrl_sock = -1;
 		fname = hostapd_ctrl_iface_path(hapd);
@@ -1780,8 +1889,10 @@ void hostapd_ctrl_iface_deinit(struct hostapd_data *hapd)
 	while (dst) {
 		prev = dst;
 		dst = dst->next;
+		ctrl_mon_queue_clear(&prev->queue);
 		os_free(prev);
 	}
+	hapd->ctrl_dst = NULL;
 }
 
 
@@ -2035,54 +2146,93 @@ void hostapd_global_ctrl_iface_deinit(struct hapd_interfaces *interfaces)
 }
 
 
-static void hostapd_ctrl_iface_send(struct hostapd_data *hapd, int level,
-				    const char *buf, size_t len)
+/* Retry interval for monitors that could not receive all pending events */
+#define CTRL_IFACE_RETRY_MS 100
+
+static void hostapd_ctrl_iface_send_pending(struct hostapd_data *hapd)
 {
 	struct wpa_ctrl_dst *dst, *next;
-	struct msghdr msg;
-	int idx;
-	struct iovec io[2];
-	char levelstr[10];
+	int idx, res, pending = 0;
 
 	dst = hapd->ctrl_dst;
-	if (hapd->ctrl_sock < 0 || dst == NULL)
-		return;
-
-	os_snprintf(levelstr, sizeof(levelstr), "<%d>", level);
-	io[0].iov_base = levelstr;
-	io[0].iov_len = os_strlen(levelstr);
-	io[1].iov_base = (char *) buf;
-	io[1].iov_len = len;
-	os_memset(&msg, 0, sizeof(msg));
-	msg.msg_iov = io;
-	msg.msg_iovlen = 2;
-
 	idx = 0;
-	while (dst) {
+	while (dst && hapd->ctrl_sock >= 0) {
 		next = dst->next;
-		if (level >= dst->debug_level) {
+		if (dst->queue.count || dst->queue.dropped) {
 			wpa_hexdump(MSG_DEBUG, "CTRL_IFACE monitor send",
 				    (u8 *) dst->addr.sun_path, dst->addrlen -
 				    offsetof(struct sockaddr_un, sun_path));
-			msg.msg_name = &dst->addr;
-			msg.msg_namelen = dst->addrlen;
-			if (sendmsg(hapd->ctrl_sock, &msg, 0) < 0) {
+			res = ctrl_mon_queue_send(&dst->queue, hapd->ctrl_sock,
+						  &dst->addr, dst->addrlen);
+			if (res < 0) {
 				int _errno = errno;
 				wpa_printf(MSG_INFO, "CTRL_IFACE monitor[%d]: "
-					   "%d - %s",
-					   idx, errno, strerror(errno));
+					   "%d - %s (%u pending)",
+					   idx, errno, strerror(errno),
+					   dst->queue.count);
 				dst->errors++;
 				if (dst->errors > 10 || _errno == ENOENT) {
 					hostapd_ctrl_iface_detach(
 						hapd, &dst->addr,
 						dst->addrlen);
-				}
+				} else
+					pending = 1;
 			} else
 				dst->errors = 0;
 		}
 		idx++;
 		dst = next;
 	}
+
+	if (pending)
+		eloop_register_timeout(0, CTRL_IFACE_RETRY_MS * 1000,
+				       hostapd_ctrl_iface_pending_timeout, hapd,
+				       NULL);
+}
+
+
+static void hostapd_ctrl_iface_pending_timeout(void *eloop_ctx,
+					       void *timeout_ctx)
+{
+	struct hostapd_data *hapd = eloop_ctx;
+
+	hostapd_ctrl_iface_send_pending(hapd);
+}
+
+
+static void hostapd_ctrl_iface_send(struct hostapd_data *hapd, int level,
+				    const char *buf, size_t len)
+{
+	struct wpa_ctrl_dst *dst;
+	struct wpabuf *msg;
+	int queued = 0;
+
+	dst = hapd->ctrl_dst;
+	if (hapd->ctrl_sock < 0 || dst == NULL)
+		return;
+
+	msg = ctrl_mon_msg_build(NULL, level, buf, len);
+	if (msg == NULL)
+		return;
+
+	while (dst) {
+		if (level >= dst->debug_level) {
+			ctrl_mon_queue_add(&dst->queue, msg);
+			queued = 1;
+		}
+		dst = dst->next;
+	}
+	wpabuf_free(msg);
+
+	/*
+	 * Send the queued events once the current event has been processed
+	 * to allow bursts of events to be sent in batches.
+	 */
+	if (queued &&
+	    !eloop_is_timeout_registered(hostapd_ctrl_iface_pending_timeout,
+					 hapd, NULL))
+		eloop_register_timeout(0, 0, hostapd_ctrl_iface_pending_timeout,
+				       hapd, NULL);
 }
 
 #endif /* CONFIG_NATIVE_WINDOWS */
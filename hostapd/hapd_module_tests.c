@@ -9,9 +9,94 @@
 #include "utils/includes.h"
 
 #include "utils/common.h"
+#include "drivers/driver.h"
+
+
+struct probe_req_filter_test_data {
+	u8 *ie;
+	size_t len;
+	int ignore_broadcast_ssid;
+	int interworking;
+	int result;
+};
+
+static const struct probe_req_filter_test_data probe_req_filter_tests[] = {
+	/* SSID "test" + Supported Rates */
+	{ (u8 *) "\x00\x04test\x01\x01\x82", 9, 0, 0, 1 },
+	/* Wildcard SSID */
+	{ (u8 *) "\x00\x00\x01\x01\x82", 5, 0, 0, 1 },
+	{ (u8 *) "\x00\x00\x01\x01\x82", 5, 1, 0, 0 },
+	/* Foreign SSID */
+	{ (u8 *) "\x00\x04" "abcd\x01\x01\x82", 9, 0, 0, 0 },
+	/* Wildcard SSID with an SSID List including our SSID */
+	{ (u8 *) "\x00\x00\x01\x01\x82\x54\x06\x00\x04test", 13, 1, 0, 1 },
+	/* Foreign SSID with an SSID List including a wildcard SSID */
+	{ (u8 *) "\x00\x04" "abcd\x01\x01\x82\x54\x02\x00\x00", 13, 0, 0, 1 },
+	/* Missing Supported Rates */
+	{ (u8 *) "\x00\x04test", 6, 0, 0, 0 },
+	/* Truncated element */
+	{ (u8 *) "\x00\x04test\x01\x01\x82\xdd", 10, 0, 0, 0 },
+	{ (u8 *) "\x00\x04test\x01\x05\x82", 9, 0, 0, 0 },
+	/* Interworking: wildcard ANT, matching ANT, mismatching ANT */
+	{ (u8 *) "\x00\x00\x01\x01\x82\x6b\x01\x0f", 8, 0, 1, 1 },
+	{ (u8 *) "\x00\x00\x01\x01\x82\x6b\x01\x02", 8, 0, 1, 1 },
+	{ (u8 *) "\x00\x00\x01\x01\x82\x6b\x01\x03", 8, 0, 1, 0 },
+	{ (u8 *) "\x00\x00\x01\x01\x82\x6b\x01\x03", 8, 0, 0, 1 },
+	/* Interworking: broadcast HESSID, matching HESSID, other HESSID */
+	{ (u8 *) "\x00\x00\x01\x01\x82\x6b\x07\x0f\xff\xff\xff\xff\xff\xff",
+	  14, 0, 1, 1 },
+	{ (u8 *) "\x00\x00\x01\x01\x82\x6b\x07\x0f\x02\x00\x00\x00\x00\x01",
+	  14, 0, 1, 1 },
+	{ (u8 *) "\x00\x00\x01\x01\x82\x6b\x07\x0f\x02\x00\x00\x00\x00\x02",
+	  14, 0, 1, 0 },
+	{ NULL, 0, 0, 0, 0 }
+};
+
+static int probe_req_filter_tests_run(void)
+{
+	struct wpa_driver_probe_req_filter filter;
+	int i, ret = 0;
+
+	wpa_printf(MSG_INFO, "probe_req_filter tests");
+
+	for (i = 0; probe_req_filter_tests[i].ie; i++) {
+		const struct probe_req_filter_test_data *test;
+
+		test = &probe_req_filter_tests[i];
+		os_memset(&filter, 0, sizeof(filter));
+		os_memcpy(filter.ssid, "test", 4);
+		filter.ssid_len = 4;
+		filter.ignore_broadcast_ssid = test->ignore_broadcast_ssid;
+		filter.interworking = test->interworking;
+		filter.access_network_type = 2;
+		os_memcpy(filter.hessid, "\x02\x00\x00\x00\x00\x01", ETH_ALEN);
+		if (probe_req_filter_match(&filter, test->ie, test->len) !=
+		    test->result) {
+			wpa_printf(MSG_ERROR, "probe_req_filter test %d failed",
+				   i);
+			ret = -1;
+		}
+	}
+
+	os_memset(&filter, 0, sizeof(filter));
+	filter.drop_all = 1;
+	if (probe_req_filter_match(&filter, (u8 *) "\x00\x00\x01\x01\x82", 5)) {
+		wpa_printf(MSG_ERROR, "probe_req_filter drop_all test failed");
+		ret = -1;
+	}
+
+	return ret;
+}
+
 
 int hapd_module_tests(void)
 {
+	int ret = 0;
+
 	wpa_printf(MSG_INFO, "hostapd module tests");
-	return 0;
+
+	if (probe_req_filter_tests_run() < 0)
+		ret = -1;
+
+	return ret;
 }
@@ -33,6 +33,12 @@
  * IMSI and max_chal are sent as an ASCII string,
  * Kc/SRES/RAND/AUTN/IK/CK/RES/AUTS as hex strings.
  *
+ * Multiple queries can be sent in a single datagram by separating them with
+ * a newline character. The responses are then sent in a single datagram in
+ * the same order, separated with newline characters. This can be used to
+ * fetch several authentication vectors (e.g., for different IMSIs or multiple
+ * AKA vectors for the same IMSI) with a single round trip.
+ *
  * An example implementation here reads GSM authentication triplets from a
  * text file in IMSI:Kc:SRES:RAND format, IMSI in ASCII, other fields as hex
  * strings. This is used to simulate an HLR/AuC. As such, it is not very useful
@@ -50,6 +56,8 @@
 
 #include "includes.h"
 #include <sys/un.h>
+#include <sys/stat.h>
+#include <stddef.h>
 #ifdef CONFIG_SQLITE
 #include <sqlite3.h>
 #endif /* CONFIG_SQLITE */
@@ -67,20 +75,49 @@ static int sqn_changes = 0;
 static int ind_len = 5;
 static int stdout_debug = 1;
 
+/* Maximum size of a request or response datagram */
+#define HLR_MSG_MAX 16384
+
+/* Maximum number of queries in a single datagram */
+#define HLR_MAX_BATCH 64
+
+/*
+ * Hash table of database entries indexed by IMSI. The entries are linked
+ * through a next pointer within the entry itself, so the same table
+ * implementation is used for different entry types.
+ */
+struct imsi_table {
+	void **bucket;
+	size_t size; /* number of buckets; power of two */
+	size_t count;
+	size_t imsi_off; /* offset of char imsi[] within the entry */
+	size_t hnext_off; /* offset of the hash chain pointer within the entry */
+};
+
+#define IMSI_TABLE_INIT(type) \
+	{ NULL, 0, 0, offsetof(type, imsi), offsetof(type, hnext) }
+#define IMSI_TABLE_MIN_SIZE 256
+
 /* GSM triplets */
 struct gsm_triplet {
 	struct gsm_triplet *next;
-	char imsi[20];
 	u8 kc[8];
 	u8 sres[4];
 	u8 _rand[16];
 };
 
-static struct gsm_triplet *gsm_db = NULL, *gsm_db_pos = NULL;
+/* GSM triplets of an IMSI; used in round robin order */
+struct gsm_imsi {
+	struct gsm_imsi *hnext;
+	char imsi[20];
+	struct gsm_triplet *triplets, *last, *pos;
+};
+
+static struct imsi_table gsm_db = IMSI_TABLE_INIT(struct gsm_imsi);
 
 /* OPc and AMF parameters for Milenage (Example algorithms for AKA). */
 struct milenage_parameters {
-	struct milenage_parameters *next;
+	struct milenage_parameters *hnext;
 	char imsi[20];
 	u8 ki[16];
 	u8 opc[16];
@@ -89,7 +126,8 @@ struct milenage_parameters {
 	int set;
 };
 
-static struct milenage_parameters *milenage_db = NULL;
+static struct imsi_table milenage_db =
+	IMSI_TABLE_INIT(struct milenage_parameters);
 
 #define EAP_SIM_MAX_CHAL 3
 
@@ -104,6 +142,8 @@ static struct milenage_parameters *milenage_db = NULL;
 #ifdef CONFIG_SQLITE
 
 static sqlite3 *sqlite_db = NULL;
+static sqlite3_stmt *db_get_stmt = NULL;
+static sqlite3_stmt *db_update_stmt = NULL;
 static struct milenage_parameters db_tmp_milenage;
 
 
@@ -138,6 +178,19 @@ static int db_table_create_milenage(sqlite3 *db)
 }
 
 
+static void db_close(void)
+{
+	sqlite3_finalize(db_get_stmt);
+	db_get_stmt = NULL;
+	sqlite3_finalize(db_update_stmt);
+	db_update_stmt = NULL;
+	if (sqlite_db) {
+		sqlite3_close(sqlite_db);
+		sqlite_db = NULL;
+	}
+}
+
+
 static sqlite3 * db_open(const char *db_file)
 {
 	sqlite3 *db;
@@ -155,72 +208,77 @@ static sqlite3 * db_open(const char *db_file)
 		return NULL;
 	}
 
+	/* The statements are prepared once since they are used for each
+	 * request */
+	if (sqlite3_prepare_v2(db, "SELECT ki,opc,amf,sqn FROM milenage "
+			       "WHERE imsi=?;", -1, &db_get_stmt,
+			       NULL) != SQLITE_OK ||
+	    sqlite3_prepare_v2(db, "UPDATE milenage SET sqn=? WHERE imsi=?;",
+			       -1, &db_update_stmt, NULL) != SQLITE_OK) {
+		printf("Failed to prepare database statements: %s\n",
+		       sqlite3_errmsg(db));
+		sqlite_db = db;
+		db_close();
+		return NULL;
+	}
+
 	return db;
 }
 
 
-static int get_milenage_cb(void *ctx, int argc, char *argv[], char *col[])
+static int db_get_hex(sqlite3_stmt *stmt, int col, const char *name,
+		      u8 *buf, size_t len)
 {
-	struct milenage_parameters *m = ctx;
-	int i;
+	const char *val = (const char *) sqlite3_column_text(stmt, col);
 
-	m->set = 1;
-
-	for (i = 0; i < argc; i++) {
-		if (os_strcmp(col[i], "ki") == 0 && argv[i] &&
-		    hexstr2bin(argv[i], m->ki, sizeof(m->ki))) {
-			printf("Invalid ki value in database\n");
-			return -1;
-		}
-
-		if (os_strcmp(col[i], "opc") == 0 && argv[i] &&
-		    hexstr2bin(argv[i], m->opc, sizeof(m->opc))) {
-			printf("Invalid opcvalue in database\n");
-			return -1;
-		}
-
-		if (os_strcmp(col[i], "amf") == 0 && argv[i] &&
-		    hexstr2bin(argv[i], m->amf, sizeof(m->amf))) {
-			printf("Invalid amf value in database\n");
-			return -1;
-		}
-
-		if (os_strcmp(col[i], "sqn") == 0 && argv[i] &&
-		    hexstr2bin(argv[i], m->sqn, sizeof(m->sqn))) {
-			printf("Invalid sqn value in database\n");
-			return -1;
-		}
+	if (val && hexstr2bin(val, buf, len)) {
+		printf("Invalid %s value in database\n", name);
+		return -1;
 	}
-
 	return 0;
 }
 
 
 static struct milenage_parameters * db_get_milenage(const char *imsi_txt)
 {
-	char cmd[128];
+	struct milenage_parameters *m = &db_tmp_milenage;
 	unsigned long long imsi;
+	int res;
 
-	os_memset(&db_tmp_milenage, 0, sizeof(db_tmp_milenage));
+	os_memset(m, 0, sizeof(*m));
 	imsi = atoll(imsi_txt);
-	os_snprintf(db_tmp_milenage.imsi, sizeof(db_tmp_milenage.imsi),
-		    "%llu", imsi);
-	os_snprintf(cmd, sizeof(cmd),
-		    "SELECT ki,opc,amf,sqn FROM milenage WHERE imsi=%llu;",
-		    imsi);
-	if (sqlite3_exec(sqlite_db, cmd, get_milenage_cb, &db_tmp_milenage,
-			 NULL) != SQLITE_OK)
+	os_snprintf(m->imsi, sizeof(m->imsi), "%llu", imsi);
+
+	sqlite3_reset(db_get_stmt);
+	if (sqlite3_bind_int64(db_get_stmt, 1, (sqlite3_int64) imsi) !=
+	    SQLITE_OK)
 		return NULL;
+	res = sqlite3_step(db_get_stmt);
+	if (res != SQLITE_ROW) {
+		if (res != SQLITE_DONE)
+			printf("SQLite error: %s\n", sqlite3_errmsg(sqlite_db));
+		sqlite3_reset(db_get_stmt);
+		return NULL;
+	}
 
-	if (!db_tmp_milenage.set)
+	if (db_get_hex(db_get_stmt, 0, "ki", m->ki, sizeof(m->ki)) < 0 ||
+	    db_get_hex(db_get_stmt, 1, "opc", m->opc, sizeof(m->opc)) < 0 ||
+	    db_get_hex(db_get_stmt, 2, "amf", m->amf, sizeof(m->amf)) < 0 ||
+	    db_get_hex(db_get_stmt, 3, "sqn", m->sqn, sizeof(m->sqn)) < 0) {
+		sqlite3_reset(db_get_stmt);
 		return NULL;
-	return &db_tmp_milenage;
+	}
+	sqlite3_reset(db_get_stmt);
+
+	m->set = 1;
+	return m;
 }
 
 
 static int db_update_milenage_sqn(struct milenage_parameters *m)
 {
-	char cmd[128], val[13], *pos;
+	char val[13], *pos;
+	int res;
 
 	if (sqlite_db == NULL)
 		return 0;
@@ -228,10 +286,17 @@ static int db_update_milenage_sqn(struct milenage_parameters *m)
 	pos = val;
 	pos += wpa_snprintf_hex(pos, sizeof(val), m->sqn, 6);
 	*pos = '\0';
-	os_snprintf(cmd, sizeof(cmd),
-		    "UPDATE milenage SET sqn='%s' WHERE imsi=%s;",
-		    val, m->imsi);
-	if (sqlite3_exec(sqlite_db, cmd, NULL, NULL, NULL) != SQLITE_OK) {
+
+	sqlite3_reset(db_update_stmt);
+	if (sqlite3_bind_text(db_update_stmt, 1, val, -1, SQLITE_TRANSIENT) !=
+	    SQLITE_OK ||
+	    sqlite3_bind_int64(db_update_stmt, 2,
+			       (sqlite3_int64) atoll(m->imsi)) != SQLITE_OK)
+		res = SQLITE_ERROR;
+	else
+		res = sqlite3_step(db_update_stmt);
+	sqlite3_reset(db_update_stmt);
+	if (res != SQLITE_DONE) {
 		printf("Failed to update SQN in database for IMSI %s\n",
 		       m->imsi);
 		return -1;
@@ -266,11 +331,171 @@ static int open_socket(const char *path)
 }
 
 
+static unsigned int imsi_hash(const char *imsi)
+{
+	unsigned int hash = 2166136261U;
+
+	/* FNV-1a */
+	while (*imsi) {
+		hash ^= (u8) *imsi++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+
+static void ** imsi_table_hnext(struct imsi_table *t, void *e)
+{
+	return (void **) ((u8 *) e + t->hnext_off);
+}
+
+
+static const char * imsi_table_imsi(struct imsi_table *t, void *e)
+{
+	return (const char *) e + t->imsi_off;
+}
+
+
+static int imsi_table_resize(struct imsi_table *t, size_t size)
+{
+	void **bucket, *e, *next;
+	size_t i, h;
+
+	bucket = os_calloc(size, sizeof(void *));
+	if (bucket == NULL)
+		return -1;
+
+	for (i = 0; i < t->size; i++) {
+		for (e = t->bucket[i]; e; e = next) {
+			next = *imsi_table_hnext(t, e);
+			h = imsi_hash(imsi_table_imsi(t, e)) & (size - 1);
+			*imsi_table_hnext(t, e) = bucket[h];
+			bucket[h] = e;
+		}
+	}
+
+	os_free(t->bucket);
+	t->bucket = bucket;
+	t->size = size;
+	return 0;
+}
+
+
+/* Size the table for the expected number of entries to avoid rehashing */
+static void imsi_table_reserve(struct imsi_table *t, size_t count)
+{
+	size_t size = IMSI_TABLE_MIN_SIZE;
+
+	while (size < count)
+		size *= 2;
+	if (size > t->size)
+		imsi_table_resize(t, size);
+}
+
+
+static void * imsi_table_get(struct imsi_table *t, const char *imsi)
+{
+	void *e;
+
+	if (t->size == 0)
+		return NULL;
+
+	e = t->bucket[imsi_hash(imsi) & (t->size - 1)];
+	while (e && os_strcmp(imsi_table_imsi(t, e), imsi) != 0)
+		e = *imsi_table_hnext(t, e);
+	return e;
+}
+
+
+/*
+ * Add an entry into the table. An entry added later shadows an earlier entry
+ * with the same IMSI, so the last one in the data file is used.
+ */
+static int imsi_table_add(struct imsi_table *t, void *entry)
+{
+	void **pos;
+
+	/* Keep the load factor at most one; a failure to grow the table only
+	 * makes the chains longer */
+	if (t->count >= t->size &&
+	    imsi_table_resize(t, t->size ? t->size * 2 :
+			      IMSI_TABLE_MIN_SIZE) < 0 && t->size == 0)
+		return -1;
+
+	pos = &t->bucket[imsi_hash(imsi_table_imsi(t, entry)) &
+			 (t->size - 1)];
+	*imsi_table_hnext(t, entry) = *pos;
+	*pos = entry;
+	t->count++;
+	return 0;
+}
+
+
+static void imsi_table_deinit(struct imsi_table *t, void (*free_entry)(void *))
+{
+	void *e, *next;
+	size_t i;
+
+	for (i = 0; i < t->size; i++) {
+		for (e = t->bucket[i]; e; e = next) {
+			next = *imsi_table_hnext(t, e);
+			free_entry(e);
+		}
+	}
+	os_free(t->bucket);
+	t->bucket = NULL;
+	t->size = 0;
+	t->count = 0;
+}
+
+
+static void free_milenage(void *ctx)
+{
+	os_free(ctx);
+}
+
+
+static void free_gsm_imsi(void *ctx)
+{
+	struct gsm_imsi *i = ctx;
+	struct gsm_triplet *g, *prev;
+
+	g = i->triplets;
+	while (g) {
+		prev = g;
+		g = g->next;
+		os_free(prev);
+	}
+	os_free(i);
+}
+
+
+static struct gsm_imsi * get_gsm_imsi(const char *imsi, int create)
+{
+	struct gsm_imsi *i;
+
+	i = imsi_table_get(&gsm_db, imsi);
+	if (i || !create)
+		return i;
+
+	i = os_zalloc(sizeof(*i));
+	if (i == NULL)
+		return NULL;
+	os_strlcpy(i->imsi, imsi, sizeof(i->imsi));
+	if (imsi_table_add(&gsm_db, i) < 0) {
+		os_free(i);
+		return NULL;
+	}
+	return i;
+}
+
+
 static int read_gsm_triplets(const char *fname)
 {
 	FILE *f;
 	char buf[200], *pos, *pos2;
 	struct gsm_triplet *g = NULL;
+	struct gsm_imsi *i;
 	int line, ret = 0;
 
 	if (fname == NULL)
@@ -314,13 +539,17 @@ static int read_gsm_triplets(const char *fname)
 			break;
 		}
 		*pos2 = '\0';
-		if (strlen(pos) >= sizeof(g->imsi)) {
+		if (strlen(pos) >= sizeof(i->imsi)) {
 			printf("%s:%d - Too long IMSI (%s)\n",
 			       fname, line, pos);
 			ret = -1;
 			break;
 		}
-		os_strlcpy(g->imsi, pos, sizeof(g->imsi));
+		i = get_gsm_imsi(pos, 1);
+		if (i == NULL) {
+			ret = -1;
+			break;
+		}
 		pos = pos2 + 1;
 
 		/* Kc */
@@ -367,8 +596,11 @@ static int read_gsm_triplets(const char *fname)
 		}
 		pos = pos2 + 1;
 
-		g->next = gsm_db;
-		gsm_db = g;
+		if (i->last)
+			i->last->next = g;
+		else
+			i->triplets = g;
+		i->last = g;
 		g = NULL;
 	}
 	os_free(g);
@@ -381,26 +613,16 @@ static int read_gsm_triplets(const char *fname)
 
 static struct gsm_triplet * get_gsm_triplet(const char *imsi)
 {
-	struct gsm_triplet *g = gsm_db_pos;
-
-	while (g) {
-		if (strcmp(g->imsi, imsi) == 0) {
-			gsm_db_pos = g->next;
-			return g;
-		}
-		g = g->next;
-	}
+	struct gsm_imsi *i;
+	struct gsm_triplet *g;
 
-	g = gsm_db;
-	while (g && g != gsm_db_pos) {
-		if (strcmp(g->imsi, imsi) == 0) {
-			gsm_db_pos = g->next;
-			return g;
-		}
-		g = g->next;
-	}
+	i = get_gsm_imsi(imsi, 0);
+	if (i == NULL)
+		return NULL;
 
-	return NULL;
+	g = i->pos ? i->pos : i->triplets;
+	i->pos = g ? g->next : NULL;
+	return g;
 }
 
 
@@ -409,6 +631,7 @@ static int read_milenage(const char *fname)
 	FILE *f;
 	char buf[200], *pos, *pos2;
 	struct milenage_parameters *m = NULL;
+	struct stat st;
 	int line, ret = 0;
 
 	if (fname == NULL)
@@ -420,6 +643,10 @@ static int read_milenage(const char *fname)
 		return -1;
 	}
 
+	/* Each entry uses about 100 octets in the file */
+	if (fstat(fileno(f), &st) == 0)
+		imsi_table_reserve(&milenage_db, st.st_size / 100);
+
 	line = 0;
 	while (fgets(buf, sizeof(buf), f)) {
 		line++;
@@ -517,8 +744,10 @@ static int read_milenage(const char *fname)
 		}
 		pos = pos2 + 1;
 
-		m->next = milenage_db;
-		milenage_db = m;
+		if (imsi_table_add(&milenage_db, m) < 0) {
+			ret = -1;
+			break;
+		}
 		m = NULL;
 	}
 	os_free(m);
@@ -536,6 +765,7 @@ static void update_milenage_file(const char *fname)
 	char *end = buf + sizeof(buf);
 	struct milenage_parameters *m;
 	size_t imsi_len;
+	char imsi[20];
 
 	f = fopen(fname, "r");
 	if (f == NULL) {
@@ -560,13 +790,10 @@ static void update_milenage_file(const char *fname)
 			goto no_update;
 
 		imsi_len = pos - buf;
+		os_memcpy(imsi, buf, imsi_len);
+		imsi[imsi_len] = '\0';
 
-		for (m = milenage_db; m; m = m->next) {
-			if (strncmp(buf, m->imsi, imsi_len) == 0 &&
-			    m->imsi[imsi_len] == '\0')
-				break;
-		}
-
+		m = imsi_table_get(&milenage_db, imsi);
 		if (!m)
 			goto no_update;
 
@@ -605,13 +832,9 @@ static void update_milenage_file(const char *fname)
 
 static struct milenage_parameters * get_milenage(const char *imsi)
 {
-	struct milenage_parameters *m = milenage_db;
+	struct milenage_parameters *m;
 
-	while (m) {
-		if (strcmp(m->imsi, imsi) == 0)
-			break;
-		m = m->next;
-	}
+	m = imsi_table_get(&milenage_db, imsi);
 
 #ifdef CONFIG_SQLITE
 	if (!m)
@@ -668,9 +891,6 @@ static int sim_req_auth(char *imsi, char *resp, size_t resp_len)
 
 	count = 0;
 	while (count < max_chal && (g = get_gsm_triplet(imsi))) {
-		if (strcmp(g->imsi, imsi) != 0)
-			continue;
-
 		if (rpos < rend)
 			*rpos++ = ' ';
 		rpos += wpa_snprintf_hex(rpos, rend - rpos, g->kc, 8);
@@ -916,10 +1136,13 @@ static int process_cmd(char *cmd, char *resp, size_t resp_len)
 
 static int process(int s)
 {
-	char buf[1000], resp[1000];
+	char buf[HLR_MSG_MAX], resp[HLR_MSG_MAX], out[1000];
+	char *cmd, *next, *rpos, *rend;
 	struct sockaddr_un from;
 	socklen_t fromlen;
 	ssize_t res;
+	size_t len;
+	int count = 0;
 
 	fromlen = sizeof(from);
 	res = recvfrom(s, buf, sizeof(buf), 0, (struct sockaddr *) &from,
@@ -936,21 +1159,51 @@ static int process(int s)
 		res = sizeof(buf) - 1;
 	buf[res] = '\0';
 
-	printf("Received: %s\n", buf);
+	if (stdout_debug)
+		printf("Received: %s\n", buf);
 
-	if (process_cmd(buf, resp, sizeof(resp)) < 0) {
-		printf("Failed to process request\n");
-		return -1;
+	/* One or more queries separated with newline characters */
+	rpos = resp;
+	rend = resp + sizeof(resp);
+	for (cmd = buf; cmd; cmd = next) {
+		next = os_strchr(cmd, '\n');
+		if (next)
+			*next++ = '\0';
+		if (*cmd == '\0')
+			continue;
+		if (++count > HLR_MAX_BATCH) {
+			printf("Too many queries in a single request\n");
+			break;
+		}
+
+		if (process_cmd(cmd, out, sizeof(out)) < 0) {
+			printf("Failed to process request\n");
+			continue;
+		}
+		if (out[0] == '\0')
+			continue;
+
+		len = os_strlen(out);
+		if ((size_t) (rend - rpos) < len + 2) {
+			printf("Too long response\n");
+			break;
+		}
+		if (rpos > resp)
+			*rpos++ = '\n';
+		os_memcpy(rpos, out, len + 1);
+		rpos += len;
 	}
 
-	if (resp[0] == '\0') {
-		printf("No response\n");
+	if (rpos == resp) {
+		if (stdout_debug)
+			printf("No response\n");
 		return 0;
 	}
 
-	printf("Send: %s\n", resp);
+	if (stdout_debug)
+		printf("Send: %s\n", resp);
 
-	if (sendto(s, resp, os_strlen(resp), 0, (struct sockaddr *) &from,
+	if (sendto(s, resp, rpos - resp, 0, (struct sockaddr *) &from,
 		   fromlen) < 0)
 		perror("send");
 
@@ -960,25 +1213,11 @@ static int process(int s)
 
 static void cleanup(void)
 {
-	struct gsm_triplet *g, *gprev;
-	struct milenage_parameters *m, *prev;
-
 	if (update_milenage && milenage_file && sqn_changes)
 		update_milenage_file(milenage_file);
 
-	g = gsm_db;
-	while (g) {
-		gprev = g;
-		g = g->next;
-		os_free(gprev);
-	}
-
-	m = milenage_db;
-	while (m) {
-		prev = m;
-		m = m->next;
-		os_free(prev);
-	}
+	imsi_table_deinit(&gsm_db, free_gsm_imsi);
+	imsi_table_deinit(&milenage_db, free_milenage);
 
 	if (serv_sock >= 0)
 		close(serv_sock);
@@ -986,10 +1225,7 @@ static void cleanup(void)
 		unlink(socket_path);
 
 #ifdef CONFIG_SQLITE
-	if (sqlite_db) {
-		sqlite3_close(sqlite_db);
-		sqlite_db = NULL;
-	}
+	db_close();
 #endif /* CONFIG_SQLITE */
 }
 
@@ -1008,12 +1244,13 @@ static void usage(void)
 	       "Copyright (c) 2005-2007, 2012-2013, Jouni Malinen <j@w1.fi>\n"
 	       "\n"
 	       "usage:\n"
-	       "hlr_auc_gw [-hu] [-s<socket path>] [-g<triplet file>] "
+	       "hlr_auc_gw [-hqu] [-s<socket path>] [-g<triplet file>] "
 	       "[-m<milenage file>] \\\n"
 	       "        [-D<DB file>] [-i<IND len in bits>] [command]\n"
 	       "\n"
 	       "options:\n"
 	       "  -h = show this usage help\n"
+	       "  -q = do not print each request and response\n"
 	       "  -u = update SQN in Milenage file on exit\n"
 	       "  -s<socket path> = path for UNIX domain socket\n"
 	       "                    (default: %s)\n"
@@ -1046,7 +1283,7 @@ int main(int argc, char *argv[])
 	socket_path = default_socket_path;
 
 	for (;;) {
-		c = getopt(argc, argv, "D:g:hi:m:s:u");
+		c = getopt(argc, argv, "D:g:hi:m:qs:u");
 		if (c < 0)
 			break;
 		switch (c) {
@@ -1074,6 +1311,9 @@ int main(int argc, char *argv[])
 		case 'm':
 			milenage_file = optarg;
 			break;
+		case 'q':
+			stdout_debug = 0;
+			break;
 		case 's':
 			socket_path = optarg;
 			break;
@@ -1116,7 +1356,7 @@ int main(int argc, char *argv[])
 		for (;;)
 			process(serv_sock);
 	} else {
-		char buf[1000];
+		char buf[HLR_MSG_MAX];
 		socket_path = NULL;
 		stdout_debug = 0;
 		if (process_cmd(argv[optind], buf, sizeof(buf)) < 0) {
@@ -1129,10 +1369,7 @@ int main(int argc, char *argv[])
 	}
 
 #ifdef CONFIG_SQLITE
-	if (sqlite_db) {
-		sqlite3_close(sqlite_db);
-		sqlite_db = NULL;
-	}
+	db_close();
 #endif /* CONFIG_SQLITE */
 
 	os_program_deinit();
@@ -0,0 +1,224 @@
+/*
+ * Load test client for hlr_auc_gw
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * This program sends EAP-SIM/AKA authentication queries to hlr_auc_gw (or any
+ * other program implementing the same interface) over the UNIX domain socket
+ * and reports the number of queries processed per second. Multiple queries can
+ * be sent in a single datagram and multiple datagrams can be outstanding at
+ * the same time to measure the throughput of the gateway instead of the round
+ * trip time.
+ */
+
+#include "includes.h"
+#include <sys/un.h>
+
+#include "common.h"
+
+
+static void usage(void)
+{
+	printf("hlr_auc_gw_load [-hS] [-s<socket path>] [-n<queries>] "
+	       "[-b<batch>] \\\n"
+	       "        [-w<window>] [-c<IMSI count>] <IMSI>\n"
+	       "\n"
+	       "options:\n"
+	       "  -h = show this usage help\n"
+	       "  -S = send SIM-REQ-AUTH queries (default: AKA-REQ-AUTH)\n"
+	       "  -s<socket path> = path for hlr_auc_gw UNIX domain socket\n"
+	       "                    (default: /tmp/hlr_auc_gw.sock)\n"
+	       "  -n<queries> = total number of queries (default: 10000)\n"
+	       "  -b<batch> = number of queries per datagram (default: 1)\n"
+	       "  -w<window> = maximum number of outstanding datagrams "
+	       "(default: 16)\n"
+	       "  -c<IMSI count> = number of consecutive IMSIs to use starting "
+	       "from <IMSI>\n"
+	       "                   (default: 1)\n");
+}
+
+
+static int open_socket(const char *path, char *local, size_t local_len)
+{
+	struct sockaddr_un addr;
+	int s;
+
+	s = socket(PF_UNIX, SOCK_DGRAM, 0);
+	if (s < 0) {
+		perror("socket(PF_UNIX)");
+		return -1;
+	}
+
+	os_memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	os_snprintf(addr.sun_path, sizeof(addr.sun_path),
+		    "/tmp/hlr_auc_gw_load_%d", getpid());
+	os_strlcpy(local, addr.sun_path, local_len);
+	unlink(local);
+	if (bind(s, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		perror("bind(PF_UNIX)");
+		close(s);
+		return -1;
+	}
+
+	os_memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	os_strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+	if (connect(s, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		perror("connect(PF_UNIX)");
+		close(s);
+		unlink(local);
+		return -1;
+	}
+
+	return s;
+}
+
+
+int main(int argc, char *argv[])
+{
+	const char *socket_path = "/tmp/hlr_auc_gw.sock";
+	unsigned int queries = 10000, batch = 1, window = 16, imsi_count = 1;
+	int sim = 0;
+	char local[108], buf[16384], *pos, *end;
+	unsigned long long imsi;
+	int imsi_len, c, s, ret = 0;
+	unsigned int sent = 0, resp = 0, failures = 0, outstanding = 0;
+	unsigned int datagrams = 0, i;
+	struct os_reltime start, now, diff;
+	double secs;
+
+	for (;;) {
+		c = getopt(argc, argv, "b:c:hn:Ss:w:");
+		if (c < 0)
+			break;
+		switch (c) {
+		case 'b':
+			batch = atoi(optarg);
+			break;
+		case 'c':
+			imsi_count = atoi(optarg);
+			break;
+		case 'h':
+			usage();
+			return 0;
+		case 'n':
+			queries = atoi(optarg);
+			break;
+		case 'S':
+			sim = 1;
+			break;
+		case 's':
+			socket_path = optarg;
+			break;
+		case 'w':
+			window = atoi(optarg);
+			break;
+		default:
+			usage();
+			return -1;
+		}
+	}
+
+	if (optind + 1 != argc || batch < 1 || batch > 64 || window < 1 ||
+	    imsi_count < 1) {
+		usage();
+		return -1;
+	}
+	imsi_len = os_strlen(argv[optind]);
+	if (imsi_len < 1 || imsi_len >= 20) {
+		printf("Invalid IMSI\n");
+		return -1;
+	}
+	imsi = strtoull(argv[optind], NULL, 10);
+
+	s = open_socket(socket_path, local, sizeof(local));
+	if (s < 0)
+		return -1;
+
+	os_get_reltime(&start);
+
+	while (resp < queries) {
+		fd_set rfds;
+		struct timeval tv;
+		ssize_t res;
+
+		while (outstanding < window && sent < queries) {
+			pos = buf;
+			end = buf + sizeof(buf);
+			for (i = 0; i < batch && sent < queries; i++, sent++) {
+				int r;
+
+				r = os_snprintf(pos, end - pos,
+						"%s%s %0*llu%s",
+						i ? "\n" : "",
+						sim ? "SIM-REQ-AUTH" :
+						"AKA-REQ-AUTH",
+						imsi_len,
+						imsi + sent % imsi_count,
+						sim ? " 3" : "");
+				if (r < 0 || r >= end - pos)
+					break;
+				pos += r;
+			}
+			if (send(s, buf, pos - buf, 0) < 0) {
+				perror("send");
+				ret = -1;
+				goto done;
+			}
+			outstanding++;
+			datagrams++;
+		}
+
+		FD_ZERO(&rfds);
+		FD_SET(s, &rfds);
+		tv.tv_sec = 5;
+		tv.tv_usec = 0;
+		res = select(s + 1, &rfds, NULL, NULL, &tv);
+		if (res < 0) {
+			perror("select");
+			ret = -1;
+			goto done;
+		}
+		if (res == 0) {
+			printf("Timeout - %u datagram(s) not answered\n",
+			       outstanding);
+			ret = -1;
+			break;
+		}
+
+		res = recv(s, buf, sizeof(buf) - 1, 0);
+		if (res < 0) {
+			perror("recv");
+			ret = -1;
+			goto done;
+		}
+		buf[res] = '\0';
+		outstanding--;
+
+		for (pos = buf; pos; pos = end) {
+			end = os_strchr(pos, '\n');
+			if (end)
+				*end++ = '\0';
+			resp++;
+			if (os_strstr(pos, "FAILURE"))
+				failures++;
+		}
+	}
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &start, &diff);
+	secs = diff.sec + diff.usec / 1000000.0;
+	printf("%u queries in %u datagrams, %u responses (%u failures) in "
+	       "%.3f seconds: %.0f queries/s\n",
+	       sent, datagrams, resp, failures, secs,
+	       secs > 0 ? resp / secs : 0.0);
+	if (failures)
+		ret = -1;
+
+done:
+	close(s);
+	unlink(local);
+	return ret;
+}
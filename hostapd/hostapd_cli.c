@@ -60,7 +60,7 @@ static const char *commands_help =
 "Commands:\n"
 "   mib                  get MIB variables (dot1x, dot11, radius)\n"
 "   sta <addr>           get MIB variables for one station\n"
-"   all_sta              get MIB variables for all stations\n"
+"   all_sta [fields]     get MIB variables for all stations\n"
 "   new_sta <addr>       add a new station\n"
 "   deauthenticate <addr>  deauthenticate a station\n"
 "   disassociate <addr>  disassociate a station\n"
@@ -665,11 +665,83 @@ static int wpa_ctrl_command_sta(struct wpa_ctrl *ctrl, char *cmd,
 }
 
 
+/*
+ * Returns 0 on success, -1 on failure, or 1 if STA-DUMP is not supported by
+ * the hostapd process
+ */
+static int wpa_ctrl_command_sta_dump(struct wpa_ctrl *ctrl, const char *fields)
+{
+	char buf[32768], cmd[100], addr[18], *pos, *end;
+	size_t len;
+	int ret, more;
+
+	if (ctrl_conn == NULL) {
+		printf("Not connected to hostapd - command dropped.\n");
+		return -1;
+	}
+
+	addr[0] = '\0';
+	do {
+		ret = os_snprintf(cmd, sizeof(cmd), "STA-DUMP%s%s%s%s",
+				  addr[0] ? " " : "", addr,
+				  fields ? " fields=" : "",
+				  fields ? fields : "");
+		if (ret < 0 || (size_t) ret >= sizeof(cmd))
+			return -1;
+		len = sizeof(buf) - 1;
+		ret = wpa_ctrl_request(ctrl, cmd, os_strlen(cmd), buf, &len,
+				       hostapd_cli_msg_cb);
+		if (ret == -2) {
+			printf("'%s' command timed out.\n", cmd);
+			return -1;
+		} else if (ret < 0) {
+			printf("'%s' command failed.\n", cmd);
+			return -1;
+		}
+		buf[len] = '\0';
+		if (os_strncmp(buf, "UNKNOWN COMMAND", 15) == 0)
+			return 1;
+		if (os_strncmp(buf, "FAIL", 4) == 0) {
+			printf("'%s' command failed.\n", cmd);
+			return -1;
+		}
+
+		/* Each station starts with a line containing only the
+		 * address; the last one is used to continue the dump */
+		more = 0;
+		for (pos = buf; *pos; pos = end) {
+			end = os_strchr(pos, '\n');
+			end = end ? end + 1 : pos + os_strlen(pos);
+			if (os_strncmp(pos, "MORE\n", 5) == 0) {
+				more = 1;
+				break;
+			}
+			if (end - pos == 18 && pos[2] == ':' &&
+			    pos[14] == ':' && pos[17] == '\n') {
+				os_memcpy(addr, pos, 17);
+				addr[17] = '\0';
+			}
+			fwrite(pos, 1, end - pos, stdout);
+		}
+	} while (more && addr[0]);
+
+	return 0;
+}
+
+
 static int hostapd_cli_cmd_all_sta(struct wpa_ctrl *ctrl, int argc,
 				   char *argv[])
 {
 	char addr[32], cmd[64];
+	int ret;
+
+	ret = wpa_ctrl_command_sta_dump(ctrl, argc > 0 ? argv[0] : "all");
+	if (ret <= 0)
+		return ret;
 
+	/* Fall back to one station per command with older hostapd versions */
+	if (argc > 0)
+		printf("Station information fields not supported\n");
 	if (wpa_ctrl_command_sta(ctrl, "STA-FIRST", addr, sizeof(addr)))
 		return 0;
 	do {
@@ -313,6 +313,26 @@ static void handle_dump_state(int sig, void *signal_ctx)
 #endif /* CONFIG_NATIVE_WINDOWS */
 
 
+#ifdef CONFIG_DEBUG_BUFFER
+
+#define HOSTAPD_DEBUG_BUFFER_SIZE (256 * 1024)
+#define HOSTAPD_DEBUG_BUFFER_FLUSH_USEC 100000
+
+static void hostapd_debug_buffer_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	wpa_debug_flush_buffer();
+}
+
+
+static void hostapd_debug_buffer_pending(void)
+{
+	eloop_register_timeout(0, HOSTAPD_DEBUG_BUFFER_FLUSH_USEC,
+			       hostapd_debug_buffer_timeout, NULL, NULL);
+}
+
+#endif /* CONFIG_DEBUG_BUFFER */
+
+
 static int hostapd_global_init(struct hapd_interfaces *interfaces,
 			       const char *entropy_file)
 {
@@ -332,6 +352,12 @@ static int hostapd_global_init(struct hapd_interfaces *interfaces,
 		return -1;
 	}
 
+#ifdef CONFIG_DEBUG_BUFFER
+	if (wpa_debug_open_buffer(HOSTAPD_DEBUG_BUFFER_SIZE,
+				  hostapd_debug_buffer_pending) < 0)
+		wpa_printf(MSG_ERROR, "Failed to allocate debug buffer");
+#endif /* CONFIG_DEBUG_BUFFER */
+
 	random_init(entropy_file);
 
 #ifndef CONFIG_NATIVE_WINDOWS
@@ -375,6 +401,12 @@ static void hostapd_global_deinit(const char *pid_file)
 #endif /* EAP_SERVER_TNC */
 
 	random_deinit();
+	wpabuf_pool_deinit();
+
+#ifdef CONFIG_DEBUG_BUFFER
+	eloop_cancel_timeout(hostapd_debug_buffer_timeout, NULL, NULL);
+	wpa_debug_close_buffer();
+#endif /* CONFIG_DEBUG_BUFFER */
 
 	eloop_destroy();
 
@@ -150,10 +150,17 @@ static struct radius_msg * accounting_msg(struct hostapd_data *hapd,
 
 static int accounting_sta_update_stats(struct hostapd_data *hapd,
 				       struct sta_info *sta,
-				       struct hostap_sta_driver_data *data)
+				       struct hostap_sta_driver_data *data,
+				       int snapshot)
 {
-	if (hostapd_drv_read_sta_data(hapd, data, sta->addr))
+	/* Periodic updates can share the station data snapshot, but the final
+	 * values for Accounting-Stop are read directly from the driver */
+	if (snapshot) {
+		if (hostapd_read_sta_data_snapshot(hapd, sta, data))
+			return -1;
+	} else if (hostapd_drv_read_sta_data(hapd, data, sta->addr)) {
 		return -1;
+	}
 
 	if (sta->last_rx_bytes > data->rx_bytes)
 		sta->acct_input_gigawords++;
@@ -184,12 +191,12 @@ static void accounting_interim_update(void *eloop_ctx, void *timeout_ctx)
 		interval = sta->acct_interim_interval;
 	} else {
 		struct hostap_sta_driver_data data;
-		accounting_sta_update_stats(hapd, sta, &data);
+		accounting_sta_update_stats(hapd, sta, &data, 1);
 		interval = ACCT_DEFAULT_UPDATE_INTERVAL;
 	}
 
-	eloop_register_timeout(interval, 0, accounting_interim_update,
-			       hapd, sta);
+	ap_sta_register_sweep_timeout(interval, accounting_interim_update,
+				      hapd, sta);
 }
 
 
@@ -223,8 +230,8 @@ void accounting_sta_start(struct hostapd_data *hapd, struct sta_info *sta)
 		interval = sta->acct_interim_interval;
 	else
 		interval = ACCT_DEFAULT_UPDATE_INTERVAL;
-	eloop_register_timeout(interval, 0, accounting_interim_update,
-			       hapd, sta);
+	ap_sta_register_sweep_timeout(interval, accounting_interim_update,
+				      hapd, sta);
 
 	msg = accounting_msg(hapd, sta, RADIUS_ACCT_STATUS_TYPE_START);
 	if (msg &&
@@ -265,7 +272,7 @@ static void accounting_sta_report(struct hostapd_data *hapd,
 		goto fail;
 	}
 
-	if (accounting_sta_update_stats(hapd, sta, &data) == 0) {
+	if (accounting_sta_update_stats(hapd, sta, &data, !stop) == 0) {
 		if (!radius_msg_add_attr_int32(msg,
 					       RADIUS_ATTR_ACCT_INPUT_PACKETS,
 					       data.rx_packets)) {
@@ -59,6 +59,9 @@ void hostapd_config_defaults_bss(struct hostapd_bss_config *bss)
 	bss->rsn_pairwise = 0;
 
 	bss->max_num_sta = MAX_STA_COUNT;
+#ifdef CONFIG_STATS_SHM
+	bss->stats_interval = 5;
+#endif /* CONFIG_STATS_SHM */
 
 	bss->dtim_period = 2;
 
@@ -438,6 +441,9 @@ void hostapd_config_free_bss(struct hostapd_bss_config *conf)
 	hostapd_config_free_radius_attr(conf->radius_acct_req_attr);
 	os_free(conf->rsn_preauth_interfaces);
 	os_free(conf->ctrl_interface);
+#ifdef CONFIG_STATS_SHM
+	os_free(conf->stats_file);
+#endif /* CONFIG_STATS_SHM */
 	os_free(conf->ca_cert);
 	os_free(conf->server_cert);
 	os_free(conf->private_key);
@@ -914,3 +920,143 @@ void hostapd_set_security_params(struct hostapd_bss_config *bss,
 		bss->rsn_pairwise = WPA_CIPHER_NONE;
 	}
 }
+
+
+#define SWAP_FIELD(a, b, f) do {			\
+	u8 _tmp[sizeof((a)->f)];			\
+	os_memcpy(_tmp, &(a)->f, sizeof(_tmp));		\
+	os_memcpy(&(a)->f, &(b)->f, sizeof(_tmp));	\
+	os_memcpy(&(b)->f, _tmp, sizeof(_tmp));		\
+	} while (0)
+
+
+/**
+ * hostapd_config_swap_bss_info - Swap informational BSS parameters
+ * @a: BSS configuration
+ * @b: BSS configuration
+ *
+ * This exchanges the parameters that only affect advertised information
+ * (Beacon and Probe Response frames and ANQP) and can thus be updated without
+ * reconfiguring the BSS. The set of parameters must match the configuration
+ * file items that hostapd_config_read() includes in info_hash.
+ */
+void hostapd_config_swap_bss_info(struct hostapd_bss_config *a,
+				  struct hostapd_bss_config *b)
+{
+	SWAP_FIELD(a, b, logger_syslog_level);
+	SWAP_FIELD(a, b, logger_stdout_level);
+	SWAP_FIELD(a, b, logger_syslog);
+	SWAP_FIELD(a, b, logger_stdout);
+	SWAP_FIELD(a, b, dtim_period);
+	SWAP_FIELD(a, b, ignore_broadcast_ssid);
+	SWAP_FIELD(a, b, ap_max_inactivity);
+	SWAP_FIELD(a, b, skip_inactivity_poll);
+	SWAP_FIELD(a, b, max_listen_interval);
+	SWAP_FIELD(a, b, disassoc_low_ack);
+	SWAP_FIELD(a, b, time_advertisement);
+	SWAP_FIELD(a, b, time_zone);
+
+	SWAP_FIELD(a, b, access_network_type);
+	SWAP_FIELD(a, b, internet);
+	SWAP_FIELD(a, b, asra);
+	SWAP_FIELD(a, b, esr);
+	SWAP_FIELD(a, b, uesa);
+	SWAP_FIELD(a, b, venue_info_set);
+	SWAP_FIELD(a, b, venue_group);
+	SWAP_FIELD(a, b, venue_type);
+	SWAP_FIELD(a, b, hessid);
+	SWAP_FIELD(a, b, roaming_consortium_count);
+	SWAP_FIELD(a, b, roaming_consortium);
+	SWAP_FIELD(a, b, venue_name_count);
+	SWAP_FIELD(a, b, venue_name);
+	SWAP_FIELD(a, b, network_auth_type);
+	SWAP_FIELD(a, b, network_auth_type_len);
+	SWAP_FIELD(a, b, ipaddr_type_availability);
+	SWAP_FIELD(a, b, ipaddr_type_configured);
+	SWAP_FIELD(a, b, anqp_3gpp_cell_net);
+	SWAP_FIELD(a, b, anqp_3gpp_cell_net_len);
+	SWAP_FIELD(a, b, domain_name);
+	SWAP_FIELD(a, b, domain_name_len);
+	SWAP_FIELD(a, b, nai_realm_count);
+	SWAP_FIELD(a, b, nai_realm_data);
+	SWAP_FIELD(a, b, gas_comeback_delay);
+	SWAP_FIELD(a, b, gas_frag_limit);
+
+#ifdef CONFIG_HS20
+	SWAP_FIELD(a, b, anqp_domain_id);
+	SWAP_FIELD(a, b, hs20_oper_friendly_name_count);
+	SWAP_FIELD(a, b, hs20_oper_friendly_name);
+	SWAP_FIELD(a, b, hs20_wan_metrics);
+	SWAP_FIELD(a, b, hs20_connection_capability);
+	SWAP_FIELD(a, b, hs20_connection_capability_len);
+	SWAP_FIELD(a, b, hs20_operating_class);
+	SWAP_FIELD(a, b, hs20_operating_class_len);
+	SWAP_FIELD(a, b, hs20_icons);
+	SWAP_FIELD(a, b, hs20_icons_count);
+	SWAP_FIELD(a, b, osu_ssid);
+	SWAP_FIELD(a, b, osu_ssid_len);
+	SWAP_FIELD(a, b, hs20_osu_providers);
+	SWAP_FIELD(a, b, last_osu);
+	SWAP_FIELD(a, b, hs20_osu_providers_count);
+	SWAP_FIELD(a, b, hs20_deauth_req_timeout);
+	SWAP_FIELD(a, b, subscr_remediation_url);
+	SWAP_FIELD(a, b, subscr_remediation_method);
+#endif /* CONFIG_HS20 */
+
+	SWAP_FIELD(a, b, vendor_elements);
+
+	SWAP_FIELD(a, b, info_hash);
+}
+
+
+static int hostapd_maclist_equal(const struct mac_acl_entry *a, int num_a,
+				 const struct mac_acl_entry *b, int num_b)
+{
+	int i;
+
+	if (num_a != num_b)
+		return 0;
+
+	for (i = 0; i < num_a; i++) {
+		if (os_memcmp(a[i].addr, b[i].addr, ETH_ALEN) != 0 ||
+		    a[i].vlan_id != b[i].vlan_id)
+			return 0;
+	}
+
+	return 1;
+}
+
+
+/**
+ * hostapd_config_acl_changed - Check whether MAC ACL configuration differs
+ * @a: BSS configuration
+ * @b: BSS configuration
+ * Returns: 1 if the MAC address ACL parameters differ, 0 if not
+ */
+int hostapd_config_acl_changed(const struct hostapd_bss_config *a,
+			       const struct hostapd_bss_config *b)
+{
+	return a->macaddr_acl != b->macaddr_acl ||
+		!hostapd_maclist_equal(a->accept_mac, a->num_accept_mac,
+				       b->accept_mac, b->num_accept_mac) ||
+		!hostapd_maclist_equal(a->deny_mac, a->num_deny_mac,
+				       b->deny_mac, b->num_deny_mac);
+}
+
+
+/**
+ * hostapd_config_swap_acl - Swap MAC ACL parameters
+ * @a: BSS configuration
+ * @b: BSS configuration
+ */
+void hostapd_config_swap_acl(struct hostapd_bss_config *a,
+			     struct hostapd_bss_config *b)
+{
+	SWAP_FIELD(a, b, macaddr_acl);
+	SWAP_FIELD(a, b, accept_mac);
+	SWAP_FIELD(a, b, num_accept_mac);
+	SWAP_FIELD(a, b, deny_mac);
+	SWAP_FIELD(a, b, num_deny_mac);
+}
+
+#undef SWAP_FIELD
@@ -30,6 +30,7 @@ struct ft_remote_r0kh;
 struct ft_remote_r1kh;
 
 #define HOSTAPD_MAX_SSID_LEN 32
+#define HOSTAPD_CONF_HASH_LEN 20
 
 #define NUM_WEP_KEYS 4
 struct hostapd_wep_keys {
@@ -295,6 +296,11 @@ struct hostapd_bss_config {
 #endif /* CONFIG_NATIVE_WINDOWS */
 	int ctrl_interface_gid_set;
 
+#ifdef CONFIG_STATS_SHM
+	char *stats_file; /* shared memory statistics region */
+	int stats_interval; /* seconds between updates of stats_file */
+#endif /* CONFIG_STATS_SHM */
+
 	char *ca_cert;
 	char *server_cert;
 	char *private_key;
@@ -514,6 +520,17 @@ struct hostapd_bss_config {
 	u8 bss_load_test[5];
 	u8 bss_load_test_set;
 #endif /* CONFIG_TESTING_OPTIONS */
+
+	/*
+	 * Hashes of the configuration file lines of this BSS. These are used
+	 * on configuration reload to find out which BSSs were changed.
+	 * conf_hash covers the parameters that require the BSS to be
+	 * reconfigured and info_hash the parameters that only change the
+	 * advertised information (see hostapd_config_swap_bss_info()). MAC
+	 * ACL parameters are compared directly and are not included.
+	 */
+	u8 conf_hash[HOSTAPD_CONF_HASH_LEN];
+	u8 info_hash[HOSTAPD_CONF_HASH_LEN];
 };
 
 
@@ -600,6 +617,9 @@ struct hostapd_config {
 #ifdef CONFIG_ACS
 	unsigned int acs_num_scans;
 #endif /* CONFIG_ACS */
+
+	/* Hash of the configuration file lines for per-radio parameters */
+	u8 conf_hash[HOSTAPD_CONF_HASH_LEN];
 };
 
 
@@ -625,5 +645,11 @@ hostapd_config_get_radius_attr(struct hostapd_radius_attr *attr, u8 type);
 int hostapd_config_check(struct hostapd_config *conf, int full_config);
 void hostapd_set_security_params(struct hostapd_bss_config *bss,
 				 int full_config);
+void hostapd_config_swap_bss_info(struct hostapd_bss_config *a,
+				  struct hostapd_bss_config *b);
+int hostapd_config_acl_changed(const struct hostapd_bss_config *a,
+			       const struct hostapd_bss_config *b);
+void hostapd_config_swap_acl(struct hostapd_bss_config *a,
+			     struct hostapd_bss_config *b);
 
 #endif /* HOSTAPD_CONFIG_H */
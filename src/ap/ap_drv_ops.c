@@ -269,6 +269,104 @@ int hostapd_set_sta_flags(struct hostapd_data *hapd, struct sta_info *sta)
 }
 
 
+/* Maximum age (in seconds) of a station data snapshot */
+#define STA_DATA_SNAPSHOT_TTL 1
+
+static void hostapd_sta_data_snapshot_cb(void *ctx, const u8 *addr,
+					 struct hostap_sta_driver_data *data)
+{
+	struct hostapd_data *hapd = ctx;
+	struct sta_info *sta;
+
+	sta = ap_get_sta(hapd, addr);
+	if (sta == NULL)
+		return;
+
+	if (sta->drv_data == NULL) {
+		sta->drv_data = os_malloc(sizeof(*data));
+		if (sta->drv_data == NULL)
+			return;
+	}
+	os_memcpy(sta->drv_data, data, sizeof(*data));
+	sta->drv_data_gen = hapd->sta_data_gen;
+}
+
+
+static int hostapd_sta_data_snapshot(struct hostapd_data *hapd)
+{
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	if (hapd->sta_data_gen &&
+	    !os_reltime_expired(&now, &hapd->sta_data_time,
+				STA_DATA_SNAPSHOT_TTL))
+		return hapd->sta_data_valid ? 0 : -1;
+
+	/* Generation 0 is used for stations that have no snapshot data */
+	hapd->sta_data_gen++;
+	if (hapd->sta_data_gen == 0)
+		hapd->sta_data_gen++;
+	hapd->sta_data_time = now;
+	hapd->sta_data_valid =
+		hapd->driver->read_all_sta_data(hapd->drv_priv,
+						hostapd_sta_data_snapshot_cb,
+						hapd) == 0;
+
+	return hapd->sta_data_valid ? 0 : -1;
+}
+
+
+/**
+ * hostapd_read_sta_data_snapshot - Fetch station data using a shared snapshot
+ * @hapd: Pointer to BSS data
+ * @sta: Station
+ * @data: Buffer for returning station information
+ * Returns: 0 on success, -1 on failure
+ *
+ * If the driver supports read_all_sta_data(), the data for all stations is
+ * fetched with a single request and reused for other stations for up to
+ * STA_DATA_SNAPSHOT_TTL seconds. This is meant for periodic per-station work
+ * like inactivity checks and accounting updates. read_sta_data() is used if
+ * bulk fetching is not supported or the station is not in the snapshot.
+ */
+int hostapd_read_sta_data_snapshot(struct hostapd_data *hapd,
+				   struct sta_info *sta,
+				   struct hostap_sta_driver_data *data)
+{
+	if (hapd->driver == NULL || hapd->driver->read_all_sta_data == NULL ||
+	    hostapd_sta_data_snapshot(hapd) < 0 ||
+	    sta->drv_data_gen != hapd->sta_data_gen || sta->drv_data == NULL)
+		return hostapd_drv_read_sta_data(hapd, data, sta->addr);
+
+	os_memcpy(data, sta->drv_data, sizeof(*data));
+	return 0;
+}
+
+
+/**
+ * hostapd_get_inact_sec_snapshot - Get station inactivity using a snapshot
+ * @hapd: Pointer to BSS data
+ * @sta: Station
+ * Returns: Number of seconds station has been inactive, -1 on failure
+ *
+ * Like hostapd_drv_get_inact_sec(), but uses the shared station data snapshot
+ * if the driver supports read_all_sta_data().
+ */
+int hostapd_get_inact_sec_snapshot(struct hostapd_data *hapd,
+				   struct sta_info *sta)
+{
+	struct hostap_sta_driver_data data;
+
+	if (hapd->driver == NULL || hapd->driver->read_all_sta_data == NULL)
+		return hostapd_drv_get_inact_sec(hapd, sta->addr);
+
+	os_memset(&data, 0, sizeof(data));
+	if (hostapd_read_sta_data_snapshot(hapd, sta, &data) < 0)
+		return -1;
+	return data.inactive_msec / 1000;
+}
+
+
 int hostapd_set_drv_ieee8021x(struct hostapd_data *hapd, const char *ifname,
 			      int enabled)
 {
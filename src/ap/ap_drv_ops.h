@@ -28,6 +28,11 @@ int hostapd_set_ap_wps_ie(struct hostapd_data *hapd);
 int hostapd_set_authorized(struct hostapd_data *hapd,
 			   struct sta_info *sta, int authorized);
 int hostapd_set_sta_flags(struct hostapd_data *hapd, struct sta_info *sta);
+int hostapd_read_sta_data_snapshot(struct hostapd_data *hapd,
+				   struct sta_info *sta,
+				   struct hostap_sta_driver_data *data);
+int hostapd_get_inact_sec_snapshot(struct hostapd_data *hapd,
+				   struct sta_info *sta);
 int hostapd_set_drv_ieee8021x(struct hostapd_data *hapd, const char *ifname,
 			      int enabled);
 int hostapd_vlan_if_add(struct hostapd_data *hapd, const char *ifname);
@@ -203,6 +208,15 @@ static inline int hostapd_drv_set_ap(struct hostapd_data *hapd,
 	return hapd->driver->set_ap(hapd->drv_priv, params);
 }
 
+static inline int hostapd_drv_set_probe_req_filter(
+	struct hostapd_data *hapd,
+	const struct wpa_driver_probe_req_filter *filter)
+{
+	if (hapd->driver == NULL || hapd->driver->set_probe_req_filter == NULL)
+		return -1;
+	return hapd->driver->set_probe_req_filter(hapd->drv_priv, filter);
+}
+
 static inline int hostapd_drv_set_radius_acl_auth(struct hostapd_data *hapd,
 						  const u8 *mac, int accepted,
 						  u32 session_timeout)
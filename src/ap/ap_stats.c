@@ -0,0 +1,190 @@
+/*
+ * hostapd / Shared memory statistics
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "radius/radius_client.h"
+#include "eapol_auth/eapol_auth_sm.h"
+#include "eapol_auth/eapol_auth_sm_i.h"
+#include "hostapd.h"
+#include "sta_info.h"
+#include "ap_config.h"
+#include "ap_drv_ops.h"
+#include "ap_stats.h"
+
+
+struct ap_stats {
+	struct stats_shm *shm;
+	size_t len;
+
+	/* Copy of the region that is filled in before the sequence lock is
+	 * taken so that driver calls do not block readers */
+	struct hostapd_stats_bss *tmp;
+};
+
+
+static void ap_stats_radius(struct hostapd_stats_radius *stats,
+			    struct hostapd_radius_server *servers, int num,
+			    struct hostapd_radius_server *current)
+{
+	int i;
+
+	for (i = 0; i < num; i++) {
+		struct hostapd_radius_server *srv = &servers[i];
+
+		stats->requests += srv->requests;
+		stats->retransmissions += srv->retransmissions;
+		stats->access_accepts += srv->access_accepts;
+		stats->access_rejects += srv->access_rejects;
+		stats->access_challenges += srv->access_challenges;
+		stats->responses += srv->responses;
+		stats->malformed_responses += srv->malformed_responses;
+		stats->bad_authenticators += srv->bad_authenticators;
+		stats->timeouts += srv->timeouts;
+		stats->unknown_types += srv->unknown_types;
+		stats->packets_dropped += srv->packets_dropped;
+	}
+
+	if (current)
+		stats->round_trip_time = current->round_trip_time;
+}
+
+
+static void ap_stats_sta(struct hostapd_data *hapd, struct sta_info *sta,
+			 struct hostapd_stats_sta *stats)
+{
+	struct hostap_sta_driver_data data;
+	struct os_reltime age;
+
+	os_memcpy(stats->addr, sta->addr, ETH_ALEN);
+	stats->aid = sta->aid;
+	stats->flags = sta->flags;
+	if (sta->connected_time.sec) {
+		os_reltime_age(&sta->connected_time, &age);
+		stats->connected_time = age.sec;
+	}
+
+	os_memset(&data, 0, sizeof(data));
+	if (hostapd_read_sta_data_snapshot(hapd, sta, &data) == 0) {
+		stats->rx_packets = data.rx_packets;
+		stats->tx_packets = data.tx_packets;
+		stats->rx_bytes = data.rx_bytes;
+		stats->tx_bytes = data.tx_bytes;
+		stats->inactive_msec = data.inactive_msec;
+	}
+
+	if (sta->eapol_sm) {
+		stats->eapol_frames_rx = sta->eapol_sm->dot1xAuthEapolFramesRx;
+		stats->eapol_frames_tx = sta->eapol_sm->dot1xAuthEapolFramesTx;
+		stats->eapol_invalid_frames_rx =
+			sta->eapol_sm->dot1xAuthInvalidEapolFramesRx;
+	}
+}
+
+
+static void ap_stats_update(struct hostapd_data *hapd)
+{
+	struct ap_stats *stats = hapd->stats;
+	struct hostapd_stats_bss *tmp = stats->tmp;
+	struct hostapd_radius_servers *radius = hapd->conf->radius;
+	struct sta_info *sta;
+	u8 *region;
+	u32 num_sta = 0;
+
+	os_memset((u8 *) tmp + sizeof(tmp->hdr), 0,
+		  stats->len - sizeof(tmp->hdr));
+	os_memcpy(tmp->bssid, hapd->own_addr, ETH_ALEN);
+	tmp->max_sta = hapd->conf->max_num_sta;
+
+	if (radius) {
+		ap_stats_radius(&tmp->radius_auth, radius->auth_servers,
+				radius->num_auth_servers, radius->auth_server);
+		ap_stats_radius(&tmp->radius_acct, radius->acct_servers,
+				radius->num_acct_servers, radius->acct_server);
+	}
+
+	for (sta = hapd->sta_list; sta && num_sta < tmp->max_sta;
+	     sta = sta->next)
+		ap_stats_sta(hapd, sta, &tmp->sta[num_sta++]);
+	tmp->num_sta = num_sta;
+
+	region = stats_shm_update_begin(stats->shm);
+	os_memcpy(region + sizeof(tmp->hdr), (u8 *) tmp + sizeof(tmp->hdr),
+		  (u8 *) &tmp->sta[num_sta] - (u8 *) tmp - sizeof(tmp->hdr));
+	stats_shm_update_end(stats->shm);
+}
+
+
+static void ap_stats_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct hostapd_data *hapd = eloop_ctx;
+
+	ap_stats_update(hapd);
+	eloop_register_timeout(hapd->conf->stats_interval, 0,
+			       ap_stats_timeout, hapd, NULL);
+}
+
+
+/**
+ * ap_stats_init - Initialize the shared memory statistics region for a BSS
+ * @hapd: Pointer to BSS data
+ * Returns: 0 on success (or if not configured) or -1 on failure
+ */
+int ap_stats_init(struct hostapd_data *hapd)
+{
+	struct ap_stats *stats;
+	size_t len;
+
+	if (hapd->conf->stats_file == NULL)
+		return 0;
+
+	len = sizeof(struct hostapd_stats_bss) +
+		hapd->conf->max_num_sta * sizeof(struct hostapd_stats_sta);
+
+	stats = os_zalloc(sizeof(*stats));
+	if (stats == NULL)
+		return -1;
+	stats->len = len;
+	stats->tmp = os_zalloc(len);
+	if (stats->tmp == NULL) {
+		os_free(stats);
+		return -1;
+	}
+	stats->shm = stats_shm_create(hapd->conf->stats_file,
+				      STATS_SHM_TYPE_HOSTAPD_BSS, len);
+	if (stats->shm == NULL) {
+		os_free(stats->tmp);
+		os_free(stats);
+		return -1;
+	}
+	hapd->stats = stats;
+
+	ap_stats_timeout(hapd, NULL);
+
+	return 0;
+}
+
+
+/**
+ * ap_stats_deinit - Remove the shared memory statistics region of a BSS
+ * @hapd: Pointer to BSS data
+ */
+void ap_stats_deinit(struct hostapd_data *hapd)
+{
+	struct ap_stats *stats = hapd->stats;
+
+	if (stats == NULL)
+		return;
+
+	eloop_cancel_timeout(ap_stats_timeout, hapd, NULL);
+	stats_shm_destroy(stats->shm);
+	os_free(stats->tmp);
+	os_free(stats);
+	hapd->stats = NULL;
+}
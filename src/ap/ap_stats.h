@@ -0,0 +1,78 @@
+/*
+ * hostapd / Shared memory statistics
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef AP_STATS_H
+#define AP_STATS_H
+
+#include "utils/stats_shm.h"
+
+/*
+ * Layout of a STATS_SHM_TYPE_HOSTAPD_BSS region (see utils/stats_shm.h for
+ * the common header and the locking rules). Offsets are from the beginning of
+ * the region.
+ */
+
+struct hostapd_stats_radius {
+	u32 requests; /* +0 */
+	u32 retransmissions; /* +4 */
+	u32 access_accepts; /* +8: authentication servers only */
+	u32 access_rejects; /* +12: authentication servers only */
+	u32 access_challenges; /* +16: authentication servers only */
+	u32 responses; /* +20 */
+	u32 malformed_responses; /* +24 */
+	u32 bad_authenticators; /* +28 */
+	u32 timeouts; /* +32 */
+	u32 unknown_types; /* +36 */
+	u32 packets_dropped; /* +40 */
+	u32 round_trip_time; /* +44: current server, in hundredths of seconds */
+};
+
+struct hostapd_stats_sta {
+	u8 addr[6]; /* +0 */
+	u16 aid; /* +6 */
+	u32 flags; /* +8: WLAN_STA_* */
+	u32 connected_time; /* +12: seconds */
+	u64 rx_packets; /* +16: from the driver */
+	u64 tx_packets; /* +24: from the driver */
+	u64 rx_bytes; /* +32: from the driver */
+	u64 tx_bytes; /* +40: from the driver */
+	u32 eapol_frames_rx; /* +48 */
+	u32 eapol_frames_tx; /* +52 */
+	u32 eapol_invalid_frames_rx; /* +56 */
+	u32 inactive_msec; /* +60: from the driver */
+};
+
+struct hostapd_stats_bss {
+	struct stats_shm_hdr hdr; /* 0 */
+	u8 bssid[6]; /* 32 */
+	u16 reserved; /* 38 */
+	u32 num_sta; /* 40: number of valid entries in sta[] */
+	u32 max_sta; /* 44: number of entries reserved for sta[] */
+	struct hostapd_stats_radius radius_auth; /* 48 */
+	struct hostapd_stats_radius radius_acct; /* 96 */
+	struct hostapd_stats_sta sta[]; /* 144 */
+};
+
+#ifdef CONFIG_STATS_SHM
+
+int ap_stats_init(struct hostapd_data *hapd);
+void ap_stats_deinit(struct hostapd_data *hapd);
+
+#else /* CONFIG_STATS_SHM */
+
+static inline int ap_stats_init(struct hostapd_data *hapd)
+{
+	return 0;
+}
+
+static inline void ap_stats_deinit(struct hostapd_data *hapd)
+{
+}
+
+#endif /* CONFIG_STATS_SHM */
+
+#endif /* AP_STATS_H */
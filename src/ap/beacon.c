@@ -329,11 +329,12 @@ static u8 * hostapd_add_csa_elems(struct hostapd_data *hapd, u8 *pos,
 }
 
 
-static u8 * hostapd_gen_probe_resp(struct hostapd_data *hapd,
-				   struct sta_info *sta,
-				   const struct ieee80211_mgmt *req,
-				   int is_p2p, size_t *resp_len)
+static struct wpabuf * hostapd_gen_probe_resp(struct hostapd_data *hapd,
+					      struct sta_info *sta,
+					      const struct ieee80211_mgmt *req,
+					      int is_p2p)
 {
+	struct wpabuf *buf;
 	struct ieee80211_mgmt *resp;
 	u8 *pos, *epos;
 	size_t buflen;
@@ -350,9 +351,10 @@ static u8 * hostapd_gen_probe_resp(struct hostapd_data *hapd,
 #endif /* CONFIG_P2P */
 	if (hapd->conf->vendor_elements)
 		buflen += wpabuf_len(hapd->conf->vendor_elements);
-	resp = os_zalloc(buflen);
-	if (resp == NULL)
+	buf = wpabuf_alloc_pool(buflen);
+	if (buf == NULL)
 		return NULL;
+	resp = wpabuf_mhead(buf);
 
 	epos = ((u8 *) resp) + MAX_PROBERESP_LEN;
 
@@ -455,8 +457,8 @@ static u8 * hostapd_gen_probe_resp(struct hostapd_data *hapd,
 		pos += wpabuf_len(hapd->conf->vendor_elements);
 	}
 
-	*resp_len = pos - (u8 *) resp;
-	return (u8 *) resp;
+	wpabuf_put(buf, pos - (u8 *) resp);
+	return buf;
 }
 
 
@@ -504,12 +506,12 @@ void handle_probe_req(struct hostapd_data *hapd,
 		      const struct ieee80211_mgmt *mgmt, size_t len,
 		      int ssi_signal)
 {
-	u8 *resp;
+	struct wpabuf *resp;
 	struct ieee802_11_elems elems;
 	const u8 *ie;
 	size_t ie_len;
 	struct sta_info *sta = NULL;
-	size_t i, resp_len;
+	size_t i;
 	int noack;
 	enum ssid_match_result res;
 
@@ -658,8 +660,7 @@ void handle_probe_req(struct hostapd_data *hapd,
 	}
 #endif /* CONFIG_TESTING_OPTIONS */
 
-	resp = hostapd_gen_probe_resp(hapd, sta, mgmt, elems.p2p != NULL,
-				      &resp_len);
+	resp = hostapd_gen_probe_resp(hapd, sta, mgmt, elems.p2p != NULL);
 	if (resp == NULL)
 		return;
 
@@ -670,10 +671,11 @@ void handle_probe_req(struct hostapd_data *hapd,
 	noack = !!(res == WILDCARD_SSID_MATCH &&
 		   is_broadcast_ether_addr(mgmt->da));
 
-	if (hostapd_drv_send_mlme(hapd, resp, resp_len, noack) < 0)
+	if (hostapd_drv_send_mlme(hapd, wpabuf_head(resp), wpabuf_len(resp),
+				  noack) < 0)
 		wpa_printf(MSG_INFO, "handle_probe_req: send failed");
 
-	os_free(resp);
+	wpabuf_free(resp);
 
 	wpa_printf(MSG_EXCESSIVE, "STA " MACSTR " sent probe request for %s "
 		   "SSID", MAC2STR(mgmt->sa),
@@ -684,6 +686,9 @@ void handle_probe_req(struct hostapd_data *hapd,
 static u8 * hostapd_probe_resp_offloads(struct hostapd_data *hapd,
 					size_t *resp_len)
 {
+	struct wpabuf *buf;
+	u8 *resp;
+
 	/* check probe response offloading caps and print warnings */
 	if (!(hapd->iface->drv_flags & WPA_DRIVER_FLAGS_PROBE_RESP_OFFLOAD))
 		return NULL;
@@ -713,7 +718,16 @@ static u8 * hostapd_probe_resp_offloads(struct hostapd_data *hapd,
 			   "this");
 
 	/* Generate a Probe Response template for the non-P2P case */
-	return hostapd_gen_probe_resp(hapd, NULL, NULL, 0, resp_len);
+	buf = hostapd_gen_probe_resp(hapd, NULL, NULL, 0);
+	if (buf == NULL)
+		return NULL;
+	resp = os_malloc(wpabuf_len(buf));
+	if (resp) {
+		os_memcpy(resp, wpabuf_head(buf), wpabuf_len(buf));
+		*resp_len = wpabuf_len(buf);
+	}
+	wpabuf_free(buf);
+	return resp;
 }
 
 #endif /* NEED_AP_MLME */
@@ -952,6 +966,52 @@ void ieee802_11_free_ap_params(struct wpa_driver_ap_params *params)
 }
 
 
+/**
+ * hostapd_set_probe_req_filter - Push the Probe Request filter to the driver
+ * @hapd: Pointer to BSS data
+ *
+ * The filter covers the checks in handle_probe_req() that depend only on the
+ * BSS configuration. It is not used if anything else needs to see all Probe
+ * Request frames (Probe Request callbacks, P2P group owner, external
+ * management frame handling).
+ */
+void hostapd_set_probe_req_filter(struct hostapd_data *hapd)
+{
+	struct wpa_driver_probe_req_filter filter;
+
+	if (hapd->driver == NULL || hapd->driver->set_probe_req_filter == NULL)
+		return;
+
+	if (hapd->num_probereq_cb ||
+#ifdef CONFIG_P2P
+	    (hapd->conf->p2p & P2P_GROUP_OWNER) ||
+#endif /* CONFIG_P2P */
+#ifdef CONFIG_TESTING_OPTIONS
+	    hapd->ext_mgmt_frame_handling ||
+#endif /* CONFIG_TESTING_OPTIONS */
+	    hapd->conf->ssid.ssid_len > sizeof(filter.ssid)) {
+		hostapd_drv_set_probe_req_filter(hapd, NULL);
+		return;
+	}
+
+	os_memset(&filter, 0, sizeof(filter));
+	os_memcpy(filter.ssid, hapd->conf->ssid.ssid, hapd->conf->ssid.ssid_len);
+	filter.ssid_len = hapd->conf->ssid.ssid_len;
+	filter.drop_all = !hapd->iconf->send_probe_response;
+	filter.ignore_broadcast_ssid = !!hapd->conf->ignore_broadcast_ssid;
+#ifdef CONFIG_INTERWORKING
+	if (hapd->conf->interworking) {
+		filter.interworking = 1;
+		filter.access_network_type = hapd->conf->access_network_type;
+		os_memcpy(filter.hessid, hapd->conf->hessid, ETH_ALEN);
+	}
+#endif /* CONFIG_INTERWORKING */
+
+	if (hostapd_drv_set_probe_req_filter(hapd, &filter) < 0)
+		wpa_printf(MSG_DEBUG, "Could not set Probe Request filter");
+}
+
+
 int ieee802_11_set_beacon(struct hostapd_data *hapd)
 {
 	struct wpa_driver_ap_params params;
@@ -992,10 +1052,12 @@ int ieee802_11_set_beacon(struct hostapd_data *hapd)
 
 	res = hostapd_drv_set_ap(hapd, &params);
 	hostapd_free_ap_extra_ies(hapd, beacon, proberesp, assocresp);
-	if (res)
+	if (res) {
 		wpa_printf(MSG_ERROR, "Failed to set beacon parameters");
-	else
+	} else {
+		hostapd_set_probe_req_filter(hapd);
 		ret = 0;
+	}
 fail:
 	ieee802_11_free_ap_params(&params);
 	return ret;
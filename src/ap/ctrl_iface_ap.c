@@ -80,9 +80,41 @@ static const char * timeout_next_str(int val)
 }
 
 
-static int hostapd_ctrl_iface_sta_mib(struct hostapd_data *hapd,
-				      struct sta_info *sta,
-				      char *buf, size_t buflen)
+/* Fields of station information in STA and STA-DUMP command output */
+#define STA_FIELD_FLAGS BIT(0)
+#define STA_FIELD_AID BIT(1)
+#define STA_FIELD_CAPABILITY BIT(2)
+#define STA_FIELD_LISTEN_INTERVAL BIT(3)
+#define STA_FIELD_SUPPORTED_RATES BIT(4)
+#define STA_FIELD_TIMEOUT_NEXT BIT(5)
+#define STA_FIELD_MIB BIT(6)
+#define STA_FIELD_COUNTERS BIT(7)
+#define STA_FIELD_CONNECTED_TIME BIT(8)
+#define STA_FIELD_ALL (BIT(9) - 1)
+/* STA-DUMP default: everything except the MIB variables of each module */
+#define STA_FIELD_DUMP_DEFAULT (STA_FIELD_ALL & ~STA_FIELD_MIB)
+
+static const struct {
+	const char *name;
+	unsigned int field;
+} sta_fields[] = {
+	{ "flags", STA_FIELD_FLAGS },
+	{ "aid", STA_FIELD_AID },
+	{ "capability", STA_FIELD_CAPABILITY },
+	{ "listen_interval", STA_FIELD_LISTEN_INTERVAL },
+	{ "supported_rates", STA_FIELD_SUPPORTED_RATES },
+	{ "timeout_next", STA_FIELD_TIMEOUT_NEXT },
+	{ "mib", STA_FIELD_MIB },
+	{ "counters", STA_FIELD_COUNTERS },
+	{ "connected_time", STA_FIELD_CONNECTED_TIME },
+	{ "all", STA_FIELD_ALL },
+};
+
+
+static int hostapd_ctrl_iface_sta_info(struct hostapd_data *hapd,
+				       struct sta_info *sta,
+				       unsigned int fields,
+				       char *buf, size_t buflen)
 {
 	int len, res, ret, i;
 
@@ -90,63 +122,124 @@ static int hostapd_ctrl_iface_sta_mib(struct hostapd_data *hapd,
 		return 0;
 
 	len = 0;
-	ret = os_snprintf(buf + len, buflen - len, MACSTR "\nflags=",
+	ret = os_snprintf(buf + len, buflen - len, MACSTR "\n",
 			  MAC2STR(sta->addr));
 	if (ret < 0 || (size_t) ret >= buflen - len)
 		return len;
 	len += ret;
 
-	ret = ap_sta_flags_txt(sta->flags, buf + len, buflen - len);
-	if (ret < 0)
-		return len;
-	len += ret;
+	if (fields & STA_FIELD_FLAGS) {
+		ret = os_snprintf(buf + len, buflen - len, "flags=");
+		if (ret < 0 || (size_t) ret >= buflen - len)
+			return len;
+		len += ret;
 
-	ret = os_snprintf(buf + len, buflen - len, "\naid=%d\ncapability=0x%x\n"
-			  "listen_interval=%d\nsupported_rates=",
-			  sta->aid, sta->capability, sta->listen_interval);
-	if (ret < 0 || (size_t) ret >= buflen - len)
-		return len;
-	len += ret;
+		ret = ap_sta_flags_txt(sta->flags, buf + len, buflen - len);
+		if (ret < 0)
+			return len;
+		len += ret;
 
-	for (i = 0; i < sta->supported_rates_len; i++) {
-		ret = os_snprintf(buf + len, buflen - len, "%02x%s",
-				  sta->supported_rates[i],
-				  i + 1 < sta->supported_rates_len ? " " : "");
+		ret = os_snprintf(buf + len, buflen - len, "\n");
 		if (ret < 0 || (size_t) ret >= buflen - len)
 			return len;
 		len += ret;
 	}
 
-	ret = os_snprintf(buf + len, buflen - len, "\ntimeout_next=%s\n",
-			  timeout_next_str(sta->timeout_next));
-	if (ret < 0 || (size_t) ret >= buflen - len)
-		return len;
-	len += ret;
+	if (fields & STA_FIELD_AID) {
+		ret = os_snprintf(buf + len, buflen - len, "aid=%d\n",
+				  sta->aid);
+		if (ret < 0 || (size_t) ret >= buflen - len)
+			return len;
+		len += ret;
+	}
+
+	if (fields & STA_FIELD_CAPABILITY) {
+		ret = os_snprintf(buf + len, buflen - len, "capability=0x%x\n",
+				  sta->capability);
+		if (ret < 0 || (size_t) ret >= buflen - len)
+			return len;
+		len += ret;
+	}
+
+	if (fields & STA_FIELD_LISTEN_INTERVAL) {
+		ret = os_snprintf(buf + len, buflen - len,
+				  "listen_interval=%d\n", sta->listen_interval);
+		if (ret < 0 || (size_t) ret >= buflen - len)
+			return len;
+		len += ret;
+	}
+
+	if (fields & STA_FIELD_SUPPORTED_RATES) {
+		ret = os_snprintf(buf + len, buflen - len, "supported_rates=");
+		if (ret < 0 || (size_t) ret >= buflen - len)
+			return len;
+		len += ret;
 
-	res = ieee802_11_get_mib_sta(hapd, sta, buf + len, buflen - len);
-	if (res >= 0)
-		len += res;
-	res = wpa_get_mib_sta(sta->wpa_sm, buf + len, buflen - len);
-	if (res >= 0)
-		len += res;
-	res = ieee802_1x_get_mib_sta(hapd, sta, buf + len, buflen - len);
-	if (res >= 0)
-		len += res;
-	res = hostapd_wps_get_mib_sta(hapd, sta->addr, buf + len,
-				      buflen - len);
-	if (res >= 0)
-		len += res;
-	res = hostapd_p2p_get_mib_sta(hapd, sta, buf + len, buflen - len);
-	if (res >= 0)
-		len += res;
-
-	len += hostapd_get_sta_tx_rx(hapd, sta, buf + len, buflen - len);
-	len += hostapd_get_sta_conn_time(sta, buf + len, buflen - len);
+		for (i = 0; i < sta->supported_rates_len; i++) {
+			ret = os_snprintf(buf + len, buflen - len, "%02x%s",
+					  sta->supported_rates[i],
+					  i + 1 < sta->supported_rates_len ?
+					  " " : "");
+			if (ret < 0 || (size_t) ret >= buflen - len)
+				return len;
+			len += ret;
+		}
+
+		ret = os_snprintf(buf + len, buflen - len, "\n");
+		if (ret < 0 || (size_t) ret >= buflen - len)
+			return len;
+		len += ret;
+	}
+
+	if (fields & STA_FIELD_TIMEOUT_NEXT) {
+		ret = os_snprintf(buf + len, buflen - len, "timeout_next=%s\n",
+				  timeout_next_str(sta->timeout_next));
+		if (ret < 0 || (size_t) ret >= buflen - len)
+			return len;
+		len += ret;
+	}
+
+	if (fields & STA_FIELD_MIB) {
+		res = ieee802_11_get_mib_sta(hapd, sta, buf + len,
+					     buflen - len);
+		if (res >= 0)
+			len += res;
+		res = wpa_get_mib_sta(sta->wpa_sm, buf + len, buflen - len);
+		if (res >= 0)
+			len += res;
+		res = ieee802_1x_get_mib_sta(hapd, sta, buf + len,
+					     buflen - len);
+		if (res >= 0)
+			len += res;
+		res = hostapd_wps_get_mib_sta(hapd, sta->addr, buf + len,
+					      buflen - len);
+		if (res >= 0)
+			len += res;
+		res = hostapd_p2p_get_mib_sta(hapd, sta, buf + len,
+					      buflen - len);
+		if (res >= 0)
+			len += res;
+	}
+
+	if (fields & STA_FIELD_COUNTERS)
+		len += hostapd_get_sta_tx_rx(hapd, sta, buf + len,
+					     buflen - len);
+	if (fields & STA_FIELD_CONNECTED_TIME)
+		len += hostapd_get_sta_conn_time(sta, buf + len, buflen - len);
 
 	return len;
 }
 
 
+static int hostapd_ctrl_iface_sta_mib(struct hostapd_data *hapd,
+				      struct sta_info *sta,
+				      char *buf, size_t buflen)
+{
+	return hostapd_ctrl_iface_sta_info(hapd, sta, STA_FIELD_ALL, buf,
+					   buflen);
+}
+
+
 int hostapd_ctrl_iface_sta_first(struct hostapd_data *hapd,
 				 char *buf, size_t buflen)
 {
@@ -215,6 +308,93 @@ int hostapd_ctrl_iface_sta_next(struct hostapd_data *hapd, const char *txtaddr,
 }
 
 
+static int hostapd_ctrl_iface_sta_fields(const char *pos, unsigned int *fields)
+{
+	const char *end;
+	size_t i, len;
+
+	*fields = 0;
+	while (*pos && *pos != ' ') {
+		end = pos;
+		while (*end && *end != ',' && *end != ' ')
+			end++;
+		len = end - pos;
+		for (i = 0; i < ARRAY_SIZE(sta_fields); i++) {
+			if (os_strlen(sta_fields[i].name) == len &&
+			    os_strncmp(sta_fields[i].name, pos, len) == 0)
+				break;
+		}
+		if (i == ARRAY_SIZE(sta_fields))
+			return -1;
+		*fields |= sta_fields[i].field;
+		pos = *end == ',' ? end + 1 : end;
+	}
+
+	return *fields ? 0 : -1;
+}
+
+
+/**
+ * hostapd_ctrl_iface_sta_dump - Get information about multiple stations
+ * @hapd: Pointer to BSS data
+ * @cmd: Command parameters: [<addr>] [fields=<field>[,<field>...]]
+ * @buf: Buffer for the response
+ * @buflen: Length of buf in octets
+ * @sta_len: Space to reserve for each station (the maximum length of the
+ *	information about a single station)
+ * Returns: Length of the response or -1 on failure
+ *
+ * The response contains the selected information of as many stations as fit
+ * in buf, starting from the station after <addr> or from the first station
+ * if <addr> is not included. Each station is in the same format as in the
+ * STA command output. If not all the remaining stations fit in the response,
+ * the last line is "MORE" and the address of the last station in the response
+ * can be used to continue with another command. The command fails if the
+ * station at <addr> has been removed in between.
+ */
+int hostapd_ctrl_iface_sta_dump(struct hostapd_data *hapd, const char *cmd,
+				char *buf, size_t buflen, size_t sta_len)
+{
+	unsigned int fields = STA_FIELD_DUMP_DEFAULT;
+	struct sta_info *sta = hapd->sta_list;
+	const char *pos;
+	u8 addr[ETH_ALEN];
+	size_t len = 0;
+	int ret;
+
+	if (buflen <= sta_len + 5)
+		return -1;
+
+	if (*cmd && os_strncmp(cmd, "fields=", 7) != 0) {
+		if (hwaddr_aton(cmd, addr))
+			return -1;
+		sta = ap_get_sta(hapd, addr);
+		if (sta == NULL)
+			return -1;
+		sta = sta->next;
+	}
+
+	pos = os_strstr(cmd, "fields=");
+	if (pos && hostapd_ctrl_iface_sta_fields(pos + 7, &fields) < 0)
+		return -1;
+
+	/* Leave room for the "MORE" line */
+	buflen -= 5;
+	for (; sta; sta = sta->next) {
+		if (buflen - len < sta_len) {
+			os_memcpy(buf + len, "MORE\n", 5);
+			len += 5;
+			break;
+		}
+		ret = hostapd_ctrl_iface_sta_info(hapd, sta, fields, buf + len,
+						  sta_len);
+		len += ret;
+	}
+
+	return len;
+}
+
+
 #ifdef CONFIG_P2P_MANAGER
 static int p2p_manager_disconnect(struct hostapd_data *hapd, u16 stype,
 				  u8 minor_reason_code, const u8 *addr)
@@ -435,6 +435,72 @@ void hostapd_event_sta_low_ack(struct hostapd_data *hapd, const u8 *addr)
 }
 
 
+static int station_list_has(const u8 *list, size_t num, const u8 *addr)
+{
+	size_t i;
+
+	for (i = 0; i < num; i++) {
+		if (os_memcmp(&list[i * ETH_ALEN], addr, ETH_ALEN) == 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+
+void hostapd_event_station_list(struct hostapd_data *hapd, const u8 *list,
+				size_t num)
+{
+	struct sta_info *sta, *next;
+	size_t i;
+
+	wpa_printf(MSG_DEBUG, "%s: Resynchronize station state with %u "
+		   "station(s) in the driver", hapd->conf->iface,
+		   (unsigned int) num);
+
+	for (sta = hapd->sta_list; sta; sta = next) {
+		next = sta->next;
+		if (station_list_has(list, num, sta->addr))
+			continue;
+
+		if (sta->flags & WLAN_STA_ASSOC) {
+			/* Disassociation or deauthentication event was lost */
+			hostapd_notif_disassoc(hapd, sta->addr);
+		} else if (sta->flags & WLAN_STA_ASSOC_REQ_OK) {
+			/*
+			 * TX status for the (Re)Association Response frame may
+			 * have been lost. Make the station start over instead
+			 * of leaving it waiting for the 4-way handshake.
+			 */
+			hostapd_logger(hapd, sta->addr,
+				       HOSTAPD_MODULE_IEEE80211,
+				       HOSTAPD_LEVEL_INFO,
+				       "association not completed in the "
+				       "driver - deauthenticate");
+			hostapd_drv_sta_deauth(hapd, sta->addr,
+					       WLAN_REASON_PREV_AUTH_NOT_VALID);
+			ap_sta_deauthenticate(hapd, sta,
+					      WLAN_REASON_PREV_AUTH_NOT_VALID);
+		}
+	}
+
+	for (i = 0; i < num; i++) {
+		const u8 *addr = &list[i * ETH_ALEN];
+
+		if (ap_get_sta(hapd, addr))
+			continue;
+
+		/* Association event was lost (driver-based SME) */
+		hostapd_logger(hapd, addr, HOSTAPD_MODULE_IEEE80211,
+			       HOSTAPD_LEVEL_INFO,
+			       "unknown station in the driver - deauthenticate");
+		hostapd_drv_sta_deauth(hapd, addr,
+				       WLAN_REASON_PREV_AUTH_NOT_VALID);
+		hostapd_drv_sta_remove(hapd, addr);
+	}
+}
+
+
 void hostapd_event_ch_switch(struct hostapd_data *hapd, int freq, int ht,
 			     int offset, int width, int cf1, int cf2)
 {
@@ -1114,6 +1180,12 @@ void wpa_supplicant_event(void *ctx, enum wpa_event_type event,
 			break;
 		hostapd_event_sta_low_ack(hapd, data->low_ack.addr);
 		break;
+	case EVENT_STATION_LIST:
+		if (!data)
+			break;
+		hostapd_event_station_list(hapd, data->station_list.addr,
+					   data->station_list.num);
+		break;
 	case EVENT_AUTH:
 		hostapd_notif_auth(hapd, &data->auth);
 		break;
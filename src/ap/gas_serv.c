@@ -12,10 +12,10 @@
 #include "common/ieee802_11_defs.h"
 #include "common/gas.h"
 #include "utils/eloop.h"
+#include "utils/list.h"
 #include "hostapd.h"
 #include "ap_config.h"
 #include "ap_drv_ops.h"
-#include "sta_info.h"
 #include "gas_serv.h"
 
 
@@ -26,113 +26,157 @@ static void convert_to_protected_dual(struct wpabuf *msg)
 }
 
 
-static struct gas_dialog_info *
-gas_dialog_create(struct hostapd_data *hapd, const u8 *addr, u8 dialog_token)
-{
-	struct sta_info *sta;
-	struct gas_dialog_info *dia = NULL;
-	int i, j;
+#define GAS_DIALOG_TIMEOUT 5 /* seconds */
+#define GAS_DIALOG_HASH_SIZE 64
+#define GAS_DIALOG_HASH(a) ((a)[5] & (GAS_DIALOG_HASH_SIZE - 1))
 
-	sta = ap_get_sta(hapd, addr);
-	if (!sta) {
-		/*
-		 * We need a STA entry to be able to maintain state for
-		 * the GAS query.
-		 */
-		wpa_printf(MSG_DEBUG, "ANQP: Add a temporary STA entry for "
-			   "GAS query");
-		sta = ap_sta_add(hapd, addr);
-		if (!sta) {
-			wpa_printf(MSG_DEBUG, "Failed to add STA " MACSTR
-				   " for GAS query", MAC2STR(addr));
-			return NULL;
-		}
-		sta->flags |= WLAN_STA_GAS;
-		/*
-		 * The default inactivity is 300 seconds. We don't need
-		 * it to be that long.
-		 */
-		ap_sta_session_timeout(hapd, sta, 5);
-	} else {
-		ap_sta_replenish_timeout(hapd, sta, 5);
-	}
+/* Max number of concurrent dialogs with pending comeback responses */
+#define GAS_SERV_MAX_DIALOGS 256
 
-	if (sta->gas_dialog == NULL) {
-		sta->gas_dialog = os_zalloc(GAS_DIALOG_MAX *
-					    sizeof(struct gas_dialog_info));
-		if (sta->gas_dialog == NULL)
-			return NULL;
-	}
+struct gas_dialog_info {
+	struct dl_list list; /* gas_serv_data::dialogs, oldest first */
+	struct dl_list hash_list; /* gas_serv_data::dialog_hash[] */
+	u8 addr[ETH_ALEN];
+	u8 dialog_token;
+	struct os_reltime expire;
+	struct wpabuf *sd_resp; /* Fragmented response */
+	size_t sd_resp_pos; /* Offset in sd_resp */
+	u8 sd_frag_id;
+	int prot; /* whether Protected Dual of Public Action frame is used */
+};
 
-	for (i = sta->gas_dialog_next, j = 0; j < GAS_DIALOG_MAX; i++, j++) {
-		if (i == GAS_DIALOG_MAX)
-			i = 0;
-		if (sta->gas_dialog[i].valid)
-			continue;
-		dia = &sta->gas_dialog[i];
-		dia->valid = 1;
-		dia->dialog_token = dialog_token;
-		sta->gas_dialog_next = (++i == GAS_DIALOG_MAX) ? 0 : i;
-		return dia;
-	}
+/*
+ * Per-BSS GAS server state. Dialogs are kept in a table of their own
+ * instead of STA entries so that unassociated devices sending ANQP queries
+ * do not need a struct sta_info. The locally generated ANQP elements and
+ * icon files are built once and reused until the configuration changes.
+ */
+struct gas_serv_data {
+	struct dl_list dialogs;
+	struct dl_list dialog_hash[GAS_DIALOG_HASH_SIZE];
+	unsigned int num_dialogs;
+
+	struct wpabuf **anqp; /* indexed like anqp_elems[] */
+	size_t num_anqp;
+	struct wpabuf **icons; /* indexed like conf->hs20_icons */
+	size_t num_icons;
+};
 
-	wpa_msg(hapd->msg_ctx, MSG_ERROR, "ANQP: Could not create dialog for "
-		MACSTR " dialog_token %u. Consider increasing "
-		"GAS_DIALOG_MAX.", MAC2STR(addr), dialog_token);
 
-	return NULL;
+static void gas_serv_dialog_free(struct gas_serv_data *gas,
+				 struct gas_dialog_info *dia)
+{
+	dl_list_del(&dia->list);
+	dl_list_del(&dia->hash_list);
+	gas->num_dialogs--;
+	wpabuf_free(dia->sd_resp);
+	os_free(dia);
 }
 
 
-struct gas_dialog_info *
-gas_serv_dialog_find(struct hostapd_data *hapd, const u8 *addr,
-		     u8 dialog_token)
+static void gas_serv_dialog_timeout(void *eloop_ctx, void *timeout_ctx)
 {
-	struct sta_info *sta;
-	int i;
-
-	sta = ap_get_sta(hapd, addr);
-	if (!sta) {
-		wpa_printf(MSG_DEBUG, "ANQP: could not find STA " MACSTR,
-			   MAC2STR(addr));
-		return NULL;
-	}
-	for (i = 0; sta->gas_dialog && i < GAS_DIALOG_MAX; i++) {
-		if (sta->gas_dialog[i].dialog_token != dialog_token ||
-		    !sta->gas_dialog[i].valid)
-			continue;
-		return &sta->gas_dialog[i];
+	struct hostapd_data *hapd = eloop_ctx;
+	struct gas_serv_data *gas = hapd->gas_serv;
+	struct gas_dialog_info *dia;
+	struct os_reltime now, left;
+
+	os_get_reltime(&now);
+	while ((dia = dl_list_first(&gas->dialogs, struct gas_dialog_info,
+				    list))) {
+		if (os_reltime_before(&now, &dia->expire)) {
+			os_reltime_sub(&dia->expire, &now, &left);
+			eloop_register_timeout(left.sec, left.usec,
+					       gas_serv_dialog_timeout, hapd,
+					       NULL);
+			break;
+		}
+		wpa_printf(MSG_DEBUG, "GAS: Dialog for " MACSTR
+			   " dialog_token %u timed out",
+			   MAC2STR(dia->addr), dia->dialog_token);
+		gas_serv_dialog_free(gas, dia);
 	}
-	wpa_printf(MSG_DEBUG, "ANQP: Could not find dialog for "
-		   MACSTR " dialog_token %u", MAC2STR(addr), dialog_token);
-	return NULL;
 }
 
 
-void gas_serv_dialog_clear(struct gas_dialog_info *dia)
+static struct gas_dialog_info *
+gas_dialog_find(struct gas_serv_data *gas, const u8 *addr, u8 dialog_token,
+		unsigned int *count)
 {
-	wpabuf_free(dia->sd_resp);
-	os_memset(dia, 0, sizeof(*dia));
+	struct gas_dialog_info *dia, *found = NULL;
+
+	if (count)
+		*count = 0;
+	dl_list_for_each(dia, &gas->dialog_hash[GAS_DIALOG_HASH(addr)],
+			 struct gas_dialog_info, hash_list) {
+		if (os_memcmp(dia->addr, addr, ETH_ALEN) != 0)
+			continue;
+		if (dia->dialog_token == dialog_token) {
+			found = dia;
+			if (count == NULL)
+				break;
+		} else if (count) {
+			(*count)++;
+		}
+	}
+	return found;
 }
 
 
-static void gas_serv_free_dialogs(struct hostapd_data *hapd,
-				  const u8 *sta_addr)
+static struct gas_dialog_info *
+gas_dialog_create(struct hostapd_data *hapd, const u8 *addr, u8 dialog_token)
 {
-	struct sta_info *sta;
-	int i;
-
-	sta = ap_get_sta(hapd, sta_addr);
-	if (sta == NULL || sta->gas_dialog == NULL)
-		return;
+	struct gas_serv_data *gas = hapd->gas_serv;
+	struct gas_dialog_info *dia;
+	unsigned int count;
+
+	dia = gas_dialog_find(gas, addr, dialog_token, &count);
+	if (dia) {
+		/* Retransmitted request - replace the old response */
+		gas_serv_dialog_free(gas, dia);
+	}
 
-	for (i = 0; i < GAS_DIALOG_MAX; i++) {
-		if (sta->gas_dialog[i].valid)
-			return;
+	if (count >= GAS_DIALOG_MAX ||
+	    gas->num_dialogs >= GAS_SERV_MAX_DIALOGS) {
+		wpa_msg(hapd->msg_ctx, MSG_ERROR,
+			"ANQP: Could not create dialog for " MACSTR
+			" dialog_token %u (%u dialogs, %u total)",
+			MAC2STR(addr), dialog_token, count, gas->num_dialogs);
+		return NULL;
 	}
 
-	os_free(sta->gas_dialog);
-	sta->gas_dialog = NULL;
+	dia = os_zalloc(sizeof(*dia));
+	if (dia == NULL)
+		return NULL;
+	os_memcpy(dia->addr, addr, ETH_ALEN);
+	dia->dialog_token = dialog_token;
+	os_get_reltime(&dia->expire);
+	dia->expire.sec += GAS_DIALOG_TIMEOUT;
+
+	if (dl_list_empty(&gas->dialogs))
+		eloop_register_timeout(GAS_DIALOG_TIMEOUT, 0,
+				       gas_serv_dialog_timeout, hapd, NULL);
+	dl_list_add_tail(&gas->dialogs, &dia->list);
+	dl_list_add(&gas->dialog_hash[GAS_DIALOG_HASH(addr)],
+		    &dia->hash_list);
+	gas->num_dialogs++;
+
+	return dia;
+}
+
+
+static struct gas_dialog_info *
+gas_serv_dialog_find(struct hostapd_data *hapd, const u8 *addr,
+		     u8 dialog_token)
+{
+	struct gas_dialog_info *dia;
+
+	dia = gas_dialog_find(hapd->gas_serv, addr, dialog_token, NULL);
+	if (dia == NULL)
+		wpa_printf(MSG_DEBUG, "ANQP: Could not find dialog for "
+			   MACSTR " dialog_token %u",
+			   MAC2STR(addr), dialog_token);
+	return dia;
 }
 
 
@@ -387,11 +431,9 @@ static int hs20_add_nai_home_realm_matches(struct hostapd_data *hapd,
 }
 
 
-static void anqp_add_nai_realm(struct hostapd_data *hapd, struct wpabuf *buf,
-			       const u8 *home_realm, size_t home_realm_len,
-			       int nai_realm, int nai_home_realm)
+static void anqp_add_nai_realm(struct hostapd_data *hapd, struct wpabuf *buf)
 {
-	if (nai_realm && hapd->conf->nai_realm_data) {
+	if (hapd->conf->nai_realm_data) {
 		u8 *len;
 		unsigned int i, j;
 		len = gas_anqp_add_element(buf, ANQP_NAI_REALM);
@@ -414,9 +456,6 @@ static void anqp_add_nai_realm(struct hostapd_data *hapd, struct wpabuf *buf,
 			gas_anqp_set_element_len(buf, realm_data_len);
 		}
 		gas_anqp_set_element_len(buf, len);
-	} else if (nai_home_realm && hapd->conf->nai_realm_data && home_realm) {
-		hs20_add_nai_home_realm_matches(hapd, buf, home_realm,
-						home_realm_len);
 	}
 }
 
@@ -625,6 +664,43 @@ static void anqp_add_osu_providers_list(struct hostapd_data *hapd,
 }
 
 
+static const struct wpabuf * gas_serv_icon(struct hostapd_data *hapd,
+					  size_t idx)
+{
+	struct gas_serv_data *gas = hapd->gas_serv;
+	struct hs20_icon *icon = &hapd->conf->hs20_icons[idx];
+	char *data;
+	size_t data_len;
+
+	if (gas->icons == NULL) {
+		gas->icons = os_calloc(hapd->conf->hs20_icons_count,
+				       sizeof(struct wpabuf *));
+		if (gas->icons == NULL)
+			return NULL;
+		gas->num_icons = hapd->conf->hs20_icons_count;
+	}
+	if (idx >= gas->num_icons)
+		return NULL;
+	if (gas->icons[idx])
+		return gas->icons[idx];
+
+	data = os_readfile(icon->file, &data_len);
+	if (data == NULL || data_len > 65535) {
+		os_free(data);
+		return NULL;
+	}
+	gas->icons[idx] = wpabuf_alloc_ext_data((u8 *) data, data_len);
+	if (gas->icons[idx] == NULL) {
+		os_free(data);
+		return NULL;
+	}
+	wpa_printf(MSG_DEBUG, "HS 2.0: Loaded icon file %s (%u bytes)",
+		   icon->file, (unsigned int) data_len);
+
+	return gas->icons[idx];
+}
+
+
 static void anqp_add_icon_binary_file(struct hostapd_data *hapd,
 				      struct wpabuf *buf,
 				      const u8 *name, size_t name_len)
@@ -654,11 +730,10 @@ static void anqp_add_icon_binary_file(struct hostapd_data *hapd,
 	wpabuf_put_u8(buf, 0); /* Reserved */
 
 	if (icon) {
-		char *data;
-		size_t data_len;
+		const struct wpabuf *data;
 
-		data = os_readfile(icon->file, &data_len);
-		if (data == NULL || data_len > 65535) {
+		data = gas_serv_icon(hapd, i);
+		if (data == NULL) {
 			wpabuf_put_u8(buf, 2); /* Download Status:
 						* Unspecified file error */
 			wpabuf_put_u8(buf, 0);
@@ -667,10 +742,9 @@ static void anqp_add_icon_binary_file(struct hostapd_data *hapd,
 			wpabuf_put_u8(buf, 0); /* Download Status: Success */
 			wpabuf_put_u8(buf, os_strlen(icon->type));
 			wpabuf_put_str(buf, icon->type);
-			wpabuf_put_le16(buf, data_len);
-			wpabuf_put_data(buf, data, data_len);
+			wpabuf_put_le16(buf, wpabuf_len(data));
+			wpabuf_put_buf(buf, data);
 		}
-		os_free(data);
 	} else {
 		wpabuf_put_u8(buf, 1); /* Download Status: File not found */
 		wpabuf_put_u8(buf, 0);
@@ -683,57 +757,100 @@ static void anqp_add_icon_binary_file(struct hostapd_data *hapd,
 #endif /* CONFIG_HS20 */
 
 
+/*
+ * ANQP elements that depend only on the configuration. These are generated
+ * once and then reused for all queries until gas_serv_config_changed() is
+ * called. The order of this table determines the order of the elements in
+ * the response.
+ */
+static const struct anqp_elem {
+	unsigned int request;
+	void (*add)(struct hostapd_data *hapd, struct wpabuf *buf);
+} anqp_elems[] = {
+	{ ANQP_REQ_CAPABILITY_LIST, anqp_add_capab_list },
+	{ ANQP_REQ_VENUE_NAME, anqp_add_venue_name },
+	{ ANQP_REQ_NETWORK_AUTH_TYPE, anqp_add_network_auth_type },
+	{ ANQP_REQ_ROAMING_CONSORTIUM, anqp_add_roaming_consortium },
+	{ ANQP_REQ_IP_ADDR_TYPE_AVAILABILITY,
+	  anqp_add_ip_addr_type_availability },
+	{ ANQP_REQ_NAI_REALM, anqp_add_nai_realm },
+	{ ANQP_REQ_3GPP_CELLULAR_NETWORK, anqp_add_3gpp_cellular_network },
+	{ ANQP_REQ_DOMAIN_NAME, anqp_add_domain_name },
+#ifdef CONFIG_HS20
+	{ ANQP_REQ_HS_CAPABILITY_LIST, anqp_add_hs_capab_list },
+	{ ANQP_REQ_OPERATOR_FRIENDLY_NAME, anqp_add_operator_friendly_name },
+	{ ANQP_REQ_WAN_METRICS, anqp_add_wan_metrics },
+	{ ANQP_REQ_CONNECTION_CAPABILITY, anqp_add_connection_capability },
+	{ ANQP_REQ_OPERATING_CLASS, anqp_add_operating_class },
+	{ ANQP_REQ_OSU_PROVIDERS_LIST, anqp_add_osu_providers_list },
+#endif /* CONFIG_HS20 */
+};
+
+
+static const struct wpabuf * gas_serv_anqp_elem(struct hostapd_data *hapd,
+						size_t idx)
+{
+	struct gas_serv_data *gas = hapd->gas_serv;
+	struct wpabuf *buf;
+
+	if (gas->anqp[idx])
+		return gas->anqp[idx];
+
+	buf = wpabuf_alloc(2400);
+	if (buf == NULL)
+		return NULL;
+	anqp_elems[idx].add(hapd, buf);
+	gas->anqp[idx] = wpabuf_dup(buf);
+	wpabuf_free(buf);
+
+	return gas->anqp[idx];
+}
+
+
 static struct wpabuf *
 gas_serv_build_gas_resp_payload(struct hostapd_data *hapd,
 				unsigned int request,
 				const u8 *home_realm, size_t home_realm_len,
 				const u8 *icon_name, size_t icon_name_len)
 {
+	const struct wpabuf *elem[ARRAY_SIZE(anqp_elems)];
 	struct wpabuf *buf;
-	size_t len;
+	size_t i, len;
+	int home_realm_query;
+
+	home_realm_query = !(request & ANQP_REQ_NAI_REALM) &&
+		(request & ANQP_REQ_NAI_HOME_REALM) &&
+		hapd->conf->nai_realm_data && home_realm;
 
-	len = 1400;
-	if (request & (ANQP_REQ_NAI_REALM | ANQP_REQ_NAI_HOME_REALM))
+	len = 0;
+	for (i = 0; i < ARRAY_SIZE(anqp_elems); i++) {
+		elem[i] = NULL;
+		if (!(request & anqp_elems[i].request))
+			continue;
+		elem[i] = gas_serv_anqp_elem(hapd, i);
+		if (elem[i] == NULL)
+			return NULL;
+		len += wpabuf_len(elem[i]);
+	}
+	if (home_realm_query)
 		len += 1000;
 	if (request & ANQP_REQ_ICON_REQUEST)
-		len += 65536;
+		len += 100 + 65536;
 
 	buf = wpabuf_alloc(len);
 	if (buf == NULL)
 		return NULL;
 
-	if (request & ANQP_REQ_CAPABILITY_LIST)
-		anqp_add_capab_list(hapd, buf);
-	if (request & ANQP_REQ_VENUE_NAME)
-		anqp_add_venue_name(hapd, buf);
-	if (request & ANQP_REQ_NETWORK_AUTH_TYPE)
-		anqp_add_network_auth_type(hapd, buf);
-	if (request & ANQP_REQ_ROAMING_CONSORTIUM)
-		anqp_add_roaming_consortium(hapd, buf);
-	if (request & ANQP_REQ_IP_ADDR_TYPE_AVAILABILITY)
-		anqp_add_ip_addr_type_availability(hapd, buf);
-	if (request & (ANQP_REQ_NAI_REALM | ANQP_REQ_NAI_HOME_REALM))
-		anqp_add_nai_realm(hapd, buf, home_realm, home_realm_len,
-				   request & ANQP_REQ_NAI_REALM,
-				   request & ANQP_REQ_NAI_HOME_REALM);
-	if (request & ANQP_REQ_3GPP_CELLULAR_NETWORK)
-		anqp_add_3gpp_cellular_network(hapd, buf);
-	if (request & ANQP_REQ_DOMAIN_NAME)
-		anqp_add_domain_name(hapd, buf);
+	for (i = 0; i < ARRAY_SIZE(anqp_elems); i++) {
+		if (elem[i])
+			wpabuf_put_buf(buf, elem[i]);
+		if (anqp_elems[i].request == ANQP_REQ_NAI_REALM &&
+		    home_realm_query)
+			hs20_add_nai_home_realm_matches(hapd, buf, home_realm,
+							home_realm_len);
+	}
 
 #ifdef CONFIG_HS20
-	if (request & ANQP_REQ_HS_CAPABILITY_LIST)
-		anqp_add_hs_capab_list(hapd, buf);
-	if (request & ANQP_REQ_OPERATOR_FRIENDLY_NAME)
-		anqp_add_operator_friendly_name(hapd, buf);
-	if (request & ANQP_REQ_WAN_METRICS)
-		anqp_add_wan_metrics(hapd, buf);
-	if (request & ANQP_REQ_CONNECTION_CAPABILITY)
-		anqp_add_connection_capability(hapd, buf);
-	if (request & ANQP_REQ_OPERATING_CLASS)
-		anqp_add_operating_class(hapd, buf);
-	if (request & ANQP_REQ_OSU_PROVIDERS_LIST)
-		anqp_add_osu_providers_list(hapd, buf);
 	if (request & ANQP_REQ_ICON_REQUEST)
 		anqp_add_icon_binary_file(hapd, buf, icon_name, icon_name_len);
 #endif /* CONFIG_HS20 */
@@ -1193,7 +1310,7 @@ static void gas_serv_rx_gas_comeback_req(struct hostapd_data *hapd,
 	if (buf == NULL) {
 		wpa_msg(hapd->msg_ctx, MSG_DEBUG, "GAS: Failed to allocate "
 			"buffer");
-		gas_serv_dialog_clear(dialog);
+		gas_serv_dialog_free(hapd->gas_serv, dialog);
 		return;
 	}
 	tx_buf = gas_anqp_build_comeback_resp_buf(dialog_token,
@@ -1202,7 +1319,7 @@ static void gas_serv_rx_gas_comeback_req(struct hostapd_data *hapd,
 						  more, 0, buf);
 	wpabuf_free(buf);
 	if (tx_buf == NULL) {
-		gas_serv_dialog_clear(dialog);
+		gas_serv_dialog_free(hapd->gas_serv, dialog);
 		return;
 	}
 	wpa_msg(hapd->msg_ctx, MSG_DEBUG, "GAS: Tx GAS Comeback Response "
@@ -1219,8 +1336,7 @@ static void gas_serv_rx_gas_comeback_req(struct hostapd_data *hapd,
 	} else {
 		wpa_msg(hapd->msg_ctx, MSG_DEBUG, "GAS: All fragments of "
 			"SD response sent");
-		gas_serv_dialog_clear(dialog);
-		gas_serv_free_dialogs(hapd, sa);
+		gas_serv_dialog_free(hapd->gas_serv, dialog);
 	}
 
 send_resp:
@@ -1266,8 +1382,56 @@ static void gas_serv_rx_public_action(void *ctx, const u8 *buf, size_t len,
 }
 
 
+static void gas_serv_anqp_flush(struct gas_serv_data *gas)
+{
+	size_t i;
+
+	for (i = 0; i < gas->num_anqp; i++) {
+		wpabuf_free(gas->anqp[i]);
+		gas->anqp[i] = NULL;
+	}
+	for (i = 0; i < gas->num_icons; i++)
+		wpabuf_free(gas->icons[i]);
+	os_free(gas->icons);
+	gas->icons = NULL;
+	gas->num_icons = 0;
+}
+
+
+/**
+ * gas_serv_config_changed - Notify GAS server of configuration changes
+ * @hapd: Pointer to BSS data
+ *
+ * This needs to be called whenever the BSS configuration is replaced or
+ * modified so that the prebuilt ANQP elements and cached icon files are
+ * regenerated for the following queries.
+ */
+void gas_serv_config_changed(struct hostapd_data *hapd)
+{
+	if (hapd->gas_serv)
+		gas_serv_anqp_flush(hapd->gas_serv);
+}
+
+
 int gas_serv_init(struct hostapd_data *hapd)
 {
+	struct gas_serv_data *gas;
+	size_t i;
+
+	gas = os_zalloc(sizeof(*gas));
+	if (gas == NULL)
+		return -1;
+	dl_list_init(&gas->dialogs);
+	for (i = 0; i < GAS_DIALOG_HASH_SIZE; i++)
+		dl_list_init(&gas->dialog_hash[i]);
+	gas->num_anqp = ARRAY_SIZE(anqp_elems);
+	gas->anqp = os_calloc(gas->num_anqp, sizeof(struct wpabuf *));
+	if (gas->anqp == NULL) {
+		os_free(gas);
+		return -1;
+	}
+	hapd->gas_serv = gas;
+
 	hapd->public_action_cb2 = gas_serv_rx_public_action;
 	hapd->public_action_cb2_ctx = hapd;
 	hapd->gas_frag_limit = 1400;
@@ -1279,4 +1443,18 @@ int gas_serv_init(struct hostapd_data *hapd)
 
 void gas_serv_deinit(struct hostapd_data *hapd)
 {
+	struct gas_serv_data *gas = hapd->gas_serv;
+	struct gas_dialog_info *dia, *tmp;
+
+	if (gas == NULL)
+		return;
+
+	eloop_cancel_timeout(gas_serv_dialog_timeout, hapd, NULL);
+	dl_list_for_each_safe(dia, tmp, &gas->dialogs, struct gas_dialog_info,
+			      list)
+		gas_serv_dialog_free(gas, dia);
+	gas_serv_anqp_flush(gas);
+	os_free(gas->anqp);
+	os_free(gas);
+	hapd->gas_serv = NULL;
 }
@@ -35,6 +35,7 @@
 #include "gas_serv.h"
 #include "dfs.h"
 #include "ieee802_11.h"
+#include "ap_stats.h"
 
 
 static int hostapd_flush_old_stations(struct hostapd_data *hapd, u16 reason);
@@ -111,6 +112,9 @@ static void hostapd_reload_bss(struct hostapd_data *hapd)
 
 	ieee802_11_set_beacon(hapd);
 	hostapd_update_wps(hapd);
+#ifdef CONFIG_INTERWORKING
+	gas_serv_config_changed(hapd);
+#endif /* CONFIG_INTERWORKING */
 
 	if (hapd->conf->ssid.ssid_set &&
 	    hostapd_set_ssid(hapd, hapd->conf->ssid.ssid,
@@ -122,24 +126,127 @@ static void hostapd_reload_bss(struct hostapd_data *hapd)
 }
 
 
-static void hostapd_clear_old(struct hostapd_iface *iface)
+static void hostapd_clear_old_bss(struct hostapd_data *hapd)
 {
-	size_t j;
-
 	/*
 	 * Deauthenticate all stations since the new configuration may not
 	 * allow them to use the BSS anymore.
 	 */
-	for (j = 0; j < iface->num_bss; j++) {
-		hostapd_flush_old_stations(iface->bss[j],
-					   WLAN_REASON_PREV_AUTH_NOT_VALID);
-		hostapd_broadcast_wep_clear(iface->bss[j]);
+	hostapd_flush_old_stations(hapd, WLAN_REASON_PREV_AUTH_NOT_VALID);
+	hostapd_broadcast_wep_clear(hapd);
 
 #ifndef CONFIG_NO_RADIUS
-		/* TODO: update dynamic data based on changed configuration
-		 * items (e.g., open/close sockets, etc.) */
-		radius_client_flush(iface->bss[j]->radius, 0);
+	/* TODO: update dynamic data based on changed configuration
+	 * items (e.g., open/close sockets, etc.) */
+	radius_client_flush(hapd->radius, 0);
 #endif /* CONFIG_NO_RADIUS */
+}
+
+
+static void hostapd_clear_old(struct hostapd_iface *iface)
+{
+	size_t j;
+
+	for (j = 0; j < iface->num_bss; j++)
+		hostapd_clear_old_bss(iface->bss[j]);
+}
+
+
+static int hostapd_iface_conf_changed(struct hostapd_config *newconf,
+				      struct hostapd_config *oldconf)
+{
+	size_t i;
+
+	if (newconf->num_bss != oldconf->num_bss ||
+	    os_memcmp(newconf->conf_hash, oldconf->conf_hash,
+		      HOSTAPD_CONF_HASH_LEN) != 0)
+		return 1;
+
+	for (i = 0; i < newconf->num_bss; i++) {
+		if (os_strcmp(newconf->bss[i]->iface,
+			      oldconf->bss[i]->iface) != 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+
+static void hostapd_acl_check_stas(struct hostapd_data *hapd)
+{
+	struct hostapd_bss_config *conf = hapd->conf;
+	struct sta_info *sta, *next;
+	int vlan_id;
+
+	if (conf->macaddr_acl == USE_EXTERNAL_RADIUS_AUTH)
+		return;
+
+	for (sta = hapd->sta_list; sta; sta = next) {
+		next = sta->next;
+
+		vlan_id = 0;
+		if (hostapd_maclist_found(conf->accept_mac,
+					  conf->num_accept_mac, sta->addr,
+					  &vlan_id)) {
+			if (vlan_id <= 0 || vlan_id == sta->vlan_id)
+				continue;
+		} else if (conf->macaddr_acl == ACCEPT_UNLESS_DENIED &&
+			   !hostapd_maclist_found(conf->deny_mac,
+						  conf->num_deny_mac,
+						  sta->addr, NULL)) {
+			continue;
+		}
+
+		wpa_printf(MSG_DEBUG, "%s: STA " MACSTR " not allowed by "
+			   "the updated MAC ACL", conf->iface,
+			   MAC2STR(sta->addr));
+		hostapd_drv_sta_deauth(hapd, sta->addr,
+				       WLAN_REASON_PREV_AUTH_NOT_VALID);
+		ap_sta_deauthenticate(hapd, sta,
+				      WLAN_REASON_PREV_AUTH_NOT_VALID);
+	}
+}
+
+
+static void hostapd_reload_bss_changes(struct hostapd_data *hapd,
+				       struct hostapd_config *newconf,
+				       size_t idx)
+{
+	struct hostapd_bss_config *oldbss = hapd->iconf->bss[idx];
+	struct hostapd_bss_config *newbss = newconf->bss[idx];
+
+	if (os_memcmp(oldbss->conf_hash, newbss->conf_hash,
+		      HOSTAPD_CONF_HASH_LEN) != 0) {
+		wpa_printf(MSG_DEBUG, "%s: Configuration changed - "
+			   "reconfigure BSS", oldbss->iface);
+		hostapd_clear_old_bss(hapd);
+		/* Move the new BSS configuration into use */
+		hapd->iconf->bss[idx] = newbss;
+		newconf->bss[idx] = oldbss;
+		hapd->conf = newbss;
+		hostapd_reload_bss(hapd);
+		return;
+	}
+
+	/*
+	 * Keep using the current BSS configuration and only apply the
+	 * changed parameters. The replaced values will be freed with newconf.
+	 */
+	if (hostapd_config_acl_changed(oldbss, newbss)) {
+		wpa_printf(MSG_DEBUG, "%s: MAC ACL changed", oldbss->iface);
+		hostapd_config_swap_acl(oldbss, newbss);
+		hostapd_acl_check_stas(hapd);
+	}
+
+	if (os_memcmp(oldbss->info_hash, newbss->info_hash,
+		      HOSTAPD_CONF_HASH_LEN) != 0) {
+		wpa_printf(MSG_DEBUG, "%s: Advertised information changed - "
+			   "update Beacon", oldbss->iface);
+		hostapd_config_swap_bss_info(oldbss, newbss);
+		ieee802_11_set_beacon(hapd);
+#ifdef CONFIG_INTERWORKING
+		gas_serv_config_changed(hapd);
+#endif /* CONFIG_INTERWORKING */
 	}
 }
 
@@ -165,6 +272,17 @@ int hostapd_reload_config(struct hostapd_iface *iface)
 	if (newconf == NULL)
 		return -1;
 
+	if (!hostapd_iface_conf_changed(newconf, hapd->iconf)) {
+		/*
+		 * Per-radio parameters and the set of BSSs are unchanged, so
+		 * only the modified BSSs need to be updated.
+		 */
+		for (j = 0; j < iface->num_bss; j++)
+			hostapd_reload_bss_changes(iface->bss[j], newconf, j);
+		hostapd_config_free(newconf);
+		return 0;
+	}
+
 	hostapd_clear_old(iface);
 
 	oldconf = hapd->iconf;
@@ -310,6 +428,8 @@ static void hostapd_free_hapd_data(struct hostapd_data *hapd)
 	gas_serv_deinit(hapd);
 #endif /* CONFIG_INTERWORKING */
 
+	ap_stats_deinit(hapd);
+
 #ifdef CONFIG_SQLITE
 	bin_clear_free(hapd->tmp_eap_user.identity,
 		       hapd->tmp_eap_user.identity_len);
@@ -889,6 +1009,12 @@ static int hostapd_setup_bss(struct hostapd_data *hapd, int first)
 	if (hapd->driver && hapd->driver->set_operstate)
 		hapd->driver->set_operstate(hapd->drv_priv, 1);
 
+	if (ap_stats_init(hapd) < 0) {
+		wpa_printf(MSG_ERROR, "Statistics region initialization "
+			   "failed.");
+		return -1;
+	}
+
 	return 0;
 }
 
@@ -20,6 +20,8 @@ struct hostapd_data;
 struct sta_info;
 struct ieee80211_ht_capabilities;
 struct full_dynamic_vlan;
+struct gas_serv_data;
+struct ap_stats;
 enum wps_event;
 union wps_event_data;
 
@@ -110,6 +112,12 @@ struct hostapd_data {
 #define STA_HASH(sta) (sta[5])
 	struct sta_info *sta_hash[STA_HASH_SIZE];
 
+	/* Station data snapshot from read_all_sta_data() (see
+	 * hostapd_read_sta_data_snapshot()) */
+	unsigned int sta_data_gen;
+	struct os_reltime sta_data_time;
+	int sta_data_valid;
+
 	/*
 	 * Bitfield for indicating which AIDs are allocated. Only AID values
 	 * 1-2007 are used and as such, the bit at index 0 corresponds to AID
@@ -234,12 +242,17 @@ struct hostapd_data {
 #endif /* CONFIG_P2P */
 #ifdef CONFIG_INTERWORKING
 	size_t gas_frag_limit;
+	struct gas_serv_data *gas_serv;
 #endif /* CONFIG_INTERWORKING */
 
 #ifdef CONFIG_SQLITE
 	struct hostapd_eap_user tmp_eap_user;
 #endif /* CONFIG_SQLITE */
 
+#ifdef CONFIG_STATS_SHM
+	struct ap_stats *stats;
+#endif /* CONFIG_STATS_SHM */
+
 #ifdef CONFIG_SAE
 	/** Key used for generating SAE anti-clogging tokens */
 	u8 sae_token_key[8];
@@ -416,6 +429,8 @@ int hostapd_notif_assoc(struct hostapd_data *hapd, const u8 *addr,
 			const u8 *ie, size_t ielen, int reassoc);
 void hostapd_notif_disassoc(struct hostapd_data *hapd, const u8 *addr);
 void hostapd_event_sta_low_ack(struct hostapd_data *hapd, const u8 *addr);
+void hostapd_event_station_list(struct hostapd_data *hapd, const u8 *list,
+				size_t num);
 void hostapd_event_connect_failed_reason(struct hostapd_data *hapd,
 					 const u8 *addr, int reason_code);
 int hostapd_probe_req_rx(struct hostapd_data *hapd, const u8 *sa, const u8 *da,
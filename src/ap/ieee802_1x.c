@@ -692,7 +692,9 @@ static void handle_eap_response(struct hostapd_data *hapd,
 	sm->dot1xAuthEapolRespFramesRx++;
 
 	wpabuf_free(sm->eap_if->eapRespData);
-	sm->eap_if->eapRespData = wpabuf_alloc_copy(eap, len);
+	sm->eap_if->eapRespData = wpabuf_alloc_pool(len);
+	if (sm->eap_if->eapRespData)
+		wpabuf_put_data(sm->eap_if->eapRespData, eap, len);
 	sm->eapolEap = TRUE;
 }
 
@@ -29,7 +29,6 @@
 #include "vlan_init.h"
 #include "p2p_hostapd.h"
 #include "ap_drv_ops.h"
-#include "gas_serv.h"
 #include "wnm_ap.h"
 #include "sta_info.h"
 
@@ -244,6 +243,7 @@ void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta)
 #endif /* CONFIG_NO_RADIUS */
 
 	os_free(sta->challenge);
+	os_free(sta->drv_data);
 
 #ifdef CONFIG_IEEE80211W
 	os_free(sta->sa_query_trans_id);
@@ -254,15 +254,6 @@ void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta)
 	p2p_group_notif_disassoc(hapd->p2p_group, sta->addr);
 #endif /* CONFIG_P2P */
 
-#ifdef CONFIG_INTERWORKING
-	if (sta->gas_dialog) {
-		int i;
-		for (i = 0; i < GAS_DIALOG_MAX; i++)
-			gas_serv_dialog_clear(&sta->gas_dialog[i]);
-		os_free(sta->gas_dialog);
-	}
-#endif /* CONFIG_INTERWORKING */
-
 	wpabuf_free(sta->wps_ie);
 	wpabuf_free(sta->p2p_ie);
 	wpabuf_free(sta->hs20_ie);
@@ -305,6 +296,35 @@ void hostapd_free_stas(struct hostapd_data *hapd)
 }
 
 
+/**
+ * ap_sta_register_sweep_timeout - Register a periodic per-STA timeout
+ * @secs: Timeout in seconds
+ * @handler: Timeout handler
+ * @hapd: BSS data (eloop_ctx for the handler)
+ * @sta: The station (timeout_ctx for the handler)
+ *
+ * The timeout is rounded up to expire on a full second of the monotonic
+ * clock. Timeouts of stations that are scheduled during the same second will
+ * then expire together and can share a single station data snapshot (see
+ * hostapd_read_sta_data_snapshot()).
+ */
+void ap_sta_register_sweep_timeout(unsigned int secs,
+				   void (*handler)(void *eloop_ctx,
+						   void *timeout_ctx),
+				   struct hostapd_data *hapd,
+				   struct sta_info *sta)
+{
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	if (secs > 0 && now.usec > 0)
+		eloop_register_timeout(secs - 1, 1000000 - now.usec, handler,
+				       hapd, sta);
+	else
+		eloop_register_timeout(secs, 0, handler, hapd, sta);
+}
+
+
 /**
  * ap_handle_timer - Per STA timer handler
  * @eloop_ctx: struct hostapd_data *
@@ -341,7 +361,7 @@ void ap_handle_timer(void *eloop_ctx, void *timeout_ctx)
 		 * stations that are idle (but keep re-associating).
 		 */
 		int fuzz = os_random() % 20;
-		inactive_sec = hostapd_drv_get_inact_sec(hapd, sta->addr);
+		inactive_sec = hostapd_get_inact_sec_snapshot(hapd, sta);
 		if (inactive_sec == -1) {
 			wpa_msg(hapd->msg_ctx, MSG_DEBUG,
 				"Check inactivity: Could not "
@@ -390,8 +410,8 @@ void ap_handle_timer(void *eloop_ctx, void *timeout_ctx)
 		wpa_printf(MSG_DEBUG, "%s: register ap_handle_timer timeout "
 			   "for " MACSTR " (%lu seconds)",
 			   __func__, MAC2STR(sta->addr), next_time);
-		eloop_register_timeout(next_time, 0, ap_handle_timer, hapd,
-				       sta);
+		ap_sta_register_sweep_timeout(next_time, ap_handle_timer, hapd,
+					      sta);
 		return;
 	}
 
@@ -84,6 +84,11 @@ struct sta_info {
 
 	unsigned long last_rx_bytes;
 	unsigned long last_tx_bytes;
+
+	/* Data for this station from the latest station data snapshot; valid
+	 * if drv_data_gen matches hapd->sta_data_gen */
+	struct hostap_sta_driver_data *drv_data;
+	unsigned int drv_data_gen;
 	u32 acct_input_gigawords; /* Acct-Input-Gigawords */
 	u32 acct_output_gigawords; /* Acct-Output-Gigawords */
 
@@ -116,12 +121,6 @@ struct sta_info {
 	struct os_reltime sa_query_start;
 #endif /* CONFIG_IEEE80211W */
 
-#ifdef CONFIG_INTERWORKING
-#define GAS_DIALOG_MAX 8 /* Max concurrent dialog number */
-	struct gas_dialog_info *gas_dialog;
-	u8 gas_dialog_next;
-#endif /* CONFIG_INTERWORKING */
-
 	struct wpabuf *wps_ie; /* WPS IE from (Re)Association Request */
 	struct wpabuf *p2p_ie; /* P2P IE from (Re)Association Request */
 	struct wpabuf *hs20_ie; /* HS 2.0 IE from (Re)Association Request */
@@ -168,6 +167,11 @@ struct sta_info * ap_get_sta_p2p(struct hostapd_data *hapd, const u8 *addr);
 void ap_sta_hash_add(struct hostapd_data *hapd, struct sta_info *sta);
 void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta);
 void hostapd_free_stas(struct hostapd_data *hapd);
+void ap_sta_register_sweep_timeout(unsigned int secs,
+				   void (*handler)(void *eloop_ctx,
+						   void *timeout_ctx),
+				   struct hostapd_data *hapd,
+				   struct sta_info *sta);
 void ap_handle_timer(void *eloop_ctx, void *timeout_ctx);
 void ap_sta_replenish_timeout(struct hostapd_data *hapd, struct sta_info *sta,
 			      u32 session_timeout);
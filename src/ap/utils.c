@@ -12,6 +12,7 @@
 #include "common/ieee802_11_defs.h"
 #include "sta_info.h"
 #include "hostapd.h"
+#include "ap_drv_ops.h"
 
 
 int hostapd_register_probereq_cb(struct hostapd_data *hapd,
@@ -35,6 +36,9 @@ int hostapd_register_probereq_cb(struct hostapd_data *hapd,
 	n->cb = cb;
 	n->ctx = ctx;
 
+	/* The callback needs to see all Probe Request frames */
+	hostapd_drv_set_probe_req_filter(hapd, NULL);
+
 	return 0;
 }
 
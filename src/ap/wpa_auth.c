@@ -1282,6 +1282,7 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 		      const u8 *kde, size_t kde_len,
 		      int keyidx, int encr, int force_version)
 {
+	struct wpabuf *msg;
 	struct ieee802_1x_hdr *hdr;
 	struct wpa_eapol_key *key;
 	size_t len;
@@ -1329,9 +1330,10 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 
 	len += key_data_len;
 
-	hdr = os_zalloc(len);
-	if (hdr == NULL)
+	msg = wpabuf_alloc_pool(len);
+	if (msg == NULL)
 		return;
+	hdr = wpabuf_put(msg, len);
 	hdr->version = wpa_auth->conf.eapol_version;
 	hdr->type = IEEE802_1X_TYPE_EAPOL_KEY;
 	hdr->length = host_to_be16(len  - sizeof(*hdr));
@@ -1375,7 +1377,7 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 	} else if (encr && kde) {
 		buf = os_zalloc(key_data_len);
 		if (buf == NULL) {
-			os_free(hdr);
+			wpabuf_free(msg);
 			return;
 		}
 		pos = buf;
@@ -1393,7 +1395,7 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 			if (aes_wrap(sm->PTK.kek, 16,
 				     (key_data_len - 8) / 8, buf,
 				     (u8 *) (key + 1))) {
-				os_free(hdr);
+				wpabuf_free(msg);
 				os_free(buf);
 				return;
 			}
@@ -1417,7 +1419,7 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 			wpa_auth_logger(wpa_auth, sm->addr, LOGGER_DEBUG,
 					"PTK not valid when sending EAPOL-Key "
 					"frame");
-			os_free(hdr);
+			wpabuf_free(msg);
 			return;
 		}
 		wpa_eapol_key_mic(sm->PTK.kck, version, (u8 *) hdr, len,
@@ -1438,7 +1440,7 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 			   1);
 	wpa_auth_send_eapol(wpa_auth, sm->addr, (u8 *) hdr, len,
 			    sm->pairwise_set);
-	os_free(hdr);
+	wpabuf_free(msg);
 }
 
 
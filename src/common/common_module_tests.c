@@ -81,6 +81,69 @@ static int ieee802_11_parse_tests(void)
 }
 
 
+static int ieee802_11_elem_index_tests(void)
+{
+	struct ieee802_11_elem_index *idx;
+	const u8 *ies, *pos, *end, *first;
+	int i, eid, ret = 0;
+
+	wpa_printf(MSG_INFO, "ieee802_11_elem_index tests");
+
+	for (i = 0; parse_tests[i].data; i++) {
+		ies = parse_tests[i].data;
+		idx = ieee802_11_elem_index_build(ies, parse_tests[i].len);
+		if (idx == NULL) {
+			ret = -1;
+			continue;
+		}
+		for (eid = 0; eid < 256; eid++) {
+			first = NULL;
+			pos = ies;
+			end = ies + parse_tests[i].len;
+			while (pos + 1 < end && pos + 2 + pos[1] <= end) {
+				if (pos[0] == eid) {
+					first = pos;
+					break;
+				}
+				pos += 2 + pos[1];
+			}
+			if (ieee802_11_elem_index_get(idx, ies, eid) != first) {
+				wpa_printf(MSG_ERROR,
+					   "ieee802_11_elem_index test %d failed for element %d",
+					   i, eid);
+				ret = -1;
+			}
+		}
+		os_free(idx);
+	}
+
+	ies = (const u8 *) "\xdd\x05\x00\x50\xf2\x02\x02\x30\x00"
+		"\xdd\x05\x00\x50\xf2\x02\x03\xdd\x01\x00";
+	idx = ieee802_11_elem_index_build(ies, 20);
+	if (idx) {
+		struct wpabuf *buf;
+
+		buf = ieee802_11_elem_index_vendor_concat(idx, ies, 20,
+							  0x0050f202);
+		if (ieee802_11_elem_index_get_vendor(idx, ies, 0x0050f202) !=
+		    ies ||
+		    ieee802_11_elem_index_get_vendor(idx, ies, 0x0050f204) ||
+		    buf == NULL || wpabuf_len(buf) != 2 ||
+		    os_memcmp(wpabuf_head(buf), "\x02\x03", 2) != 0) {
+			wpa_printf(MSG_ERROR,
+				   "ieee802_11_elem_index vendor test failed");
+			ret = -1;
+		}
+		wpabuf_free(buf);
+		os_free(idx);
+	} else {
+		ret = -1;
+	}
+
+	return ret;
+}
+
+
 struct rsn_ie_parse_test_data {
 	u8 *data;
 	size_t len;
@@ -165,6 +228,7 @@ int common_module_tests(void)
 	wpa_printf(MSG_INFO, "common module tests");
 
 	if (ieee802_11_parse_tests() < 0 ||
+	    ieee802_11_elem_index_tests() < 0 ||
 	    rsn_ie_parse_tests() < 0)
 		ret = -1;
 
@@ -0,0 +1,273 @@
+/*
+ * Common helpers for UNIX domain socket control interface monitors and requests
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* sendmmsg() */
+#endif /* _GNU_SOURCE */
+#endif /* __linux__ */
+
+#include "includes.h"
+#include <sys/un.h>
+
+#include "utils/common.h"
+#include "common/wpa_ctrl.h"
+#include "ctrl_iface_common.h"
+
+/* Maximum number of messages sent to a monitor with a single system call */
+#define CTRL_MON_SEND_BATCH 16
+
+
+/**
+ * ctrl_mon_msg_build - Format an event message for monitors
+ * @ifname: Interface name for global control interface or %NULL
+ * @level: Priority level of the message
+ * @buf: Message text
+ * @len: Length of the message text
+ * Returns: Formatted message or %NULL on failure
+ */
+struct wpabuf * ctrl_mon_msg_build(const char *ifname, int level,
+				   const char *buf, size_t len)
+{
+	struct wpabuf *msg;
+
+	msg = wpabuf_alloc((ifname ? 8 + os_strlen(ifname) : 0) + 10 + len);
+	if (msg == NULL)
+		return NULL;
+	if (ifname)
+		wpabuf_printf(msg, "IFNAME=%s ", ifname);
+	wpabuf_printf(msg, "<%d>", level);
+	wpabuf_put_data(msg, buf, len);
+	return msg;
+}
+
+
+/**
+ * ctrl_mon_queue_add - Queue a message for a monitor
+ * @q: Monitor queue
+ * @msg: Message from ctrl_mon_msg_build()
+ *
+ * The oldest pending message is dropped if the queue is full.
+ */
+void ctrl_mon_queue_add(struct ctrl_mon_queue *q, const struct wpabuf *msg)
+{
+	struct wpabuf *copy;
+
+	copy = wpabuf_dup(msg);
+	if (copy == NULL) {
+		q->dropped++;
+		q->dropped_total++;
+		return;
+	}
+
+	if (q->count == CTRL_MON_QUEUE_LEN) {
+		wpabuf_free(q->msg[q->first]);
+		q->first = (q->first + 1) % CTRL_MON_QUEUE_LEN;
+		q->count--;
+		q->dropped++;
+		q->dropped_total++;
+	}
+
+	q->msg[(q->first + q->count) % CTRL_MON_QUEUE_LEN] = copy;
+	q->count++;
+}
+
+
+static int ctrl_mon_sendmmsg(int sock, struct msghdr *msg, unsigned int num)
+{
+#ifdef __linux__
+	struct mmsghdr hdr[CTRL_MON_SEND_BATCH];
+	unsigned int i;
+
+	for (i = 0; i < num; i++) {
+		hdr[i].msg_hdr = msg[i];
+		hdr[i].msg_len = 0;
+	}
+	return sendmmsg(sock, hdr, num, MSG_DONTWAIT);
+#else /* __linux__ */
+	if (sendmsg(sock, &msg[0], MSG_DONTWAIT) < 0)
+		return -1;
+	return 1;
+#endif /* __linux__ */
+}
+
+
+/**
+ * ctrl_mon_queue_send - Send pending messages to a monitor
+ * @q: Monitor queue
+ * @sock: Local socket
+ * @addr: Address of the monitor
+ * @addrlen: Length of addr
+ * Returns: Number of messages sent or -1 on failure (errno is set)
+ *
+ * Messages that could not be sent remain in the queue.
+ */
+int ctrl_mon_queue_send(struct ctrl_mon_queue *q, int sock,
+			const struct sockaddr_un *addr, socklen_t addrlen)
+{
+	struct msghdr msg[CTRL_MON_SEND_BATCH];
+	struct iovec io[CTRL_MON_SEND_BATCH];
+	char notice[50];
+	unsigned int i, num, notice_sent;
+	int res, sent = 0;
+
+	while (q->count || q->dropped) {
+		num = 0;
+		if (q->dropped) {
+			res = os_snprintf(notice, sizeof(notice),
+					  "<%d>" WPA_EVENT_MONITOR_DROPPED
+					  "count=%u", MSG_WARNING, q->dropped);
+			if (res < 0 || (size_t) res >= sizeof(notice))
+				res = 0;
+			io[num].iov_base = notice;
+			io[num].iov_len = res;
+			num++;
+		}
+		notice_sent = num;
+		for (i = 0; num < CTRL_MON_SEND_BATCH && i < q->count; i++) {
+			struct wpabuf *m;
+
+			m = q->msg[(q->first + i) % CTRL_MON_QUEUE_LEN];
+			io[num].iov_base = wpabuf_mhead(m);
+			io[num].iov_len = wpabuf_len(m);
+			num++;
+		}
+
+		for (i = 0; i < num; i++) {
+			os_memset(&msg[i], 0, sizeof(msg[i]));
+			msg[i].msg_name = (void *) addr;
+			msg[i].msg_namelen = addrlen;
+			msg[i].msg_iov = &io[i];
+			msg[i].msg_iovlen = 1;
+		}
+
+		res = ctrl_mon_sendmmsg(sock, msg, num);
+		if (res <= 0)
+			return -1;
+		sent += res;
+
+		if (notice_sent) {
+			q->dropped = 0;
+			res--;
+		}
+		while (res > 0) {
+			wpabuf_free(q->msg[q->first]);
+			q->msg[q->first] = NULL;
+			q->first = (q->first + 1) % CTRL_MON_QUEUE_LEN;
+			q->count--;
+			res--;
+		}
+	}
+
+	return sent;
+}
+
+
+/**
+ * ctrl_mon_queue_clear - Free all pending messages of a monitor
+ * @q: Monitor queue
+ */
+void ctrl_mon_queue_clear(struct ctrl_mon_queue *q)
+{
+	while (q->count) {
+		wpabuf_free(q->msg[q->first]);
+		q->msg[q->first] = NULL;
+		q->first = (q->first + 1) % CTRL_MON_QUEUE_LEN;
+		q->count--;
+	}
+}
+
+
+/**
+ * ctrl_iface_cmd_match - Check whether a request is in a list of commands
+ * @cmd: Request text
+ * @list: %NULL terminated list of commands; an entry ending in a space or a
+ *	dash matches any request starting with it
+ * Returns: 1 if cmd matches an entry in list, 0 if not
+ */
+int ctrl_iface_cmd_match(const char *cmd, const char * const *list)
+{
+	size_t len;
+	char last;
+
+	for (; *list; list++) {
+		len = os_strlen(*list);
+		last = len ? (*list)[len - 1] : '\0';
+		if (last == ' ' || last == '-') {
+			if (os_strncmp(cmd, *list, len) == 0)
+				return 1;
+		} else if (os_strcmp(cmd, *list) == 0) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * ctrl_iface_snapshot_get - Find a response from a snapshot
+ * @snap: Snapshot of the current batch of requests
+ * @cmd: Request text
+ * Returns: Response to an identical earlier request or %NULL if not found
+ */
+const struct wpabuf *
+ctrl_iface_snapshot_get(const struct ctrl_iface_snapshot *snap,
+			const char *cmd)
+{
+	unsigned int i;
+
+	for (i = 0; i < snap->count; i++) {
+		if (os_strcmp(snap->cmd[i], cmd) == 0)
+			return snap->reply[i];
+	}
+
+	return NULL;
+}
+
+
+/**
+ * ctrl_iface_snapshot_add - Add a response into a snapshot
+ * @snap: Snapshot of the current batch of requests
+ * @cmd: Request text
+ * @reply: Response to the request
+ * @reply_len: Length of reply in octets
+ */
+void ctrl_iface_snapshot_add(struct ctrl_iface_snapshot *snap,
+			     const char *cmd, const char *reply,
+			     size_t reply_len)
+{
+	char *c;
+	struct wpabuf *r;
+
+	if (snap->count == CTRL_IFACE_MAX_BATCH)
+		return;
+	c = os_strdup(cmd);
+	r = wpabuf_alloc_copy(reply, reply_len);
+	if (c == NULL || r == NULL) {
+		os_free(c);
+		wpabuf_free(r);
+		return;
+	}
+	snap->cmd[snap->count] = c;
+	snap->reply[snap->count] = r;
+	snap->count++;
+}
+
+
+/**
+ * ctrl_iface_snapshot_clear - Free all responses in a snapshot
+ * @snap: Snapshot of the current batch of requests
+ */
+void ctrl_iface_snapshot_clear(struct ctrl_iface_snapshot *snap)
+{
+	while (snap->count) {
+		snap->count--;
+		os_free(snap->cmd[snap->count]);
+		wpabuf_free(snap->reply[snap->count]);
+	}
+}
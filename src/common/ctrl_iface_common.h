@@ -0,0 +1,77 @@
+/*
+ * Common helpers for UNIX domain socket control interface monitors and requests
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef CTRL_IFACE_COMMON_H
+#define CTRL_IFACE_COMMON_H
+
+struct sockaddr_un;
+
+/* Maximum number of pending event messages per attached monitor */
+#define CTRL_MON_QUEUE_LEN 64
+
+/**
+ * struct ctrl_mon_queue - Pending event messages for a monitor
+ * @msg: Ring buffer of formatted messages (one datagram each)
+ * @first: Index of the oldest message in msg
+ * @count: Number of messages in msg
+ * @dropped: Number of messages dropped and not yet reported to the monitor
+ * @dropped_total: Total number of messages dropped for this monitor
+ *
+ * Events are queued for each monitor and sent in batches from the event loop
+ * so that a burst of events (e.g., BSS-ADDED for each new scan result) does
+ * not require a separate system call per event and monitor. When a monitor
+ * does not keep up, the oldest messages are dropped and the monitor is
+ * notified with a CTRL-EVENT-MONITOR-DROPPED event once there is room again.
+ */
+struct ctrl_mon_queue {
+	struct wpabuf *msg[CTRL_MON_QUEUE_LEN];
+	unsigned int first;
+	unsigned int count;
+	unsigned int dropped;
+	unsigned int dropped_total;
+};
+
+struct wpabuf * ctrl_mon_msg_build(const char *ifname, int level,
+				   const char *buf, size_t len);
+void ctrl_mon_queue_add(struct ctrl_mon_queue *q, const struct wpabuf *msg);
+int ctrl_mon_queue_send(struct ctrl_mon_queue *q, int sock,
+			const struct sockaddr_un *addr, socklen_t addrlen);
+void ctrl_mon_queue_clear(struct ctrl_mon_queue *q);
+
+/* Maximum number of requests processed per wakeup of a control socket */
+#define CTRL_IFACE_MAX_BATCH 16
+
+/**
+ * struct ctrl_iface_snapshot - Responses to read-only requests in a batch
+ * @cmd: Request text
+ * @reply: Response to cmd
+ * @count: Number of entries in cmd and reply
+ *
+ * Pending requests are read from the control socket in batches of up to
+ * CTRL_IFACE_MAX_BATCH. A batch continues only while the requests cannot
+ * change the state (e.g., STATUS or BSS), so a response built for one
+ * read-only request is valid for an identical request from another client
+ * later in the same batch. Such a request is answered from the snapshot.
+ * This avoids building large responses (e.g., "BSS RANGE=ALL") again when
+ * several monitoring programs poll at the same time.
+ */
+struct ctrl_iface_snapshot {
+	char *cmd[CTRL_IFACE_MAX_BATCH];
+	struct wpabuf *reply[CTRL_IFACE_MAX_BATCH];
+	unsigned int count;
+};
+
+int ctrl_iface_cmd_match(const char *cmd, const char * const *list);
+const struct wpabuf *
+ctrl_iface_snapshot_get(const struct ctrl_iface_snapshot *snap,
+			const char *cmd);
+void ctrl_iface_snapshot_add(struct ctrl_iface_snapshot *snap,
+			     const char *cmd, const char *reply,
+			     size_t reply_len);
+void ctrl_iface_snapshot_clear(struct ctrl_iface_snapshot *snap);
+
+#endif /* CTRL_IFACE_COMMON_H */
@@ -378,6 +378,180 @@ struct wpabuf * ieee802_11_vendor_ie_concat(const u8 *ies, size_t ies_len,
 }
 
 
+static unsigned int elem_index_popcount(u32 val)
+{
+	val = val - ((val >> 1) & 0x55555555);
+	val = (val & 0x33333333) + ((val >> 2) & 0x33333333);
+	val = (val + (val >> 4)) & 0x0f0f0f0f;
+	return (val * 0x01010101) >> 24;
+}
+
+
+/**
+ * ieee802_11_elem_index_build - Build an element offset index for IEs
+ * @ies: Information elements
+ * @ies_len: Length of @ies in octets
+ * Returns: Allocated index (to be freed with os_free()) or %NULL on failure
+ *
+ * The index covers the same elements as a linear walk over the buffer, i.e.,
+ * it ends at the first element that does not fit in the buffer. It remains
+ * valid only as long as the contents of @ies is not modified.
+ */
+struct ieee802_11_elem_index *
+ieee802_11_elem_index_build(const u8 *ies, size_t ies_len)
+{
+	struct ieee802_11_elem_index *idx;
+	const u8 *pos, *end;
+	u32 present[8];
+	u16 *offsets, *vendor;
+	unsigned int num_ids = 0, num_vendor = 0, i, word, bit;
+
+	if (ies_len > 0xffff)
+		return NULL;
+
+	os_memset(present, 0, sizeof(present));
+	pos = ies;
+	end = ies + ies_len;
+	while (pos + 1 < end) {
+		if (pos + 2 + pos[1] > end)
+			break;
+		word = pos[0] / 32;
+		bit = pos[0] % 32;
+		if (!(present[word] & BIT(bit))) {
+			present[word] |= BIT(bit);
+			num_ids++;
+		}
+		if (pos[0] == WLAN_EID_VENDOR_SPECIFIC)
+			num_vendor++;
+		pos += 2 + pos[1];
+	}
+
+	idx = os_zalloc(sizeof(*idx) + (num_ids + num_vendor) * sizeof(u16));
+	if (idx == NULL)
+		return NULL;
+	os_memcpy(idx->present, present, sizeof(present));
+	idx->num_ids = num_ids;
+	idx->num_vendor = num_vendor;
+	for (i = 1; i < 8; i++)
+		idx->rank[i] = idx->rank[i - 1] +
+			elem_index_popcount(present[i - 1]);
+
+	/* Fill in the offsets; the first occurrence of each ID is stored */
+	os_memset(present, 0, sizeof(present));
+	offsets = (u16 *) (idx + 1);
+	vendor = offsets + num_ids;
+	num_vendor = 0;
+	pos = ies;
+	while (pos + 1 < end) {
+		if (pos + 2 + pos[1] > end)
+			break;
+		word = pos[0] / 32;
+		bit = pos[0] % 32;
+		if (!(present[word] & BIT(bit))) {
+			present[word] |= BIT(bit);
+			i = idx->rank[word] +
+				elem_index_popcount(idx->present[word] &
+						    (BIT(bit) - 1));
+			offsets[i] = pos - ies;
+		}
+		if (pos[0] == WLAN_EID_VENDOR_SPECIFIC)
+			vendor[num_vendor++] = pos - ies;
+		pos += 2 + pos[1];
+	}
+
+	return idx;
+}
+
+
+/**
+ * ieee802_11_elem_index_get - Fetch an element using an element index
+ * @idx: Index from ieee802_11_elem_index_build() for @ies
+ * @ies: Information elements
+ * @eid: Element ID (WLAN_EID_*)
+ * Returns: Pointer to the first matching element (id field) or %NULL
+ */
+const u8 * ieee802_11_elem_index_get(const struct ieee802_11_elem_index *idx,
+				     const u8 *ies, u8 eid)
+{
+	const u16 *offsets = (const u16 *) (idx + 1);
+	unsigned int word = eid / 32;
+	u32 mask = BIT(eid % 32);
+
+	if (!(idx->present[word] & mask))
+		return NULL;
+
+	return ies + offsets[idx->rank[word] +
+			     elem_index_popcount(idx->present[word] &
+						 (mask - 1))];
+}
+
+
+/**
+ * ieee802_11_elem_index_get_vendor - Fetch a vendor element using an index
+ * @idx: Index from ieee802_11_elem_index_build() for @ies
+ * @ies: Information elements
+ * @vendor_type: Vendor type (four octets starting the element payload)
+ * Returns: Pointer to the first matching element (id field) or %NULL
+ */
+const u8 *
+ieee802_11_elem_index_get_vendor(const struct ieee802_11_elem_index *idx,
+				 const u8 *ies, u32 vendor_type)
+{
+	const u16 *vendor = (const u16 *) (idx + 1) + idx->num_ids;
+	const u8 *pos;
+	unsigned int i;
+
+	for (i = 0; i < idx->num_vendor; i++) {
+		pos = ies + vendor[i];
+		if (pos[1] >= 4 && WPA_GET_BE32(&pos[2]) == vendor_type)
+			return pos;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * ieee802_11_elem_index_vendor_concat - Concatenate vendor element payloads
+ * @idx: Index from ieee802_11_elem_index_build() for @ies
+ * @ies: Information elements
+ * @ies_len: Length of @ies in octets
+ * @vendor_type: Vendor type (four octets starting the element payload)
+ * Returns: Concatenated payload of the matching elements or %NULL if none
+ *
+ * The caller is responsible for freeing the returned buffer.
+ */
+struct wpabuf *
+ieee802_11_elem_index_vendor_concat(const struct ieee802_11_elem_index *idx,
+				    const u8 *ies, size_t ies_len,
+				    u32 vendor_type)
+{
+	const u16 *vendor = (const u16 *) (idx + 1) + idx->num_ids;
+	struct wpabuf *buf = NULL;
+	const u8 *pos;
+	unsigned int i;
+
+	for (i = 0; i < idx->num_vendor; i++) {
+		pos = ies + vendor[i];
+		if (pos[1] < 4 || WPA_GET_BE32(&pos[2]) != vendor_type)
+			continue;
+		if (buf == NULL) {
+			buf = wpabuf_alloc(ies_len);
+			if (buf == NULL)
+				return NULL;
+		}
+		wpabuf_put_data(buf, pos + 6, pos[1] - 4);
+	}
+
+	if (buf && wpabuf_len(buf) == 0) {
+		wpabuf_free(buf);
+		buf = NULL;
+	}
+
+	return buf;
+}
+
+
 const u8 * get_hdr_bssid(const struct ieee80211_hdr *hdr, size_t len)
 {
 	u16 fc, type, stype;
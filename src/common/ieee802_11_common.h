@@ -84,6 +84,37 @@ struct wpabuf * ieee802_11_vendor_ie_concat(const u8 *ies, size_t ies_len,
 struct ieee80211_hdr;
 const u8 * get_hdr_bssid(const struct ieee80211_hdr *hdr, size_t len);
 
+/**
+ * struct ieee802_11_elem_index - Element offset index for an IE buffer
+ * @present: Bitmap of the element IDs that are present in the buffer
+ * @rank: Number of element IDs present in the preceding @present words
+ * @num_ids: Number of distinct element IDs
+ * @num_vendor: Number of Vendor Specific elements
+ *
+ * The structure is followed by @num_ids u16 offsets of the first element of
+ * each present element ID (in ascending ID order) and @num_vendor u16 offsets
+ * of the Vendor Specific elements (in buffer order).
+ */
+struct ieee802_11_elem_index {
+	u32 present[8];
+	u8 rank[8];
+	u16 num_ids;
+	u16 num_vendor;
+	/* followed by (num_ids + num_vendor) * u16 offsets */
+};
+
+struct ieee802_11_elem_index *
+ieee802_11_elem_index_build(const u8 *ies, size_t ies_len);
+const u8 * ieee802_11_elem_index_get(const struct ieee802_11_elem_index *idx,
+				     const u8 *ies, u8 eid);
+const u8 *
+ieee802_11_elem_index_get_vendor(const struct ieee802_11_elem_index *idx,
+				 const u8 *ies, u32 vendor_type);
+struct wpabuf *
+ieee802_11_elem_index_vendor_concat(const struct ieee802_11_elem_index *idx,
+				    const u8 *ies, size_t ies_len,
+				    u32 vendor_type);
+
 struct hostapd_wmm_ac_params {
 	int cwmin;
 	int cwmax;
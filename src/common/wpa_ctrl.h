@@ -30,6 +30,8 @@ extern "C" {
 #define WPA_EVENT_ASSOC_REJECT "CTRL-EVENT-ASSOC-REJECT "
 /** wpa_supplicant is exiting */
 #define WPA_EVENT_TERMINATING "CTRL-EVENT-TERMINATING "
+/** Events were dropped because the monitor did not receive them in time */
+#define WPA_EVENT_MONITOR_DROPPED "CTRL-EVENT-MONITOR-DROPPED "
 /** Password change was completed successfully */
 #define WPA_EVENT_PASSWORD_CHANGED "CTRL-EVENT-PASSWORD-CHANGED "
 /** EAP-Request/Notification received */
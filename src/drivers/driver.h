@@ -725,6 +725,32 @@ struct wowlan_triggers {
 	u8 rfkill_release;
 };
 
+/**
+ * struct wpa_driver_probe_req_filter - Probe Request frame filter (AP only)
+ * @ssid: SSID of the BSS
+ * @ssid_len: Length of @ssid in octets
+ * @drop_all: Whether no Probe Request frames need to be reported
+ * @ignore_broadcast_ssid: Whether to drop Probe Request frames for the
+ *	wildcard SSID that do not include an SSID List element
+ * @interworking: Whether to match the Interworking element
+ * @access_network_type: Access Network Type of the BSS (if @interworking)
+ * @hessid: HESSID of the BSS (if @interworking)
+ *
+ * This is a compiled form of the checks hostapd does in handle_probe_req()
+ * before generating a Probe Response frame. A Probe Request frame that does
+ * not pass the filter (see probe_req_filter_match()) would be ignored by
+ * hostapd, so the driver can drop it without reporting it.
+ */
+struct wpa_driver_probe_req_filter {
+	u8 ssid[32];
+	size_t ssid_len;
+	int drop_all;
+	int ignore_broadcast_ssid;
+	int interworking;
+	u8 access_network_type;
+	u8 hessid[ETH_ALEN];
+};
+
 struct wpa_driver_ap_params {
 	/**
 	 * head - Beacon head from IEEE 802.11 header to IEs before TIM IE
@@ -1994,6 +2020,23 @@ struct wpa_driver_ops {
 	int (*read_sta_data)(void *priv, struct hostap_sta_driver_data *data,
 			     const u8 *addr);
 
+	/**
+	 * read_all_sta_data - Fetch station data for all stations (AP only)
+	 * @priv: Private driver interface data
+	 * @cb: Function to call for each station
+	 * @ctx: Context pointer for the cb() calls
+	 * Returns: 0 on success, -1 on failure
+	 *
+	 * This is an optional function to fetch the same information as
+	 * read_sta_data() for all stations of the interface with a single
+	 * request to the driver. cb() is called once for each station before
+	 * this function returns.
+	 */
+	int (*read_all_sta_data)(void *priv,
+				 void (*cb)(void *ctx, const u8 *addr,
+					    struct hostap_sta_driver_data *data),
+				 void *ctx);
+
 	/**
 	 * hapd_send_eapol - Send an EAPOL packet (AP only)
 	 * @priv: private driver interface data
@@ -2403,6 +2446,22 @@ struct wpa_driver_ops {
 	 */
 	int (*probe_req_report)(void *priv, int report);
 
+	/**
+	 * set_probe_req_filter - Set Probe Request frame filter (AP only)
+	 * @priv: Private driver interface data
+	 * @filter: Filter or %NULL to report all Probe Request frames
+	 * Returns: 0 on success, -1 on failure (or if not supported)
+	 *
+	 * This is an optional function to let the driver drop Probe Request
+	 * frames that hostapd would ignore before they are reported with
+	 * EVENT_RX_MGMT or EVENT_RX_PROBE_REQ. The driver needs to copy the
+	 * filter since it is not guaranteed to remain valid after this call.
+	 * probe_req_filter_match() can be used to apply the filter.
+	 */
+	int (*set_probe_req_filter)(void *priv,
+				    const struct wpa_driver_probe_req_filter
+				    *filter);
+
 	/**
 	 * deinit_ap - Deinitialize AP mode
 	 * @priv: Private driver interface data
@@ -3589,7 +3648,17 @@ enum wpa_event_type {
 	 * Indicates a pair of primary and secondary channels chosen by ACS
 	 * in device.
 	 */
-	EVENT_ACS_CHANNEL_SELECTED
+	EVENT_ACS_CHANNEL_SELECTED,
+
+	/**
+	 * EVENT_STATION_LIST - Current list of stations in the driver
+	 *
+	 * This event is used in AP mode to report all stations that the driver
+	 * currently has an entry for when events from the driver may have
+	 * been lost (e.g., due to an event socket receive buffer overrun).
+	 * This allows the station state to be resynchronized.
+	 */
+	EVENT_STATION_LIST
 };
 
 
@@ -4258,6 +4327,16 @@ union wpa_event_data {
 		u8 pri_channel;
 		u8 sec_channel;
 	} acs_selected_channels;
+
+	/**
+	 * struct station_list - Data for EVENT_STATION_LIST
+	 * @addr: Station addresses (num * ETH_ALEN octets)
+	 * @num: Number of stations
+	 */
+	struct station_list {
+		const u8 *addr;
+		size_t num;
+	} station_list;
 };
 
 /**
@@ -4319,6 +4398,10 @@ const char * event_to_string(enum wpa_event_type event);
 /* Convert chan_width to a string for logging and control interfaces */
 const char * channel_width_to_string(enum chan_width width);
 
+/* Check whether a Probe Request frame (IEs) passes a Probe Request filter */
+int probe_req_filter_match(const struct wpa_driver_probe_req_filter *filter,
+			   const u8 *ie, size_t ie_len);
+
 /* NULL terminated array of linked in driver wrappers */
 extern struct wpa_driver_ops *wpa_drivers[];
 
@@ -8,6 +8,7 @@
 
 #include "includes.h"
 #include "utils/common.h"
+#include "common/ieee802_11_defs.h"
 #include "driver.h"
 
 void wpa_scan_results_free(struct wpa_scan_results *res)
@@ -81,6 +82,7 @@ const char * event_to_string(enum wpa_event_type event)
 	E2S(AVOID_FREQUENCIES);
 	E2S(AUTHORIZATION);
 	E2S(ACS_CHANNEL_SELECTED);
+	E2S(STATION_LIST);
 	}
 
 	return "UNKNOWN";
@@ -107,3 +109,109 @@ const char * channel_width_to_string(enum chan_width width)
 		return "unknown";
 	}
 }
+
+
+static int probe_req_ssid_list_match(
+	const struct wpa_driver_probe_req_filter *filter,
+	const u8 *ssid_list, size_t ssid_list_len, int *wildcard)
+{
+	const u8 *pos = ssid_list, *end = ssid_list + ssid_list_len;
+
+	while (pos + 1 <= end) {
+		if (pos + 2 + pos[1] > end)
+			break;
+		if (pos[1] == 0)
+			*wildcard = 1;
+		if (pos[1] == filter->ssid_len &&
+		    os_memcmp(pos + 2, filter->ssid, pos[1]) == 0)
+			return 1;
+		pos += 2 + pos[1];
+	}
+
+	return 0;
+}
+
+
+/**
+ * probe_req_filter_match - Check whether a Probe Request frame passes a filter
+ * @filter: Probe Request filter from set_probe_req_filter()
+ * @ie: Information elements from the Probe Request frame
+ * @ie_len: Length of @ie in octets
+ * Returns: 1 if the frame needs to be reported or 0 if it can be dropped
+ *
+ * The elements are scanned once and only the ones needed for the filter are
+ * looked at. This needs to match the checks in handle_probe_req().
+ */
+int probe_req_filter_match(const struct wpa_driver_probe_req_filter *filter,
+			   const u8 *ie, size_t ie_len)
+{
+	const u8 *pos = ie, *end = ie + ie_len;
+	const u8 *ssid = NULL, *ssid_list = NULL, *iw = NULL;
+	u8 ssid_len = 0, ssid_list_len = 0, iw_len = 0;
+	int supp_rates = 0, wildcard;
+
+	if (filter->drop_all)
+		return 0;
+
+	while (end - pos >= 2) {
+		u8 id = pos[0], elen = pos[1];
+
+		pos += 2;
+		if (elen > end - pos)
+			return 0; /* ParseFailed */
+		switch (id) {
+		case WLAN_EID_SSID:
+			ssid = pos;
+			ssid_len = elen;
+			break;
+		case WLAN_EID_SUPP_RATES:
+			supp_rates = 1;
+			break;
+		case WLAN_EID_SSID_LIST:
+			ssid_list = pos;
+			ssid_list_len = elen;
+			break;
+		case WLAN_EID_INTERWORKING:
+			iw = pos;
+			iw_len = elen;
+			break;
+		}
+		pos += elen;
+	}
+	if (pos != end)
+		return 0; /* ParseFailed */
+
+	if (ssid == NULL || !supp_rates)
+		return 0;
+
+	if (filter->ignore_broadcast_ssid && ssid_len == 0 &&
+	    ssid_list_len == 0)
+		return 0;
+
+	wildcard = ssid_len == 0;
+	if (!(ssid_len == filter->ssid_len &&
+	      os_memcmp(ssid, filter->ssid, ssid_len) == 0) &&
+	    !(ssid_list &&
+	      probe_req_ssid_list_match(filter, ssid_list, ssid_list_len,
+					&wildcard)) &&
+	    !wildcard)
+		return 0;
+
+	if (filter->interworking && iw && iw_len >= 1) {
+		u8 ant = iw[0] & 0x0f;
+		const u8 *hessid;
+
+		if (ant != INTERWORKING_ANT_WILDCARD &&
+		    ant != filter->access_network_type)
+			return 0;
+
+		if (iw_len == 7 || iw_len == 9) {
+			hessid = iw_len == 7 ? iw + 1 : iw + 1 + 2;
+			if (!is_broadcast_ether_addr(hessid) &&
+			    os_memcmp(hessid, filter->hessid, ETH_ALEN) != 0)
+				return 0;
+		}
+	}
+
+	return 1;
+}
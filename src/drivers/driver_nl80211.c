@@ -164,9 +164,11 @@ static void nl_destroy_handles(struct nl_handle **handle)
 
 static void nl80211_register_eloop_read(struct nl_handle **handle,
 					eloop_sock_handler handler,
-					void *eloop_data)
+					void *eloop_data, int rcvbuf)
 {
 	nl_socket_set_nonblocking(*handle);
+	if (rcvbuf > 0)
+		netlink_sock_set_rcvbuf(nl_socket_get_fd(*handle), rcvbuf);
 	eloop_register_read_sock(nl_socket_get_fd(*handle), handler,
 				 eloop_data, *handle);
 	*handle = (void *) (((intptr_t) *handle) ^ ELOOP_SOCKET_INVALID);
@@ -195,8 +197,22 @@ static void nl80211_destroy_eloop_handle(struct nl_handle **handle)
 #define IF_OPER_UP 6
 #endif
 
+#define NL80211_BSS_HASH_SIZE 64
+
+/* Default receive buffer size for the nl80211 and rtnetlink event sockets */
+#ifndef NL80211_EVENT_RCVBUF
+#define NL80211_EVENT_RCVBUF (512 * 1024)
+#endif /* NL80211_EVENT_RCVBUF */
+
+/* Maximum number of nl_recvmsgs() calls per event socket per eloop call */
+#define NL80211_EVENT_RECV_BUDGET 32
+
 struct nl80211_global {
 	struct dl_list interfaces;
+	/* Lookup of struct i802_bss for global events (see nl80211_bss_hash_*)
+	 */
+	struct i802_bss *ifindex_hash[NL80211_BSS_HASH_SIZE];
+	struct i802_bss *wdev_hash[NL80211_BSS_HASH_SIZE];
 	int if_add_ifindex;
 	u64 if_add_wdevid;
 	int if_add_wdevid_set;
@@ -207,6 +223,14 @@ struct nl80211_global {
 	int ioctl_sock; /* socket for ioctl() use */
 
 	struct nl_handle *nl_event;
+	int event_rcvbuf;
+	unsigned int event_overruns;
+
+	/* Asynchronous commands (see send_and_recv_async()) */
+	struct nl_handle *nl_async;
+	struct nl_cb *nl_async_cb;
+	struct dl_list async_cmds; /* struct nl80211_async_cmd */
+	unsigned int num_async_cmds;
 };
 
 struct nl80211_wiphy_data {
@@ -243,12 +267,25 @@ struct i802_bss {
 	int bandwidth;
 	int if_dynamic;
 
+	/* Hash table state; the keys are the ifindex and wdev_id values used
+	 * when the entry was added */
+	struct i802_bss *ifindex_hnext, *wdev_hnext;
+	int hash_ifindex;
+	u64 hash_wdev_id;
+	unsigned int in_ifindex_hash:1;
+	unsigned int in_wdev_hash:1;
+
 	void *ctx;
 	struct nl_handle *nl_preq, *nl_mgmt;
 	struct nl_cb *nl_cb;
 
 	struct nl80211_wiphy_data *wiphy_data;
 	struct dl_list wiphy_list;
+
+	/* Probe Request filter from set_probe_req_filter() */
+	struct wpa_driver_probe_req_filter probe_req_filter;
+	int probe_req_filter_set;
+	unsigned int probe_req_filtered;
 };
 
 struct wpa_driver_nl80211_data {
@@ -373,6 +410,10 @@ static int nl80211_send_frame_cmd(struct i802_bss *bss,
 				  unsigned int freq, unsigned int wait,
 				  const u8 *buf, size_t buf_len, u64 *cookie,
 				  int no_cck, int no_ack, int offchanok);
+static int nl80211_send_frame_cmd_async(struct i802_bss *bss,
+					unsigned int freq,
+					const u8 *buf, size_t buf_len,
+					int no_cck, int no_ack, int offchanok);
 static int nl80211_register_frame(struct i802_bss *bss,
 				  struct nl_handle *hl_handle,
 				  u16 type, const u8 *match, size_t match_len);
@@ -608,6 +649,93 @@ static struct i802_bss * get_bss_ifindex(struct wpa_driver_nl80211_data *drv,
 }
 
 
+#define NL80211_IFINDEX_HASH(idx) \
+	((unsigned int) (idx) % NL80211_BSS_HASH_SIZE)
+#define NL80211_WDEV_HASH(id) \
+	((unsigned int) ((id) ^ ((id) >> 32)) % NL80211_BSS_HASH_SIZE)
+
+
+static void nl80211_bss_hash_del(struct i802_bss *bss)
+{
+	struct nl80211_global *global = bss->drv->global;
+	struct i802_bss **pos;
+
+	if (bss->in_ifindex_hash) {
+		pos = &global->ifindex_hash[
+			NL80211_IFINDEX_HASH(bss->hash_ifindex)];
+		while (*pos && *pos != bss)
+			pos = &(*pos)->ifindex_hnext;
+		if (*pos)
+			*pos = bss->ifindex_hnext;
+		bss->ifindex_hnext = NULL;
+		bss->in_ifindex_hash = 0;
+	}
+
+	if (bss->in_wdev_hash) {
+		pos = &global->wdev_hash[NL80211_WDEV_HASH(bss->hash_wdev_id)];
+		while (*pos && *pos != bss)
+			pos = &(*pos)->wdev_hnext;
+		if (*pos)
+			*pos = bss->wdev_hnext;
+		bss->wdev_hnext = NULL;
+		bss->in_wdev_hash = 0;
+	}
+}
+
+
+/*
+ * Add a BSS to the global ifindex/wdev_id hash tables with its current ifindex
+ * and wdev_id. This needs to be called again whenever either of them changes.
+ */
+static void nl80211_bss_hash_add(struct i802_bss *bss)
+{
+	struct nl80211_global *global = bss->drv->global;
+	unsigned int idx;
+
+	nl80211_bss_hash_del(bss);
+
+	if (bss->ifindex > 0) {
+		idx = NL80211_IFINDEX_HASH(bss->ifindex);
+		bss->hash_ifindex = bss->ifindex;
+		bss->ifindex_hnext = global->ifindex_hash[idx];
+		global->ifindex_hash[idx] = bss;
+		bss->in_ifindex_hash = 1;
+	}
+
+	if (bss->wdev_id_set) {
+		idx = NL80211_WDEV_HASH(bss->wdev_id);
+		bss->hash_wdev_id = bss->wdev_id;
+		bss->wdev_hnext = global->wdev_hash[idx];
+		global->wdev_hash[idx] = bss;
+		bss->in_wdev_hash = 1;
+	}
+}
+
+
+static struct i802_bss * nl80211_bss_get_ifindex(struct nl80211_global *global,
+						 int ifindex)
+{
+	struct i802_bss *bss;
+
+	bss = global->ifindex_hash[NL80211_IFINDEX_HASH(ifindex)];
+	while (bss && bss->hash_ifindex != ifindex)
+		bss = bss->ifindex_hnext;
+	return bss;
+}
+
+
+static struct i802_bss * nl80211_bss_get_wdev(struct nl80211_global *global,
+					      u64 wdev_id)
+{
+	struct i802_bss *bss;
+
+	bss = global->wdev_hash[NL80211_WDEV_HASH(wdev_id)];
+	while (bss && bss->hash_wdev_id != wdev_id)
+		bss = bss->wdev_hnext;
+	return bss;
+}
+
+
 static void nl80211_mark_disconnected(struct wpa_driver_nl80211_data *drv)
 {
 	if (drv->associated)
@@ -719,6 +847,238 @@ static int send_and_recv_msgs(struct wpa_driver_nl80211_data *drv,
 }
 
 
+/*
+ * Asynchronous commands
+ *
+ * Commands whose result is not needed by the caller are sent on a separate
+ * socket and the responses are processed from the eloop when they arrive
+ * instead of blocking in nl_recvmsgs() for each command. Any number of
+ * commands can be in flight; responses are matched to the requests by the
+ * netlink sequence number. The kernel processes nl80211 commands in the
+ * order they were sent regardless of the socket used, so asynchronous and
+ * synchronous commands can be mixed freely.
+ */
+
+/* Wait for the pending responses if more commands than this are in flight to
+ * avoid overflowing the socket receive buffer */
+#define NL80211_ASYNC_MAX_PENDING 64
+
+struct nl80211_async_cmd {
+	struct dl_list list;
+	u32 seq;
+	u8 cmd;
+	int (*valid_handler)(struct nl_msg *msg, void *arg);
+	void *valid_data;
+	void (*done)(int err, void *ctx);
+	void *ctx;
+};
+
+
+static struct nl80211_async_cmd *
+nl80211_async_get(struct nl80211_global *global, u32 seq)
+{
+	struct nl80211_async_cmd *cmd;
+
+	/* Responses are received in order, so this is normally the first
+	 * entry */
+	dl_list_for_each(cmd, &global->async_cmds, struct nl80211_async_cmd,
+			 list) {
+		if (cmd->seq == seq)
+			return cmd;
+	}
+
+	return NULL;
+}
+
+
+static void nl80211_async_complete(struct nl80211_global *global,
+				   struct nl80211_async_cmd *cmd, int err)
+{
+	dl_list_del(&cmd->list);
+	global->num_async_cmds--;
+
+	if (cmd->done)
+		cmd->done(err, cmd->ctx);
+	else if (err)
+		wpa_printf(MSG_DEBUG, "nl80211: Asynchronous %s failed: %d (%s)",
+			   nl80211_command_to_string(cmd->cmd), err,
+			   strerror(-err));
+	os_free(cmd);
+}
+
+
+static void nl80211_async_fail_all(struct nl80211_global *global, int err)
+{
+	struct nl80211_async_cmd *cmd;
+
+	while ((cmd = dl_list_first(&global->async_cmds,
+				    struct nl80211_async_cmd, list)))
+		nl80211_async_complete(global, cmd, err);
+}
+
+
+static int async_valid_handler(struct nl_msg *msg, void *arg)
+{
+	struct nl80211_global *global = arg;
+	struct nl80211_async_cmd *cmd;
+
+	cmd = nl80211_async_get(global, nlmsg_hdr(msg)->nlmsg_seq);
+	if (cmd && cmd->valid_handler)
+		return cmd->valid_handler(msg, cmd->valid_data);
+	return NL_SKIP;
+}
+
+
+static int async_ack_handler(struct nl_msg *msg, void *arg)
+{
+	struct nl80211_global *global = arg;
+	struct nl80211_async_cmd *cmd;
+
+	cmd = nl80211_async_get(global, nlmsg_hdr(msg)->nlmsg_seq);
+	if (cmd)
+		nl80211_async_complete(global, cmd, 0);
+	return NL_SKIP;
+}
+
+
+static int async_error_handler(struct sockaddr_nl *nla, struct nlmsgerr *err,
+			       void *arg)
+{
+	struct nl80211_global *global = arg;
+	struct nl80211_async_cmd *cmd;
+
+	cmd = nl80211_async_get(global, err->msg.nlmsg_seq);
+	if (cmd)
+		nl80211_async_complete(global, cmd, err->error);
+	return NL_SKIP;
+}
+
+
+static void nl80211_async_receive(int sock, void *eloop_ctx, void *handle)
+{
+	struct nl80211_global *global = eloop_ctx;
+	int res;
+
+	res = nl_recvmsgs(handle, global->nl_async_cb);
+	if (res < 0) {
+		/* Responses may have been lost (e.g., receive buffer overrun),
+		 * so the pending commands cannot be completed anymore */
+		wpa_printf(MSG_INFO, "nl80211: %s->nl_recvmsgs failed: %d",
+			   __func__, res);
+		nl80211_async_fail_all(global, -ENOBUFS);
+	}
+}
+
+
+/**
+ * nl80211_async_flush - Wait for all asynchronous commands to complete
+ * @global: nl80211 global data
+ *
+ * This is the synchronous counterpart of send_and_recv_async() for callers
+ * that need the results of the queued commands before continuing.
+ */
+static void nl80211_async_flush(struct nl80211_global *global)
+{
+	int sock = nl_socket_get_fd(global->nl_async);
+
+	while (!dl_list_empty(&global->async_cmds)) {
+		fd_set rfds;
+		struct timeval tv;
+		int res;
+
+		FD_ZERO(&rfds);
+		FD_SET(sock, &rfds);
+		tv.tv_sec = 1;
+		tv.tv_usec = 0;
+		res = select(sock + 1, &rfds, NULL, NULL, &tv);
+		if (res <= 0) {
+			wpa_printf(MSG_INFO, "nl80211: No response for %u "
+				   "asynchronous command(s)",
+				   global->num_async_cmds);
+			nl80211_async_fail_all(global, -ETIMEDOUT);
+			break;
+		}
+		nl80211_async_receive(sock, global, global->nl_async);
+	}
+}
+
+
+/**
+ * send_and_recv_async - Send a command without waiting for the response
+ * @global: nl80211 global data
+ * @msg: Command; this is freed in all cases
+ * @valid_handler: Handler for response data or %NULL
+ * @valid_data: Context data for valid_handler
+ * @done: Completion callback (called with 0 or -errno) or %NULL
+ * @ctx: Context data for done
+ * Returns: 0 if the command was sent or a negative error code on failure
+ *
+ * Failures are logged if done is %NULL, so done is only needed if the caller
+ * needs to act on the result. Pending callbacks for a context that is going
+ * away can be removed with nl80211_async_cancel().
+ */
+static int send_and_recv_async(struct nl80211_global *global,
+			       struct nl_msg *msg,
+			       int (*valid_handler)(struct nl_msg *, void *),
+			       void *valid_data,
+			       void (*done)(int err, void *ctx), void *ctx)
+{
+	struct nl80211_async_cmd *cmd;
+	int err;
+
+	if (global->num_async_cmds >= NL80211_ASYNC_MAX_PENDING)
+		nl80211_async_flush(global);
+
+	cmd = os_zalloc(sizeof(*cmd));
+	if (cmd == NULL) {
+		nlmsg_free(msg);
+		return -ENOMEM;
+	}
+
+	err = nl_send_auto_complete(global->nl_async, msg);
+	if (err < 0) {
+		os_free(cmd);
+		nlmsg_free(msg);
+		return err;
+	}
+
+	cmd->seq = nlmsg_hdr(msg)->nlmsg_seq;
+	cmd->cmd = ((struct genlmsghdr *) nlmsg_data(nlmsg_hdr(msg)))->cmd;
+	cmd->valid_handler = valid_handler;
+	cmd->valid_data = valid_data;
+	cmd->done = done;
+	cmd->ctx = ctx;
+	dl_list_add_tail(&global->async_cmds, &cmd->list);
+	global->num_async_cmds++;
+	nlmsg_free(msg);
+
+	return 0;
+}
+
+
+/**
+ * nl80211_async_cancel - Remove callbacks of pending asynchronous commands
+ * @global: nl80211 global data
+ * @ctx: Context data (done ctx or valid_data) that is going to be freed
+ */
+static void nl80211_async_cancel(struct nl80211_global *global, void *ctx)
+{
+	struct nl80211_async_cmd *cmd;
+
+	dl_list_for_each(cmd, &global->async_cmds, struct nl80211_async_cmd,
+			 list) {
+		if (cmd->ctx == ctx) {
+			cmd->done = NULL;
+			cmd->ctx = NULL;
+		}
+		if (cmd->valid_data == ctx) {
+			cmd->valid_handler = NULL;
+			cmd->valid_data = NULL;
+		}
+	}
+}
+
+
 struct family_data {
 	const char *group;
 	int id;
@@ -1031,7 +1391,8 @@ nl80211_get_wiphy_data_ap(struct i802_bss *bss)
 		return NULL;
 	}
 
-	nl80211_register_eloop_read(&w->nl_beacons, nl80211_recv_beacons, w);
+	nl80211_register_eloop_read(&w->nl_beacons, nl80211_recv_beacons, w,
+				    0);
 
 	dl_list_add(&nl80211_wiphys, &w->list);
 
@@ -1207,6 +1568,14 @@ static struct wpa_driver_nl80211_data *
 nl80211_find_drv(struct nl80211_global *global, int idx, u8 *buf, size_t len)
 {
 	struct wpa_driver_nl80211_data *drv;
+	struct i802_bss *bss;
+
+	bss = nl80211_bss_get_ifindex(global, idx);
+	if (bss && bss->drv->ifindex == idx)
+		return bss->drv;
+
+	/* Interfaces that are only tracked in if_indices and removed
+	 * interfaces that may need an ifindex update */
 	dl_list_for_each(drv, &global->interfaces,
 			 struct wpa_driver_nl80211_data, list) {
 		if (wpa_driver_nl80211_own_ifindex(drv, idx, buf, len) ||
@@ -1845,6 +2214,16 @@ static void mlme_event_mgmt(struct i802_bss *bss,
 	fc = le_to_host16(mgmt->frame_control);
 	stype = WLAN_FC_GET_STYPE(fc);
 
+	if (stype == WLAN_FC_STYPE_PROBE_REQ && bss->probe_req_filter_set &&
+	    len >= IEEE80211_HDRLEN + sizeof(mgmt->u.probe_req) &&
+	    !probe_req_filter_match(&bss->probe_req_filter,
+				    mgmt->u.probe_req.variable,
+				    len - (IEEE80211_HDRLEN +
+					   sizeof(mgmt->u.probe_req)))) {
+		bss->probe_req_filtered++;
+		return;
+	}
+
 	if (sig)
 		ssi_signal = (s32) nla_get_u32(sig);
 
@@ -3393,34 +3772,26 @@ static int process_global_event(struct nl_msg *msg, void *arg)
 	struct nl80211_global *global = arg;
 	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
 	struct nlattr *tb[NL80211_ATTR_MAX + 1];
-	struct wpa_driver_nl80211_data *drv, *tmp;
-	int ifidx = -1;
+	struct wpa_driver_nl80211_data *drv;
 	struct i802_bss *bss;
-	u64 wdev_id = 0;
-	int wdev_id_set = 0;
 
 	nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
 		  genlmsg_attrlen(gnlh, 0), NULL);
 
-	if (tb[NL80211_ATTR_IFINDEX])
-		ifidx = nla_get_u32(tb[NL80211_ATTR_IFINDEX]);
-	else if (tb[NL80211_ATTR_WDEV]) {
-		wdev_id = nla_get_u64(tb[NL80211_ATTR_WDEV]);
-		wdev_id_set = 1;
+	if (tb[NL80211_ATTR_IFINDEX]) {
+		bss = nl80211_bss_get_ifindex(
+			global, nla_get_u32(tb[NL80211_ATTR_IFINDEX]));
+	} else if (tb[NL80211_ATTR_WDEV]) {
+		bss = nl80211_bss_get_wdev(global,
+					   nla_get_u64(tb[NL80211_ATTR_WDEV]));
+	} else {
+		drv = dl_list_first(&global->interfaces,
+				    struct wpa_driver_nl80211_data, list);
+		bss = drv ? drv->first_bss : NULL;
 	}
 
-	dl_list_for_each_safe(drv, tmp, &global->interfaces,
-			      struct wpa_driver_nl80211_data, list) {
-		for (bss = drv->first_bss; bss; bss = bss->next) {
-			if ((ifidx == -1 && !wdev_id_set) ||
-			    ifidx == bss->ifindex ||
-			    (wdev_id_set && bss->wdev_id_set &&
-			     wdev_id == bss->wdev_id)) {
-				do_process_drv_event(bss, gnlh->cmd, tb);
-				return NL_SKIP;
-			}
-		}
-	}
+	if (bss)
+		do_process_drv_event(bss, gnlh->cmd, tb);
 
 	return NL_SKIP;
 }
@@ -3464,19 +3835,183 @@ static int process_bss_event(struct nl_msg *msg, void *arg)
 }
 
 
+static int nl80211_station_list_handler(struct nl_msg *msg, void *arg)
+{
+	struct wpabuf **list = arg;
+	struct nlattr *tb[NL80211_ATTR_MAX + 1];
+	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+
+	nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
+		  genlmsg_attrlen(gnlh, 0), NULL);
+	if (!tb[NL80211_ATTR_MAC] || nla_len(tb[NL80211_ATTR_MAC]) != ETH_ALEN)
+		return NL_SKIP;
+
+	if (*list == NULL)
+		return NL_SKIP;
+	if (wpabuf_resize(list, ETH_ALEN) < 0) {
+		/* An incomplete list must not be used for resync */
+		wpabuf_free(*list);
+		*list = NULL;
+		return NL_SKIP;
+	}
+	wpabuf_put_data(*list, nla_data(tb[NL80211_ATTR_MAC]), ETH_ALEN);
+
+	return NL_SKIP;
+}
+
+
+static void nl80211_resync_stations(struct i802_bss *bss)
+{
+	struct wpa_driver_nl80211_data *drv = bss->drv;
+	struct nl_msg *msg;
+	struct wpabuf *list;
+	union wpa_event_data event;
+	int ret;
+
+	msg = nlmsg_alloc();
+	if (!msg)
+		return;
+
+	list = wpabuf_alloc(10 * ETH_ALEN);
+	if (!list) {
+		nlmsg_free(msg);
+		return;
+	}
+
+	nl80211_cmd(drv, msg, NLM_F_DUMP, NL80211_CMD_GET_STATION);
+	NLA_PUT_U32(msg, NL80211_ATTR_IFINDEX, bss->ifindex);
+
+	ret = send_and_recv_msgs(drv, msg, nl80211_station_list_handler,
+				 &list);
+	msg = NULL;
+	if (ret < 0 || list == NULL) {
+		wpa_printf(MSG_INFO, "nl80211: Station dump for %s failed: %d",
+			   bss->ifname, ret);
+		goto nla_put_failure;
+	}
+
+	os_memset(&event, 0, sizeof(event));
+	event.station_list.addr = wpabuf_head(list);
+	event.station_list.num = wpabuf_len(list) / ETH_ALEN;
+	wpa_supplicant_event(bss->ctx, EVENT_STATION_LIST, &event);
+
+ nla_put_failure:
+	nlmsg_free(msg);
+	wpabuf_free(list);
+}
+
+
+static void nl80211_resync_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct nl80211_global *global = eloop_ctx;
+	struct wpa_driver_nl80211_data *drv;
+	struct i802_bss *bss;
+
+	/*
+	 * Events lost in the overrun may include (re)association, TX status,
+	 * and disconnection events for AP mode stations. Fetch the current
+	 * station list from the kernel so that the upper layer can clean up
+	 * stations whose state no longer matches the driver.
+	 */
+	dl_list_for_each(drv, &global->interfaces,
+			 struct wpa_driver_nl80211_data, list) {
+		if (!is_ap_interface(drv->nlmode))
+			continue;
+		for (bss = drv->first_bss; bss; bss = bss->next)
+			nl80211_resync_stations(bss);
+	}
+}
+
+
+/*
+ * Receive up to NL80211_EVENT_RECV_BUDGET batches of messages from an event
+ * socket. Returns 1 if the kernel reported that messages were dropped due to
+ * a full receive buffer or 0 if not.
+ */
+static int nl80211_recv_events(struct nl80211_global *global,
+			       struct nl_handle *handle, struct nl_cb *cb)
+{
+	int sock = nl_socket_get_fd(handle);
+	int i, res, overrun = 0;
+	char c;
+
+	for (i = 0; i < NL80211_EVENT_RECV_BUDGET; i++) {
+		/*
+		 * Peek first to find out whether more messages are pending.
+		 * This also consumes a pending ENOBUFS error so that an
+		 * overrun is detected the same way with all libnl versions.
+		 */
+		if (recv(sock, &c, sizeof(c), MSG_PEEK | MSG_DONTWAIT) < 0) {
+			if (errno == ENOBUFS) {
+				global->event_overruns++;
+				overrun = 1;
+				continue;
+			}
+			if (errno != EAGAIN && errno != EINTR)
+				wpa_printf(MSG_INFO, "nl80211: Event socket "
+					   "recv failed: %s", strerror(errno));
+			break;
+		}
+
+		res = nl_recvmsgs(handle, cb);
+		if (res < 0) {
+			wpa_printf(MSG_INFO,
+				   "nl80211: %s->nl_recvmsgs failed: %d",
+				   __func__, res);
+			break;
+		}
+	}
+
+	if (overrun)
+		wpa_printf(MSG_INFO, "nl80211: Event socket receive buffer "
+			   "overrun (total %u)", global->event_overruns);
+
+	return overrun;
+}
+
+
+static void nl80211_schedule_resync(struct nl80211_global *global)
+{
+	/* Coalesce overruns reported during the same eloop iteration */
+	if (eloop_is_timeout_registered(nl80211_resync_timeout, global, NULL))
+		return;
+	eloop_register_timeout(0, 0, nl80211_resync_timeout, global, NULL);
+}
+
+
 static void wpa_driver_nl80211_event_receive(int sock, void *eloop_ctx,
 					     void *handle)
 {
-	struct nl_cb *cb = eloop_ctx;
-	int res;
+	struct nl80211_global *global = eloop_ctx;
 
 	wpa_printf(MSG_MSGDUMP, "nl80211: Event message available");
 
-	res = nl_recvmsgs(handle, cb);
-	if (res < 0) {
-		wpa_printf(MSG_INFO, "nl80211: %s->nl_recvmsgs failed: %d",
-			   __func__, res);
-	}
+	if (nl80211_recv_events(global, handle, global->nl_cb))
+		nl80211_schedule_resync(global);
+}
+
+
+static void nl80211_mgmt_event_receive(int sock, void *eloop_ctx,
+				       void *handle)
+{
+	struct i802_bss *bss = eloop_ctx;
+
+	wpa_printf(MSG_MSGDUMP, "nl80211: Frame event message available");
+
+	if (nl80211_recv_events(bss->drv->global, handle, bss->nl_cb))
+		nl80211_schedule_resync(bss->drv->global);
+}
+
+
+static void nl80211_preq_event_receive(int sock, void *eloop_ctx,
+				       void *handle)
+{
+	struct i802_bss *bss = eloop_ctx;
+
+	wpa_printf(MSG_MSGDUMP, "nl80211: Probe Request event available");
+
+	/* Lost Probe Request frames do not affect station state */
+	nl80211_recv_events(bss->drv->global, handle, bss->nl_cb);
 }
 
 
@@ -4388,13 +4923,40 @@ static int wpa_driver_nl80211_init_nl_global(struct nl80211_global *global)
 	nl_cb_set(global->nl_cb, NL_CB_VALID, NL_CB_CUSTOM,
 		  process_global_event, global);
 
+	global->nl_async_cb = nl_cb_alloc(NL_CB_DEFAULT);
+	if (global->nl_async_cb == NULL)
+		goto err;
+	global->nl_async = nl_create_handle(global->nl_async_cb, "async");
+	if (global->nl_async == NULL)
+		goto err;
+
 	nl80211_register_eloop_read(&global->nl_event,
 				    wpa_driver_nl80211_event_receive,
-				    global->nl_cb);
+				    global, global->event_rcvbuf);
+
+	nl_cb_set(global->nl_async_cb, NL_CB_SEQ_CHECK, NL_CB_CUSTOM,
+		  no_seq_check, NULL);
+	nl_cb_set(global->nl_async_cb, NL_CB_VALID, NL_CB_CUSTOM,
+		  async_valid_handler, global);
+	nl_cb_set(global->nl_async_cb, NL_CB_ACK, NL_CB_CUSTOM,
+		  async_ack_handler, global);
+	nl_cb_err(global->nl_async_cb, NL_CB_CUSTOM, async_error_handler,
+		  global);
+	/* The handle is used directly in nl80211_async_flush(), so it is not
+	 * registered with nl80211_register_eloop_read() */
+	nl_socket_set_nonblocking(global->nl_async);
+	eloop_register_read_sock(nl_socket_get_fd(global->nl_async),
+				 nl80211_async_receive, global,
+				 global->nl_async);
 
 	return 0;
 
 err:
+	nl_destroy_handles(&global->nl_async);
+	if (global->nl_async_cb) {
+		nl_cb_put(global->nl_async_cb);
+		global->nl_async_cb = NULL;
+	}
 	nl_destroy_handles(&global->nl_event);
 	nl_destroy_handles(&global->nl);
 	nl_cb_put(global->nl_cb);
@@ -4519,6 +5081,7 @@ static int nl80211_init_bss(struct i802_bss *bss)
 
 static void nl80211_destroy_bss(struct i802_bss *bss)
 {
+	nl80211_async_cancel(bss->drv->global, bss);
 	nl_cb_put(bss->nl_cb);
 	bss->nl_cb = NULL;
 }
@@ -4700,8 +5263,8 @@ static int nl80211_alloc_mgmt_handle(struct i802_bss *bss)
 static void nl80211_mgmt_handle_register_eloop(struct i802_bss *bss)
 {
 	nl80211_register_eloop_read(&bss->nl_mgmt,
-				    wpa_driver_nl80211_event_receive,
-				    bss->nl_cb);
+				    nl80211_mgmt_event_receive, bss,
+				    bss->drv->global->event_rcvbuf);
 }
 
 
@@ -5014,6 +5577,7 @@ wpa_driver_nl80211_finish_drv_init(struct wpa_driver_nl80211_data *drv,
 	bss->ifindex = drv->ifindex;
 	bss->wdev_id = drv->global->if_add_wdevid;
 	bss->wdev_id_set = drv->global->if_add_wdevid_set;
+	nl80211_bss_hash_add(bss);
 
 	bss->if_dynamic = drv->ifindex == drv->global->if_add_ifindex;
 	bss->if_dynamic = bss->if_dynamic || drv->global->if_add_wdevid_set;
@@ -5118,6 +5682,7 @@ static int wpa_driver_nl80211_del_beacon(struct wpa_driver_nl80211_data *drv)
 static void wpa_driver_nl80211_deinit(struct i802_bss *bss)
 {
 	struct wpa_driver_nl80211_data *drv = bss->drv;
+	struct i802_bss *tbss;
 
 	bss->in_deinit = 1;
 	if (drv->data_tx_status)
@@ -5190,6 +5755,8 @@ static void wpa_driver_nl80211_deinit(struct i802_bss *bss)
 	nl_cb_put(drv->nl_cb);
 
 	nl80211_destroy_bss(drv->first_bss);
+	for (tbss = drv->first_bss; tbss; tbss = tbss->next)
+		nl80211_bss_hash_del(tbss);
 
 	os_free(drv->filter_ssids);
 
@@ -7303,6 +7870,9 @@ static int wpa_driver_nl80211_send_frame(struct i802_bss *bss,
 					 int offchanok, unsigned int wait_time)
 {
 	struct wpa_driver_nl80211_data *drv = bss->drv;
+	const struct ieee80211_mgmt *mgmt;
+	u16 fc;
+	int action;
 	u64 cookie;
 	int res;
 
@@ -7325,17 +7895,25 @@ static int wpa_driver_nl80211_send_frame(struct i802_bss *bss,
 						    encrypt, noack);
 	}
 
+	mgmt = (const struct ieee80211_mgmt *) data;
+	fc = le_to_host16(mgmt->frame_control);
+	action = WLAN_FC_GET_TYPE(fc) == WLAN_FC_TYPE_MGMT &&
+		WLAN_FC_GET_STYPE(fc) == WLAN_FC_STYPE_ACTION;
+
+	if (is_ap_interface(drv->nlmode) && !wait_time && !action) {
+		/* TX status in AP mode does not use the cookie, so there is no
+		 * need to wait for the response */
+		wpa_printf(MSG_DEBUG,
+			   "nl80211: send_frame -> send_frame_cmd_async");
+		return nl80211_send_frame_cmd_async(bss, freq, data, len,
+						    no_cck, noack, offchanok);
+	}
+
 	wpa_printf(MSG_DEBUG, "nl80211: send_frame -> send_frame_cmd");
 	res = nl80211_send_frame_cmd(bss, freq, wait_time, data, len,
 				     &cookie, no_cck, noack, offchanok);
 	if (res == 0 && !noack) {
-		const struct ieee80211_mgmt *mgmt;
-		u16 fc;
-
-		mgmt = (const struct ieee80211_mgmt *) data;
-		fc = le_to_host16(mgmt->frame_control);
-		if (WLAN_FC_GET_TYPE(fc) == WLAN_FC_TYPE_MGMT &&
-		    WLAN_FC_GET_STYPE(fc) == WLAN_FC_STYPE_ACTION) {
+		if (action) {
 			wpa_printf(MSG_MSGDUMP,
 				   "nl80211: Update send_action_cookie from 0x%llx to 0x%llx",
 				   (long long unsigned int)
@@ -7991,6 +8569,16 @@ static void rtnl_neigh_delete_fdb_entry(struct i802_bss *bss, const u8 *addr)
 }
 
 
+static void nl80211_sta_remove_done(int err, void *ctx)
+{
+	struct i802_bss *bss = ctx;
+
+	if (err && err != -ENOENT)
+		wpa_printf(MSG_DEBUG, "nl80211: DEL_STATION on %s failed: %d (%s)",
+			   bss->ifname, err, strerror(-err));
+}
+
+
 static int wpa_driver_nl80211_sta_remove(struct i802_bss *bss, const u8 *addr,
 					 int deauth, u16 reason_code)
 {
@@ -8016,7 +8604,14 @@ static int wpa_driver_nl80211_sta_remove(struct i802_bss *bss, const u8 *addr,
 	if (reason_code)
 		NLA_PUT_U16(msg, NL80211_ATTR_REASON_CODE, reason_code);
 
-	ret = send_and_recv_msgs(drv, msg, NULL, NULL);
+	/*
+	 * The result is not needed here and the kernel processes the commands
+	 * in the order they are sent regardless of the socket, so do not wait
+	 * for the response. This avoids a round trip per station when many
+	 * stations are removed at once.
+	 */
+	ret = send_and_recv_async(drv->global, msg, NULL, NULL,
+				  nl80211_sta_remove_done, bss);
 	wpa_printf(MSG_DEBUG, "nl80211: sta_remove -> DEL_STATION %s " MACSTR
 		   " --> %d (%s)",
 		   bss->ifname, MAC2STR(addr), ret, strerror(-ret));
@@ -8024,8 +8619,6 @@ static int wpa_driver_nl80211_sta_remove(struct i802_bss *bss, const u8 *addr,
 	if (drv->rtnl_sk)
 		rtnl_neigh_delete_fdb_entry(bss, addr);
 
-	if (ret == -ENOENT)
-		return 0;
 	return ret;
  nla_put_failure:
 	nlmsg_free(msg);
@@ -9901,11 +10494,9 @@ static int i802_flush(void *priv)
 }
 
 
-static int get_sta_handler(struct nl_msg *msg, void *arg)
+static int nl80211_parse_sta_info(struct nlattr *sta_info,
+				  struct hostap_sta_driver_data *data)
 {
-	struct nlattr *tb[NL80211_ATTR_MAX + 1];
-	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
-	struct hostap_sta_driver_data *data = arg;
 	struct nlattr *stats[NL80211_STA_INFO_MAX + 1];
 	static struct nla_policy stats_policy[NL80211_STA_INFO_MAX + 1] = {
 		[NL80211_STA_INFO_INACTIVE_TIME] = { .type = NLA_U32 },
@@ -9916,24 +10507,14 @@ static int get_sta_handler(struct nl_msg *msg, void *arg)
 		[NL80211_STA_INFO_TX_FAILED] = { .type = NLA_U32 },
 	};
 
-	nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
-		  genlmsg_attrlen(gnlh, 0), NULL);
-
-	/*
-	 * TODO: validate the interface and mac address!
-	 * Otherwise, there's a race condition as soon as
-	 * the kernel starts sending station notifications.
-	 */
-
-	if (!tb[NL80211_ATTR_STA_INFO]) {
+	if (!sta_info) {
 		wpa_printf(MSG_DEBUG, "sta stats missing!");
-		return NL_SKIP;
+		return -1;
 	}
-	if (nla_parse_nested(stats, NL80211_STA_INFO_MAX,
-			     tb[NL80211_ATTR_STA_INFO],
+	if (nla_parse_nested(stats, NL80211_STA_INFO_MAX, sta_info,
 			     stats_policy)) {
 		wpa_printf(MSG_DEBUG, "failed to parse nested attributes!");
-		return NL_SKIP;
+		return -1;
 	}
 
 	if (stats[NL80211_STA_INFO_INACTIVE_TIME])
@@ -9953,6 +10534,27 @@ static int get_sta_handler(struct nl_msg *msg, void *arg)
 		data->tx_retry_failed =
 			nla_get_u32(stats[NL80211_STA_INFO_TX_FAILED]);
 
+	return 0;
+}
+
+
+static int get_sta_handler(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *tb[NL80211_ATTR_MAX + 1];
+	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+	struct hostap_sta_driver_data *data = arg;
+
+	nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
+		  genlmsg_attrlen(gnlh, 0), NULL);
+
+	/*
+	 * TODO: validate the interface and mac address!
+	 * Otherwise, there's a race condition as soon as
+	 * the kernel starts sending station notifications.
+	 */
+
+	nl80211_parse_sta_info(tb[NL80211_ATTR_STA_INFO], data);
+
 	return NL_SKIP;
 }
 
@@ -9980,6 +10582,83 @@ static int i802_read_sta_data(struct i802_bss *bss,
 }
 
 
+struct nl80211_sta_dump_arg {
+	void (*cb)(void *ctx, const u8 *addr,
+		   struct hostap_sta_driver_data *data);
+	void *ctx;
+};
+
+
+static int get_all_sta_handler(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *tb[NL80211_ATTR_MAX + 1];
+	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+	struct nl80211_sta_dump_arg *dump = arg;
+	struct hostap_sta_driver_data data;
+
+	nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
+		  genlmsg_attrlen(gnlh, 0), NULL);
+	if (!tb[NL80211_ATTR_MAC] || nla_len(tb[NL80211_ATTR_MAC]) != ETH_ALEN)
+		return NL_SKIP;
+
+	os_memset(&data, 0, sizeof(data));
+	if (nl80211_parse_sta_info(tb[NL80211_ATTR_STA_INFO], &data) == 0)
+		dump->cb(dump->ctx, nla_data(tb[NL80211_ATTR_MAC]), &data);
+
+	return NL_SKIP;
+}
+
+
+static int i802_read_all_sta_data(void *priv,
+				  void (*cb)(void *ctx, const u8 *addr,
+					     struct hostap_sta_driver_data *data),
+				  void *ctx)
+{
+	struct i802_bss *bss = priv;
+	struct wpa_driver_nl80211_data *drv = bss->drv;
+	struct nl80211_sta_dump_arg dump;
+	struct nl_msg *msg;
+
+	msg = nlmsg_alloc();
+	if (!msg)
+		return -ENOMEM;
+
+	nl80211_cmd(drv, msg, NLM_F_DUMP, NL80211_CMD_GET_STATION);
+	NLA_PUT_U32(msg, NL80211_ATTR_IFINDEX, if_nametoindex(bss->ifname));
+
+	dump.cb = cb;
+	dump.ctx = ctx;
+	return send_and_recv_msgs(drv, msg, get_all_sta_handler, &dump);
+ nla_put_failure:
+	nlmsg_free(msg);
+	return -ENOBUFS;
+}
+
+
+static int i802_set_probe_req_filter(
+	void *priv, const struct wpa_driver_probe_req_filter *filter)
+{
+	struct i802_bss *bss = priv;
+
+	/*
+	 * The kernel has no content based filter for management frames that
+	 * are registered for userspace, so the filter is applied when the
+	 * frame is received from the nl80211 socket. This avoids the
+	 * EVENT_RX_MGMT processing of frames that would be ignored.
+	 */
+	if (filter) {
+		os_memcpy(&bss->probe_req_filter, filter, sizeof(*filter));
+		bss->probe_req_filter_set = 1;
+	} else {
+		bss->probe_req_filter_set = 0;
+	}
+	wpa_printf(MSG_DEBUG, "nl80211: %s Probe Request filter for %s",
+		   filter ? "Set" : "Clear", bss->ifname);
+
+	return 0;
+}
+
+
 static int i802_set_tx_queue_params(void *priv, int queue, int aifs,
 				    int cw_min, int cw_max, int burst_time)
 {
@@ -10672,6 +11351,7 @@ static int wpa_driver_nl80211_if_add(void *priv, enum wpa_driver_if_type type,
 		if (drv_priv)
 			*drv_priv = new_bss;
 		nl80211_init_bss(new_bss);
+		nl80211_bss_hash_add(new_bss);
 
 		/* Subscribe management frames for this WPA_IF_AP_BSS */
 		if (nl80211_setup_ap(new_bss))
@@ -10738,6 +11418,7 @@ static int wpa_driver_nl80211_if_remove(struct i802_bss *bss,
 		for (tbss = drv->first_bss; tbss; tbss = tbss->next) {
 			if (tbss->next == bss) {
 				tbss->next = bss->next;
+				nl80211_bss_hash_del(bss);
 				/* Unsubscribe management frames */
 				nl80211_teardown_ap(bss);
 				nl80211_destroy_bss(bss);
@@ -10762,6 +11443,7 @@ static int wpa_driver_nl80211_if_remove(struct i802_bss *bss,
 		if (drv->first_bss->next) {
 			drv->first_bss = drv->first_bss->next;
 			drv->ctx = drv->first_bss->ctx;
+			nl80211_bss_hash_del(bss);
 			os_free(bss);
 		} else {
 			wpa_printf(MSG_DEBUG, "nl80211: No second BSS to reassign context to");
@@ -10785,20 +11467,19 @@ static int cookie_handler(struct nl_msg *msg, void *arg)
 }
 
 
-static int nl80211_send_frame_cmd(struct i802_bss *bss,
-				  unsigned int freq, unsigned int wait,
-				  const u8 *buf, size_t buf_len,
-				  u64 *cookie_out, int no_cck, int no_ack,
-				  int offchanok)
+static struct nl_msg * nl80211_frame_cmd_msg(struct i802_bss *bss,
+					     unsigned int freq,
+					     unsigned int wait,
+					     const u8 *buf, size_t buf_len,
+					     int no_cck, int no_ack,
+					     int offchanok)
 {
 	struct wpa_driver_nl80211_data *drv = bss->drv;
 	struct nl_msg *msg;
-	u64 cookie;
-	int ret = -1;
 
 	msg = nlmsg_alloc();
 	if (!msg)
-		return -1;
+		return NULL;
 
 	wpa_printf(MSG_MSGDUMP, "nl80211: CMD_FRAME freq=%u wait=%u no_cck=%d "
 		   "no_ack=%d offchanok=%d",
@@ -10822,14 +11503,37 @@ static int nl80211_send_frame_cmd(struct i802_bss *bss,
 
 	NLA_PUT(msg, NL80211_ATTR_FRAME, buf_len, buf);
 
+	return msg;
+
+nla_put_failure:
+	nlmsg_free(msg);
+	return NULL;
+}
+
+
+static int nl80211_send_frame_cmd(struct i802_bss *bss,
+				  unsigned int freq, unsigned int wait,
+				  const u8 *buf, size_t buf_len,
+				  u64 *cookie_out, int no_cck, int no_ack,
+				  int offchanok)
+{
+	struct wpa_driver_nl80211_data *drv = bss->drv;
+	struct nl_msg *msg;
+	u64 cookie;
+	int ret;
+
+	msg = nl80211_frame_cmd_msg(bss, freq, wait, buf, buf_len, no_cck,
+				    no_ack, offchanok);
+	if (!msg)
+		return -1;
+
 	cookie = 0;
 	ret = send_and_recv_msgs(drv, msg, cookie_handler, &cookie);
-	msg = NULL;
 	if (ret) {
 		wpa_printf(MSG_DEBUG, "nl80211: Frame command failed: ret=%d "
 			   "(%s) (freq=%u wait=%u)", ret, strerror(-ret),
 			   freq, wait);
-		goto nla_put_failure;
+		return ret;
 	}
 	wpa_printf(MSG_MSGDUMP, "nl80211: Frame TX command accepted%s; "
 		   "cookie 0x%llx", no_ack ? " (no ACK)" : "",
@@ -10838,9 +11542,40 @@ static int nl80211_send_frame_cmd(struct i802_bss *bss,
 	if (cookie_out)
 		*cookie_out = no_ack ? (u64) -1 : cookie;
 
-nla_put_failure:
-	nlmsg_free(msg);
-	return ret;
+	return 0;
+}
+
+
+static void nl80211_frame_cmd_done(int err, void *ctx)
+{
+	struct i802_bss *bss = ctx;
+
+	if (err)
+		wpa_printf(MSG_DEBUG, "nl80211: Frame command failed on %s: "
+			   "ret=%d (%s)", bss->ifname, err, strerror(-err));
+}
+
+
+/*
+ * Send a frame without waiting for the kernel to accept it. This can be used
+ * when the cookie is not needed (no wait time and TX status is matched
+ * without the cookie, i.e., in AP mode). Failure to queue the frame for
+ * transmission is only logged.
+ */
+static int nl80211_send_frame_cmd_async(struct i802_bss *bss,
+					unsigned int freq,
+					const u8 *buf, size_t buf_len,
+					int no_cck, int no_ack, int offchanok)
+{
+	struct nl_msg *msg;
+
+	msg = nl80211_frame_cmd_msg(bss, freq, 0, buf, buf_len, no_cck,
+				    no_ack, offchanok);
+	if (!msg)
+		return -1;
+
+	return send_and_recv_async(bss->drv->global, msg, NULL, NULL,
+				   nl80211_frame_cmd_done, bss);
 }
 
 
@@ -11043,8 +11778,8 @@ static int wpa_driver_nl80211_probe_req_report(struct i802_bss *bss, int report)
 		goto out_err;
 
 	nl80211_register_eloop_read(&bss->nl_preq,
-				    wpa_driver_nl80211_event_receive,
-				    bss->nl_cb);
+				    nl80211_preq_event_receive, bss,
+				    drv->global->event_rcvbuf);
 
 	return 0;
 
@@ -11406,6 +12141,29 @@ static int nl80211_set_param(void *priv, const char *param)
 		drv->test_use_roc_tx = 1;
 	}
 
+	if (os_strstr(param, "event_rcvbuf=")) {
+		struct i802_bss *bss = priv;
+		struct nl80211_global *global = bss->drv->global;
+		struct nl_handle *nl_event;
+
+		/*
+		 * Applies to the shared event sockets immediately and to the
+		 * per-BSS frame sockets registered after this.
+		 */
+		global->event_rcvbuf =
+			atoi(os_strstr(param, "event_rcvbuf=") + 13);
+		wpa_printf(MSG_DEBUG, "nl80211: Event socket receive buffer "
+			   "size %d", global->event_rcvbuf);
+		if (global->event_rcvbuf > 0) {
+			nl_event = (void *) (((intptr_t) global->nl_event) ^
+					     ELOOP_SOCKET_INVALID);
+			netlink_sock_set_rcvbuf(nl_socket_get_fd(nl_event),
+						global->event_rcvbuf);
+			netlink_set_rcvbuf(global->netlink,
+					   global->event_rcvbuf);
+		}
+	}
+
 	return 0;
 }
 
@@ -11420,7 +12178,9 @@ static void * nl80211_global_init(void)
 		return NULL;
 	global->ioctl_sock = -1;
 	dl_list_init(&global->interfaces);
+	dl_list_init(&global->async_cmds);
 	global->if_add_ifindex = -1;
+	global->event_rcvbuf = NL80211_EVENT_RCVBUF;
 
 	cfg = os_zalloc(sizeof(*cfg));
 	if (cfg == NULL)
@@ -11434,6 +12194,7 @@ static void * nl80211_global_init(void)
 		os_free(cfg);
 		goto err;
 	}
+	netlink_set_rcvbuf(global->netlink, global->event_rcvbuf);
 
 	if (wpa_driver_nl80211_init_nl_global(global) < 0)
 		goto err;
@@ -11464,6 +12225,8 @@ static void nl80211_global_deinit(void *priv)
 			   dl_list_len(&global->interfaces));
 	}
 
+	eloop_cancel_timeout(nl80211_resync_timeout, global, NULL);
+
 	if (global->netlink)
 		netlink_deinit(global->netlink);
 
@@ -11472,6 +12235,14 @@ static void nl80211_global_deinit(void *priv)
 	if (global->nl_event)
 		nl80211_destroy_eloop_handle(&global->nl_event);
 
+	if (global->nl_async) {
+		nl80211_async_flush(global);
+		eloop_unregister_read_sock(nl_socket_get_fd(global->nl_async));
+		nl_destroy_handles(&global->nl_async);
+	}
+	if (global->nl_async_cb)
+		nl_cb_put(global->nl_async_cb);
+
 	nl_cb_put(global->nl_cb);
 
 	if (global->ioctl_sock >= 0)
@@ -12343,6 +13114,17 @@ static int wpa_driver_nl80211_status(void *priv, char *buf, size_t buflen)
 		return pos - buf;
 	pos += res;
 
+	res = os_snprintf(pos, end - pos,
+			  "event_overruns=%u\n"
+			  "rtnetlink_overruns=%u\n"
+			  "probe_req_filtered=%u\n",
+			  drv->global->event_overruns,
+			  netlink_get_overruns(drv->global->netlink),
+			  bss->probe_req_filtered);
+	if (res < 0 || res >= end - pos)
+		return pos - buf;
+	pos += res;
+
 	if (bss->wdev_id_set) {
 		res = os_snprintf(pos, end - pos, "wdev_id=%llu\n",
 				  (unsigned long long) bss->wdev_id);
@@ -12999,6 +13781,8 @@ const struct wpa_driver_ops wpa_driver_nl80211_ops = {
 	.get_seqnum = i802_get_seqnum,
 	.flush = i802_flush,
 	.get_inact_sec = i802_get_inact_sec,
+	.read_all_sta_data = i802_read_all_sta_data,
+	.set_probe_req_filter = i802_set_probe_req_filter,
 	.sta_clear_stats = i802_sta_clear_stats,
 	.set_rts = i802_set_rts,
 	.set_frag = i802_set_frag,
@@ -55,6 +55,8 @@ struct test_driver_bss {
 	u8 ssid[32];
 	size_t ssid_len;
 	int privacy;
+	struct wpa_driver_probe_req_filter probe_req_filter;
+	int probe_req_filter_set;
 };
 
 struct wpa_driver_test_global {
@@ -97,6 +99,7 @@ struct wpa_driver_test_data {
 	int alloc_iface_idx;
 
 	int probe_req_report;
+	unsigned int probe_req_filtered;
 	unsigned int remain_on_channel_freq;
 	unsigned int remain_on_channel_duration;
 
@@ -698,6 +701,30 @@ static void test_driver_ether(struct wpa_driver_test_data *drv,
 }
 
 
+/* Returns 1 if the Probe Request frame passes the filter of any BSS */
+static int test_driver_probe_req_filter(struct wpa_driver_test_data *drv,
+					const u8 *data, size_t datalen)
+{
+	const struct ieee80211_mgmt *mgmt;
+	struct test_driver_bss *bss;
+
+	mgmt = (const struct ieee80211_mgmt *) data;
+	if (datalen < IEEE80211_HDRLEN + sizeof(mgmt->u.probe_req))
+		return 1;
+
+	dl_list_for_each(bss, &drv->bss, struct test_driver_bss, list) {
+		if (!bss->probe_req_filter_set ||
+		    probe_req_filter_match(&bss->probe_req_filter,
+					   mgmt->u.probe_req.variable,
+					   datalen - (IEEE80211_HDRLEN +
+						      sizeof(mgmt->u.probe_req))))
+			return 1;
+	}
+
+	return 0;
+}
+
+
 static void test_driver_mlme(struct wpa_driver_test_data *drv,
 			     struct sockaddr_un *from, socklen_t fromlen,
 			     u8 *data, size_t datalen)
@@ -763,6 +790,15 @@ static void test_driver_mlme(struct wpa_driver_test_data *drv,
 		return;
 	}
 
+	if (WLAN_FC_GET_STYPE(fc) == WLAN_FC_STYPE_PROBE_REQ &&
+	    !test_driver_probe_req_filter(drv, data, datalen)) {
+		drv->probe_req_filtered++;
+		wpa_printf(MSG_EXCESSIVE, "test_driver: Probe Request from "
+			   MACSTR " filtered (total %u)",
+			   MAC2STR(hdr->addr2), drv->probe_req_filtered);
+		return;
+	}
+
 	os_memset(&event, 0, sizeof(event));
 	event.rx_mgmt.frame = data;
 	event.rx_mgmt.frame_len = datalen;
@@ -834,6 +870,24 @@ static int test_driver_set_generic_elem(void *priv,
 }
 
 
+static int test_driver_set_probe_req_filter(
+	void *priv, const struct wpa_driver_probe_req_filter *filter)
+{
+	struct test_driver_bss *bss = priv;
+
+	wpa_printf(MSG_DEBUG, "test_driver(%s): %s Probe Request filter",
+		   bss->ifname, filter ? "Set" : "Clear");
+	if (filter) {
+		os_memcpy(&bss->probe_req_filter, filter, sizeof(*filter));
+		bss->probe_req_filter_set = 1;
+	} else {
+		bss->probe_req_filter_set = 0;
+	}
+
+	return 0;
+}
+
+
 static int test_driver_set_ap_wps_ie(void *priv, const struct wpabuf *beacon,
 				     const struct wpabuf *proberesp,
 				     const struct wpabuf *assocresp)
@@ -2658,6 +2712,7 @@ const struct wpa_driver_ops wpa_driver_test_ops = {
 	.sta_add = test_driver_sta_add,
 	.send_ether = test_driver_send_ether,
 	.set_ap_wps_ie = test_driver_set_ap_wps_ie,
+	.set_probe_req_filter = test_driver_set_probe_req_filter,
 	.get_bssid = wpa_driver_test_get_bssid,
 	.get_ssid = wpa_driver_test_get_ssid,
 	.set_key = wpa_driver_test_set_key,
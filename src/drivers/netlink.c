@@ -14,12 +14,39 @@
 #include "netlink.h"
 
 
+/* Maximum number of messages to receive from the socket per eloop call */
+#define NETLINK_RECV_BUDGET 32
+
 struct netlink_data {
 	struct netlink_config *cfg;
 	int sock;
+	unsigned int overruns;
 };
 
 
+static int netlink_request_links(struct netlink_data *netlink)
+{
+	struct {
+		struct nlmsghdr hdr;
+		struct ifinfomsg ifi;
+	} req;
+
+	os_memset(&req, 0, sizeof(req));
+	req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+	req.hdr.nlmsg_type = RTM_GETLINK;
+	req.hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	req.ifi.ifi_family = AF_UNSPEC;
+
+	if (send(netlink->sock, &req, req.hdr.nlmsg_len, 0) < 0) {
+		wpa_printf(MSG_INFO, "netlink: Failed to request link dump: %s",
+			   strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+
 static void netlink_receive_link(struct netlink_data *netlink,
 				 void (*cb)(void *ctx, struct ifinfomsg *ifi,
 					    u8 *buf, size_t len),
@@ -41,12 +68,27 @@ static void netlink_receive(int sock, void *eloop_ctx, void *sock_ctx)
 	struct sockaddr_nl from;
 	socklen_t fromlen;
 	struct nlmsghdr *h;
-	int max_events = 10;
+	int max_events = NETLINK_RECV_BUDGET;
 
 try_again:
 	fromlen = sizeof(from);
 	left = recvfrom(sock, buf, sizeof(buf), MSG_DONTWAIT,
 			(struct sockaddr *) &from, &fromlen);
+	if (left < 0 && errno == ENOBUFS) {
+		/*
+		 * The kernel dropped messages since the socket receive buffer
+		 * was full. Request the current state of all links so that
+		 * the lost RTM_NEWLINK/RTM_DELLINK events are reflected in the
+		 * link dump processed below like any other RTM_NEWLINK.
+		 */
+		netlink->overruns++;
+		wpa_printf(MSG_INFO, "netlink: Receive buffer overrun (%u) - "
+			   "resynchronizing link state", netlink->overruns);
+		netlink_request_links(netlink);
+		if (--max_events > 0)
+			goto try_again;
+		return;
+	}
 	if (left < 0) {
 		if (errno != EINTR && errno != EAGAIN)
 			wpa_printf(MSG_INFO, "netlink: recvfrom failed: %s",
@@ -125,6 +167,54 @@ struct netlink_data * netlink_init(struct netlink_config *cfg)
 }
 
 
+/**
+ * netlink_sock_set_rcvbuf - Set the receive buffer size of a netlink socket
+ * @sock: Socket
+ * @size: Receive buffer size in octets
+ * Returns: 0 on success or -1 on failure
+ *
+ * SO_RCVBUFFORCE is used first so that the size is not limited by
+ * net.core.rmem_max when running with CAP_NET_ADMIN.
+ */
+int netlink_sock_set_rcvbuf(int sock, int size)
+{
+#ifdef SO_RCVBUFFORCE
+	if (setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &size,
+		       sizeof(size)) == 0)
+		return 0;
+#endif /* SO_RCVBUFFORCE */
+	if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) < 0) {
+		wpa_printf(MSG_INFO, "netlink: Failed to set receive buffer "
+			   "size %d: %s", size, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+
+/**
+ * netlink_set_rcvbuf - Set the receive buffer size of the rtnetlink socket
+ * @netlink: Pointer to data from netlink_init()
+ * @size: Receive buffer size in octets
+ * Returns: 0 on success or -1 on failure
+ */
+int netlink_set_rcvbuf(struct netlink_data *netlink, int size)
+{
+	return netlink_sock_set_rcvbuf(netlink->sock, size);
+}
+
+
+/**
+ * netlink_get_overruns - Get the number of receive buffer overruns
+ * @netlink: Pointer to data from netlink_init()
+ * Returns: Number of times events were lost due to a full receive buffer
+ */
+unsigned int netlink_get_overruns(struct netlink_data *netlink)
+{
+	return netlink->overruns;
+}
+
+
 void netlink_deinit(struct netlink_data *netlink)
 {
 	if (netlink == NULL)
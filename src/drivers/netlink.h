@@ -22,6 +22,9 @@ struct netlink_config {
 
 struct netlink_data * netlink_init(struct netlink_config *cfg);
 void netlink_deinit(struct netlink_data *netlink);
+int netlink_sock_set_rcvbuf(int sock, int size);
+int netlink_set_rcvbuf(struct netlink_data *netlink, int size);
+unsigned int netlink_get_overruns(struct netlink_data *netlink);
 int netlink_send_oper_ifla(struct netlink_data *netlink, int ifindex,
 			   int linkmode, int operstate);
 
@@ -37,12 +37,16 @@
 #endif
 
 #define NLM_F_REQUEST 1
+#define NLM_F_ROOT 0x100
+#define NLM_F_MATCH 0x200
+#define NLM_F_DUMP (NLM_F_ROOT | NLM_F_MATCH)
 
 #define NETLINK_ROUTE 0
 #define RTMGRP_LINK 1
 #define RTM_BASE 0x10
 #define RTM_NEWLINK (RTM_BASE + 0)
 #define RTM_DELLINK (RTM_BASE + 1)
+#define RTM_GETLINK (RTM_BASE + 2)
 #define RTM_SETLINK (RTM_BASE + 3)
 
 #define NLMSG_ALIGNTO 4
@@ -15,6 +15,9 @@
 
 #define RFKILL_EVENT_SIZE_V1 8
 
+/* Maximum number of events to read per eloop call */
+#define RFKILL_RECV_BUDGET 16
+
 struct rfkill_event {
 	u32 idx;
 	u8 type;
@@ -50,31 +53,33 @@ struct rfkill_data {
 };
 
 
-static void rfkill_receive(int sock, void *eloop_ctx, void *sock_ctx)
+/* Returns 0 if more events can be processed, 1 if the state changed, or -1 if
+ * there are no more events */
+static int rfkill_receive_event(struct rfkill_data *rfkill)
 {
-	struct rfkill_data *rfkill = eloop_ctx;
 	struct rfkill_event event;
 	ssize_t len;
 	int new_blocked;
 
 	len = read(rfkill->fd, &event, sizeof(event));
 	if (len < 0) {
-		wpa_printf(MSG_ERROR, "rfkill: Event read failed: %s",
-			   strerror(errno));
-		return;
+		if (errno != EAGAIN && errno != EINTR)
+			wpa_printf(MSG_ERROR, "rfkill: Event read failed: %s",
+				   strerror(errno));
+		return -1;
 	}
 	if (len != RFKILL_EVENT_SIZE_V1) {
 		wpa_printf(MSG_DEBUG, "rfkill: Unexpected event size "
 			   "%d (expected %d)",
 			   (int) len, RFKILL_EVENT_SIZE_V1);
-		return;
+		return 0;
 	}
 	wpa_printf(MSG_DEBUG, "rfkill: event: idx=%u type=%d "
 		   "op=%u soft=%u hard=%u",
 		   event.idx, event.type, event.op, event.soft,
 		   event.hard);
 	if (event.op != RFKILL_OP_CHANGE || event.type != RFKILL_TYPE_WLAN)
-		return;
+		return 0;
 
 	if (event.hard) {
 		wpa_printf(MSG_INFO, "rfkill: WLAN hard blocked");
@@ -93,6 +98,22 @@ static void rfkill_receive(int sock, void *eloop_ctx, void *sock_ctx)
 			rfkill->cfg->blocked_cb(rfkill->cfg->ctx);
 		else
 			rfkill->cfg->unblocked_cb(rfkill->cfg->ctx);
+		/* The callbacks may end up removing the interface */
+		return 1;
+	}
+
+	return 0;
+}
+
+
+static void rfkill_receive(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct rfkill_data *rfkill = eloop_ctx;
+	int i;
+
+	for (i = 0; i < RFKILL_RECV_BUDGET; i++) {
+		if (rfkill_receive_event(rfkill) != 0)
+			break;
 	}
 }
 
@@ -22,39 +22,89 @@
 #endif /* CONFIG_SQLITE */
 
 #include "common.h"
+#include "utils/list.h"
 #include "crypto/random.h"
 #include "eap_common/eap_sim_common.h"
 #include "eap_server/eap_sim_db.h"
 #include "eloop.h"
 
+#define EAP_SIM_DB_HASH_SIZE 256
+
+/*
+ * Pseudonyms and reauth ids that have been used within this time are never
+ * removed to enforce max_ids since an EAP session may still be referring to
+ * them.
+ */
+#define EAP_SIM_DB_ID_MIN_AGE 300
+
+/* Requests to the external server that have not been answered in time */
+#define EAP_SIM_DB_PENDING_TIMEOUT 60
+
+/* Prefetched authentication vectors */
+#define EAP_SIM_DB_MAX_POOLS 1000
+#define EAP_SIM_DB_POOL_LIFETIME 600
+
 struct eap_sim_pseudonym {
-	struct eap_sim_pseudonym *next;
+	struct dl_list list; /* eap_sim_db_data::pseudonyms, least recently
+			      * used first */
+	struct dl_list perm_list; /* eap_sim_db_data::pseudonym_perm[] */
+	struct dl_list id_list; /* eap_sim_db_data::pseudonym_id[] */
+	struct os_reltime used;
 	char *permanent; /* permanent username */
 	char *pseudonym; /* pseudonym username */
 };
 
+union eap_sim_db_vector {
+	struct {
+		u8 kc[EAP_SIM_MAX_CHAL][EAP_SIM_KC_LEN];
+		u8 sres[EAP_SIM_MAX_CHAL][EAP_SIM_SRES_LEN];
+		u8 rand[EAP_SIM_MAX_CHAL][GSM_RAND_LEN];
+		int num_chal;
+	} sim;
+	struct {
+		u8 rand[EAP_AKA_RAND_LEN];
+		u8 autn[EAP_AKA_AUTN_LEN];
+		u8 ik[EAP_AKA_IK_LEN];
+		u8 ck[EAP_AKA_CK_LEN];
+		u8 res[EAP_AKA_RES_MAX_LEN];
+		size_t res_len;
+	} aka;
+};
+
 struct eap_sim_db_pending {
-	struct eap_sim_db_pending *next;
+	struct dl_list list; /* eap_sim_db_data::pending, oldest first */
+	struct dl_list hash_list; /* eap_sim_db_data::pending_hash[] */
+	struct os_reltime added;
 	char imsi[20];
 	enum { PENDING, SUCCESS, FAILURE } state;
 	void *cb_session_ctx;
 	int aka;
-	union {
-		struct {
-			u8 kc[EAP_SIM_MAX_CHAL][EAP_SIM_KC_LEN];
-			u8 sres[EAP_SIM_MAX_CHAL][EAP_SIM_SRES_LEN];
-			u8 rand[EAP_SIM_MAX_CHAL][GSM_RAND_LEN];
-			int num_chal;
-		} sim;
-		struct {
-			u8 rand[EAP_AKA_RAND_LEN];
-			u8 autn[EAP_AKA_AUTN_LEN];
-			u8 ik[EAP_AKA_IK_LEN];
-			u8 ck[EAP_AKA_CK_LEN];
-			u8 res[EAP_AKA_RES_MAX_LEN];
-			size_t res_len;
-		} aka;
-	} u;
+	union eap_sim_db_vector u;
+};
+
+/**
+ * struct eap_sim_db_pool - Prefetched authentication vectors for an IMSI
+ *
+ * When prefetch=<count> is configured, authentication vectors are requested
+ * from the external server ahead of time for each IMSI that has been
+ * authenticated so that the following authentications can be completed
+ * without waiting for the external server. The vectors are used in the order
+ * they were received.
+ */
+struct eap_sim_db_pool {
+	struct dl_list list; /* eap_sim_db_data::pools, least recently used
+			      * first */
+	struct dl_list hash_list; /* eap_sim_db_data::pool_hash[] */
+	struct os_reltime used;
+	struct os_reltime requested_time;
+	char imsi[20];
+	int aka;
+	int max_chal;
+	unsigned int requested; /* prefetch requests not yet answered */
+	unsigned int discard; /* responses to ignore after resynchronization */
+	unsigned int first; /* index of the oldest vector in vec */
+	unsigned int count; /* number of vectors in vec */
+	union eap_sim_db_vector *vec; /* eap_sim_db_data::prefetch entries */
 };
 
 struct eap_sim_db_data {
@@ -63,9 +113,27 @@ struct eap_sim_db_data {
 	char *local_sock;
 	void (*get_complete_cb)(void *ctx, void *session_ctx);
 	void *ctx;
-	struct eap_sim_pseudonym *pseudonyms;
-	struct eap_sim_reauth *reauths;
-	struct eap_sim_db_pending *pending;
+
+	unsigned int max_ids; /* per type; 0 = no limit */
+	unsigned int id_lifetime; /* seconds; 0 = no expiration */
+	unsigned int prefetch; /* vectors per IMSI; 0 = disabled */
+
+	struct dl_list pseudonyms;
+	struct dl_list pseudonym_perm[EAP_SIM_DB_HASH_SIZE];
+	struct dl_list pseudonym_id[EAP_SIM_DB_HASH_SIZE];
+	unsigned int num_pseudonyms;
+
+	struct dl_list reauths;
+	struct dl_list reauth_perm[EAP_SIM_DB_HASH_SIZE];
+	struct dl_list reauth_id[EAP_SIM_DB_HASH_SIZE];
+	unsigned int num_reauths;
+
+	struct dl_list pending;
+	struct dl_list pending_hash[EAP_SIM_DB_HASH_SIZE];
+
+	struct dl_list pools;
+	struct dl_list pool_hash[EAP_SIM_DB_HASH_SIZE];
+	unsigned int num_pools;
 #ifdef CONFIG_SQLITE
 	sqlite3 *sqlite_db;
 	char db_tmp_identity[100];
@@ -368,65 +436,59 @@ static void db_remove_reauth(struct eap_sim_db_data *data,
 #endif /* CONFIG_SQLITE */
 
 
+static unsigned int eap_sim_db_hash(const char *str)
+{
+	unsigned int hash = 2166136261U;
+
+	/* FNV-1a */
+	while (*str) {
+		hash ^= (u8) *str++;
+		hash *= 16777619U;
+	}
+	return hash & (EAP_SIM_DB_HASH_SIZE - 1);
+}
+
+
 static struct eap_sim_db_pending *
-eap_sim_db_get_pending(struct eap_sim_db_data *data, const char *imsi, int aka)
+eap_sim_db_get_pending(struct eap_sim_db_data *data, const char *imsi, int aka,
+		       int waiting)
 {
-	struct eap_sim_db_pending *entry, *prev = NULL;
-
-	entry = data->pending;
-	while (entry) {
-		if (entry->aka == aka && os_strcmp(entry->imsi, imsi) == 0) {
-			if (prev)
-				prev->next = entry->next;
-			else
-				data->pending = entry->next;
-			break;
-		}
-		prev = entry;
-		entry = entry->next;
+	struct eap_sim_db_pending *entry;
+
+	dl_list_for_each(entry, &data->pending_hash[eap_sim_db_hash(imsi)],
+			 struct eap_sim_db_pending, hash_list) {
+		if (entry->aka == aka && os_strcmp(entry->imsi, imsi) == 0 &&
+		    (!waiting || entry->state == PENDING))
+			return entry;
 	}
-	return entry;
+	return NULL;
 }
 
 
 static void eap_sim_db_add_pending(struct eap_sim_db_data *data,
 				   struct eap_sim_db_pending *entry)
 {
-	entry->next = data->pending;
-	data->pending = entry;
+	os_get_reltime(&entry->added);
+	dl_list_add_tail(&data->pending, &entry->list);
+	dl_list_add_tail(&data->pending_hash[eap_sim_db_hash(entry->imsi)],
+			 &entry->hash_list);
 }
 
 
-static void eap_sim_db_sim_resp_auth(struct eap_sim_db_data *data,
-				     const char *imsi, char *buf)
+static void eap_sim_db_free_pending(struct eap_sim_db_pending *entry)
 {
-	char *start, *end, *pos;
-	struct eap_sim_db_pending *entry;
-	int num_chal;
+	dl_list_del(&entry->list);
+	dl_list_del(&entry->hash_list);
+	bin_clear_free(entry, sizeof(*entry));
+}
 
-	/*
-	 * SIM-RESP-AUTH <IMSI> Kc(i):SRES(i):RAND(i) ...
-	 * SIM-RESP-AUTH <IMSI> FAILURE
-	 * (IMSI = ASCII string, Kc/SRES/RAND = hex string)
-	 */
 
-	entry = eap_sim_db_get_pending(data, imsi, 0);
-	if (entry == NULL) {
-		wpa_printf(MSG_DEBUG, "EAP-SIM DB: No pending entry for the "
-			   "received message found");
-		return;
-	}
+static int eap_sim_db_parse_sim(char *buf, union eap_sim_db_vector *vec)
+{
+	char *start, *end, *pos;
+	int num_chal;
 
 	start = buf;
-	if (os_strncmp(start, "FAILURE", 7) == 0) {
-		wpa_printf(MSG_DEBUG, "EAP-SIM DB: External server reported "
-			   "failure");
-		entry->state = FAILURE;
-		eap_sim_db_add_pending(data, entry);
-		data->get_complete_cb(data->ctx, entry->cb_session_ctx);
-		return;
-	}
-
 	num_chal = 0;
 	while (num_chal < EAP_SIM_MAX_CHAL) {
 		end = os_strchr(start, ' ');
@@ -435,25 +497,23 @@ static void eap_sim_db_sim_resp_auth(struct eap_sim_db_data *data,
 
 		pos = os_strchr(start, ':');
 		if (pos == NULL)
-			goto parse_fail;
+			return -1;
 		*pos = '\0';
-		if (hexstr2bin(start, entry->u.sim.kc[num_chal],
-			       EAP_SIM_KC_LEN))
-			goto parse_fail;
+		if (hexstr2bin(start, vec->sim.kc[num_chal], EAP_SIM_KC_LEN))
+			return -1;
 
 		start = pos + 1;
 		pos = os_strchr(start, ':');
 		if (pos == NULL)
-			goto parse_fail;
+			return -1;
 		*pos = '\0';
-		if (hexstr2bin(start, entry->u.sim.sres[num_chal],
+		if (hexstr2bin(start, vec->sim.sres[num_chal],
 			       EAP_SIM_SRES_LEN))
-			goto parse_fail;
+			return -1;
 
 		start = pos + 1;
-		if (hexstr2bin(start, entry->u.sim.rand[num_chal],
-			       GSM_RAND_LEN))
-			goto parse_fail;
+		if (hexstr2bin(start, vec->sim.rand[num_chal], GSM_RAND_LEN))
+			return -1;
 
 		num_chal++;
 		if (end == NULL)
@@ -461,80 +521,47 @@ static void eap_sim_db_sim_resp_auth(struct eap_sim_db_data *data,
 		else
 			start = end + 1;
 	}
-	entry->u.sim.num_chal = num_chal;
+	vec->sim.num_chal = num_chal;
 
-	entry->state = SUCCESS;
-	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Authentication data parsed "
-		   "successfully - callback");
-	eap_sim_db_add_pending(data, entry);
-	data->get_complete_cb(data->ctx, entry->cb_session_ctx);
-	return;
-
-parse_fail:
-	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Failed to parse response string");
-	os_free(entry);
+	return 0;
 }
 
 
-static void eap_sim_db_aka_resp_auth(struct eap_sim_db_data *data,
-				     const char *imsi, char *buf)
+static int eap_sim_db_parse_aka(char *buf, union eap_sim_db_vector *vec)
 {
 	char *start, *end;
-	struct eap_sim_db_pending *entry;
-
-	/*
-	 * AKA-RESP-AUTH <IMSI> <RAND> <AUTN> <IK> <CK> <RES>
-	 * AKA-RESP-AUTH <IMSI> FAILURE
-	 * (IMSI = ASCII string, RAND/AUTN/IK/CK/RES = hex string)
-	 */
-
-	entry = eap_sim_db_get_pending(data, imsi, 1);
-	if (entry == NULL) {
-		wpa_printf(MSG_DEBUG, "EAP-SIM DB: No pending entry for the "
-			   "received message found");
-		return;
-	}
 
 	start = buf;
-	if (os_strncmp(start, "FAILURE", 7) == 0) {
-		wpa_printf(MSG_DEBUG, "EAP-SIM DB: External server reported "
-			   "failure");
-		entry->state = FAILURE;
-		eap_sim_db_add_pending(data, entry);
-		data->get_complete_cb(data->ctx, entry->cb_session_ctx);
-		return;
-	}
-
 	end = os_strchr(start, ' ');
 	if (end == NULL)
-		goto parse_fail;
+		return -1;
 	*end = '\0';
-	if (hexstr2bin(start, entry->u.aka.rand, EAP_AKA_RAND_LEN))
-		goto parse_fail;
+	if (hexstr2bin(start, vec->aka.rand, EAP_AKA_RAND_LEN))
+		return -1;
 
 	start = end + 1;
 	end = os_strchr(start, ' ');
 	if (end == NULL)
-		goto parse_fail;
+		return -1;
 	*end = '\0';
-	if (hexstr2bin(start, entry->u.aka.autn, EAP_AKA_AUTN_LEN))
-		goto parse_fail;
+	if (hexstr2bin(start, vec->aka.autn, EAP_AKA_AUTN_LEN))
+		return -1;
 
 	start = end + 1;
 	end = os_strchr(start, ' ');
 	if (end == NULL)
-		goto parse_fail;
+		return -1;
 	*end = '\0';
-	if (hexstr2bin(start, entry->u.aka.ik, EAP_AKA_IK_LEN))
-		goto parse_fail;
+	if (hexstr2bin(start, vec->aka.ik, EAP_AKA_IK_LEN))
+		return -1;
 
 	start = end + 1;
 	end = os_strchr(start, ' ');
 	if (end == NULL)
-		goto parse_fail;
+		return -1;
 	*end = '\0';
-	if (hexstr2bin(start, entry->u.aka.ck, EAP_AKA_CK_LEN))
-		goto parse_fail;
+	if (hexstr2bin(start, vec->aka.ck, EAP_AKA_CK_LEN))
+		return -1;
 
 	start = end + 1;
 	end = os_strchr(start, ' ');
@@ -545,25 +572,175 @@ static void eap_sim_db_aka_resp_auth(struct eap_sim_db_data *data,
 		while (*end)
 			end++;
 	}
-	entry->u.aka.res_len = (end - start) / 2;
-	if (entry->u.aka.res_len > EAP_AKA_RES_MAX_LEN) {
+	vec->aka.res_len = (end - start) / 2;
+	if (vec->aka.res_len > EAP_AKA_RES_MAX_LEN) {
 		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Too long RES");
-		entry->u.aka.res_len = 0;
-		goto parse_fail;
+		vec->aka.res_len = 0;
+		return -1;
+	}
+	if (hexstr2bin(start, vec->aka.res, vec->aka.res_len))
+		return -1;
+
+	return 0;
+}
+
+
+static int eap_sim_db_parse(int aka, char *buf, union eap_sim_db_vector *vec)
+{
+	if (aka)
+		return eap_sim_db_parse_aka(buf, vec);
+	return eap_sim_db_parse_sim(buf, vec);
+}
+
+
+static struct eap_sim_db_pool *
+eap_sim_db_get_pool(struct eap_sim_db_data *data, const char *imsi, int aka)
+{
+	struct eap_sim_db_pool *pool;
+
+	dl_list_for_each(pool, &data->pool_hash[eap_sim_db_hash(imsi)],
+			 struct eap_sim_db_pool, hash_list) {
+		if (pool->aka == aka && os_strcmp(pool->imsi, imsi) == 0)
+			return pool;
+	}
+	return NULL;
+}
+
+
+static void eap_sim_db_free_pool(struct eap_sim_db_data *data,
+				 struct eap_sim_db_pool *pool)
+{
+	dl_list_del(&pool->list);
+	dl_list_del(&pool->hash_list);
+	data->num_pools--;
+	bin_clear_free(pool, sizeof(*pool) +
+		       data->prefetch * sizeof(union eap_sim_db_vector));
+}
+
+
+static void eap_sim_db_expire_pools(struct eap_sim_db_data *data)
+{
+	struct eap_sim_db_pool *pool;
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	while ((pool = dl_list_first(&data->pools, struct eap_sim_db_pool,
+				     list))) {
+		if (data->num_pools <= EAP_SIM_DB_MAX_POOLS &&
+		    !os_reltime_expired(&now, &pool->used,
+					EAP_SIM_DB_POOL_LIFETIME))
+			break;
+		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Remove prefetched "
+			   "authentication data for IMSI '%s'", pool->imsi);
+		eap_sim_db_free_pool(data, pool);
+	}
+}
+
+
+static void eap_sim_db_pool_add(struct eap_sim_db_data *data,
+				struct eap_sim_db_pool *pool, char *buf)
+{
+	union eap_sim_db_vector *vec;
+
+	if (pool->count >= data->prefetch)
+		return;
+
+	vec = &pool->vec[(pool->first + pool->count) % data->prefetch];
+	if (eap_sim_db_parse(pool->aka, buf, vec) < 0) {
+		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Failed to parse prefetched "
+			   "authentication data");
+		os_memset(vec, 0, sizeof(*vec));
+		return;
+	}
+	pool->count++;
+	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Prefetched authentication data for "
+		   "IMSI '%s' (%u available)", pool->imsi, pool->count);
+}
+
+
+static int eap_sim_db_pool_get(struct eap_sim_db_data *data, const char *imsi,
+			       int aka, union eap_sim_db_vector *vec)
+{
+	struct eap_sim_db_pool *pool;
+
+	pool = eap_sim_db_get_pool(data, imsi, aka);
+	if (pool == NULL || pool->count == 0)
+		return -1;
+
+	os_memcpy(vec, &pool->vec[pool->first], sizeof(*vec));
+	os_memset(&pool->vec[pool->first], 0, sizeof(*vec));
+	pool->first = (pool->first + 1) % data->prefetch;
+	pool->count--;
+	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Using prefetched authentication "
+		   "data for IMSI '%s' (%u left)", imsi, pool->count);
+	return 0;
+}
+
+
+static void eap_sim_db_resp_auth(struct eap_sim_db_data *data,
+				 const char *imsi, char *buf, int aka)
+{
+	struct eap_sim_db_pending *entry;
+	struct eap_sim_db_pool *pool;
+	int failure;
+
+	/*
+	 * SIM-RESP-AUTH <IMSI> Kc(i):SRES(i):RAND(i) ...
+	 * SIM-RESP-AUTH <IMSI> FAILURE
+	 * (IMSI = ASCII string, Kc/SRES/RAND = hex string)
+	 *
+	 * AKA-RESP-AUTH <IMSI> <RAND> <AUTN> <IK> <CK> <RES>
+	 * AKA-RESP-AUTH <IMSI> FAILURE
+	 * (IMSI = ASCII string, RAND/AUTN/IK/CK/RES = hex string)
+	 */
+
+	failure = os_strncmp(buf, "FAILURE", 7) == 0;
+
+	pool = eap_sim_db_get_pool(data, imsi, aka);
+	if (pool && pool->discard) {
+		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Ignore response to a "
+			   "request sent before resynchronization");
+		pool->discard--;
+		return;
+	}
+
+	/*
+	 * Responses do not identify the request, so the first one for an IMSI
+	 * goes to the session that is waiting for it and the rest fill the
+	 * prefetch pool.
+	 */
+	entry = eap_sim_db_get_pending(data, imsi, aka, 1);
+	if (entry == NULL) {
+		if (pool && pool->requested) {
+			pool->requested--;
+			if (!failure)
+				eap_sim_db_pool_add(data, pool, buf);
+			return;
+		}
+		wpa_printf(MSG_DEBUG, "EAP-SIM DB: No pending entry for the "
+			   "received message found");
+		return;
+	}
+
+	if (failure) {
+		wpa_printf(MSG_DEBUG, "EAP-SIM DB: External server reported "
+			   "failure");
+		entry->state = FAILURE;
+		data->get_complete_cb(data->ctx, entry->cb_session_ctx);
+		return;
+	}
+
+	if (eap_sim_db_parse(aka, buf, &entry->u) < 0) {
+		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Failed to parse response "
+			   "string");
+		eap_sim_db_free_pending(entry);
+		return;
 	}
-	if (hexstr2bin(start, entry->u.aka.res, entry->u.aka.res_len))
-		goto parse_fail;
 
 	entry->state = SUCCESS;
 	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Authentication data parsed "
 		   "successfully - callback");
-	eap_sim_db_add_pending(data, entry);
 	data->get_complete_cb(data->ctx, entry->cb_session_ctx);
-	return;
-
-parse_fail:
-	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Failed to parse response string");
-	os_free(entry);
 }
 
 
@@ -606,9 +783,9 @@ static void eap_sim_db_receive(int sock, void *eloop_ctx, void *sock_ctx)
 		   cmd, imsi);
 
 	if (os_strcmp(cmd, "SIM-RESP-AUTH") == 0)
-		eap_sim_db_sim_resp_auth(data, imsi, pos + 1);
+		eap_sim_db_resp_auth(data, imsi, pos + 1, 0);
 	else if (os_strcmp(cmd, "AKA-RESP-AUTH") == 0)
-		eap_sim_db_aka_resp_auth(data, imsi, pos + 1);
+		eap_sim_db_resp_auth(data, imsi, pos + 1, 1);
 	else
 		wpa_printf(MSG_INFO, "EAP-SIM DB: Unknown external response "
 			   "'%s'", cmd);
@@ -702,7 +879,8 @@ eap_sim_db_init(const char *config,
 		void *ctx)
 {
 	struct eap_sim_db_data *data;
-	char *pos;
+	char *pos, *end;
+	int i;
 
 	data = os_zalloc(sizeof(*data));
 	if (data == NULL)
@@ -711,18 +889,59 @@ eap_sim_db_init(const char *config,
 	data->sock = -1;
 	data->get_complete_cb = get_complete_cb;
 	data->ctx = ctx;
+	dl_list_init(&data->pseudonyms);
+	dl_list_init(&data->reauths);
+	dl_list_init(&data->pending);
+	dl_list_init(&data->pools);
+	for (i = 0; i < EAP_SIM_DB_HASH_SIZE; i++) {
+		dl_list_init(&data->pseudonym_perm[i]);
+		dl_list_init(&data->pseudonym_id[i]);
+		dl_list_init(&data->reauth_perm[i]);
+		dl_list_init(&data->reauth_id[i]);
+		dl_list_init(&data->pending_hash[i]);
+		dl_list_init(&data->pool_hash[i]);
+	}
+
 	data->fname = os_strdup(config);
 	if (data->fname == NULL)
 		goto fail;
-	pos = os_strstr(data->fname, " db=");
-	if (pos) {
-		*pos = '\0';
+
+	/* <path> [db=<path>] [prefetch=<count>] [max_ids=<count>]
+	 * [id_lifetime=<seconds>] */
+	pos = os_strchr(data->fname, ' ');
+	if (pos)
+		*pos++ = '\0';
+	while (pos && *pos) {
+		end = os_strchr(pos, ' ');
+		if (end)
+			*end++ = '\0';
+		if (os_strncmp(pos, "db=", 3) == 0) {
 #ifdef CONFIG_SQLITE
-		pos += 4;
-		data->sqlite_db = db_open(pos);
-		if (data->sqlite_db == NULL)
-			goto fail;
+			data->sqlite_db = db_open(pos + 3);
+			if (data->sqlite_db == NULL)
+				goto fail;
 #endif /* CONFIG_SQLITE */
+		} else if (os_strncmp(pos, "prefetch=", 9) == 0) {
+			data->prefetch = atoi(pos + 9);
+			if (data->prefetch > 100)
+				data->prefetch = 100;
+		} else if (os_strncmp(pos, "max_ids=", 8) == 0) {
+			data->max_ids = atoi(pos + 8);
+		} else if (os_strncmp(pos, "id_lifetime=", 12) == 0) {
+			data->id_lifetime = atoi(pos + 12);
+			if (data->id_lifetime &&
+			    data->id_lifetime < EAP_SIM_DB_ID_MIN_AGE) {
+				wpa_printf(MSG_INFO, "EAP-SIM DB: Use minimum "
+					   "id_lifetime %d",
+					   EAP_SIM_DB_ID_MIN_AGE);
+				data->id_lifetime = EAP_SIM_DB_ID_MIN_AGE;
+			}
+		} else if (*pos) {
+			wpa_printf(MSG_INFO, "EAP-SIM DB: Unknown parameter "
+				   "'%s'", pos);
+			goto fail;
+		}
+		pos = end;
 	}
 
 	if (os_strncmp(data->fname, "unix:", 5) == 0) {
@@ -736,6 +955,10 @@ eap_sim_db_init(const char *config,
 	return data;
 
 fail:
+#ifdef CONFIG_SQLITE
+	if (data->sqlite_db)
+		sqlite3_close(data->sqlite_db);
+#endif /* CONFIG_SQLITE */
 	eap_sim_db_close_socket(data);
 	os_free(data->fname);
 	os_free(data);
@@ -743,19 +966,29 @@ fail:
 }
 
 
-static void eap_sim_db_free_pseudonym(struct eap_sim_pseudonym *p)
+static void eap_sim_db_free_pseudonym(struct eap_sim_db_data *data,
+				      struct eap_sim_pseudonym *p)
 {
+	dl_list_del(&p->list);
+	dl_list_del(&p->perm_list);
+	dl_list_del(&p->id_list);
+	data->num_pseudonyms--;
 	os_free(p->permanent);
 	os_free(p->pseudonym);
 	os_free(p);
 }
 
 
-static void eap_sim_db_free_reauth(struct eap_sim_reauth *r)
+static void eap_sim_db_free_reauth(struct eap_sim_db_data *data,
+				   struct eap_sim_reauth *r)
 {
+	dl_list_del(&r->list);
+	dl_list_del(&r->perm_list);
+	dl_list_del(&r->id_list);
+	data->num_reauths--;
 	os_free(r->permanent);
 	os_free(r->reauth_id);
-	os_free(r);
+	bin_clear_free(r, sizeof(*r));
 }
 
 
@@ -766,9 +999,10 @@ static void eap_sim_db_free_reauth(struct eap_sim_reauth *r)
 void eap_sim_db_deinit(void *priv)
 {
 	struct eap_sim_db_data *data = priv;
-	struct eap_sim_pseudonym *p, *prev;
-	struct eap_sim_reauth *r, *prevr;
-	struct eap_sim_db_pending *pending, *prev_pending;
+	struct eap_sim_pseudonym *p;
+	struct eap_sim_reauth *r;
+	struct eap_sim_db_pending *pending;
+	struct eap_sim_db_pool *pool;
 
 #ifdef CONFIG_SQLITE
 	if (data->sqlite_db) {
@@ -780,26 +1014,21 @@ void eap_sim_db_deinit(void *priv)
 	eap_sim_db_close_socket(data);
 	os_free(data->fname);
 
-	p = data->pseudonyms;
-	while (p) {
-		prev = p;
-		p = p->next;
-		eap_sim_db_free_pseudonym(prev);
-	}
+	while ((p = dl_list_first(&data->pseudonyms, struct eap_sim_pseudonym,
+				  list)))
+		eap_sim_db_free_pseudonym(data, p);
 
-	r = data->reauths;
-	while (r) {
-		prevr = r;
-		r = r->next;
-		eap_sim_db_free_reauth(prevr);
-	}
+	while ((r = dl_list_first(&data->reauths, struct eap_sim_reauth,
+				  list)))
+		eap_sim_db_free_reauth(data, r);
 
-	pending = data->pending;
-	while (pending) {
-		prev_pending = pending;
-		pending = pending->next;
-		os_free(prev_pending);
-	}
+	while ((pending = dl_list_first(&data->pending,
+					struct eap_sim_db_pending, list)))
+		eap_sim_db_free_pending(pending);
+
+	while ((pool = dl_list_first(&data->pools, struct eap_sim_db_pool,
+				     list)))
+		eap_sim_db_free_pool(data, pool);
 
 	os_free(data);
 }
@@ -837,9 +1066,197 @@ static int eap_sim_db_send(struct eap_sim_db_data *data, const char *msg,
 
 static void eap_sim_db_expire_pending(struct eap_sim_db_data *data)
 {
-	/* TODO: add limit for maximum length for pending list; remove latest
-	 * (i.e., last) entry from the list if the limit is reached; could also
-	 * use timeout to expire pending entries */
+	struct eap_sim_db_pending *entry;
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	while ((entry = dl_list_first(&data->pending,
+				      struct eap_sim_db_pending, list))) {
+		if (!os_reltime_expired(&now, &entry->added,
+					EAP_SIM_DB_PENDING_TIMEOUT))
+			break;
+		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Remove expired pending "
+			   "entry for IMSI '%s'", entry->imsi);
+		eap_sim_db_free_pending(entry);
+	}
+}
+
+
+static int eap_sim_db_send_auth_req(struct eap_sim_db_data *data,
+				    const char *imsi, int aka, int max_chal)
+{
+	char msg[40];
+	int len, ret;
+	size_t imsi_len;
+
+	imsi_len = os_strlen(imsi);
+	len = os_snprintf(msg, sizeof(msg), aka ? "AKA-REQ-AUTH " :
+			  "SIM-REQ-AUTH ");
+	if (len < 0 || len + imsi_len >= sizeof(msg))
+		return -1;
+	os_memcpy(msg + len, imsi, imsi_len);
+	len += imsi_len;
+	if (!aka) {
+		ret = os_snprintf(msg + len, sizeof(msg) - len, " %d",
+				  max_chal);
+		if (ret < 0 || (size_t) ret >= sizeof(msg) - len)
+			return -1;
+		len += ret;
+	}
+
+	wpa_printf(MSG_DEBUG, "EAP-SIM DB: requesting %s authentication "
+		   "data for IMSI '%s'", aka ? "AKA" : "SIM", imsi);
+	return eap_sim_db_send(data, msg, len);
+}
+
+
+/* Keep prefetch vectors available or requested for the IMSI */
+static void eap_sim_db_prefetch(struct eap_sim_db_data *data,
+				const char *imsi, int aka, int max_chal)
+{
+	struct eap_sim_db_pool *pool;
+	struct os_reltime now;
+
+	if (data->prefetch == 0 || data->sock < 0)
+		return;
+
+	os_get_reltime(&now);
+	pool = eap_sim_db_get_pool(data, imsi, aka);
+	if (pool == NULL) {
+		pool = os_zalloc(sizeof(*pool) + data->prefetch *
+				 sizeof(union eap_sim_db_vector));
+		if (pool == NULL)
+			return;
+		pool->vec = (union eap_sim_db_vector *) (pool + 1);
+		os_strlcpy(pool->imsi, imsi, sizeof(pool->imsi));
+		pool->aka = aka;
+		dl_list_add_tail(&data->pool_hash[eap_sim_db_hash(imsi)],
+				 &pool->hash_list);
+		data->num_pools++;
+	} else {
+		dl_list_del(&pool->list);
+	}
+	dl_list_add_tail(&data->pools, &pool->list);
+	pool->used = now;
+	pool->max_chal = max_chal;
+
+	if ((pool->requested || pool->discard) &&
+	    os_reltime_expired(&now, &pool->requested_time,
+			       EAP_SIM_DB_PENDING_TIMEOUT)) {
+		/* The external server did not reply to all requests */
+		pool->requested = 0;
+		pool->discard = 0;
+	}
+
+	while (pool->count + pool->requested < data->prefetch) {
+		if (eap_sim_db_send_auth_req(data, imsi, aka, max_chal) < 0)
+			break;
+		pool->requested++;
+		pool->requested_time = now;
+	}
+
+	eap_sim_db_expire_pools(data);
+}
+
+
+static int eap_sim_db_copy_sim(const union eap_sim_db_vector *vec,
+			       int max_chal, u8 *_rand, u8 *kc, u8 *sres)
+{
+	int num_chal;
+
+	num_chal = vec->sim.num_chal;
+	if (num_chal > max_chal)
+		num_chal = max_chal;
+	os_memcpy(_rand, vec->sim.rand, num_chal * GSM_RAND_LEN);
+	os_memcpy(sres, vec->sim.sres, num_chal * EAP_SIM_SRES_LEN);
+	os_memcpy(kc, vec->sim.kc, num_chal * EAP_SIM_KC_LEN);
+	return num_chal;
+}
+
+
+static void eap_sim_db_copy_aka(const union eap_sim_db_vector *vec,
+				u8 *_rand, u8 *autn, u8 *ik, u8 *ck,
+				u8 *res, size_t *res_len)
+{
+	os_memcpy(_rand, vec->aka.rand, EAP_AKA_RAND_LEN);
+	os_memcpy(autn, vec->aka.autn, EAP_AKA_AUTN_LEN);
+	os_memcpy(ik, vec->aka.ik, EAP_AKA_IK_LEN);
+	os_memcpy(ck, vec->aka.ck, EAP_AKA_CK_LEN);
+	os_memcpy(res, vec->aka.res, EAP_AKA_RES_MAX_LEN);
+	*res_len = vec->aka.res_len;
+}
+
+
+/* Mark an entry used and move it to the end of its least recently used list */
+static void eap_sim_db_touch(struct dl_list *lru, struct dl_list *entry,
+			     struct os_reltime *used)
+{
+	dl_list_del(entry);
+	dl_list_add_tail(lru, entry);
+	os_get_reltime(used);
+}
+
+
+static int eap_sim_db_id_expired(struct eap_sim_db_data *data,
+				 struct os_reltime *used)
+{
+	struct os_reltime now;
+
+	if (data->id_lifetime == 0)
+		return 0;
+	os_get_reltime(&now);
+	return os_reltime_expired(&now, used, data->id_lifetime);
+}
+
+
+/*
+ * Check whether the least recently used pseudonym or reauth entry can be
+ * removed. Entries that have been used recently are kept even if max_ids is
+ * exceeded since an ongoing EAP session may still be referring to them.
+ */
+static int eap_sim_db_id_removable(struct eap_sim_db_data *data,
+				   struct os_reltime *used, unsigned int num)
+{
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	if (!os_reltime_expired(&now, used, EAP_SIM_DB_ID_MIN_AGE))
+		return 0;
+	if (data->max_ids && num > data->max_ids)
+		return 1;
+	return data->id_lifetime &&
+		os_reltime_expired(&now, used, data->id_lifetime);
+}
+
+
+static void eap_sim_db_expire_pseudonyms(struct eap_sim_db_data *data)
+{
+	struct eap_sim_pseudonym *p;
+
+	while ((p = dl_list_first(&data->pseudonyms, struct eap_sim_pseudonym,
+				  list))) {
+		if (!eap_sim_db_id_removable(data, &p->used,
+					     data->num_pseudonyms))
+			break;
+		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Remove pseudonym '%s'",
+			   p->pseudonym);
+		eap_sim_db_free_pseudonym(data, p);
+	}
+}
+
+
+static void eap_sim_db_expire_reauths(struct eap_sim_db_data *data)
+{
+	struct eap_sim_reauth *r;
+
+	while ((r = dl_list_first(&data->reauths, struct eap_sim_reauth,
+				  list))) {
+		if (!eap_sim_db_id_removable(data, &r->used, data->num_reauths))
+			break;
+		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Remove reauth_id '%s'",
+			   r->reauth_id);
+		eap_sim_db_free_reauth(data, r);
+	}
 }
 
 
@@ -872,10 +1289,9 @@ int eap_sim_db_get_gsm_triplets(struct eap_sim_db_data *data,
 				void *cb_session_ctx)
 {
 	struct eap_sim_db_pending *entry;
-	int len, ret;
-	char msg[40];
+	union eap_sim_db_vector vec;
 	const char *imsi;
-	size_t imsi_len;
+	int num_chal;
 
 	if (username == NULL || username[0] != EAP_SIM_PERMANENT_PREFIX ||
 	    username[1] == '\0' || os_strlen(username) > sizeof(entry->imsi)) {
@@ -887,33 +1303,34 @@ int eap_sim_db_get_gsm_triplets(struct eap_sim_db_data *data,
 	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Get GSM triplets for IMSI '%s'",
 		   imsi);
 
-	entry = eap_sim_db_get_pending(data, imsi, 0);
+	entry = eap_sim_db_get_pending(data, imsi, 0, 0);
 	if (entry) {
-		int num_chal;
 		if (entry->state == FAILURE) {
 			wpa_printf(MSG_DEBUG, "EAP-SIM DB: Pending entry -> "
 				   "failure");
-			os_free(entry);
+			eap_sim_db_free_pending(entry);
 			return EAP_SIM_DB_FAILURE;
 		}
 
 		if (entry->state == PENDING) {
 			wpa_printf(MSG_DEBUG, "EAP-SIM DB: Pending entry -> "
 				   "still pending");
-			eap_sim_db_add_pending(data, entry);
 			return EAP_SIM_DB_PENDING;
 		}
 
 		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Pending entry -> "
 			   "%d challenges", entry->u.sim.num_chal);
-		num_chal = entry->u.sim.num_chal;
-		if (num_chal > max_chal)
-			num_chal = max_chal;
-		os_memcpy(_rand, entry->u.sim.rand, num_chal * GSM_RAND_LEN);
-		os_memcpy(sres, entry->u.sim.sres,
-			  num_chal * EAP_SIM_SRES_LEN);
-		os_memcpy(kc, entry->u.sim.kc, num_chal * EAP_SIM_KC_LEN);
-		os_free(entry);
+		num_chal = eap_sim_db_copy_sim(&entry->u, max_chal, _rand, kc,
+					       sres);
+		eap_sim_db_free_pending(entry);
+		eap_sim_db_prefetch(data, imsi, 0, max_chal);
+		return num_chal;
+	}
+
+	if (eap_sim_db_pool_get(data, imsi, 0, &vec) == 0) {
+		num_chal = eap_sim_db_copy_sim(&vec, max_chal, _rand, kc, sres);
+		os_memset(&vec, 0, sizeof(vec));
+		eap_sim_db_prefetch(data, imsi, 0, max_chal);
 		return num_chal;
 	}
 
@@ -922,20 +1339,7 @@ int eap_sim_db_get_gsm_triplets(struct eap_sim_db_data *data,
 			return EAP_SIM_DB_FAILURE;
 	}
 
-	imsi_len = os_strlen(imsi);
-	len = os_snprintf(msg, sizeof(msg), "SIM-REQ-AUTH ");
-	if (len < 0 || len + imsi_len >= sizeof(msg))
-		return EAP_SIM_DB_FAILURE;
-	os_memcpy(msg + len, imsi, imsi_len);
-	len += imsi_len;
-	ret = os_snprintf(msg + len, sizeof(msg) - len, " %d", max_chal);
-	if (ret < 0 || (size_t) ret >= sizeof(msg) - len)
-		return EAP_SIM_DB_FAILURE;
-	len += ret;
-
-	wpa_printf(MSG_DEBUG, "EAP-SIM DB: requesting SIM authentication "
-		   "data for IMSI '%s'", imsi);
-	if (eap_sim_db_send(data, msg, len) < 0)
+	if (eap_sim_db_send_auth_req(data, imsi, 0, max_chal) < 0)
 		return EAP_SIM_DB_FAILURE;
 
 	entry = os_zalloc(sizeof(*entry));
@@ -945,8 +1349,9 @@ int eap_sim_db_get_gsm_triplets(struct eap_sim_db_data *data,
 	os_strlcpy(entry->imsi, imsi, sizeof(entry->imsi));
 	entry->cb_session_ctx = cb_session_ctx;
 	entry->state = PENDING;
-	eap_sim_db_add_pending(data, entry);
 	eap_sim_db_expire_pending(data);
+	eap_sim_db_add_pending(data, entry);
+	eap_sim_db_prefetch(data, imsi, 0, max_chal);
 
 	return EAP_SIM_DB_PENDING;
 }
@@ -1053,6 +1458,8 @@ int eap_sim_db_add_pseudonym(struct eap_sim_db_data *data,
 			     const char *permanent, char *pseudonym)
 {
 	struct eap_sim_pseudonym *p;
+	unsigned int hash;
+
 	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Add pseudonym '%s' for permanent "
 		   "username '%s'", pseudonym, permanent);
 
@@ -1061,16 +1468,21 @@ int eap_sim_db_add_pseudonym(struct eap_sim_db_data *data,
 	if (data->sqlite_db)
 		return db_add_pseudonym(data, permanent, pseudonym);
 #endif /* CONFIG_SQLITE */
-	for (p = data->pseudonyms; p; p = p->next) {
-		if (os_strcmp(permanent, p->permanent) == 0)
-			break;
-	}
-	if (p) {
-		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Replacing previous "
-			   "pseudonym: %s", p->pseudonym);
-		os_free(p->pseudonym);
-		p->pseudonym = pseudonym;
-		return 0;
+	hash = eap_sim_db_hash(permanent);
+	dl_list_for_each(p, &data->pseudonym_perm[hash],
+			 struct eap_sim_pseudonym, perm_list) {
+		if (os_strcmp(permanent, p->permanent) == 0) {
+			wpa_printf(MSG_DEBUG, "EAP-SIM DB: Replacing previous "
+				   "pseudonym: %s", p->pseudonym);
+			dl_list_del(&p->id_list);
+			os_free(p->pseudonym);
+			p->pseudonym = pseudonym;
+			dl_list_add(&data->pseudonym_id[
+					    eap_sim_db_hash(pseudonym)],
+				    &p->id_list);
+			eap_sim_db_touch(&data->pseudonyms, &p->list, &p->used);
+			return 0;
+		}
 	}
 
 	p = os_zalloc(sizeof(*p));
@@ -1079,7 +1491,6 @@ int eap_sim_db_add_pseudonym(struct eap_sim_db_data *data,
 		return -1;
 	}
 
-	p->next = data->pseudonyms;
 	p->permanent = os_strdup(permanent);
 	if (p->permanent == NULL) {
 		os_free(p);
@@ -1087,9 +1498,15 @@ int eap_sim_db_add_pseudonym(struct eap_sim_db_data *data,
 		return -1;
 	}
 	p->pseudonym = pseudonym;
-	data->pseudonyms = p;
+	os_get_reltime(&p->used);
+	dl_list_add_tail(&data->pseudonyms, &p->list);
+	dl_list_add(&data->pseudonym_perm[hash], &p->perm_list);
+	dl_list_add(&data->pseudonym_id[eap_sim_db_hash(pseudonym)],
+		    &p->id_list);
+	data->num_pseudonyms++;
 
 	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Added new pseudonym entry");
+	eap_sim_db_expire_pseudonyms(data);
 	return 0;
 }
 
@@ -1100,37 +1517,49 @@ eap_sim_db_add_reauth_data(struct eap_sim_db_data *data,
 			   char *reauth_id, u16 counter)
 {
 	struct eap_sim_reauth *r;
-
-	for (r = data->reauths; r; r = r->next) {
-		if (os_strcmp(r->permanent, permanent) == 0)
-			break;
-	}
-
-	if (r) {
-		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Replacing previous "
-			   "reauth_id: %s", r->reauth_id);
-		os_free(r->reauth_id);
-		r->reauth_id = reauth_id;
-	} else {
-		r = os_zalloc(sizeof(*r));
-		if (r == NULL) {
-			os_free(reauth_id);
-			return NULL;
+	unsigned int hash;
+
+	hash = eap_sim_db_hash(permanent);
+	dl_list_for_each(r, &data->reauth_perm[hash], struct eap_sim_reauth,
+			 perm_list) {
+		if (os_strcmp(r->permanent, permanent) == 0) {
+			wpa_printf(MSG_DEBUG, "EAP-SIM DB: Replacing previous "
+				   "reauth_id: %s", r->reauth_id);
+			dl_list_del(&r->id_list);
+			os_free(r->reauth_id);
+			r->reauth_id = reauth_id;
+			dl_list_add(&data->reauth_id[
+					    eap_sim_db_hash(reauth_id)],
+				    &r->id_list);
+			eap_sim_db_touch(&data->reauths, &r->list, &r->used);
+			r->counter = counter;
+			return r;
 		}
+	}
 
-		r->next = data->reauths;
-		r->permanent = os_strdup(permanent);
-		if (r->permanent == NULL) {
-			os_free(r);
-			os_free(reauth_id);
-			return NULL;
-		}
-		r->reauth_id = reauth_id;
-		data->reauths = r;
-		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Added new reauth entry");
+	r = os_zalloc(sizeof(*r));
+	if (r == NULL) {
+		os_free(reauth_id);
+		return NULL;
 	}
 
+	r->permanent = os_strdup(permanent);
+	if (r->permanent == NULL) {
+		os_free(r);
+		os_free(reauth_id);
+		return NULL;
+	}
+	r->reauth_id = reauth_id;
 	r->counter = counter;
+	os_get_reltime(&r->used);
+	dl_list_add_tail(&data->reauths, &r->list);
+	dl_list_add(&data->reauth_perm[hash], &r->perm_list);
+	dl_list_add(&data->reauth_id[eap_sim_db_hash(reauth_id)],
+		    &r->id_list);
+	data->num_reauths++;
+	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Added new reauth entry");
+
+	eap_sim_db_expire_reauths(data);
 
 	return r;
 }
@@ -1237,11 +1666,18 @@ eap_sim_db_get_permanent(struct eap_sim_db_data *data, const char *pseudonym)
 		return db_get_pseudonym(data, pseudonym);
 #endif /* CONFIG_SQLITE */
 
-	p = data->pseudonyms;
-	while (p) {
-		if (os_strcmp(p->pseudonym, pseudonym) == 0)
-			return p->permanent;
-		p = p->next;
+	dl_list_for_each(p, &data->pseudonym_id[eap_sim_db_hash(pseudonym)],
+			 struct eap_sim_pseudonym, id_list) {
+		if (os_strcmp(p->pseudonym, pseudonym) != 0)
+			continue;
+		if (eap_sim_db_id_expired(data, &p->used)) {
+			wpa_printf(MSG_DEBUG, "EAP-SIM DB: Pseudonym '%s' has "
+				   "expired", pseudonym);
+			eap_sim_db_free_pseudonym(data, p);
+			return NULL;
+		}
+		eap_sim_db_touch(&data->pseudonyms, &p->list, &p->used);
+		return p->permanent;
 	}
 
 	return NULL;
@@ -1265,14 +1701,21 @@ eap_sim_db_get_reauth_entry(struct eap_sim_db_data *data,
 		return db_get_reauth(data, reauth_id);
 #endif /* CONFIG_SQLITE */
 
-	r = data->reauths;
-	while (r) {
-		if (os_strcmp(r->reauth_id, reauth_id) == 0)
-			break;
-		r = r->next;
+	dl_list_for_each(r, &data->reauth_id[eap_sim_db_hash(reauth_id)],
+			 struct eap_sim_reauth, id_list) {
+		if (os_strcmp(r->reauth_id, reauth_id) != 0)
+			continue;
+		if (eap_sim_db_id_expired(data, &r->used)) {
+			wpa_printf(MSG_DEBUG, "EAP-SIM DB: reauth_id '%s' has "
+				   "expired", reauth_id);
+			eap_sim_db_free_reauth(data, r);
+			return NULL;
+		}
+		eap_sim_db_touch(&data->reauths, &r->list, &r->used);
+		return r;
 	}
 
-	return r;
+	return NULL;
 }
 
 
@@ -1285,26 +1728,13 @@ eap_sim_db_get_reauth_entry(struct eap_sim_db_data *data,
 void eap_sim_db_remove_reauth(struct eap_sim_db_data *data,
 			      struct eap_sim_reauth *reauth)
 {
-	struct eap_sim_reauth *r, *prev = NULL;
 #ifdef CONFIG_SQLITE
 	if (data->sqlite_db) {
 		db_remove_reauth(data, reauth);
 		return;
 	}
 #endif /* CONFIG_SQLITE */
-	r = data->reauths;
-	while (r) {
-		if (r == reauth) {
-			if (prev)
-				prev->next = r->next;
-			else
-				data->reauths = r->next;
-			eap_sim_db_free_reauth(r);
-			return;
-		}
-		prev = r;
-		r = r->next;
-	}
+	eap_sim_db_free_reauth(data, reauth);
 }
 
 
@@ -1337,10 +1767,8 @@ int eap_sim_db_get_aka_auth(struct eap_sim_db_data *data, const char *username,
 			    u8 *res, size_t *res_len, void *cb_session_ctx)
 {
 	struct eap_sim_db_pending *entry;
-	int len;
-	char msg[40];
+	union eap_sim_db_vector vec;
 	const char *imsi;
-	size_t imsi_len;
 
 	if (username == NULL ||
 	    (username[0] != EAP_AKA_PERMANENT_PREFIX &&
@@ -1354,29 +1782,32 @@ int eap_sim_db_get_aka_auth(struct eap_sim_db_data *data, const char *username,
 	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Get AKA auth for IMSI '%s'",
 		   imsi);
 
-	entry = eap_sim_db_get_pending(data, imsi, 1);
+	entry = eap_sim_db_get_pending(data, imsi, 1, 0);
 	if (entry) {
 		if (entry->state == FAILURE) {
-			os_free(entry);
+			eap_sim_db_free_pending(entry);
 			wpa_printf(MSG_DEBUG, "EAP-SIM DB: Failure");
 			return EAP_SIM_DB_FAILURE;
 		}
 
 		if (entry->state == PENDING) {
-			eap_sim_db_add_pending(data, entry);
 			wpa_printf(MSG_DEBUG, "EAP-SIM DB: Pending");
 			return EAP_SIM_DB_PENDING;
 		}
 
 		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Returning successfully "
 			   "received authentication data");
-		os_memcpy(_rand, entry->u.aka.rand, EAP_AKA_RAND_LEN);
-		os_memcpy(autn, entry->u.aka.autn, EAP_AKA_AUTN_LEN);
-		os_memcpy(ik, entry->u.aka.ik, EAP_AKA_IK_LEN);
-		os_memcpy(ck, entry->u.aka.ck, EAP_AKA_CK_LEN);
-		os_memcpy(res, entry->u.aka.res, EAP_AKA_RES_MAX_LEN);
-		*res_len = entry->u.aka.res_len;
-		os_free(entry);
+		eap_sim_db_copy_aka(&entry->u, _rand, autn, ik, ck, res,
+				    res_len);
+		eap_sim_db_free_pending(entry);
+		eap_sim_db_prefetch(data, imsi, 1, 0);
+		return 0;
+	}
+
+	if (eap_sim_db_pool_get(data, imsi, 1, &vec) == 0) {
+		eap_sim_db_copy_aka(&vec, _rand, autn, ik, ck, res, res_len);
+		os_memset(&vec, 0, sizeof(vec));
+		eap_sim_db_prefetch(data, imsi, 1, 0);
 		return 0;
 	}
 
@@ -1385,16 +1816,7 @@ int eap_sim_db_get_aka_auth(struct eap_sim_db_data *data, const char *username,
 			return EAP_SIM_DB_FAILURE;
 	}
 
-	imsi_len = os_strlen(imsi);
-	len = os_snprintf(msg, sizeof(msg), "AKA-REQ-AUTH ");
-	if (len < 0 || len + imsi_len >= sizeof(msg))
-		return EAP_SIM_DB_FAILURE;
-	os_memcpy(msg + len, imsi, imsi_len);
-	len += imsi_len;
-
-	wpa_printf(MSG_DEBUG, "EAP-SIM DB: requesting AKA authentication "
-		    "data for IMSI '%s'", imsi);
-	if (eap_sim_db_send(data, msg, len) < 0)
+	if (eap_sim_db_send_auth_req(data, imsi, 1, 0) < 0)
 		return EAP_SIM_DB_FAILURE;
 
 	entry = os_zalloc(sizeof(*entry));
@@ -1405,8 +1827,9 @@ int eap_sim_db_get_aka_auth(struct eap_sim_db_data *data, const char *username,
 	os_strlcpy(entry->imsi, imsi, sizeof(entry->imsi));
 	entry->cb_session_ctx = cb_session_ctx;
 	entry->state = PENDING;
-	eap_sim_db_add_pending(data, entry);
 	eap_sim_db_expire_pending(data);
+	eap_sim_db_add_pending(data, entry);
+	eap_sim_db_prefetch(data, imsi, 1, 0);
 
 	return EAP_SIM_DB_PENDING;
 }
@@ -1430,6 +1853,7 @@ int eap_sim_db_resynchronize(struct eap_sim_db_data *data,
 			     const char *username,
 			     const u8 *auts, const u8 *_rand)
 {
+	struct eap_sim_db_pool *pool;
 	const char *imsi;
 	size_t imsi_len;
 
@@ -1445,6 +1869,22 @@ int eap_sim_db_resynchronize(struct eap_sim_db_data *data,
 	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Get AKA auth for IMSI '%s'",
 		   imsi);
 
+	pool = eap_sim_db_get_pool(data, imsi, 1);
+	if (pool) {
+		/*
+		 * Prefetched vectors are based on the old sequence number and
+		 * would fail again after resynchronization.
+		 */
+		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Flush prefetched AKA "
+			   "authentication data for IMSI '%s'", imsi);
+		os_memset(pool->vec, 0,
+			  data->prefetch * sizeof(union eap_sim_db_vector));
+		pool->first = 0;
+		pool->count = 0;
+		pool->discard += pool->requested;
+		pool->requested = 0;
+	}
+
 	if (data->sock >= 0) {
 		char msg[100];
 		int len, ret;
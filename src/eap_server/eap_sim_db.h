@@ -9,6 +9,7 @@
 #ifndef EAP_SIM_DB_H
 #define EAP_SIM_DB_H
 
+#include "utils/list.h"
 #include "eap_common/eap_sim_common.h"
 
 /* Identity prefixes */
@@ -65,7 +66,10 @@ const char * eap_sim_db_get_permanent(struct eap_sim_db_data *data,
 				      const char *pseudonym);
 
 struct eap_sim_reauth {
-	struct eap_sim_reauth *next;
+	struct dl_list list; /* least recently used first */
+	struct dl_list perm_list; /* hash table by permanent username */
+	struct dl_list id_list; /* hash table by reauth_id */
+	struct os_reltime used;
 	char *permanent; /* Permanent username */
 	char *reauth_id; /* Fast re-authentication username */
 	u16 counter;
@@ -107,7 +107,7 @@ struct radius_msg * radius_msg_new(u8 code, u8 identifier)
 	if (msg == NULL)
 		return NULL;
 
-	msg->buf = wpabuf_alloc(RADIUS_DEFAULT_MSG_SIZE);
+	msg->buf = wpabuf_alloc_pool(RADIUS_DEFAULT_MSG_SIZE);
 	if (msg->buf == NULL || radius_msg_initialize(msg)) {
 		radius_msg_free(msg);
 		return NULL;
@@ -676,7 +676,9 @@ struct radius_msg * radius_msg_parse(const u8 *data, size_t len)
 	if (msg == NULL)
 		return NULL;
 
-	msg->buf = wpabuf_alloc_copy(data, msg_len);
+	msg->buf = wpabuf_alloc_pool(msg_len);
+	if (msg->buf)
+		wpabuf_put_data(msg->buf, data, msg_len);
 	if (msg->buf == NULL || radius_msg_initialize(msg)) {
 		radius_msg_free(msg);
 		return NULL;
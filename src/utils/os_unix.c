@@ -9,8 +9,13 @@
 #include "includes.h"
 
 #include <time.h>
+#include <fcntl.h>
 #include <sys/wait.h>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif /* __linux__ */
+
 #ifdef ANDROID
 #include <sys/capability.h>
 #include <sys/prctl.h>
@@ -191,6 +196,9 @@ static int os_daemon(int nochdir, int noclose)
 #endif /* __APPLE__ */
 
 
+static void os_random_cache_clear(void);
+
+
 int os_daemonize(const char *pid_file)
 {
 #if defined(__uClinux__) || defined(__sun__)
@@ -201,6 +209,9 @@ int os_daemonize(const char *pid_file)
 		return -1;
 	}
 
+	/* Do not share buffered random data with the parent process */
+	os_random_cache_clear();
+
 	if (pid_file) {
 		FILE *f = fopen(pid_file, "w");
 		if (f) {
@@ -221,21 +232,130 @@ void os_daemonize_terminate(const char *pid_file)
 }
 
 
-int os_get_random(unsigned char *buf, size_t len)
+#ifdef SYS_getrandom
+#ifndef GRND_NONBLOCK
+#define GRND_NONBLOCK 0x0001
+#endif /* GRND_NONBLOCK */
+static int os_random_getrandom = 1;
+#endif /* SYS_getrandom */
+
+static int os_random_fd = -1;
+
+/*
+ * Small requests (nonces, salts, identifiers) are served from a block of
+ * kernel randomness to avoid a system call per request. Used bytes are
+ * cleared immediately and the block is discarded after
+ * OS_RANDOM_CACHE_MAX_AGE seconds or when the process is daemonized.
+ */
+#define OS_RANDOM_CACHE_LEN 256
+#define OS_RANDOM_CACHE_MAX_REQ 64
+#define OS_RANDOM_CACHE_MAX_AGE 60
+
+static struct {
+	unsigned char buf[OS_RANDOM_CACHE_LEN];
+	size_t avail;
+	struct os_reltime filled;
+} os_random_cache;
+
+
+static void os_random_cache_clear(void)
 {
-	FILE *f;
-	size_t rc;
+	os_memset(os_random_cache.buf, 0, sizeof(os_random_cache.buf));
+	os_random_cache.avail = 0;
+}
 
-	f = fopen("/dev/urandom", "rb");
-	if (f == NULL) {
-		printf("Could not open /dev/urandom.\n");
-		return -1;
+
+static int os_random_read_fd(unsigned char *buf, size_t len)
+{
+	ssize_t res;
+
+	if (os_random_fd < 0) {
+		os_random_fd = open("/dev/urandom", O_RDONLY);
+		if (os_random_fd < 0) {
+			printf("Could not open /dev/urandom.\n");
+			return -1;
+		}
+#ifdef FD_CLOEXEC
+		fcntl(os_random_fd, F_SETFD, FD_CLOEXEC);
+#endif /* FD_CLOEXEC */
 	}
 
-	rc = fread(buf, 1, len, f);
-	fclose(f);
+	while (len > 0) {
+		res = read(os_random_fd, buf, len);
+		if (res < 0 && errno == EINTR)
+			continue;
+		if (res <= 0)
+			return -1;
+		buf += res;
+		len -= res;
+	}
+
+	return 0;
+}
+
+
+static int os_random_read_kernel(unsigned char *buf, size_t len)
+{
+#ifdef SYS_getrandom
+	long res;
+
+	while (os_random_getrandom && len > 0) {
+		/*
+		 * Do not block before the kernel pool has been initialized;
+		 * fall back to /dev/urandom to maintain the earlier behavior
+		 * during early boot.
+		 */
+		res = syscall(SYS_getrandom, buf, len, GRND_NONBLOCK);
+		if (res < 0 && errno == EINTR)
+			continue;
+		if (res < 0 && errno == ENOSYS) {
+			os_random_getrandom = 0;
+			break;
+		}
+		if (res <= 0)
+			break;
+		buf += res;
+		len -= res;
+	}
+	if (len == 0)
+		return 0;
+#endif /* SYS_getrandom */
+
+	return os_random_read_fd(buf, len);
+}
+
+
+int os_get_random(unsigned char *buf, size_t len)
+{
+	struct os_reltime now;
+	unsigned char *pos;
+
+	if (len > OS_RANDOM_CACHE_MAX_REQ)
+		return os_random_read_kernel(buf, len);
+
+	os_get_reltime(&now);
+	if (os_random_cache.avail &&
+	    os_reltime_expired(&now, &os_random_cache.filled,
+			       OS_RANDOM_CACHE_MAX_AGE))
+		os_random_cache_clear();
+
+	if (os_random_cache.avail < len) {
+		if (os_random_read_kernel(os_random_cache.buf,
+					  OS_RANDOM_CACHE_LEN) < 0) {
+			os_random_cache_clear();
+			return -1;
+		}
+		os_random_cache.avail = OS_RANDOM_CACHE_LEN;
+		os_random_cache.filled = now;
+	}
+
+	pos = &os_random_cache.buf[OS_RANDOM_CACHE_LEN -
+				   os_random_cache.avail];
+	os_memcpy(buf, pos, len);
+	os_memset(pos, 0, len);
+	os_random_cache.avail -= len;
 
-	return rc != len ? -1 : 0;
+	return 0;
 }
 
 
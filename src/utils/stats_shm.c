@@ -0,0 +1,191 @@
+/*
+ * Shared memory statistics region
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "includes.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "common.h"
+#include "stats_shm.h"
+
+
+struct stats_shm {
+	struct stats_shm_hdr *hdr;
+	size_t len;
+	int fd;
+	char *path;
+};
+
+
+static void stats_shm_barrier(void)
+{
+#ifdef __GNUC__
+	__sync_synchronize();
+#endif /* __GNUC__ */
+}
+
+
+/**
+ * stats_shm_create - Create a statistics region
+ * @path: Path of the file to use for the region; replaced if it exists
+ * @type: Type of the region
+ * @len: Length of the region in octets including struct stats_shm_hdr
+ * Returns: Pointer to the region or %NULL on failure
+ *
+ * The data following the header is initialized to zero.
+ */
+struct stats_shm * stats_shm_create(const char *path, enum stats_shm_type type,
+				    size_t len)
+{
+	struct stats_shm *shm;
+	void *addr;
+
+	if (len < sizeof(struct stats_shm_hdr) || len > 0xffffffff)
+		return NULL;
+
+	shm = os_zalloc(sizeof(*shm));
+	if (shm == NULL)
+		return NULL;
+	shm->path = os_strdup(path);
+	if (shm->path == NULL) {
+		os_free(shm);
+		return NULL;
+	}
+
+	unlink(path);
+	shm->fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0640);
+	if (shm->fd < 0) {
+		wpa_printf(MSG_ERROR, "stats: Could not create '%s': %s",
+			   path, strerror(errno));
+		goto fail;
+	}
+	if (ftruncate(shm->fd, len) < 0) {
+		wpa_printf(MSG_ERROR, "stats: Could not resize '%s': %s",
+			   path, strerror(errno));
+		goto fail;
+	}
+	addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, shm->fd, 0);
+	if (addr == MAP_FAILED) {
+		wpa_printf(MSG_ERROR, "stats: Could not map '%s': %s",
+			   path, strerror(errno));
+		goto fail;
+	}
+
+	shm->hdr = addr;
+	shm->len = len;
+	shm->hdr->version = STATS_SHM_VERSION;
+	shm->hdr->type = type;
+	shm->hdr->len = len;
+	stats_shm_barrier();
+	/* Readers check the magic value last, so this marks the region as
+	 * valid */
+	shm->hdr->magic = STATS_SHM_MAGIC;
+
+	wpa_printf(MSG_DEBUG, "stats: Created statistics region '%s' (%u octets)",
+		   path, (unsigned int) len);
+
+	return shm;
+
+fail:
+	if (shm->fd >= 0) {
+		close(shm->fd);
+		unlink(path);
+	}
+	os_free(shm->path);
+	os_free(shm);
+	return NULL;
+}
+
+
+/**
+ * stats_shm_destroy - Remove a statistics region
+ * @shm: Pointer to the region from stats_shm_create()
+ */
+void stats_shm_destroy(struct stats_shm *shm)
+{
+	if (shm == NULL)
+		return;
+	munmap(shm->hdr, shm->len);
+	close(shm->fd);
+	unlink(shm->path);
+	os_free(shm->path);
+	os_free(shm);
+}
+
+
+/**
+ * stats_shm_update_begin - Start updating a statistics region
+ * @shm: Pointer to the region from stats_shm_create()
+ * Returns: Pointer to the start of the region (struct stats_shm_hdr)
+ *
+ * Readers will retry until stats_shm_update_end() is called, so the data
+ * should be collected before calling this function and only copied into the
+ * region in between.
+ */
+void * stats_shm_update_begin(struct stats_shm *shm)
+{
+	volatile u32 *seq = &shm->hdr->seq;
+
+	*seq = *seq + 1;
+	stats_shm_barrier();
+	return shm->hdr;
+}
+
+
+/**
+ * stats_shm_update_end - Complete updating a statistics region
+ * @shm: Pointer to the region from stats_shm_create()
+ */
+void stats_shm_update_end(struct stats_shm *shm)
+{
+	volatile u32 *seq = &shm->hdr->seq;
+	struct os_time now;
+
+	os_get_time(&now);
+	shm->hdr->update_sec = now.sec;
+	shm->hdr->update_usec = now.usec;
+	stats_shm_barrier();
+	*seq = *seq + 1;
+}
+
+
+/**
+ * stats_shm_read - Read a consistent copy of a statistics region
+ * @region: Mapped statistics region
+ * @region_len: Length of the mapping in octets
+ * @buf: Buffer for the copy
+ * @len: Number of octets to copy from the beginning of the region
+ * Returns: 0 on success or -1 on failure
+ *
+ * This is an example of the reader side of the sequence lock and is not
+ * needed by the daemons themselves.
+ */
+int stats_shm_read(const void *region, size_t region_len, void *buf,
+		   size_t len)
+{
+	const volatile struct stats_shm_hdr *hdr = region;
+	u32 seq;
+	int i;
+
+	if (region_len < sizeof(*hdr) || len > region_len)
+		return -1;
+
+	for (i = 0; i < 1000; i++) {
+		seq = hdr->seq;
+		stats_shm_barrier();
+		if (hdr->magic != STATS_SHM_MAGIC)
+			return -1;
+		if (seq & 1)
+			continue;
+		os_memcpy(buf, region, len);
+		stats_shm_barrier();
+		if (hdr->seq == seq)
+			return 0;
+	}
+
+	return -1;
+}
@@ -0,0 +1,59 @@
+/*
+ * Shared memory statistics region
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef STATS_SHM_H
+#define STATS_SHM_H
+
+/*
+ * A statistics region is a file (e.g., in /dev/shm) that a daemon maps into
+ * memory and updates in place so that external programs can read runtime
+ * counters by mapping the same file without any interaction with the daemon.
+ *
+ * The region starts with struct stats_shm_hdr followed by data specific to
+ * the region type. All fields are in host byte order and naturally aligned;
+ * the offsets listed in the structure definitions are part of the interface.
+ * Fields are only ever added to the end of a structure and a reader must use
+ * hdr.len and the per-type length fields instead of assuming a fixed total
+ * length.
+ *
+ * Updates are protected with a sequence lock. A reader should:
+ * 1. read hdr.seq and retry later if it is odd (an update is in progress)
+ * 2. copy the data it needs
+ * 3. issue a read memory barrier and read hdr.seq again
+ * 4. retry from step 1 if the value changed
+ */
+
+#define STATS_SHM_MAGIC 0x53545357 /* "WSTS" when read as a little endian u32 */
+#define STATS_SHM_VERSION 1
+
+enum stats_shm_type {
+	STATS_SHM_TYPE_HOSTAPD_BSS = 1,
+	STATS_SHM_TYPE_WPA_SUPPLICANT = 2,
+};
+
+struct stats_shm_hdr {
+	u32 magic; /* 0: STATS_SHM_MAGIC */
+	u16 version; /* 4: STATS_SHM_VERSION */
+	u16 type; /* 6: enum stats_shm_type */
+	u32 seq; /* 8: sequence lock; odd while an update is in progress */
+	u32 len; /* 12: total length of the region in octets */
+	u64 update_sec; /* 16: time of the last update (seconds since Epoch) */
+	u32 update_usec; /* 24: microseconds part of the update time */
+	u32 reserved; /* 28 */
+};
+
+struct stats_shm;
+
+struct stats_shm * stats_shm_create(const char *path, enum stats_shm_type type,
+				    size_t len);
+void stats_shm_destroy(struct stats_shm *shm);
+void * stats_shm_update_begin(struct stats_shm *shm);
+void stats_shm_update_end(struct stats_shm *shm);
+int stats_shm_read(const void *region, size_t region_len, void *buf,
+		   size_t len);
+
+#endif /* STATS_SHM_H */
@@ -7,10 +7,15 @@
  */
 
 #include "utils/includes.h"
+#ifdef CONFIG_STATS_SHM
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif /* CONFIG_STATS_SHM */
 
 #include "utils/common.h"
 #include "utils/bitfield.h"
 #include "utils/ext_password.h"
+#include "utils/stats_shm.h"
 #include "utils/trace.h"
 
 
@@ -207,6 +212,73 @@ static int int_array_tests(void)
 }
 
 
+#ifndef CONFIG_NO_WPABUF_POOL
+static int wpabuf_pool_tests(void)
+{
+	struct wpabuf_pool_stats before[4], after[4];
+	struct wpabuf *buf, *buf2;
+	const u8 *pos;
+	void *ptr;
+	size_t i;
+	int errors = 0;
+
+	wpa_printf(MSG_INFO, "wpabuf pool tests");
+
+	if (wpabuf_pool_get_stats(before, ARRAY_SIZE(before)) < 2)
+		return -1;
+
+	/* A freed buffer is reused for the next allocation of the same size
+	 * class and it is cleared */
+	buf = wpabuf_alloc_pool(100);
+	if (buf == NULL)
+		return -1;
+	os_memset(wpabuf_put(buf, 100), 0xaa, 100);
+	ptr = buf;
+	wpabuf_free(buf);
+	buf = wpabuf_alloc_pool(before[0].size);
+	if (buf == NULL)
+		return -1;
+	if (buf != ptr || wpabuf_size(buf) != before[0].size ||
+	    wpabuf_len(buf) != 0)
+		errors++;
+	pos = wpabuf_head_u8(buf);
+	for (i = 0; i < before[0].size; i++) {
+		if (pos[i])
+			errors++;
+	}
+
+	/* Growing beyond the size class moves the data to the next class */
+	wpabuf_put_data(buf, "test", 4);
+	if (wpabuf_resize(&buf, before[0].size) < 0)
+		errors++;
+	else if (wpabuf_len(buf) != 4 ||
+		 os_memcmp(wpabuf_head(buf), "test", 4) != 0 ||
+		 wpabuf_tailroom(buf) < before[0].size)
+		errors++;
+
+	/* Large buffers are not taken from the pool */
+	buf2 = wpabuf_alloc_pool(100000);
+	if (buf2 == NULL || (buf2->flags & WPABUF_FLAG_POOL))
+		errors++;
+	wpabuf_free(buf2);
+
+	if (wpabuf_pool_get_stats(after, ARRAY_SIZE(after)) < 2 ||
+	    after[0].hits < before[0].hits + 1 ||
+	    after[0].in_use != before[0].in_use ||
+	    after[1].in_use != before[1].in_use + 1)
+		errors++;
+	wpabuf_free(buf);
+
+	if (errors) {
+		wpa_printf(MSG_ERROR, "%d wpabuf pool test(s) failed", errors);
+		return -1;
+	}
+
+	return 0;
+}
+#endif /* CONFIG_NO_WPABUF_POOL */
+
+
 static int ext_password_tests(void)
 {
 	struct ext_password_data *data;
@@ -238,6 +310,121 @@ static int ext_password_tests(void)
 }
 
 
+static int os_random_tests(void)
+{
+	u8 a[32], b[32], large[300], zero[32];
+	unsigned int i;
+	int errors = 0;
+
+	wpa_printf(MSG_INFO, "os_get_random tests");
+
+	os_memset(zero, 0, sizeof(zero));
+
+	/* Enough small requests to go through a number of cache refills */
+	for (i = 0; i < 50; i++) {
+		if (os_get_random(a, sizeof(a)) < 0 ||
+		    os_get_random(b, sizeof(b)) < 0) {
+			errors++;
+			break;
+		}
+		if (os_memcmp(a, b, sizeof(a)) == 0 ||
+		    os_memcmp(a, zero, sizeof(a)) == 0) {
+			errors++;
+			break;
+		}
+	}
+
+	/* Odd sized requests that do not align with the cache block */
+	for (i = 1; i < sizeof(a); i += 7) {
+		if (os_get_random(a, i) < 0)
+			errors++;
+	}
+
+	/* Large requests bypass the cache */
+	os_memset(large, 0, sizeof(large));
+	if (os_get_random(large, sizeof(large)) < 0 ||
+	    os_memcmp(&large[sizeof(large) - sizeof(zero)], zero,
+		      sizeof(zero)) == 0)
+		errors++;
+
+	if (errors) {
+		wpa_printf(MSG_ERROR, "%d os_get_random test(s) failed",
+			   errors);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+#ifdef CONFIG_STATS_SHM
+static int stats_shm_tests(void)
+{
+	struct stats_shm *shm;
+	struct {
+		struct stats_shm_hdr hdr;
+		u32 counter;
+	} *region, copy;
+	char path[64];
+	void *addr;
+	int fd, ret = -1;
+
+	wpa_printf(MSG_INFO, "stats_shm tests");
+
+	os_snprintf(path, sizeof(path), "/tmp/stats_shm_test_%d", getpid());
+	shm = stats_shm_create(path, STATS_SHM_TYPE_HOSTAPD_BSS,
+			       sizeof(*region));
+	if (shm == NULL)
+		return -1;
+
+	/* A reader using a separate mapping of the same file */
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		stats_shm_destroy(shm);
+		return -1;
+	}
+	addr = mmap(NULL, sizeof(copy), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED) {
+		stats_shm_destroy(shm);
+		return -1;
+	}
+
+	if (stats_shm_read(addr, sizeof(copy), &copy, sizeof(copy)) < 0 ||
+	    copy.hdr.version != STATS_SHM_VERSION ||
+	    copy.hdr.type != STATS_SHM_TYPE_HOSTAPD_BSS ||
+	    copy.hdr.len != sizeof(copy) || copy.hdr.seq != 0 ||
+	    copy.counter != 0)
+		goto fail;
+
+	region = stats_shm_update_begin(shm);
+	region->counter = 12345;
+	/* Readers must not see an update in progress */
+	if (stats_shm_read(addr, sizeof(copy), &copy, sizeof(copy)) == 0)
+		goto fail;
+	stats_shm_update_end(shm);
+
+	if (stats_shm_read(addr, sizeof(copy), &copy, sizeof(copy)) < 0 ||
+	    copy.hdr.seq != 2 || copy.counter != 12345 ||
+	    copy.hdr.update_sec == 0)
+		goto fail;
+
+	if (stats_shm_read(addr, sizeof(copy), &copy, sizeof(copy) + 1) == 0)
+		goto fail;
+
+	ret = 0;
+fail:
+	munmap(addr, sizeof(copy));
+	stats_shm_destroy(shm);
+	if (ret == 0 && access(path, F_OK) == 0)
+		ret = -1;
+	if (ret < 0)
+		wpa_printf(MSG_ERROR, "stats_shm test failed");
+	return ret;
+}
+#endif /* CONFIG_STATS_SHM */
+
+
 static int trace_tests(void)
 {
 	wpa_printf(MSG_INFO, "trace tests");
@@ -259,8 +446,19 @@ int utils_module_tests(void)
 	    ext_password_tests() < 0 ||
 	    trace_tests() < 0 ||
 	    bitfield_tests() < 0 ||
-	    int_array_tests() < 0)
+	    int_array_tests() < 0 ||
+	    os_random_tests() < 0)
+		ret = -1;
+
+#ifndef CONFIG_NO_WPABUF_POOL
+	if (wpabuf_pool_tests() < 0)
+		ret = -1;
+#endif /* CONFIG_NO_WPABUF_POOL */
+
+#ifdef CONFIG_STATS_SHM
+	if (stats_shm_tests() < 0)
 		ret = -1;
+#endif /* CONFIG_STATS_SHM */
 
 	return ret;
 }
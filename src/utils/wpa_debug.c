@@ -189,6 +189,573 @@ void wpa_debug_close_linux_tracing(void)
 
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 
+#ifdef CONFIG_DEBUG_BUFFER
+
+/*
+ * Deferred debug output
+ *
+ * Debug messages below MSG_INFO are not formatted when they are generated.
+ * Instead, the format string pointer, timestamp, and raw arguments (with
+ * copies of the strings) are appended to a buffer that is rendered to the
+ * debug output when wpa_debug_flush_buffer() is called from the event loop.
+ * If the buffer is full, messages are dropped and counted. Messages at
+ * MSG_INFO and higher levels are never dropped: the buffer is flushed and the
+ * message is printed immediately to maintain the order of the output.
+ */
+
+enum wpa_debug_rec_type {
+	WPA_DEBUG_REC_PRINTF, WPA_DEBUG_REC_HEXDUMP, WPA_DEBUG_REC_HEXDUMP_ASCII
+};
+
+struct wpa_debug_rec {
+	size_t len; /* including this header */
+	enum wpa_debug_rec_type type;
+	int with_time;
+	struct os_time tv;
+	const char *fmt;
+	/* followed by encoded arguments */
+};
+
+enum wpa_debug_arg_type {
+	WPA_DEBUG_ARG_NONE, WPA_DEBUG_ARG_INT, WPA_DEBUG_ARG_LONG,
+	WPA_DEBUG_ARG_LLONG, WPA_DEBUG_ARG_SIZE, WPA_DEBUG_ARG_DOUBLE,
+	WPA_DEBUG_ARG_PTR, WPA_DEBUG_ARG_STR, WPA_DEBUG_ARG_UNSUPP
+};
+
+struct wpa_debug_spec {
+	const char *start; /* '%' */
+	const char *width_end; /* end of flags and field width */
+	const char *end; /* end of conversion specification */
+	int width_star;
+	int prec_star;
+	int prec; /* -1 if not specified */
+	enum wpa_debug_arg_type type;
+};
+
+#define WPA_DEBUG_MAX_SPEC 24
+
+static u8 *debug_buf;
+static size_t debug_buf_size, debug_buf_used;
+static unsigned int debug_buf_dropped;
+static int debug_buf_flush_pending;
+static void (*debug_buf_pending_cb)(void);
+
+
+static const char * wpa_debug_parse_spec(const char *pos,
+					 struct wpa_debug_spec *spec)
+{
+	int lmod = 0;
+
+	os_memset(spec, 0, sizeof(*spec));
+	spec->start = pos++;
+	spec->prec = -1;
+
+	while (*pos && os_strchr("-+ #0", *pos))
+		pos++;
+	if (*pos == '*') {
+		spec->width_star = 1;
+		pos++;
+	} else {
+		while (*pos >= '0' && *pos <= '9')
+			pos++;
+	}
+	spec->width_end = pos;
+	if (*pos == '.') {
+		pos++;
+		if (*pos == '*') {
+			spec->prec_star = 1;
+			pos++;
+		} else {
+			spec->prec = 0;
+			while (*pos >= '0' && *pos <= '9')
+				spec->prec = spec->prec * 10 + *pos++ - '0';
+		}
+	}
+
+	if (*pos == 'h') {
+		pos++;
+		if (*pos == 'h')
+			pos++;
+	} else if (*pos == 'l') {
+		lmod = 1;
+		pos++;
+		if (*pos == 'l') {
+			lmod = 2;
+			pos++;
+		}
+	} else if (*pos == 'z') {
+		lmod = 3;
+		pos++;
+	}
+
+	switch (*pos) {
+	case '%':
+		spec->type = pos == spec->start + 1 ? WPA_DEBUG_ARG_NONE :
+			WPA_DEBUG_ARG_UNSUPP;
+		break;
+	case 'd':
+	case 'i':
+	case 'u':
+	case 'x':
+	case 'X':
+	case 'o':
+		spec->type = lmod == 0 ? WPA_DEBUG_ARG_INT :
+			lmod == 1 ? WPA_DEBUG_ARG_LONG :
+			lmod == 2 ? WPA_DEBUG_ARG_LLONG : WPA_DEBUG_ARG_SIZE;
+		break;
+	case 'c':
+		spec->type = lmod ? WPA_DEBUG_ARG_UNSUPP : WPA_DEBUG_ARG_INT;
+		break;
+	case 'f':
+	case 'e':
+	case 'g':
+		spec->type = lmod ? WPA_DEBUG_ARG_UNSUPP : WPA_DEBUG_ARG_DOUBLE;
+		break;
+	case 'p':
+		spec->type = lmod ? WPA_DEBUG_ARG_UNSUPP : WPA_DEBUG_ARG_PTR;
+		break;
+	case 's':
+		spec->type = lmod ? WPA_DEBUG_ARG_UNSUPP : WPA_DEBUG_ARG_STR;
+		break;
+	default:
+		spec->type = WPA_DEBUG_ARG_UNSUPP;
+		return pos;
+	}
+	pos++;
+	spec->end = pos;
+	if (pos - spec->start > WPA_DEBUG_MAX_SPEC)
+		spec->type = WPA_DEBUG_ARG_UNSUPP;
+
+	return pos;
+}
+
+
+static int wpa_debug_buffer_put(size_t *used, const void *data, size_t len)
+{
+	if (debug_buf_size - *used < len)
+		return -1;
+	os_memcpy(debug_buf + *used, data, len);
+	*used += len;
+	return 0;
+}
+
+
+static int wpa_debug_buffer_start(size_t *used,
+				  enum wpa_debug_rec_type type,
+				  const char *fmt)
+{
+	struct wpa_debug_rec rec;
+
+	os_memset(&rec, 0, sizeof(rec));
+	rec.type = type;
+	rec.fmt = fmt;
+	if (wpa_debug_timestamp) {
+		rec.with_time = 1;
+		os_get_time(&rec.tv);
+	}
+	*used = debug_buf_used;
+	return wpa_debug_buffer_put(used, &rec, sizeof(rec));
+}
+
+
+static void wpa_debug_buffer_commit(size_t used)
+{
+	struct wpa_debug_rec *rec;
+
+	rec = (struct wpa_debug_rec *) (debug_buf + debug_buf_used);
+	rec->len = used - debug_buf_used;
+	/* Keep the following record header aligned */
+	debug_buf_used += (rec->len + sizeof(void *) - 1) &
+		~(sizeof(void *) - 1);
+	if (debug_buf_used > debug_buf_size)
+		debug_buf_used = debug_buf_size;
+
+	if (!debug_buf_flush_pending && debug_buf_pending_cb) {
+		debug_buf_flush_pending = 1;
+		debug_buf_pending_cb();
+	}
+}
+
+
+static int wpa_debug_buffer_active(int level)
+{
+	if (debug_buf == NULL)
+		return 0;
+	if (level >= MSG_INFO) {
+		wpa_debug_flush_buffer();
+		return 0;
+	}
+	return 1;
+}
+
+
+/* Returns 0 if the message was buffered or dropped, -1 if it is to be printed
+ * immediately */
+static int wpa_debug_buffer_printf(int level, const char *fmt, va_list ap)
+{
+	struct wpa_debug_spec spec;
+	const char *pos;
+	size_t used, slen;
+	va_list aq;
+	int res = 0;
+
+	if (!wpa_debug_buffer_active(level))
+		return -1;
+
+	for (pos = os_strchr(fmt, '%'); pos; pos = os_strchr(pos, '%')) {
+		pos = wpa_debug_parse_spec(pos, &spec);
+		if (spec.type == WPA_DEBUG_ARG_UNSUPP) {
+			wpa_debug_flush_buffer();
+			return -1;
+		}
+	}
+
+	if (wpa_debug_buffer_start(&used, WPA_DEBUG_REC_PRINTF, fmt) < 0)
+		goto drop;
+
+	va_copy(aq, ap);
+	for (pos = os_strchr(fmt, '%'); res == 0 && pos;
+	     pos = os_strchr(pos, '%')) {
+		pos = wpa_debug_parse_spec(pos, &spec);
+		if (spec.width_star) {
+			int val = va_arg(aq, int);
+			res = wpa_debug_buffer_put(&used, &val, sizeof(val));
+		}
+		if (res == 0 && spec.prec_star) {
+			spec.prec = va_arg(aq, int);
+			res = wpa_debug_buffer_put(&used, &spec.prec,
+						   sizeof(spec.prec));
+		}
+		if (res < 0)
+			break;
+
+		switch (spec.type) {
+		case WPA_DEBUG_ARG_INT: {
+			int val = va_arg(aq, int);
+			res = wpa_debug_buffer_put(&used, &val, sizeof(val));
+			break;
+		}
+		case WPA_DEBUG_ARG_LONG: {
+			long val = va_arg(aq, long);
+			res = wpa_debug_buffer_put(&used, &val, sizeof(val));
+			break;
+		}
+		case WPA_DEBUG_ARG_LLONG: {
+			long long val = va_arg(aq, long long);
+			res = wpa_debug_buffer_put(&used, &val, sizeof(val));
+			break;
+		}
+		case WPA_DEBUG_ARG_SIZE: {
+			size_t val = va_arg(aq, size_t);
+			res = wpa_debug_buffer_put(&used, &val, sizeof(val));
+			break;
+		}
+		case WPA_DEBUG_ARG_DOUBLE: {
+			double val = va_arg(aq, double);
+			res = wpa_debug_buffer_put(&used, &val, sizeof(val));
+			break;
+		}
+		case WPA_DEBUG_ARG_PTR: {
+			void *val = va_arg(aq, void *);
+			res = wpa_debug_buffer_put(&used, &val, sizeof(val));
+			break;
+		}
+		case WPA_DEBUG_ARG_STR: {
+			const char *val = va_arg(aq, const char *);
+			if (val == NULL)
+				val = "(null)";
+			slen = 0;
+			while ((spec.prec < 0 || slen < (size_t) spec.prec) &&
+			       val[slen])
+				slen++;
+			res = wpa_debug_buffer_put(&used, &slen, sizeof(slen));
+			if (res == 0)
+				res = wpa_debug_buffer_put(&used, val, slen);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+	va_end(aq);
+
+	if (res < 0)
+		goto drop;
+	wpa_debug_buffer_commit(used);
+	return 0;
+
+drop:
+	debug_buf_dropped++;
+	return 0;
+}
+
+
+/* Returns 0 if the hexdump was buffered or dropped, -1 if it is to be printed
+ * immediately */
+static int wpa_debug_buffer_hexdump(int level, enum wpa_debug_rec_type type,
+				    const char *title, const u8 *buf,
+				    size_t len, int show)
+{
+	size_t used, tlen;
+	int flags;
+
+	if (!wpa_debug_buffer_active(level))
+		return -1;
+
+	/* flags: 0 = data follows, 1 = NULL buffer, 2 = removed */
+	flags = buf == NULL ? 1 : !show ? 2 : 0;
+	tlen = os_strlen(title);
+	if (wpa_debug_buffer_start(&used, type, NULL) < 0 ||
+	    wpa_debug_buffer_put(&used, &flags, sizeof(flags)) < 0 ||
+	    wpa_debug_buffer_put(&used, &len, sizeof(len)) < 0 ||
+	    wpa_debug_buffer_put(&used, &tlen, sizeof(tlen)) < 0 ||
+	    wpa_debug_buffer_put(&used, title, tlen) < 0 ||
+	    (flags == 0 && wpa_debug_buffer_put(&used, buf, len) < 0)) {
+		debug_buf_dropped++;
+		return 0;
+	}
+
+	wpa_debug_buffer_commit(used);
+	return 0;
+}
+
+
+static void wpa_debug_render_printf(FILE *out, const struct wpa_debug_rec *rec)
+{
+	struct wpa_debug_spec spec;
+	const u8 *arg = (const u8 *) (rec + 1);
+	const char *pos = rec->fmt, *next;
+	char fmt[WPA_DEBUG_MAX_SPEC + 4];
+	int width = 0, prec = 0;
+
+#define WPA_DEBUG_GET(var) \
+	do { os_memcpy(&var, arg, sizeof(var)); arg += sizeof(var); } while (0)
+#define WPA_DEBUG_OUT(val)						\
+	do {								\
+		if (spec.width_star && spec.prec_star)			\
+			fprintf(out, fmt, width, prec, val);		\
+		else if (spec.width_star)				\
+			fprintf(out, fmt, width, val);			\
+		else if (spec.prec_star)				\
+			fprintf(out, fmt, prec, val);			\
+		else							\
+			fprintf(out, fmt, val);				\
+	} while (0)
+
+	while ((next = os_strchr(pos, '%')) != NULL) {
+		fwrite(pos, 1, next - pos, out);
+		pos = wpa_debug_parse_spec(next, &spec);
+		if (spec.type == WPA_DEBUG_ARG_NONE) {
+			fputc('%', out);
+			continue;
+		}
+		if (spec.width_star)
+			WPA_DEBUG_GET(width);
+		if (spec.prec_star)
+			WPA_DEBUG_GET(prec);
+		os_memcpy(fmt, spec.start, spec.end - spec.start);
+		fmt[spec.end - spec.start] = '\0';
+
+		switch (spec.type) {
+		case WPA_DEBUG_ARG_INT: {
+			int val;
+			WPA_DEBUG_GET(val);
+			WPA_DEBUG_OUT(val);
+			break;
+		}
+		case WPA_DEBUG_ARG_LONG: {
+			long val;
+			WPA_DEBUG_GET(val);
+			WPA_DEBUG_OUT(val);
+			break;
+		}
+		case WPA_DEBUG_ARG_LLONG: {
+			long long val;
+			WPA_DEBUG_GET(val);
+			WPA_DEBUG_OUT(val);
+			break;
+		}
+		case WPA_DEBUG_ARG_SIZE: {
+			size_t val;
+			WPA_DEBUG_GET(val);
+			WPA_DEBUG_OUT(val);
+			break;
+		}
+		case WPA_DEBUG_ARG_DOUBLE: {
+			double val;
+			WPA_DEBUG_GET(val);
+			WPA_DEBUG_OUT(val);
+			break;
+		}
+		case WPA_DEBUG_ARG_PTR: {
+			void *val;
+			WPA_DEBUG_GET(val);
+			WPA_DEBUG_OUT(val);
+			break;
+		}
+		case WPA_DEBUG_ARG_STR: {
+			size_t slen;
+			WPA_DEBUG_GET(slen);
+			/* The string was already truncated to the precision */
+			os_memcpy(fmt, spec.start, spec.width_end - spec.start);
+			os_strlcpy(fmt + (spec.width_end - spec.start), ".*s",
+				   4);
+			if (spec.width_star)
+				fprintf(out, fmt, width, (int) slen, arg);
+			else
+				fprintf(out, fmt, (int) slen, arg);
+			arg += slen;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+	fputs(pos, out);
+
+#undef WPA_DEBUG_OUT
+#undef WPA_DEBUG_GET
+}
+
+
+static void wpa_debug_render_hexdump(FILE *out,
+				     const struct wpa_debug_rec *rec)
+{
+	const u8 *pos = (const u8 *) (rec + 1), *title, *data;
+	int flags;
+	size_t len, tlen, i, llen;
+	const size_t line_len = 16;
+	const char *name = rec->type == WPA_DEBUG_REC_HEXDUMP ?
+		"hexdump" : "hexdump_ascii";
+
+	os_memcpy(&flags, pos, sizeof(flags));
+	pos += sizeof(flags);
+	os_memcpy(&len, pos, sizeof(len));
+	pos += sizeof(len);
+	os_memcpy(&tlen, pos, sizeof(tlen));
+	pos += sizeof(tlen);
+	title = pos;
+	data = pos + tlen;
+
+	fprintf(out, "%.*s - %s(len=%lu):", (int) tlen, title, name,
+		(unsigned long) len);
+	if (flags == 1) {
+		fprintf(out, " [NULL]\n");
+		return;
+	}
+	if (flags == 2) {
+		fprintf(out, " [REMOVED]\n");
+		return;
+	}
+	if (rec->type == WPA_DEBUG_REC_HEXDUMP) {
+		for (i = 0; i < len; i++)
+			fprintf(out, " %02x", data[i]);
+		fprintf(out, "\n");
+		return;
+	}
+
+	fprintf(out, "\n");
+	while (len) {
+		llen = len > line_len ? line_len : len;
+		fprintf(out, "    ");
+		for (i = 0; i < llen; i++)
+			fprintf(out, " %02x", data[i]);
+		for (i = llen; i < line_len; i++)
+			fprintf(out, "   ");
+		fprintf(out, "   ");
+		for (i = 0; i < llen; i++)
+			fputc(isprint(data[i]) ? data[i] : '_', out);
+		for (i = llen; i < line_len; i++)
+			fputc(' ', out);
+		fprintf(out, "\n");
+		data += llen;
+		len -= llen;
+	}
+}
+
+
+/**
+ * wpa_debug_flush_buffer - Write out buffered debug messages
+ *
+ * This function is to be called from the event loop after the pending
+ * callback registered with wpa_debug_open_buffer() has been called.
+ */
+void wpa_debug_flush_buffer(void)
+{
+	const struct wpa_debug_rec *rec;
+	size_t pos = 0;
+	FILE *out = stdout;
+
+	if (debug_buf == NULL)
+		return;
+
+#ifdef CONFIG_DEBUG_FILE
+	if (out_file)
+		out = out_file;
+#endif /* CONFIG_DEBUG_FILE */
+
+	while (pos < debug_buf_used) {
+		rec = (const struct wpa_debug_rec *) (debug_buf + pos);
+		if (rec->with_time)
+			fprintf(out, "%ld.%06u: ", (long) rec->tv.sec,
+				(unsigned int) rec->tv.usec);
+		if (rec->type == WPA_DEBUG_REC_PRINTF) {
+			wpa_debug_render_printf(out, rec);
+			fprintf(out, "\n");
+		} else {
+			wpa_debug_render_hexdump(out, rec);
+		}
+		pos += (rec->len + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+	}
+	debug_buf_used = 0;
+	debug_buf_flush_pending = 0;
+
+	if (debug_buf_dropped) {
+		fprintf(out, "wpa_debug: %u debug messages dropped (buffer "
+			"full)\n", debug_buf_dropped);
+		debug_buf_dropped = 0;
+	}
+	fflush(out);
+}
+
+
+/**
+ * wpa_debug_open_buffer - Start deferring debug output
+ * @size: Size of the message buffer in octets
+ * @pending_cb: Callback to request wpa_debug_flush_buffer() call or %NULL
+ * Returns: 0 on success, -1 on failure
+ *
+ * The pending callback is called when a message is added to an empty buffer.
+ * It is expected to schedule a call to wpa_debug_flush_buffer(), e.g., with
+ * a short event loop timeout.
+ */
+int wpa_debug_open_buffer(size_t size, void (*pending_cb)(void))
+{
+	wpa_debug_close_buffer();
+	debug_buf = os_malloc(size);
+	if (debug_buf == NULL)
+		return -1;
+	debug_buf_size = size;
+	debug_buf_pending_cb = pending_cb;
+	return 0;
+}
+
+
+/**
+ * wpa_debug_close_buffer - Flush buffered debug messages and stop deferring
+ */
+void wpa_debug_close_buffer(void)
+{
+	wpa_debug_flush_buffer();
+	os_free(debug_buf);
+	debug_buf = NULL;
+	debug_buf_size = 0;
+	debug_buf_pending_cb = NULL;
+}
+
+#endif /* CONFIG_DEBUG_BUFFER */
+
+
 
 /**
  * wpa_printf - conditional printf
@@ -216,6 +783,9 @@ void wpa_printf(int level, const char *fmt, ...)
 			vsyslog(syslog_priority(level), fmt, ap);
 		} else {
 #endif /* CONFIG_DEBUG_SYSLOG */
+#ifdef CONFIG_DEBUG_BUFFER
+		if (wpa_debug_buffer_printf(level, fmt, ap) < 0) {
+#endif /* CONFIG_DEBUG_BUFFER */
 		wpa_debug_print_timestamp();
 #ifdef CONFIG_DEBUG_FILE
 		if (out_file) {
@@ -228,6 +798,9 @@ void wpa_printf(int level, const char *fmt, ...)
 #ifdef CONFIG_DEBUG_FILE
 		}
 #endif /* CONFIG_DEBUG_FILE */
+#ifdef CONFIG_DEBUG_BUFFER
+		}
+#endif /* CONFIG_DEBUG_BUFFER */
 #ifdef CONFIG_DEBUG_SYSLOG
 		}
 #endif /* CONFIG_DEBUG_SYSLOG */
@@ -343,6 +916,11 @@ static void _wpa_hexdump(int level, const char *title, const u8 *buf,
 		return;
 	}
 #endif /* CONFIG_DEBUG_SYSLOG */
+#ifdef CONFIG_DEBUG_BUFFER
+	if (wpa_debug_buffer_hexdump(level, WPA_DEBUG_REC_HEXDUMP, title, buf,
+				     len, show) == 0)
+		return;
+#endif /* CONFIG_DEBUG_BUFFER */
 	wpa_debug_print_timestamp();
 #ifdef CONFIG_DEBUG_FILE
 	if (out_file) {
@@ -418,6 +996,11 @@ static void _wpa_hexdump_ascii(int level, const char *title, const void *buf,
 #ifdef CONFIG_ANDROID_LOG
 	_wpa_hexdump(level, title, buf, len, show);
 #else /* CONFIG_ANDROID_LOG */
+#ifdef CONFIG_DEBUG_BUFFER
+	if (wpa_debug_buffer_hexdump(level, WPA_DEBUG_REC_HEXDUMP_ASCII, title,
+				     buf, len, show) == 0)
+		return;
+#endif /* CONFIG_DEBUG_BUFFER */
 	wpa_debug_print_timestamp();
 #ifdef CONFIG_DEBUG_FILE
 	if (out_file) {
@@ -565,6 +1148,9 @@ void wpa_debug_close_file(void)
 #ifdef CONFIG_DEBUG_FILE
 	if (!out_file)
 		return;
+#ifdef CONFIG_DEBUG_BUFFER
+	wpa_debug_flush_buffer();
+#endif /* CONFIG_DEBUG_BUFFER */
 	fclose(out_file);
 	out_file = NULL;
 	os_free(last_path);
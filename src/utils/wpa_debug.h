@@ -325,6 +325,29 @@ static inline void wpa_debug_close_linux_tracing(void)
 
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 
+#if defined(CONFIG_DEBUG_BUFFER) && !defined(CONFIG_NO_STDOUT_DEBUG)
+
+int wpa_debug_open_buffer(size_t size, void (*pending_cb)(void));
+void wpa_debug_flush_buffer(void);
+void wpa_debug_close_buffer(void);
+
+#else /* CONFIG_DEBUG_BUFFER && !CONFIG_NO_STDOUT_DEBUG */
+
+static inline int wpa_debug_open_buffer(size_t size, void (*pending_cb)(void))
+{
+	return 0;
+}
+
+static inline void wpa_debug_flush_buffer(void)
+{
+}
+
+static inline void wpa_debug_close_buffer(void)
+{
+}
+
+#endif /* CONFIG_DEBUG_BUFFER && !CONFIG_NO_STDOUT_DEBUG */
+
 
 #ifdef EAPOL_TEST
 #define WPA_ASSERT(a)						       \
@@ -27,6 +27,62 @@ static struct wpabuf_trace * wpabuf_get_trace(const struct wpabuf *buf)
 #endif /* WPA_TRACE */
 
 
+#ifndef CONFIG_NO_WPABUF_POOL
+
+/*
+ * Buffer pool for short lived buffers (frames, EAPOL and RADIUS messages)
+ * that are allocated and freed at a high rate. Freed buffers are kept in a
+ * per size class free list (linked through wpabuf::buf) instead of returning
+ * them to the system allocator.
+ */
+
+#ifndef WPABUF_POOL_MAX_FREE
+/* Maximum number of free buffers to keep in each size class */
+#define WPABUF_POOL_MAX_FREE 16
+#endif /* WPABUF_POOL_MAX_FREE */
+
+#define WPABUF_POOL_CLASS_SHIFT 8
+
+static const size_t wpabuf_pool_sizes[] = { 256, 512, 1024, 2048 };
+#define WPABUF_POOL_CLASSES ARRAY_SIZE(wpabuf_pool_sizes)
+
+struct wpabuf_pool_class {
+	struct wpabuf *free_list;
+	unsigned int num_free;
+	unsigned int in_use;
+	unsigned int hits;
+	unsigned int misses;
+};
+
+static struct wpabuf_pool_class wpabuf_pool[WPABUF_POOL_CLASSES];
+static int wpabuf_pool_disabled;
+
+
+static size_t wpabuf_pool_class(const struct wpabuf *buf)
+{
+	return buf->flags >> WPABUF_POOL_CLASS_SHIFT;
+}
+
+
+/* Returns 1 if the buffer was moved to the free list or 0 if the caller needs
+ * to free it */
+static int wpabuf_pool_put(struct wpabuf *buf)
+{
+	struct wpabuf_pool_class *pc = &wpabuf_pool[wpabuf_pool_class(buf)];
+
+	pc->in_use--;
+	if (wpabuf_pool_disabled || pc->num_free >= WPABUF_POOL_MAX_FREE)
+		return 0;
+
+	buf->buf = (u8 *) pc->free_list;
+	pc->free_list = buf;
+	pc->num_free++;
+	return 1;
+}
+
+#endif /* CONFIG_NO_WPABUF_POOL */
+
+
 static void wpabuf_overflow(const struct wpabuf *buf, size_t len)
 {
 #ifdef WPA_TRACE
@@ -66,6 +122,30 @@ int wpabuf_resize(struct wpabuf **_buf, size_t add_len)
 	}
 #endif /* WPA_TRACE */
 
+#ifndef CONFIG_NO_WPABUF_POOL
+	if ((buf->flags & WPABUF_FLAG_POOL) &&
+	    buf->used + add_len > buf->size) {
+		struct wpabuf *nbuf;
+
+		if (buf->used + add_len <=
+		    wpabuf_pool_sizes[wpabuf_pool_class(buf)]) {
+			/* Still fits in the buffer from the pool */
+			os_memset(buf->buf + buf->used, 0, add_len);
+			buf->size = buf->used + add_len;
+			return 0;
+		}
+
+		/* Move to a larger size class (or out of the pool) */
+		nbuf = wpabuf_alloc_pool(buf->used + add_len);
+		if (nbuf == NULL)
+			return -1;
+		wpabuf_put_buf(nbuf, buf);
+		wpabuf_free(buf);
+		*_buf = nbuf;
+		return 0;
+	}
+#endif /* CONFIG_NO_WPABUF_POOL */
+
 	if (buf->used + add_len > buf->size) {
 		unsigned char *nbuf;
 		if (buf->flags & WPABUF_FLAG_EXT_DATA) {
@@ -194,12 +274,20 @@ void wpabuf_free(struct wpabuf *buf)
 	}
 	if (buf->flags & WPABUF_FLAG_EXT_DATA)
 		os_free(buf->buf);
+#ifndef CONFIG_NO_WPABUF_POOL
+	if ((buf->flags & WPABUF_FLAG_POOL) && wpabuf_pool_put(buf))
+		return;
+#endif /* CONFIG_NO_WPABUF_POOL */
 	os_free(trace);
 #else /* WPA_TRACE */
 	if (buf == NULL)
 		return;
 	if (buf->flags & WPABUF_FLAG_EXT_DATA)
 		os_free(buf->buf);
+#ifndef CONFIG_NO_WPABUF_POOL
+	if ((buf->flags & WPABUF_FLAG_POOL) && wpabuf_pool_put(buf))
+		return;
+#endif /* CONFIG_NO_WPABUF_POOL */
 	os_free(buf);
 #endif /* WPA_TRACE */
 }
@@ -301,3 +389,112 @@ void wpabuf_printf(struct wpabuf *buf, char *fmt, ...)
 		wpabuf_overflow(buf, res);
 	buf->used += res;
 }
+
+
+#ifndef CONFIG_NO_WPABUF_POOL
+
+/**
+ * wpabuf_alloc_pool - Allocate a wpabuf from the buffer pool
+ * @len: Length for the allocated buffer
+ * Returns: Buffer to the allocated wpabuf or %NULL on failure
+ *
+ * This is otherwise identical to wpabuf_alloc(), but a previously freed
+ * buffer of the same size class is reused if available. This should be used
+ * for buffers that are freed soon after the allocation. Buffers larger than
+ * the largest size class are allocated with wpabuf_alloc().
+ */
+struct wpabuf * wpabuf_alloc_pool(size_t len)
+{
+	struct wpabuf_pool_class *pc;
+	struct wpabuf *buf;
+	size_t i;
+
+	for (i = 0; i < WPABUF_POOL_CLASSES; i++) {
+		if (len <= wpabuf_pool_sizes[i])
+			break;
+	}
+	if (i == WPABUF_POOL_CLASSES || wpabuf_pool_disabled)
+		return wpabuf_alloc(len);
+
+	pc = &wpabuf_pool[i];
+	buf = pc->free_list;
+	if (buf) {
+		pc->free_list = (struct wpabuf *) buf->buf;
+		pc->num_free--;
+		pc->hits++;
+		buf->used = 0;
+		buf->buf = (u8 *) (buf + 1);
+		os_memset(buf->buf, 0, len);
+	} else {
+		buf = wpabuf_alloc(wpabuf_pool_sizes[i]);
+		if (buf == NULL)
+			return NULL;
+		pc->misses++;
+	}
+	pc->in_use++;
+
+	buf->size = len;
+	buf->flags = WPABUF_FLAG_POOL | (i << WPABUF_POOL_CLASS_SHIFT);
+	return buf;
+}
+
+
+/**
+ * wpabuf_pool_get_stats - Get buffer pool statistics
+ * @stats: Buffer for the statistics (one entry per size class)
+ * @max: Maximum number of entries in stats
+ * Returns: Number of entries written
+ */
+int wpabuf_pool_get_stats(struct wpabuf_pool_stats *stats, int max)
+{
+	int i;
+
+	for (i = 0; i < (int) WPABUF_POOL_CLASSES && i < max; i++) {
+		stats[i].size = wpabuf_pool_sizes[i];
+		stats[i].in_use = wpabuf_pool[i].in_use;
+		stats[i].cached = wpabuf_pool[i].num_free;
+		stats[i].hits = wpabuf_pool[i].hits;
+		stats[i].misses = wpabuf_pool[i].misses;
+	}
+
+	return i;
+}
+
+
+/**
+ * wpabuf_pool_deinit - Free the buffer pool
+ *
+ * This frees all cached buffers and reports buffers from the pool that have
+ * not been freed. Buffers freed after this call are returned to the system
+ * allocator directly.
+ */
+void wpabuf_pool_deinit(void)
+{
+	struct wpabuf *buf;
+	size_t i;
+
+	for (i = 0; i < WPABUF_POOL_CLASSES; i++) {
+		struct wpabuf_pool_class *pc = &wpabuf_pool[i];
+
+		wpa_printf(MSG_DEBUG, "wpabuf pool: size=%u hits=%u misses=%u "
+			   "cached=%u in_use=%u",
+			   (unsigned int) wpabuf_pool_sizes[i], pc->hits,
+			   pc->misses, pc->num_free, pc->in_use);
+		if (pc->in_use)
+			wpa_printf(MSG_ERROR, "wpabuf pool: %u buffer(s) of "
+				   "size %u not freed", pc->in_use,
+				   (unsigned int) wpabuf_pool_sizes[i]);
+
+		while ((buf = pc->free_list) != NULL) {
+			pc->free_list = (struct wpabuf *) buf->buf;
+			buf->buf = (u8 *) (buf + 1);
+			buf->flags = 0;
+			wpabuf_free(buf);
+		}
+		pc->num_free = 0;
+	}
+
+	wpabuf_pool_disabled = 1;
+}
+
+#endif /* CONFIG_NO_WPABUF_POOL */
@@ -11,6 +11,8 @@
 
 /* wpabuf::buf is a pointer to external data */
 #define WPABUF_FLAG_EXT_DATA BIT(0)
+/* wpabuf was allocated from the buffer pool */
+#define WPABUF_FLAG_POOL BIT(1)
 
 /*
  * Internal data structure for wpabuf. Please do not touch this directly from
@@ -37,6 +39,29 @@ struct wpabuf * wpabuf_concat(struct wpabuf *a, struct wpabuf *b);
 struct wpabuf * wpabuf_zeropad(struct wpabuf *buf, size_t len);
 void wpabuf_printf(struct wpabuf *buf, char *fmt, ...) PRINTF_FORMAT(2, 3);
 
+#ifndef CONFIG_NO_WPABUF_POOL
+struct wpabuf_pool_stats {
+	size_t size; /* buffer size of the size class */
+	unsigned int in_use; /* buffers currently allocated */
+	unsigned int cached; /* buffers in the free list */
+	unsigned int hits; /* allocations served from the free list */
+	unsigned int misses; /* allocations that needed os_malloc() */
+};
+
+struct wpabuf * wpabuf_alloc_pool(size_t len);
+int wpabuf_pool_get_stats(struct wpabuf_pool_stats *stats, int max);
+void wpabuf_pool_deinit(void);
+#else /* CONFIG_NO_WPABUF_POOL */
+static inline struct wpabuf * wpabuf_alloc_pool(size_t len)
+{
+	return wpabuf_alloc(len);
+}
+
+static inline void wpabuf_pool_deinit(void)
+{
+}
+#endif /* CONFIG_NO_WPABUF_POOL */
+
 
 /**
  * wpabuf_size - Get the currently allocated size of a wpabuf buffer
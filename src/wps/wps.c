@@ -345,6 +345,26 @@ int wps_is_addr_authorized(const struct wpabuf *msg, const u8 *addr,
 }
 
 
+/**
+ * wps_ap_priority - Get WPS provisioning priority of an AP
+ * @msg: WPS IE contents from Beacon or Probe Response frame
+ * Returns: -1 if the WPS IE is missing or invalid, 1 if a Registrar is
+ * selected, or 0 if not
+ *
+ * This can be used to get a sort key once per AP instead of parsing the WPS IE
+ * in each wps_ap_priority_compar() call.
+ */
+int wps_ap_priority(const struct wpabuf *msg)
+{
+	struct wps_parse_attr attr;
+
+	if (msg == NULL || wps_parse_msg(msg, &attr) < 0)
+		return -1;
+
+	return attr.selected_registrar && *attr.selected_registrar != 0;
+}
+
+
 /**
  * wps_ap_priority_compar - Prioritize WPS IE from two APs
  * @wps_a: WPS IE contents from Beacon or Probe Response frame
@@ -355,23 +375,16 @@ int wps_is_addr_authorized(const struct wpabuf *msg, const u8 *addr,
 int wps_ap_priority_compar(const struct wpabuf *wps_a,
 			   const struct wpabuf *wps_b)
 {
-	struct wps_parse_attr attr_a, attr_b;
 	int sel_a, sel_b;
 
-	if (wps_a == NULL || wps_parse_msg(wps_a, &attr_a) < 0)
+	sel_a = wps_ap_priority(wps_a);
+	if (sel_a < 0)
 		return 1;
-	if (wps_b == NULL || wps_parse_msg(wps_b, &attr_b) < 0)
+	sel_b = wps_ap_priority(wps_b);
+	if (sel_b < 0)
 		return -1;
 
-	sel_a = attr_a.selected_registrar && *attr_a.selected_registrar != 0;
-	sel_b = attr_b.selected_registrar && *attr_b.selected_registrar != 0;
-
-	if (sel_a && !sel_b)
-		return -1;
-	if (!sel_a && sel_b)
-		return 1;
-
-	return 0;
+	return sel_b - sel_a;
 }
 
 
@@ -9,6 +9,7 @@
 #include "utils/includes.h"
 
 #include "utils/common.h"
+#include "wps_i.h"
 #include "wps_attr_parse.h"
 
 struct wps_attr_parse_test {
@@ -324,6 +325,97 @@ static int wps_attr_parse_tests(void)
 }
 
 
+static void wps_test_pbc_probe_req(struct wps_registrar *reg, int addr_id,
+				   int uuid_id)
+{
+	struct wpabuf *buf;
+	u8 addr[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	u8 uuid[WPS_UUID_LEN];
+
+	buf = wpabuf_alloc(100);
+	if (buf == NULL)
+		return;
+	addr[ETH_ALEN - 1] = addr_id;
+	os_memset(uuid, 0x11, WPS_UUID_LEN);
+	uuid[WPS_UUID_LEN - 1] = uuid_id;
+	wpabuf_put_be16(buf, ATTR_CONFIG_METHODS);
+	wpabuf_put_be16(buf, 2);
+	wpabuf_put_be16(buf, WPS_CONFIG_PUSHBUTTON);
+	wpabuf_put_be16(buf, ATTR_DEV_PASSWORD_ID);
+	wpabuf_put_be16(buf, 2);
+	wpabuf_put_be16(buf, DEV_PW_PUSHBUTTON);
+	wpabuf_put_be16(buf, ATTR_UUID_E);
+	wpabuf_put_be16(buf, WPS_UUID_LEN);
+	wpabuf_put_data(buf, uuid, WPS_UUID_LEN);
+	wps_registrar_probe_req_rx(reg, addr, buf, 0);
+	wpabuf_free(buf);
+}
+
+
+static int wps_registrar_tests(void)
+{
+	struct wps_context wps;
+	struct wps_registrar_config cfg;
+	struct wps_registrar *reg;
+	u8 uuid[WPS_UUID_LEN];
+	int i, ret = -1;
+
+	wpa_printf(MSG_INFO, "WPS registrar PBC session and PIN tests");
+
+	os_memset(&wps, 0, sizeof(wps));
+	os_memset(&cfg, 0, sizeof(cfg));
+	reg = wps_registrar_init(&wps, &cfg);
+	if (reg == NULL)
+		return -1;
+
+	os_memset(uuid, 0x11, WPS_UUID_LEN);
+
+	/* Same Enrollee from two addresses is not an overlap */
+	wps_test_pbc_probe_req(reg, 1, 1);
+	wps_test_pbc_probe_req(reg, 1, 1);
+	wps_test_pbc_probe_req(reg, 2, 1);
+	uuid[WPS_UUID_LEN - 1] = 1;
+	if (wps_registrar_pbc_overlap(reg, NULL, NULL) ||
+	    wps_registrar_pbc_overlap(reg, NULL, uuid))
+		goto fail;
+	uuid[WPS_UUID_LEN - 1] = 2;
+	if (!wps_registrar_pbc_overlap(reg, NULL, uuid))
+		goto fail;
+
+	/* Enrollees with UUIDs in the same hash bucket */
+	wps_test_pbc_probe_req(reg, 3, 1 + 64);
+	if (!wps_registrar_pbc_overlap(reg, NULL, NULL))
+		goto fail;
+
+	/* PIN lookup by UUID */
+	for (i = 0; i < 200; i++) {
+		uuid[WPS_UUID_LEN - 1] = i;
+		if (wps_registrar_add_pin(reg, NULL, uuid,
+					  (const u8 *) "12345670", 8, 0) < 0)
+			goto fail;
+	}
+	uuid[WPS_UUID_LEN - 1] = 100;
+	if (wps_registrar_unlock_pin(reg, uuid) < 0 ||
+	    wps_registrar_invalidate_pin(reg, uuid) < 0 ||
+	    wps_registrar_invalidate_pin(reg, uuid) == 0 ||
+	    wps_registrar_unlock_pin(reg, uuid) == 0)
+		goto fail;
+	uuid[WPS_UUID_LEN - 1] = 100 + 64;
+	if (wps_registrar_invalidate_pin(reg, uuid) < 0)
+		goto fail;
+	uuid[WPS_UUID_LEN - 1] = 0xff;
+	if (wps_registrar_invalidate_pin(reg, uuid) == 0)
+		goto fail;
+
+	ret = 0;
+fail:
+	if (ret)
+		wpa_printf(MSG_ERROR, "WPS registrar test failed");
+	wps_registrar_deinit(reg);
+	return ret;
+}
+
+
 int wps_module_tests(void)
 {
 	int ret = 0;
@@ -333,5 +425,8 @@ int wps_module_tests(void)
 	if (wps_attr_parse_tests() < 0)
 		ret = -1;
 
+	if (wps_registrar_tests() < 0)
+		ret = -1;
+
 	return ret;
 }
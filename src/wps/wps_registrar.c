@@ -75,8 +75,14 @@ static struct wps_nfc_pw_token * wps_get_nfc_pw_token(struct dl_list *tokens,
 #endif /* CONFIG_WPS_NFC */
 
 
+/* Hash table size for PINs and PBC sessions by UUID; must be power of two */
+#define WPS_UUID_HASH_SIZE 64
+#define WPS_UUID_HASH(uuid) \
+	((uuid)[WPS_UUID_LEN - 1] & (WPS_UUID_HASH_SIZE - 1))
+
 struct wps_uuid_pin {
 	struct dl_list list;
+	struct dl_list hash_list; /* in reg->pin_hash once the UUID is known */
 	u8 uuid[WPS_UUID_LEN];
 	int wildcard_uuid;
 	u8 *pin;
@@ -99,6 +105,7 @@ static void wps_free_pin(struct wps_uuid_pin *pin)
 static void wps_remove_pin(struct wps_uuid_pin *pin)
 {
 	dl_list_del(&pin->list);
+	dl_list_del(&pin->hash_list);
 	wps_free_pin(pin);
 }
 
@@ -112,21 +119,22 @@ static void wps_free_pins(struct dl_list *pins)
 
 
 struct wps_pbc_session {
-	struct wps_pbc_session *next;
+	struct dl_list list; /* in reg->pbc_sessions; most recent first */
+	struct wps_pbc_session *hnext; /* in reg->pbc_hash by UUID-E */
 	u8 addr[ETH_ALEN];
 	u8 uuid_e[WPS_UUID_LEN];
 	struct os_reltime timestamp;
 };
 
 
-static void wps_free_pbc_sessions(struct wps_pbc_session *pbc)
+static void wps_free_pbc_sessions(struct dl_list *sessions)
 {
-	struct wps_pbc_session *prev;
+	struct wps_pbc_session *pbc, *prev;
 
-	while (pbc) {
-		prev = pbc;
-		pbc = pbc->next;
-		os_free(prev);
+	dl_list_for_each_safe(pbc, prev, sessions, struct wps_pbc_session,
+			      list) {
+		dl_list_del(&pbc->list);
+		os_free(pbc);
 	}
 }
 
@@ -162,8 +170,11 @@ struct wps_registrar {
 	void *cb_ctx;
 
 	struct dl_list pins;
+	struct dl_list pin_hash[WPS_UUID_HASH_SIZE];
 	struct dl_list nfc_pw_tokens;
-	struct wps_pbc_session *pbc_sessions;
+	struct dl_list pbc_sessions;
+	struct wps_pbc_session *pbc_hash[WPS_UUID_HASH_SIZE];
+	unsigned int pbc_uuids; /* number of different UUID-Es in sessions */
 
 	int skip_cred_build;
 	struct wpabuf *extra_cred;
@@ -311,55 +322,96 @@ int wps_device_store(struct wps_registrar *reg,
 }
 
 
-static void wps_registrar_add_pbc_session(struct wps_registrar *reg,
-					  const u8 *addr, const u8 *uuid_e)
+static struct wps_pbc_session *
+wps_registrar_get_pbc_session(struct wps_registrar *reg, const u8 *addr,
+			      const u8 *uuid_e)
 {
-	struct wps_pbc_session *pbc, *prev = NULL;
-	struct os_reltime now;
+	struct wps_pbc_session *pbc;
 
-	os_get_reltime(&now);
+	for (pbc = reg->pbc_hash[WPS_UUID_HASH(uuid_e)]; pbc;
+	     pbc = pbc->hnext) {
+		if (os_memcmp(pbc->uuid_e, uuid_e, WPS_UUID_LEN) == 0 &&
+		    (addr == NULL || os_memcmp(pbc->addr, addr, ETH_ALEN) == 0))
+			return pbc;
+	}
 
-	pbc = reg->pbc_sessions;
-	while (pbc) {
-		if (os_memcmp(pbc->addr, addr, ETH_ALEN) == 0 &&
-		    os_memcmp(pbc->uuid_e, uuid_e, WPS_UUID_LEN) == 0) {
-			if (prev)
-				prev->next = pbc->next;
-			else
-				reg->pbc_sessions = pbc->next;
+	return NULL;
+}
+
+
+static void wps_registrar_pbc_hash_add(struct wps_registrar *reg,
+				       struct wps_pbc_session *pbc)
+{
+	struct wps_pbc_session **bucket;
+
+	if (!wps_registrar_get_pbc_session(reg, NULL, pbc->uuid_e))
+		reg->pbc_uuids++;
+	bucket = &reg->pbc_hash[WPS_UUID_HASH(pbc->uuid_e)];
+	pbc->hnext = *bucket;
+	*bucket = pbc;
+}
+
+
+static void wps_registrar_free_pbc_session(struct wps_registrar *reg,
+					   struct wps_pbc_session *pbc)
+{
+	struct wps_pbc_session **pos;
+
+	for (pos = &reg->pbc_hash[WPS_UUID_HASH(pbc->uuid_e)]; *pos;
+	     pos = &(*pos)->hnext) {
+		if (*pos == pbc) {
+			*pos = pbc->hnext;
 			break;
 		}
-		prev = pbc;
-		pbc = pbc->next;
 	}
+	if (!wps_registrar_get_pbc_session(reg, NULL, pbc->uuid_e))
+		reg->pbc_uuids--;
+	dl_list_del(&pbc->list);
+	os_free(pbc);
+}
+
+
+static void wps_registrar_expire_pbc_sessions(struct wps_registrar *reg,
+					      struct os_reltime *now)
+{
+	struct wps_pbc_session *pbc;
+
+	/* The list is ordered by timestamp, so expired entries are at the
+	 * tail */
+	while ((pbc = dl_list_last(&reg->pbc_sessions, struct wps_pbc_session,
+				   list)) &&
+	       os_reltime_expired(now, &pbc->timestamp, WPS_PBC_WALK_TIME)) {
+		wpa_printf(MSG_DEBUG, "WPS: PBC session for " MACSTR
+			   " expired", MAC2STR(pbc->addr));
+		wps_registrar_free_pbc_session(reg, pbc);
+	}
+}
+
 
-	if (!pbc) {
+static void wps_registrar_add_pbc_session(struct wps_registrar *reg,
+					  const u8 *addr, const u8 *uuid_e)
+{
+	struct wps_pbc_session *pbc;
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+
+	pbc = wps_registrar_get_pbc_session(reg, addr, uuid_e);
+	if (pbc) {
+		dl_list_del(&pbc->list);
+	} else {
 		pbc = os_zalloc(sizeof(*pbc));
 		if (pbc == NULL)
 			return;
 		os_memcpy(pbc->addr, addr, ETH_ALEN);
-		if (uuid_e)
-			os_memcpy(pbc->uuid_e, uuid_e, WPS_UUID_LEN);
+		os_memcpy(pbc->uuid_e, uuid_e, WPS_UUID_LEN);
+		wps_registrar_pbc_hash_add(reg, pbc);
 	}
 
-	pbc->next = reg->pbc_sessions;
-	reg->pbc_sessions = pbc;
+	dl_list_add(&reg->pbc_sessions, &pbc->list);
 	pbc->timestamp = now;
 
-	/* remove entries that have timed out */
-	prev = pbc;
-	pbc = pbc->next;
-
-	while (pbc) {
-		if (os_reltime_expired(&now, &pbc->timestamp,
-				       WPS_PBC_WALK_TIME)) {
-			prev->next = NULL;
-			wps_free_pbc_sessions(pbc);
-			break;
-		}
-		prev = pbc;
-		pbc = pbc->next;
-	}
+	wps_registrar_expire_pbc_sessions(reg, &now);
 }
 
 
@@ -367,29 +419,21 @@ static void wps_registrar_remove_pbc_session(struct wps_registrar *reg,
 					     const u8 *uuid_e,
 					     const u8 *p2p_dev_addr)
 {
-	struct wps_pbc_session *pbc, *prev = NULL, *tmp;
+	struct wps_pbc_session *pbc, *prev;
+	int all;
 
-	pbc = reg->pbc_sessions;
-	while (pbc) {
-		if (os_memcmp(pbc->uuid_e, uuid_e, WPS_UUID_LEN) == 0 ||
-		    (p2p_dev_addr && !is_zero_ether_addr(reg->p2p_dev_addr) &&
-		     os_memcmp(reg->p2p_dev_addr, p2p_dev_addr, ETH_ALEN) ==
-		     0)) {
-			if (prev)
-				prev->next = pbc->next;
-			else
-				reg->pbc_sessions = pbc->next;
-			tmp = pbc;
-			pbc = pbc->next;
-			wpa_printf(MSG_DEBUG, "WPS: Removing PBC session for "
-				   "addr=" MACSTR, MAC2STR(tmp->addr));
-			wpa_hexdump(MSG_DEBUG, "WPS: Removed UUID-E",
-				    tmp->uuid_e, WPS_UUID_LEN);
-			os_free(tmp);
+	all = p2p_dev_addr && !is_zero_ether_addr(reg->p2p_dev_addr) &&
+		os_memcmp(reg->p2p_dev_addr, p2p_dev_addr, ETH_ALEN) == 0;
+
+	dl_list_for_each_safe(pbc, prev, &reg->pbc_sessions,
+			      struct wps_pbc_session, list) {
+		if (!all && os_memcmp(pbc->uuid_e, uuid_e, WPS_UUID_LEN) != 0)
 			continue;
-		}
-		prev = pbc;
-		pbc = pbc->next;
+		wpa_printf(MSG_DEBUG, "WPS: Removing PBC session for "
+			   "addr=" MACSTR, MAC2STR(pbc->addr));
+		wpa_hexdump(MSG_DEBUG, "WPS: Removed UUID-E",
+			    pbc->uuid_e, WPS_UUID_LEN);
+		wps_registrar_free_pbc_session(reg, pbc);
 	}
 }
 
@@ -397,44 +441,24 @@ static void wps_registrar_remove_pbc_session(struct wps_registrar *reg,
 int wps_registrar_pbc_overlap(struct wps_registrar *reg,
 			      const u8 *addr, const u8 *uuid_e)
 {
-	int count = 0;
-	struct wps_pbc_session *pbc;
-	struct wps_pbc_session *first = NULL;
+	unsigned int count;
 	struct os_reltime now;
 
 	os_get_reltime(&now);
+	wps_registrar_expire_pbc_sessions(reg, &now);
 
-	wpa_printf(MSG_DEBUG, "WPS: Checking active PBC sessions for overlap");
-
+	/*
+	 * There is an overlap if more than one Enrollee (UUID-E) is in active
+	 * PBC mode when the requested UUID-E is included in the count. This
+	 * is determined from the number of different UUID-Es in the active
+	 * sessions without having to go through all of them.
+	 */
+	count = reg->pbc_uuids;
 	if (uuid_e) {
-		wpa_printf(MSG_DEBUG, "WPS: Add one for the requested UUID");
 		wpa_hexdump(MSG_DEBUG, "WPS: Requested UUID",
 			    uuid_e, WPS_UUID_LEN);
-		count++;
-	}
-
-	for (pbc = reg->pbc_sessions; pbc; pbc = pbc->next) {
-		wpa_printf(MSG_DEBUG, "WPS: Consider PBC session with " MACSTR,
-			   MAC2STR(pbc->addr));
-		wpa_hexdump(MSG_DEBUG, "WPS: UUID-E",
-			    pbc->uuid_e, WPS_UUID_LEN);
-		if (os_reltime_expired(&now, &pbc->timestamp,
-				       WPS_PBC_WALK_TIME)) {
-			wpa_printf(MSG_DEBUG, "WPS: PBC walk time has expired");
-			break;
-		}
-		if (first &&
-		    os_memcmp(pbc->uuid_e, first->uuid_e, WPS_UUID_LEN) == 0) {
-			wpa_printf(MSG_DEBUG, "WPS: Same Enrollee");
-			continue; /* same Enrollee */
-		}
-		if (uuid_e == NULL ||
-		    os_memcmp(uuid_e, pbc->uuid_e, WPS_UUID_LEN)) {
-			wpa_printf(MSG_DEBUG, "WPS: New Enrollee");
+		if (!wps_registrar_get_pbc_session(reg, NULL, uuid_e))
 			count++;
-		}
-		if (first == NULL)
-			first = pbc;
 	}
 
 	wpa_printf(MSG_DEBUG, "WPS: %u active PBC session(s) found", count);
@@ -638,11 +662,16 @@ wps_registrar_init(struct wps_context *wps,
 		   const struct wps_registrar_config *cfg)
 {
 	struct wps_registrar *reg = os_zalloc(sizeof(*reg));
+	int i;
+
 	if (reg == NULL)
 		return NULL;
 
 	dl_list_init(&reg->pins);
+	for (i = 0; i < WPS_UUID_HASH_SIZE; i++)
+		dl_list_init(&reg->pin_hash[i]);
 	dl_list_init(&reg->nfc_pw_tokens);
+	dl_list_init(&reg->pbc_sessions);
 	reg->wps = wps;
 	reg->new_psk_cb = cfg->new_psk_cb;
 	reg->set_ie_cb = cfg->set_ie_cb;
@@ -688,7 +717,7 @@ void wps_registrar_deinit(struct wps_registrar *reg)
 	eloop_cancel_timeout(wps_registrar_set_selected_timeout, reg, NULL);
 	wps_free_pins(&reg->pins);
 	wps_free_nfc_pw_tokens(&reg->nfc_pw_tokens, 0);
-	wps_free_pbc_sessions(reg->pbc_sessions);
+	wps_free_pbc_sessions(&reg->pbc_sessions);
 	wpabuf_free(reg->extra_cred);
 	wps_free_devices(reg->devices);
 	os_free(reg);
@@ -731,6 +760,7 @@ int wps_registrar_add_pin(struct wps_registrar *reg, const u8 *addr,
 		return -1;
 	if (addr)
 		os_memcpy(p->enrollee_addr, addr, ETH_ALEN);
+	dl_list_init(&p->hash_list);
 	if (uuid == NULL)
 		p->wildcard_uuid = 1;
 	else
@@ -753,6 +783,9 @@ int wps_registrar_add_pin(struct wps_registrar *reg, const u8 *addr,
 		wps_registrar_invalidate_unused(reg);
 
 	dl_list_add(&reg->pins, &p->list);
+	if (!p->wildcard_uuid)
+		dl_list_add(&reg->pin_hash[WPS_UUID_HASH(p->uuid)],
+			    &p->hash_list);
 
 	wpa_printf(MSG_DEBUG, "WPS: A new PIN configured (timeout=%d)",
 		   timeout);
@@ -809,6 +842,24 @@ static void wps_registrar_expire_pins(struct wps_registrar *reg)
 }
 
 
+static struct wps_uuid_pin * wps_registrar_find_pin(struct wps_registrar *reg,
+						    const u8 *uuid,
+						    int skip_wildcard)
+{
+	struct wps_uuid_pin *pin;
+
+	dl_list_for_each(pin, &reg->pin_hash[WPS_UUID_HASH(uuid)],
+			 struct wps_uuid_pin, hash_list) {
+		if (skip_wildcard && pin->wildcard_uuid)
+			continue;
+		if (os_memcmp(pin->uuid, uuid, WPS_UUID_LEN) == 0)
+			return pin;
+	}
+
+	return NULL;
+}
+
+
 /**
  * wps_registrar_invalidate_wildcard_pin - Invalidate a wildcard PIN
  * @reg: Registrar data from wps_registrar_init()
@@ -848,37 +899,27 @@ static int wps_registrar_invalidate_wildcard_pin(struct wps_registrar *reg,
  */
 int wps_registrar_invalidate_pin(struct wps_registrar *reg, const u8 *uuid)
 {
-	struct wps_uuid_pin *pin, *prev;
+	struct wps_uuid_pin *pin;
 
-	dl_list_for_each_safe(pin, prev, &reg->pins, struct wps_uuid_pin, list)
-	{
-		if (os_memcmp(pin->uuid, uuid, WPS_UUID_LEN) == 0) {
-			wpa_hexdump(MSG_DEBUG, "WPS: Invalidated PIN for UUID",
-				    pin->uuid, WPS_UUID_LEN);
-			wps_registrar_remove_pin(reg, pin);
-			return 0;
-		}
-	}
+	pin = wps_registrar_find_pin(reg, uuid, 0);
+	if (pin == NULL)
+		return -1;
 
-	return -1;
+	wpa_hexdump(MSG_DEBUG, "WPS: Invalidated PIN for UUID",
+		    pin->uuid, WPS_UUID_LEN);
+	wps_registrar_remove_pin(reg, pin);
+	return 0;
 }
 
 
 static const u8 * wps_registrar_get_pin(struct wps_registrar *reg,
 					const u8 *uuid, size_t *pin_len)
 {
-	struct wps_uuid_pin *pin, *found = NULL;
+	struct wps_uuid_pin *pin, *found;
 
 	wps_registrar_expire_pins(reg);
 
-	dl_list_for_each(pin, &reg->pins, struct wps_uuid_pin, list) {
-		if (!pin->wildcard_uuid &&
-		    os_memcmp(pin->uuid, uuid, WPS_UUID_LEN) == 0) {
-			found = pin;
-			break;
-		}
-	}
-
+	found = wps_registrar_find_pin(reg, uuid, 1);
 	if (!found) {
 		/* Check for wildcard UUIDs since none of the UUID-specific
 		 * PINs matched */
@@ -889,6 +930,9 @@ static const u8 * wps_registrar_get_pin(struct wps_registrar *reg,
 					   "PIN. Assigned it for this UUID-E");
 				pin->wildcard_uuid++;
 				os_memcpy(pin->uuid, uuid, WPS_UUID_LEN);
+				dl_list_del(&pin->hash_list);
+				dl_list_add(&reg->pin_hash[WPS_UUID_HASH(uuid)],
+					    &pin->hash_list);
 				found = pin;
 				break;
 			}
@@ -927,19 +971,16 @@ int wps_registrar_unlock_pin(struct wps_registrar *reg, const u8 *uuid)
 {
 	struct wps_uuid_pin *pin;
 
-	dl_list_for_each(pin, &reg->pins, struct wps_uuid_pin, list) {
-		if (os_memcmp(pin->uuid, uuid, WPS_UUID_LEN) == 0) {
-			if (pin->wildcard_uuid == 3) {
-				wpa_printf(MSG_DEBUG, "WPS: Invalidating used "
-					   "wildcard PIN");
-				return wps_registrar_invalidate_pin(reg, uuid);
-			}
-			pin->flags &= ~PIN_LOCKED;
-			return 0;
-		}
-	}
+	pin = wps_registrar_find_pin(reg, uuid, 0);
+	if (pin == NULL)
+		return -1;
 
-	return -1;
+	if (pin->wildcard_uuid == 3) {
+		wpa_printf(MSG_DEBUG, "WPS: Invalidating used wildcard PIN");
+		return wps_registrar_invalidate_pin(reg, uuid);
+	}
+	pin->flags &= ~PIN_LOCKED;
+	return 0;
 }
 
 
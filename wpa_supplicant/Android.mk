@@ -162,6 +162,11 @@ ifndef CONFIG_NO_CONFIG_BLOBS
 NEED_BASE64=y
 endif
 L_CFLAGS += -DCONFIG_BACKEND_FILE
+ifdef CONFIG_ASYNC_CONFIG_WRITE
+ifndef CONFIG_NO_CONFIG_WRITE
+L_CFLAGS += -DCONFIG_ASYNC_CONFIG_WRITE
+endif
+endif
 endif
 
 ifeq ($(CONFIG_BACKEND), winreg)
@@ -1243,6 +1248,10 @@ ifdef NEED_ECC
 L_CFLAGS += -DCONFIG_ECC
 endif
 
+ifdef CONFIG_NO_WPABUF_POOL
+L_CFLAGS += -DCONFIG_NO_WPABUF_POOL
+endif
+
 ifdef CONFIG_NO_RANDOM_POOL
 L_CFLAGS += -DCONFIG_NO_RANDOM_POOL
 else
@@ -1260,6 +1269,7 @@ endif
 L_CFLAGS += -DCONFIG_CTRL_IFACE
 ifeq ($(CONFIG_CTRL_IFACE), unix)
 L_CFLAGS += -DCONFIG_CTRL_IFACE_UNIX
+OBJS += src/common/ctrl_iface_common.c
 endif
 ifeq ($(CONFIG_CTRL_IFACE), udp)
 L_CFLAGS += -DCONFIG_CTRL_IFACE_UDP
@@ -1425,6 +1435,12 @@ OBJS += bgscan_learn.c
 NEED_BGSCAN=y
 endif
 
+ifdef CONFIG_BGSCAN_PLAN
+L_CFLAGS += -DCONFIG_BGSCAN_PLAN
+OBJS += bgscan_plan.c
+NEED_BGSCAN=y
+endif
+
 ifdef NEED_BGSCAN
 L_CFLAGS += -DCONFIG_BGSCAN
 OBJS += bgscan.c
@@ -1470,6 +1486,15 @@ OBJS += offchannel.c
 L_CFLAGS += -DCONFIG_OFFCHANNEL
 endif
 
+ifdef CONFIG_STATS_SHM
+L_CFLAGS += -DCONFIG_STATS_SHM
+OBJS += src/utils/stats_shm.c
+OBJS += wpas_stats.c
+ifdef CONFIG_AP
+OBJS += src/ap/ap_stats.c
+endif
+endif
+
 OBJS += src/drivers/driver_common.c
 
 OBJS_wpa_rm := ctrl_iface.c ctrl_iface_unix.c
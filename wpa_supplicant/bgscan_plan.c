@@ -0,0 +1,792 @@
+/*
+ * WPA Supplicant - background scan and roaming module: plan
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * This module learns how likely BSSes of the ESS are to be found on each
+ * channel and how likely each known BSS is to show up when its channel is
+ * scanned. Background scans are limited to the channels where the ESS is
+ * likely to be found. A full scan is used whenever the model is not
+ * confident enough: not all channels have been observed enough, the expected
+ * number of APs on the skipped channels is too large, or a planned scan did
+ * not find any other BSS of the ESS. In addition, every PLAN_FULL_SCAN_EVERY
+ * background scan is a full scan to track changes in the network.
+ */
+
+#include "includes.h"
+
+#include "common.h"
+#include "eloop.h"
+#include "list.h"
+#include "common/ieee802_11_defs.h"
+#include "drivers/driver.h"
+#include "config_ssid.h"
+#include "wpa_supplicant_i.h"
+#include "driver_i.h"
+#include "scan.h"
+#include "bgscan.h"
+
+/* Probabilities are stored as fixed point values in range 0..PLAN_PROB_MAX */
+#define PLAN_PROB_MAX 0xffff
+/* Weight of a new observation in the moving averages is 1/PLAN_EWMA_DIV */
+#define PLAN_EWMA_DIV 8
+/* Channels with a lower ESS occupancy are left out from planned scans */
+#define PLAN_OCCUPANCY_THRESHOLD (PLAN_PROB_MAX / 10)
+/* Full scans are used until each channel has been observed this many times */
+#define PLAN_MIN_SAMPLES 3
+/* Maximum expected number of ESS APs on the skipped channels */
+#define PLAN_MAX_EXPECTED_MISS (PLAN_PROB_MAX / 4)
+/* Every Nth background scan is a full scan */
+#define PLAN_FULL_SCAN_EVERY 10
+/* Maximum number of BSSes in the model */
+#define PLAN_MAX_BSS 64
+/* BSSes with a lower appearance probability are removed from the model */
+#define PLAN_BSS_EXPIRE (PLAN_PROB_MAX / 100)
+/* Maximum age of results from scans that were not requested by this module */
+#define PLAN_MAX_AGE_MS 5000
+
+/*
+ * Model file format (all values in network byte order):
+ * header: "BGSP" (4), version (1), SSID length (1), SSID, number of channels
+ *	(2), number of BSSes (2)
+ * channel: frequency in MHz (2), occupancy (2), number of samples (2)
+ * BSS: BSSID (6), frequency in MHz (2), appearance (2)
+ */
+#define PLAN_FILE_MAGIC "BGSP"
+#define PLAN_FILE_VERSION 1
+#define PLAN_FILE_CHAN_LEN 6
+#define PLAN_FILE_BSS_LEN 10
+
+struct bgscan_plan_chan {
+	int freq;
+	u16 occupancy; /* P(ESS BSS found | channel scanned) */
+	u16 samples;
+};
+
+struct bgscan_plan_bss {
+	struct dl_list list;
+	u8 bssid[ETH_ALEN];
+	int freq;
+	u16 appearance; /* P(BSS found | channel of the BSS scanned) */
+};
+
+struct bgscan_plan_data {
+	struct wpa_supplicant *wpa_s;
+	const struct wpa_ssid *ssid;
+	int scan_interval;
+	int signal_threshold;
+	int short_interval; /* use if signal < threshold */
+	int long_interval; /* use if signal > threshold */
+	struct os_reltime last_bgscan;
+	char *fname;
+	struct bgscan_plan_chan *chan;
+	size_t num_chan;
+	struct dl_list bss;
+	size_t num_bss;
+	int scan_pending; /* a scan requested by this module is in progress */
+	int *scan_freqs; /* frequencies of the pending scan; NULL = full scan */
+	unsigned int planned_scans; /* partial scans since last full scan */
+	int force_full;
+};
+
+
+static void ewma_update(u16 *val, int hit)
+{
+	int diff = (hit ? PLAN_PROB_MAX : 0) - (int) *val;
+
+	*val += diff / PLAN_EWMA_DIV;
+}
+
+
+static int in_array(const int *array, int val)
+{
+	int i;
+
+	if (array == NULL)
+		return 0;
+
+	for (i = 0; array[i]; i++) {
+		if (array[i] == val)
+			return 1;
+	}
+
+	return 0;
+}
+
+
+static struct bgscan_plan_chan * bgscan_plan_get_chan(
+	struct bgscan_plan_data *data, int freq)
+{
+	size_t i;
+
+	for (i = 0; i < data->num_chan; i++) {
+		if (data->chan[i].freq == freq)
+			return &data->chan[i];
+	}
+	return NULL;
+}
+
+
+static struct bgscan_plan_bss * bgscan_plan_get_bss(
+	struct bgscan_plan_data *data, const u8 *bssid)
+{
+	struct bgscan_plan_bss *bss;
+
+	dl_list_for_each(bss, &data->bss, struct bgscan_plan_bss, list) {
+		if (os_memcmp(bss->bssid, bssid, ETH_ALEN) == 0)
+			return bss;
+	}
+	return NULL;
+}
+
+
+static void bgscan_plan_del_bss(struct bgscan_plan_data *data,
+				struct bgscan_plan_bss *bss)
+{
+	dl_list_del(&bss->list);
+	data->num_bss--;
+	os_free(bss);
+}
+
+
+static struct bgscan_plan_bss * bgscan_plan_add_bss(
+	struct bgscan_plan_data *data, const u8 *bssid, int freq,
+	u16 appearance)
+{
+	struct bgscan_plan_bss *bss, *tmp, *least = NULL;
+
+	if (data->num_bss >= PLAN_MAX_BSS) {
+		/* Replace the BSS that is least likely to be seen */
+		dl_list_for_each(tmp, &data->bss, struct bgscan_plan_bss,
+				 list) {
+			if (least == NULL || tmp->appearance < least->appearance)
+				least = tmp;
+		}
+		if (least == NULL || least->appearance > appearance)
+			return NULL;
+		bgscan_plan_del_bss(data, least);
+	}
+
+	bss = os_zalloc(sizeof(*bss));
+	if (bss == NULL)
+		return NULL;
+	os_memcpy(bss->bssid, bssid, ETH_ALEN);
+	bss->freq = freq;
+	bss->appearance = appearance;
+	dl_list_add(&data->bss, &bss->list);
+	data->num_bss++;
+
+	return bss;
+}
+
+
+static int bgscan_plan_load(struct bgscan_plan_data *data)
+{
+	char *buf;
+	const u8 *pos, *end;
+	size_t len, num_chan, num_bss, i;
+	struct bgscan_plan_chan *chan;
+
+	if (data->fname == NULL)
+		return 0;
+
+	buf = os_readfile(data->fname, &len);
+	if (buf == NULL)
+		return 0;
+
+	wpa_printf(MSG_DEBUG, "bgscan plan: Loading data from %s",
+		   data->fname);
+
+	pos = (const u8 *) buf;
+	end = pos + len;
+	if (len < 6 || os_memcmp(pos, PLAN_FILE_MAGIC, 4) != 0 ||
+	    pos[4] != PLAN_FILE_VERSION || len < 6 + pos[5] + 4U)
+		goto invalid;
+	if (pos[5] != data->ssid->ssid_len ||
+	    os_memcmp(pos + 6, data->ssid->ssid, pos[5]) != 0) {
+		wpa_printf(MSG_INFO, "bgscan plan: Data file %s is for another "
+			   "SSID - ignore it", data->fname);
+		os_free(buf);
+		return 0;
+	}
+	pos += 6 + pos[5];
+	num_chan = WPA_GET_BE16(pos);
+	num_bss = WPA_GET_BE16(pos + 2);
+	pos += 4;
+	if ((size_t) (end - pos) != num_chan * PLAN_FILE_CHAN_LEN +
+	    num_bss * PLAN_FILE_BSS_LEN)
+		goto invalid;
+
+	for (i = 0; i < num_chan; i++) {
+		/* Channels that are not currently supported are dropped */
+		chan = bgscan_plan_get_chan(data, WPA_GET_BE16(pos));
+		if (chan) {
+			chan->occupancy = WPA_GET_BE16(pos + 2);
+			chan->samples = WPA_GET_BE16(pos + 4);
+		}
+		pos += PLAN_FILE_CHAN_LEN;
+	}
+
+	for (i = 0; i < num_bss; i++) {
+		if (!bgscan_plan_get_bss(data, pos))
+			bgscan_plan_add_bss(data, pos, WPA_GET_BE16(pos + 6),
+					    WPA_GET_BE16(pos + 8));
+		pos += PLAN_FILE_BSS_LEN;
+	}
+
+	wpa_printf(MSG_DEBUG, "bgscan plan: Loaded %u channels and %u BSSes",
+		   (unsigned int) num_chan, (unsigned int) num_bss);
+	os_free(buf);
+	return 0;
+
+invalid:
+	wpa_printf(MSG_INFO, "bgscan plan: Invalid data file %s", data->fname);
+	os_free(buf);
+	return -1;
+}
+
+
+static void bgscan_plan_save(struct bgscan_plan_data *data)
+{
+	FILE *f;
+	u8 *buf, *pos;
+	size_t len, i;
+	struct bgscan_plan_bss *bss;
+
+	if (data->fname == NULL)
+		return;
+
+	wpa_printf(MSG_DEBUG, "bgscan plan: Saving data to %s",
+		   data->fname);
+
+	len = 6 + data->ssid->ssid_len + 4 +
+		data->num_chan * PLAN_FILE_CHAN_LEN +
+		data->num_bss * PLAN_FILE_BSS_LEN;
+	buf = os_malloc(len);
+	if (buf == NULL)
+		return;
+
+	pos = buf;
+	os_memcpy(pos, PLAN_FILE_MAGIC, 4);
+	pos[4] = PLAN_FILE_VERSION;
+	pos[5] = data->ssid->ssid_len;
+	os_memcpy(pos + 6, data->ssid->ssid, data->ssid->ssid_len);
+	pos += 6 + data->ssid->ssid_len;
+	WPA_PUT_BE16(pos, data->num_chan);
+	WPA_PUT_BE16(pos + 2, data->num_bss);
+	pos += 4;
+
+	for (i = 0; i < data->num_chan; i++) {
+		WPA_PUT_BE16(pos, data->chan[i].freq);
+		WPA_PUT_BE16(pos + 2, data->chan[i].occupancy);
+		WPA_PUT_BE16(pos + 4, data->chan[i].samples);
+		pos += PLAN_FILE_CHAN_LEN;
+	}
+
+	dl_list_for_each(bss, &data->bss, struct bgscan_plan_bss, list) {
+		os_memcpy(pos, bss->bssid, ETH_ALEN);
+		WPA_PUT_BE16(pos + 6, bss->freq);
+		WPA_PUT_BE16(pos + 8, bss->appearance);
+		pos += PLAN_FILE_BSS_LEN;
+	}
+
+	f = fopen(data->fname, "wb");
+	if (f == NULL) {
+		os_free(buf);
+		return;
+	}
+	if (fwrite(buf, 1, len, f) != len)
+		wpa_printf(MSG_INFO, "bgscan plan: Failed to write %s",
+			   data->fname);
+	fclose(f);
+	os_free(buf);
+}
+
+
+/*
+ * Build the list of channels for a planned background scan. Returns %NULL if
+ * a full scan is to be used instead.
+ */
+static int * bgscan_plan_get_freqs(struct bgscan_plan_data *data)
+{
+	struct bgscan_plan_bss *bss;
+	int *freqs;
+	size_t i, count = 0;
+	u32 miss = 0;
+
+	if (data->force_full) {
+		wpa_printf(MSG_DEBUG, "bgscan plan: Previous planned scan did "
+			   "not find other BSSes - use full scan");
+		return NULL;
+	}
+
+	if (data->planned_scans >= PLAN_FULL_SCAN_EVERY - 1) {
+		wpa_printf(MSG_DEBUG, "bgscan plan: Periodic full scan");
+		return NULL;
+	}
+
+	freqs = os_calloc(data->num_chan + 2, sizeof(int));
+	if (freqs == NULL)
+		return NULL;
+
+	for (i = 0; i < data->num_chan; i++) {
+		if (data->chan[i].samples < PLAN_MIN_SAMPLES) {
+			wpa_printf(MSG_DEBUG, "bgscan plan: Not enough samples "
+				   "for %d MHz - use full scan",
+				   data->chan[i].freq);
+			os_free(freqs);
+			return NULL;
+		}
+		if (data->chan[i].occupancy >= PLAN_OCCUPANCY_THRESHOLD)
+			freqs[count++] = data->chan[i].freq;
+	}
+
+	/* Expected number of ESS APs that would be missed by this plan */
+	dl_list_for_each(bss, &data->bss, struct bgscan_plan_bss, list) {
+		if (!in_array(freqs, bss->freq))
+			miss += bss->appearance;
+	}
+	if (miss > PLAN_MAX_EXPECTED_MISS) {
+		wpa_printf(MSG_DEBUG, "bgscan plan: Too many APs expected on "
+			   "skipped channels (%u/%u) - use full scan",
+			   miss, PLAN_PROB_MAX);
+		os_free(freqs);
+		return NULL;
+	}
+
+	if (data->wpa_s->assoc_freq &&
+	    !in_array(freqs, data->wpa_s->assoc_freq))
+		freqs[count++] = data->wpa_s->assoc_freq;
+
+	if (count == 0 || count >= data->num_chan) {
+		os_free(freqs);
+		return NULL;
+	}
+
+	return freqs;
+}
+
+
+static void bgscan_plan_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct bgscan_plan_data *data = eloop_ctx;
+	struct wpa_supplicant *wpa_s = data->wpa_s;
+	struct wpa_driver_scan_params params;
+	int *freqs = NULL;
+	size_t i;
+	char msg[100], *pos;
+
+	os_memset(&params, 0, sizeof(params));
+	params.num_ssids = 1;
+	params.ssids[0].ssid = data->ssid->ssid;
+	params.ssids[0].ssid_len = data->ssid->ssid_len;
+	if (data->ssid->scan_freq)
+		params.freqs = data->ssid->scan_freq;
+	else {
+		freqs = bgscan_plan_get_freqs(data);
+
+		msg[0] = '\0';
+		pos = msg;
+		for (i = 0; freqs && freqs[i]; i++) {
+			int ret;
+			ret = os_snprintf(pos, msg + sizeof(msg) - pos, " %d",
+					  freqs[i]);
+			if (ret < 0 || ret >= msg + sizeof(msg) - pos)
+				break;
+			pos += ret;
+		}
+		pos[0] = '\0';
+		wpa_printf(MSG_DEBUG, "bgscan plan: Scanning frequencies:%s",
+			   freqs ? msg : " all");
+		params.freqs = freqs;
+	}
+
+	wpa_printf(MSG_DEBUG, "bgscan plan: Request a background scan");
+	if (wpa_supplicant_trigger_scan(wpa_s, &params)) {
+		wpa_printf(MSG_DEBUG, "bgscan plan: Failed to trigger scan");
+		eloop_register_timeout(data->scan_interval, 0,
+				       bgscan_plan_timeout, data, NULL);
+		os_free(freqs);
+		return;
+	}
+
+	os_get_reltime(&data->last_bgscan);
+	if (data->ssid->scan_freq) {
+		/* Configured channel list is not used for learning */
+		data->scan_pending = 0;
+		return;
+	}
+	data->scan_pending = 1;
+	os_free(data->scan_freqs);
+	data->scan_freqs = freqs;
+	if (freqs)
+		data->planned_scans++;
+	else
+		data->planned_scans = 0;
+	data->force_full = 0;
+}
+
+
+static int bgscan_plan_get_params(struct bgscan_plan_data *data,
+				  const char *params)
+{
+	const char *pos;
+
+	if (params == NULL)
+		return 0;
+
+	data->short_interval = atoi(params);
+
+	pos = os_strchr(params, ':');
+	if (pos == NULL)
+		return 0;
+	pos++;
+	data->signal_threshold = atoi(pos);
+	pos = os_strchr(pos, ':');
+	if (pos == NULL) {
+		wpa_printf(MSG_ERROR, "bgscan plan: Missing scan interval "
+			   "for high signal");
+		return -1;
+	}
+	pos++;
+	data->long_interval = atoi(pos);
+	pos = os_strchr(pos, ':');
+	if (pos) {
+		pos++;
+		data->fname = os_strdup(pos);
+	}
+
+	return 0;
+}
+
+
+static int bgscan_plan_init_chan(struct bgscan_plan_data *data)
+{
+	struct wpa_supplicant *wpa_s = data->wpa_s;
+	struct hostapd_hw_modes *modes;
+	struct bgscan_plan_chan *n;
+	int i, j, freq;
+
+	modes = wpa_s->hw.modes;
+	if (modes == NULL)
+		return 0;
+
+	for (i = 0; i < wpa_s->hw.num_modes; i++) {
+		for (j = 0; j < modes[i].num_channels; j++) {
+			if (modes[i].channels[j].flag & HOSTAPD_CHAN_DISABLED)
+				continue;
+			freq = modes[i].channels[j].freq;
+			/* some hw modes (e.g. 11b & 11g) contain same freqs */
+			if (bgscan_plan_get_chan(data, freq))
+				continue;
+			n = os_realloc_array(data->chan, data->num_chan + 1,
+					     sizeof(*n));
+			if (n == NULL)
+				return -1;
+			data->chan = n;
+			os_memset(&n[data->num_chan], 0, sizeof(*n));
+			n[data->num_chan].freq = freq;
+			data->num_chan++;
+		}
+	}
+
+	return 0;
+}
+
+
+static void bgscan_plan_free(struct bgscan_plan_data *data)
+{
+	struct bgscan_plan_bss *bss, *n;
+
+	dl_list_for_each_safe(bss, n, &data->bss, struct bgscan_plan_bss,
+			      list)
+		bgscan_plan_del_bss(data, bss);
+	os_free(data->chan);
+	os_free(data->scan_freqs);
+	os_free(data->fname);
+	os_free(data);
+}
+
+
+static void * bgscan_plan_init(struct wpa_supplicant *wpa_s,
+			       const char *params,
+			       const struct wpa_ssid *ssid)
+{
+	struct bgscan_plan_data *data;
+
+	data = os_zalloc(sizeof(*data));
+	if (data == NULL)
+		return NULL;
+	dl_list_init(&data->bss);
+	data->wpa_s = wpa_s;
+	data->ssid = ssid;
+	if (bgscan_plan_get_params(data, params) < 0 ||
+	    bgscan_plan_init_chan(data) < 0 ||
+	    bgscan_plan_load(data) < 0) {
+		bgscan_plan_free(data);
+		return NULL;
+	}
+	if (data->short_interval <= 0)
+		data->short_interval = 30;
+	if (data->long_interval <= 0)
+		data->long_interval = 30;
+
+	wpa_printf(MSG_DEBUG, "bgscan plan: Signal strength threshold %d  "
+		   "Short bgscan interval %d  Long bgscan interval %d",
+		   data->signal_threshold, data->short_interval,
+		   data->long_interval);
+
+	if (data->signal_threshold &&
+	    wpa_drv_signal_monitor(wpa_s, data->signal_threshold, 4) < 0) {
+		wpa_printf(MSG_ERROR, "bgscan plan: Failed to enable "
+			   "signal strength monitoring");
+	}
+
+	data->scan_interval = data->short_interval;
+	if (data->signal_threshold) {
+		/* Poll for signal info to set initial scan interval */
+		struct wpa_signal_info siginfo;
+		if (wpa_drv_signal_poll(wpa_s, &siginfo) == 0 &&
+		    siginfo.current_signal >= data->signal_threshold)
+			data->scan_interval = data->long_interval;
+	}
+
+	eloop_register_timeout(data->scan_interval, 0, bgscan_plan_timeout,
+			       data, NULL);
+
+	/*
+	 * This function is called immediately after an association, so it is
+	 * reasonable to assume that a scan was completed recently. This makes
+	 * us skip an immediate new scan in cases where the current signal
+	 * level is below the bgscan threshold.
+	 */
+	os_get_reltime(&data->last_bgscan);
+
+	return data;
+}
+
+
+static void bgscan_plan_deinit(void *priv)
+{
+	struct bgscan_plan_data *data = priv;
+
+	bgscan_plan_save(data);
+	eloop_cancel_timeout(bgscan_plan_timeout, data, NULL);
+	if (data->signal_threshold)
+		wpa_drv_signal_monitor(data->wpa_s, 0, 0);
+	bgscan_plan_free(data);
+}
+
+
+static int bgscan_plan_bss_match(struct bgscan_plan_data *data,
+				 struct wpa_scan_res *bss,
+				 unsigned int max_age)
+{
+	const u8 *ie;
+
+	if (bss->age > max_age)
+		return 0; /* not from the scan that is being processed */
+
+	ie = wpa_scan_get_ie(bss, WLAN_EID_SSID);
+	if (ie == NULL)
+		return 0;
+
+	if (data->ssid->ssid_len != ie[1] ||
+	    os_memcmp(data->ssid->ssid, ie + 2, ie[1]) != 0)
+		return 0; /* SSID mismatch */
+
+	return 1;
+}
+
+
+static int bgscan_plan_notify_scan(void *priv,
+				   struct wpa_scan_results *scan_res)
+{
+	struct bgscan_plan_data *data = priv;
+	struct bgscan_plan_bss *bss, *n;
+	struct bgscan_plan_chan *chan;
+	struct os_reltime now, age;
+	unsigned int max_age, found = 0, others = 0;
+	size_t i, j;
+	int own, scanned, hit;
+
+	wpa_printf(MSG_DEBUG, "bgscan plan: scan result notification");
+
+	eloop_cancel_timeout(bgscan_plan_timeout, data, NULL);
+	eloop_register_timeout(data->scan_interval, 0, bgscan_plan_timeout,
+			       data, NULL);
+
+	/*
+	 * Only the results of a scan requested by this module tell which
+	 * channels were scanned without finding the ESS. Other scans (e.g.,
+	 * for network selection) are only used as positive observations.
+	 */
+	own = data->scan_pending;
+	data->scan_pending = 0;
+	if (own) {
+		os_get_reltime(&now);
+		os_reltime_sub(&now, &data->last_bgscan, &age);
+		max_age = age.sec * 1000 + age.usec / 1000 + 1000;
+	} else {
+		max_age = PLAN_MAX_AGE_MS;
+	}
+
+	for (i = 0; i < data->num_chan; i++) {
+		chan = &data->chan[i];
+		scanned = own && (data->scan_freqs == NULL ||
+				  in_array(data->scan_freqs, chan->freq));
+		hit = 0;
+		for (j = 0; j < scan_res->num; j++) {
+			if (scan_res->res[j]->freq == chan->freq &&
+			    bgscan_plan_bss_match(data, scan_res->res[j],
+						  max_age)) {
+				hit = 1;
+				break;
+			}
+		}
+		if (!scanned && !hit)
+			continue;
+		ewma_update(&chan->occupancy, hit);
+		if (scanned && chan->samples < 0xffff)
+			chan->samples++;
+	}
+
+	for (i = 0; i < scan_res->num; i++) {
+		struct wpa_scan_res *res = scan_res->res[i];
+
+		if (!bgscan_plan_bss_match(data, res, max_age))
+			continue;
+		found++;
+		if (os_memcmp(res->bssid, data->wpa_s->bssid, ETH_ALEN) != 0)
+			others++;
+
+		bss = bgscan_plan_get_bss(data, res->bssid);
+		if (bss == NULL) {
+			wpa_printf(MSG_DEBUG, "bgscan plan: Add BSS " MACSTR
+				   " freq=%d", MAC2STR(res->bssid), res->freq);
+			bgscan_plan_add_bss(data, res->bssid, res->freq,
+					    PLAN_PROB_MAX / 2);
+			continue;
+		}
+		if (bss->freq != res->freq) {
+			wpa_printf(MSG_DEBUG, "bgscan plan: Update BSS "
+				   MACSTR " freq %d -> %d",
+				   MAC2STR(res->bssid), bss->freq, res->freq);
+			bss->freq = res->freq;
+		}
+		ewma_update(&bss->appearance, 1);
+	}
+
+	if (own) {
+		/* Known BSSes that were not found on a scanned channel */
+		dl_list_for_each_safe(bss, n, &data->bss,
+				      struct bgscan_plan_bss, list) {
+			if (data->scan_freqs &&
+			    !in_array(data->scan_freqs, bss->freq))
+				continue;
+			for (i = 0; i < scan_res->num; i++) {
+				if (os_memcmp(scan_res->res[i]->bssid,
+					      bss->bssid, ETH_ALEN) == 0 &&
+				    scan_res->res[i]->age <= max_age)
+					break;
+			}
+			if (i < scan_res->num)
+				continue;
+			ewma_update(&bss->appearance, 0);
+			if (bss->appearance < PLAN_BSS_EXPIRE) {
+				wpa_printf(MSG_DEBUG, "bgscan plan: Remove BSS "
+					   MACSTR, MAC2STR(bss->bssid));
+				bgscan_plan_del_bss(data, bss);
+			}
+		}
+
+		if (data->scan_freqs && others == 0)
+			data->force_full = 1;
+	}
+
+	wpa_printf(MSG_DEBUG, "bgscan plan: %u matching BSSes in scan "
+		   "results (%s scan)", found,
+		   !own ? "external" : data->scan_freqs ? "planned" : "full");
+
+	/*
+	 * A more advanced bgscan could process scan results internally, select
+	 * the BSS and request roam if needed. This module uses the existing
+	 * BSS/ESS selection routine.
+	 */
+
+	return 0;
+}
+
+
+static void bgscan_plan_notify_beacon_loss(void *priv)
+{
+	struct bgscan_plan_data *data = priv;
+
+	wpa_printf(MSG_DEBUG, "bgscan plan: beacon loss");
+	/* Make sure the next scan can find APs on any channel */
+	data->force_full = 1;
+}
+
+
+static void bgscan_plan_notify_signal_change(void *priv, int above,
+					     int current_signal,
+					     int current_noise,
+					     int current_txrate)
+{
+	struct bgscan_plan_data *data = priv;
+	int scan = 0;
+	struct os_reltime now;
+
+	if (data->short_interval == data->long_interval ||
+	    data->signal_threshold == 0)
+		return;
+
+	wpa_printf(MSG_DEBUG, "bgscan plan: signal level changed "
+		   "(above=%d current_signal=%d current_noise=%d "
+		   "current_txrate=%d)", above, current_signal,
+		   current_noise, current_txrate);
+	if (data->scan_interval == data->long_interval && !above) {
+		wpa_printf(MSG_DEBUG, "bgscan plan: Start using short bgscan "
+			   "interval");
+		data->scan_interval = data->short_interval;
+		os_get_reltime(&now);
+		if (now.sec > data->last_bgscan.sec + 1)
+			scan = 1;
+	} else if (data->scan_interval == data->short_interval && above) {
+		wpa_printf(MSG_DEBUG, "bgscan plan: Start using long bgscan "
+			   "interval");
+		data->scan_interval = data->long_interval;
+		eloop_cancel_timeout(bgscan_plan_timeout, data, NULL);
+		eloop_register_timeout(data->scan_interval, 0,
+				       bgscan_plan_timeout, data, NULL);
+	} else if (!above) {
+		/*
+		 * Signal dropped further 4 dB. Request a new scan if we have
+		 * not yet scanned in a while.
+		 */
+		os_get_reltime(&now);
+		if (now.sec > data->last_bgscan.sec + 10)
+			scan = 1;
+	}
+
+	if (scan) {
+		/*
+		 * A planned scan is fine here: it covers the channels where
+		 * roaming candidates are most likely to be found.
+		 */
+		wpa_printf(MSG_DEBUG, "bgscan plan: Trigger immediate scan");
+		eloop_cancel_timeout(bgscan_plan_timeout, data, NULL);
+		eloop_register_timeout(0, 0, bgscan_plan_timeout, data, NULL);
+	}
+}
+
+
+const struct bgscan_ops bgscan_plan_ops = {
+	.name = "plan",
+	.init = bgscan_plan_init,
+	.deinit = bgscan_plan_deinit,
+	.notify_scan = bgscan_plan_notify_scan,
+	.notify_beacon_loss = bgscan_plan_notify_beacon_loss,
+	.notify_signal_change = bgscan_plan_notify_signal_change,
+};
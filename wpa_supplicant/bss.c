@@ -11,6 +11,7 @@
 #include "utils/common.h"
 #include "utils/eloop.h"
 #include "common/ieee802_11_defs.h"
+#include "common/ieee802_11_common.h"
 #include "drivers/driver.h"
 #include "wpa_supplicant_i.h"
 #include "config.h"
@@ -224,6 +225,8 @@ static void wpa_bss_remove(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 		wpa_ssid_txt(bss->ssid, bss->ssid_len), reason);
 	wpas_notify_bss_removed(wpa_s, bss->bssid, bss->id);
 	wpa_bss_anqp_free(bss->anqp);
+	os_free(bss->ie_index);
+	os_free(bss->beacon_ie_index);
 	os_free(bss);
 }
 
@@ -352,6 +355,38 @@ static int wpa_bss_remove_oldest(struct wpa_supplicant *wpa_s)
 }
 
 
+static u32 wpa_bss_ie_hash(const u8 *ies, size_t len)
+{
+	u32 hash = 2166136261U;
+	size_t i;
+
+	/* FNV-1a */
+	for (i = 0; i < len; i++) {
+		hash ^= ies[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+
+static void wpa_bss_update_ie_index(struct wpa_bss *bss)
+{
+	const u8 *ies = (const u8 *) (bss + 1);
+
+	/*
+	 * The IEs are parsed once here so that the element lookups below do not
+	 * need to walk the IE buffers. If the index cannot be built, the
+	 * lookups fall back to a linear search.
+	 */
+	os_free(bss->ie_index);
+	bss->ie_index = ieee802_11_elem_index_build(ies, bss->ie_len);
+	os_free(bss->beacon_ie_index);
+	bss->beacon_ie_index = ieee802_11_elem_index_build(ies + bss->ie_len,
+							   bss->beacon_ie_len);
+}
+
+
 static struct wpa_bss * wpa_bss_add(struct wpa_supplicant *wpa_s,
 				    const u8 *ssid, size_t ssid_len,
 				    struct wpa_scan_res *res,
@@ -370,6 +405,10 @@ static struct wpa_bss * wpa_bss_add(struct wpa_supplicant *wpa_s,
 	bss->ie_len = res->ie_len;
 	bss->beacon_ie_len = res->beacon_ie_len;
 	os_memcpy(bss + 1, res + 1, res->ie_len + res->beacon_ie_len);
+	bss->ie_hash = wpa_bss_ie_hash((const u8 *) (res + 1), res->ie_len);
+	bss->beacon_ie_hash = wpa_bss_ie_hash((const u8 *) (res + 1) +
+					      res->ie_len, res->beacon_ie_len);
+	wpa_bss_update_ie_index(bss);
 	wpa_bss_set_hessid(bss);
 
 	if (wpa_s->num_bss + 1 > wpa_s->conf->bss_max_count &&
@@ -448,7 +487,7 @@ static int are_ies_equal(const struct wpa_bss *old,
 
 
 static u32 wpa_bss_compare_res(const struct wpa_bss *old,
-			       const struct wpa_scan_res *new)
+			       const struct wpa_scan_res *new, u32 ie_hash)
 {
 	u32 changes = 0;
 	int caps_diff = old->caps ^ new->caps;
@@ -465,7 +504,7 @@ static u32 wpa_bss_compare_res(const struct wpa_bss *old,
 	if (caps_diff & IEEE80211_CAP_IBSS)
 		changes |= WPA_BSS_MODE_CHANGED_FLAG;
 
-	if (old->ie_len == new->ie_len &&
+	if (old->ie_len == new->ie_len && old->ie_hash == ie_hash &&
 	    os_memcmp(old + 1, new + 1, old->ie_len) == 0)
 		return changes;
 	changes |= WPA_BSS_IES_CHANGED_FLAG;
@@ -525,14 +564,31 @@ static struct wpa_bss *
 wpa_bss_update(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 	       struct wpa_scan_res *res, struct os_reltime *fetch_time)
 {
-	u32 changes;
-
-	changes = wpa_bss_compare_res(bss, res);
+	u32 changes, ie_hash, beacon_ie_hash;
+	const u8 *res_ies = (const u8 *) (res + 1);
+	int ies_unchanged;
+
+	ie_hash = wpa_bss_ie_hash(res_ies, res->ie_len);
+	beacon_ie_hash = wpa_bss_ie_hash(res_ies + res->ie_len,
+					 res->beacon_ie_len);
+	changes = wpa_bss_compare_res(bss, res, ie_hash);
+	ies_unchanged = !(changes & WPA_BSS_IES_CHANGED_FLAG) &&
+		bss->beacon_ie_len == res->beacon_ie_len &&
+		bss->beacon_ie_hash == beacon_ie_hash &&
+		os_memcmp((const u8 *) (bss + 1) + bss->ie_len,
+			  res_ies + res->ie_len, res->beacon_ie_len) == 0;
 	bss->scan_miss_count = 0;
 	bss->last_update_idx = wpa_s->bss_update_idx;
 	wpa_bss_copy_res(bss, res, fetch_time);
 	/* Move the entry to the end of the list */
 	dl_list_del(&bss->list);
+	if (ies_unchanged) {
+		/*
+		 * Common case of a BSS that was seen again with only the
+		 * signal, TSF, or timestamp changing. The stored IEs and their
+		 * index are still valid, so there is no need to copy them.
+		 */
+	} else
 #ifdef CONFIG_P2P
 	if (wpa_bss_get_vendor_ie(bss, P2P_IE_VENDOR_TYPE) &&
 	    !wpa_scan_get_vendor_ie(res, P2P_IE_VENDOR_TYPE)) {
@@ -554,6 +610,9 @@ wpa_bss_update(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 		os_memcpy(bss + 1, res + 1, res->ie_len + res->beacon_ie_len);
 		bss->ie_len = res->ie_len;
 		bss->beacon_ie_len = res->beacon_ie_len;
+		bss->ie_hash = ie_hash;
+		bss->beacon_ie_hash = beacon_ie_hash;
+		wpa_bss_update_ie_index(bss);
 	} else {
 		struct wpa_bss *nbss;
 		struct dl_list *prev = bss->list_id.prev;
@@ -576,6 +635,9 @@ wpa_bss_update(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 				  res->ie_len + res->beacon_ie_len);
 			bss->ie_len = res->ie_len;
 			bss->beacon_ie_len = res->beacon_ie_len;
+			bss->ie_hash = ie_hash;
+			bss->beacon_ie_hash = beacon_ie_hash;
+			wpa_bss_update_ie_index(bss);
 		}
 		dl_list_add(prev, &bss->list_id);
 	}
@@ -1002,6 +1064,8 @@ const u8 * wpa_bss_get_ie(const struct wpa_bss *bss, u8 ie)
 	const u8 *end, *pos;
 
 	pos = (const u8 *) (bss + 1);
+	if (bss->ie_index)
+		return ieee802_11_elem_index_get(bss->ie_index, pos, ie);
 	end = pos + bss->ie_len;
 
 	while (pos + 1 < end) {
@@ -1030,6 +1094,9 @@ const u8 * wpa_bss_get_vendor_ie(const struct wpa_bss *bss, u32 vendor_type)
 	const u8 *end, *pos;
 
 	pos = (const u8 *) (bss + 1);
+	if (bss->ie_index)
+		return ieee802_11_elem_index_get_vendor(bss->ie_index, pos,
+							vendor_type);
 	end = pos + bss->ie_len;
 
 	while (pos + 1 < end) {
@@ -1067,6 +1134,9 @@ const u8 * wpa_bss_get_vendor_ie_beacon(const struct wpa_bss *bss,
 
 	pos = (const u8 *) (bss + 1);
 	pos += bss->ie_len;
+	if (bss->beacon_ie_index)
+		return ieee802_11_elem_index_get_vendor(bss->beacon_ie_index,
+							pos, vendor_type);
 	end = pos + bss->beacon_ie_len;
 
 	while (pos + 1 < end) {
@@ -1098,6 +1168,11 @@ struct wpabuf * wpa_bss_get_vendor_ie_multi(const struct wpa_bss *bss,
 	struct wpabuf *buf;
 	const u8 *end, *pos;
 
+	if (bss->ie_index)
+		return ieee802_11_elem_index_vendor_concat(
+			bss->ie_index, (const u8 *) (bss + 1), bss->ie_len,
+			vendor_type);
+
 	buf = wpabuf_alloc(bss->ie_len);
 	if (buf == NULL)
 		return NULL;
@@ -1142,6 +1217,12 @@ struct wpabuf * wpa_bss_get_vendor_ie_multi_beacon(const struct wpa_bss *bss,
 	struct wpabuf *buf;
 	const u8 *end, *pos;
 
+	if (bss->beacon_ie_index)
+		return ieee802_11_elem_index_vendor_concat(
+			bss->beacon_ie_index,
+			(const u8 *) (bss + 1) + bss->ie_len,
+			bss->beacon_ie_len, vendor_type);
+
 	buf = wpabuf_alloc(bss->beacon_ie_len);
 	if (buf == NULL)
 		return NULL;
@@ -10,6 +10,7 @@
 #define BSS_H
 
 struct wpa_scan_res;
+struct ieee802_11_elem_index;
 
 #define WPA_BSS_QUAL_INVALID		BIT(0)
 #define WPA_BSS_NOISE_INVALID		BIT(1)
@@ -88,6 +89,14 @@ struct wpa_bss {
 	struct os_reltime last_update;
 	/** ANQP data */
 	struct wpa_bss_anqp *anqp;
+	/** Element index for the IEs (from Probe Response) or %NULL */
+	struct ieee802_11_elem_index *ie_index;
+	/** Element index for the Beacon IEs or %NULL */
+	struct ieee802_11_elem_index *beacon_ie_index;
+	/** Hash of the IEs (from Probe Response) for change detection */
+	u32 ie_hash;
+	/** Hash of the Beacon IEs for change detection */
+	u32 beacon_ie_hash;
 	/** Length of the following IE field in octets (from Probe Response) */
 	size_t ie_len;
 	/** Length of the following Beacon IE field in octets */
@@ -1776,6 +1776,50 @@ static const struct parse_data ssid_fields[] = {
 #define NUM_SSID_FIELDS ARRAY_SIZE(ssid_fields)
 
 
+/*
+ * Sorted view of ssid_fields[] for binary search by variable name. The table
+ * itself is kept in the order used for listing the variables, so the index is
+ * built on the first lookup instead.
+ */
+static const struct parse_data *ssid_fields_sorted[NUM_SSID_FIELDS];
+static int ssid_fields_sorted_ready = 0;
+
+
+static int ssid_field_sort_cmp(const void *a, const void *b)
+{
+	const struct parse_data *fa = *(const struct parse_data **) a;
+	const struct parse_data *fb = *(const struct parse_data **) b;
+	return os_strcmp(fa->name, fb->name);
+}
+
+
+static int ssid_field_search_cmp(const void *key, const void *elem)
+{
+	const struct parse_data *field = *(const struct parse_data **) elem;
+	return os_strcmp(key, field->name);
+}
+
+
+static const struct parse_data * wpa_config_get_ssid_field(const char *var)
+{
+	const struct parse_data **res;
+
+	if (!ssid_fields_sorted_ready) {
+		size_t i;
+
+		for (i = 0; i < NUM_SSID_FIELDS; i++)
+			ssid_fields_sorted[i] = &ssid_fields[i];
+		qsort(ssid_fields_sorted, NUM_SSID_FIELDS,
+		      sizeof(ssid_fields_sorted[0]), ssid_field_sort_cmp);
+		ssid_fields_sorted_ready = 1;
+	}
+
+	res = bsearch(var, ssid_fields_sorted, NUM_SSID_FIELDS,
+		      sizeof(ssid_fields_sorted[0]), ssid_field_search_cmp);
+	return res ? *res : NULL;
+}
+
+
 /**
  * wpa_config_add_prio_network - Add a network to priority lists
  * @config: Configuration data from wpa_config_read()
@@ -2017,6 +2061,8 @@ void wpa_config_free(struct wpa_config *config)
 
 	wpa_config_flush_blobs(config);
 
+	os_free(config->ssid_index);
+	os_free(config->write_hash);
 	wpabuf_free(config->wps_vendor_ext_m1);
 	os_free(config->ctrl_interface);
 	os_free(config->ctrl_interface_group);
@@ -2042,6 +2088,7 @@ void wpa_config_free(struct wpa_config *config)
 	wpabuf_free(config->wps_nfc_dh_privkey);
 	wpabuf_free(config->wps_nfc_dev_pw);
 	os_free(config->ext_password_backend);
+	os_free(config->stats_file);
 	os_free(config->sae_groups);
 	wpabuf_free(config->ap_vendor_elements);
 	os_free(config->osu_dir);
@@ -2083,16 +2130,50 @@ void wpa_config_foreach_network(struct wpa_config *config,
  */
 struct wpa_ssid * wpa_config_get_network(struct wpa_config *config, int id)
 {
-	struct wpa_ssid *ssid;
+	if (id < 0 || (size_t) id >= config->ssid_index_len)
+		return NULL;
 
-	ssid = config->ssid;
-	while (ssid) {
-		if (id == ssid->id)
-			break;
-		ssid = ssid->next;
+	return config->ssid_index[id];
+}
+
+
+/**
+ * wpa_config_update_ssid_index - Update network id index
+ * @config: Configuration data from wpa_config_read()
+ * Returns: 0 on success, -1 on failure
+ *
+ * This function must be called whenever networks are added to or removed
+ * from the config->ssid list.
+ */
+int wpa_config_update_ssid_index(struct wpa_config *config)
+{
+	struct wpa_ssid *ssid, **index;
+	size_t len = 0;
+
+	for (ssid = config->ssid; ssid; ssid = ssid->next) {
+		if (ssid->id >= 0 && (size_t) ssid->id >= len)
+			len = ssid->id + 1;
 	}
 
-	return ssid;
+	if (len > config->ssid_index_len) {
+		index = os_realloc_array(config->ssid_index, len,
+					 sizeof(struct wpa_ssid *));
+		if (index == NULL)
+			return -1;
+		config->ssid_index = index;
+	}
+	config->ssid_index_len = len;
+	if (len == 0)
+		return 0;
+
+	os_memset(config->ssid_index, 0, len * sizeof(struct wpa_ssid *));
+	for (ssid = config->ssid; ssid; ssid = ssid->next) {
+		/* Use the first entry in case of duplicate ids */
+		if (ssid->id >= 0 && config->ssid_index[ssid->id] == NULL)
+			config->ssid_index[ssid->id] = ssid;
+	}
+
+	return 0;
 }
 
 
@@ -2106,15 +2187,13 @@ struct wpa_ssid * wpa_config_add_network(struct wpa_config *config)
 	int id;
 	struct wpa_ssid *ssid, *last = NULL;
 
-	id = -1;
+	/* The index covers ids up to the highest one in use */
+	id = config->ssid_index_len;
 	ssid = config->ssid;
 	while (ssid) {
-		if (ssid->id > id)
-			id = ssid->id;
 		last = ssid;
 		ssid = ssid->next;
 	}
-	id++;
 
 	ssid = os_zalloc(sizeof(*ssid));
 	if (ssid == NULL)
@@ -2126,6 +2205,15 @@ struct wpa_ssid * wpa_config_add_network(struct wpa_config *config)
 	else
 		config->ssid = ssid;
 
+	if (wpa_config_update_ssid_index(config) < 0) {
+		if (last)
+			last->next = NULL;
+		else
+			config->ssid = NULL;
+		os_free(ssid);
+		return NULL;
+	}
+
 	wpa_config_update_prio_list(config);
 
 	return ssid;
@@ -2158,6 +2246,7 @@ int wpa_config_remove_network(struct wpa_config *config, int id)
 	else
 		config->ssid = ssid->next;
 
+	wpa_config_update_ssid_index(config);
 	wpa_config_update_prio_list(config);
 	wpa_config_free_ssid(ssid);
 	return 0;
@@ -2232,31 +2321,26 @@ void wpa_config_set_network_defaults(struct wpa_ssid *ssid)
 int wpa_config_set(struct wpa_ssid *ssid, const char *var, const char *value,
 		   int line)
 {
-	size_t i;
+	const struct parse_data *field;
 	int ret = 0;
 
 	if (ssid == NULL || var == NULL || value == NULL)
 		return -1;
 
-	for (i = 0; i < NUM_SSID_FIELDS; i++) {
-		const struct parse_data *field = &ssid_fields[i];
-		if (os_strcmp(var, field->name) != 0)
-			continue;
-
-		if (field->parser(field, ssid, line, value)) {
-			if (line) {
-				wpa_printf(MSG_ERROR, "Line %d: failed to "
-					   "parse %s '%s'.", line, var, value);
-			}
-			ret = -1;
-		}
-		break;
-	}
-	if (i == NUM_SSID_FIELDS) {
+	field = wpa_config_get_ssid_field(var);
+	if (field == NULL) {
 		if (line) {
 			wpa_printf(MSG_ERROR, "Line %d: unknown network field "
 				   "'%s'.", line, var);
 		}
+		return -1;
+	}
+
+	if (field->parser(field, ssid, line, value)) {
+		if (line) {
+			wpa_printf(MSG_ERROR, "Line %d: failed to "
+				   "parse %s '%s'.", line, var, value);
+		}
 		ret = -1;
 	}
 
@@ -2362,18 +2446,16 @@ err:
  */
 char * wpa_config_get(struct wpa_ssid *ssid, const char *var)
 {
-	size_t i;
+	const struct parse_data *field;
 
 	if (ssid == NULL || var == NULL)
 		return NULL;
 
-	for (i = 0; i < NUM_SSID_FIELDS; i++) {
-		const struct parse_data *field = &ssid_fields[i];
-		if (os_strcmp(var, field->name) == 0)
-			return field->writer(field, ssid);
-	}
+	field = wpa_config_get_ssid_field(var);
+	if (field == NULL)
+		return NULL;
 
-	return NULL;
+	return field->writer(field, ssid);
 }
 
 
@@ -2395,32 +2477,29 @@ char * wpa_config_get(struct wpa_ssid *ssid, const char *var)
  */
 char * wpa_config_get_no_key(struct wpa_ssid *ssid, const char *var)
 {
-	size_t i;
+	const struct parse_data *field;
+	char *res;
 
 	if (ssid == NULL || var == NULL)
 		return NULL;
 
-	for (i = 0; i < NUM_SSID_FIELDS; i++) {
-		const struct parse_data *field = &ssid_fields[i];
-		if (os_strcmp(var, field->name) == 0) {
-			char *res = field->writer(field, ssid);
-			if (field->key_data) {
-				if (res && res[0]) {
-					wpa_printf(MSG_DEBUG, "Do not allow "
-						   "key_data field to be "
-						   "exposed");
-					str_clear_free(res);
-					return os_strdup("*");
-				}
+	field = wpa_config_get_ssid_field(var);
+	if (field == NULL)
+		return NULL;
 
-				os_free(res);
-				return NULL;
-			}
-			return res;
+	res = field->writer(field, ssid);
+	if (field->key_data) {
+		if (res && res[0]) {
+			wpa_printf(MSG_DEBUG, "Do not allow key_data field to "
+				   "be exposed");
+			str_clear_free(res);
+			return os_strdup("*");
 		}
-	}
 
-	return NULL;
+		os_free(res);
+		return NULL;
+	}
+	return res;
 }
 #endif /* NO_CONFIG_WRITE */
 
@@ -3291,6 +3370,7 @@ struct wpa_config * wpa_config_alloc_empty(const char *ctrl_interface,
 	config->p2p_search_delay = DEFAULT_P2P_SEARCH_DELAY;
 	config->rand_addr_lifetime = DEFAULT_RAND_ADDR_LIFETIME;
 	config->key_mgmt_offload = DEFAULT_KEY_MGMT_OFFLOAD;
+	config->stats_interval = DEFAULT_STATS_INTERVAL;
 
 	if (ctrl_interface)
 		config->ctrl_interface = os_strdup(ctrl_interface);
@@ -3917,6 +3997,8 @@ static const struct global_parse_data global_fields[] = {
 	{ INT(rand_addr_lifetime), 0 },
 	{ INT(preassoc_mac_addr), 0 },
 	{ INT(key_mgmt_offload), 0},
+	{ STR(stats_file), 0 },
+	{ INT_RANGE(stats_interval, 1, 3600), 0 },
 };
 
 #undef FUNC
@@ -3931,19 +4013,76 @@ static const struct global_parse_data global_fields[] = {
 #define NUM_GLOBAL_FIELDS ARRAY_SIZE(global_fields)
 
 
+/* Sorted view of global_fields[] for binary search; see ssid_fields_sorted */
+static const struct global_parse_data *global_fields_sorted[NUM_GLOBAL_FIELDS];
+static int global_fields_sorted_ready = 0;
+
+struct global_field_key {
+	const char *name;
+	size_t len;
+};
+
+
+static int global_field_sort_cmp(const void *a, const void *b)
+{
+	const struct global_parse_data *fa =
+		*(const struct global_parse_data **) a;
+	const struct global_parse_data *fb =
+		*(const struct global_parse_data **) b;
+	return os_strcmp(fa->name, fb->name);
+}
+
+
+static int global_field_search_cmp(const void *key, const void *elem)
+{
+	const struct global_field_key *k = key;
+	const struct global_parse_data *field =
+		*(const struct global_parse_data **) elem;
+	int res;
+
+	res = os_strncmp(k->name, field->name, k->len);
+	if (res)
+		return res;
+	/* Key is a prefix of the field name, so it sorts before it */
+	return field->name[k->len] ? -1 : 0;
+}
+
+
+static const struct global_parse_data *
+wpa_config_get_global_field(const char *name, size_t len)
+{
+	const struct global_parse_data **res;
+	struct global_field_key key;
+
+	if (!global_fields_sorted_ready) {
+		size_t i;
+
+		for (i = 0; i < NUM_GLOBAL_FIELDS; i++)
+			global_fields_sorted[i] = &global_fields[i];
+		qsort(global_fields_sorted, NUM_GLOBAL_FIELDS,
+		      sizeof(global_fields_sorted[0]), global_field_sort_cmp);
+		global_fields_sorted_ready = 1;
+	}
+
+	key.name = name;
+	key.len = len;
+	res = bsearch(&key, global_fields_sorted, NUM_GLOBAL_FIELDS,
+		      sizeof(global_fields_sorted[0]), global_field_search_cmp);
+	return res ? *res : NULL;
+}
+
+
 int wpa_config_process_global(struct wpa_config *config, char *pos, int line)
 {
-	size_t i;
+	const struct global_parse_data *field = NULL;
+	const char *eq;
 	int ret = 0;
 
-	for (i = 0; i < NUM_GLOBAL_FIELDS; i++) {
-		const struct global_parse_data *field = &global_fields[i];
-		size_t flen = os_strlen(field->name);
-		if (os_strncmp(pos, field->name, flen) != 0 ||
-		    pos[flen] != '=')
-			continue;
-
-		if (field->parser(field, config, line, pos + flen + 1)) {
+	eq = os_strchr(pos, '=');
+	if (eq)
+		field = wpa_config_get_global_field(pos, eq - pos);
+	if (field) {
+		if (field->parser(field, config, line, eq + 1)) {
 			wpa_printf(MSG_ERROR, "Line %d: failed to "
 				   "parse '%s'.", line, pos);
 			ret = -1;
@@ -3951,9 +4090,7 @@ int wpa_config_process_global(struct wpa_config *config, char *pos, int line)
 		if (field->changed_flag == CFG_CHANGED_NFC_PASSWORD_TOKEN)
 			config->wps_nfc_pw_from_config = 1;
 		config->changed_parameters |= field->changed_flag;
-		break;
-	}
-	if (i == NUM_GLOBAL_FIELDS) {
+	} else {
 #ifdef CONFIG_AP
 		if (os_strncmp(pos, "wmm_ac_", 7) == 0) {
 			char *tmp = os_strchr(pos, '=');
@@ -29,6 +29,7 @@
 #define DEFAULT_P2P_SEARCH_DELAY 500
 #define DEFAULT_RAND_ADDR_LIFETIME 60
 #define DEFAULT_KEY_MGMT_OFFLOAD 1
+#define DEFAULT_STATS_INTERVAL 5
 
 #include "config_ssid.h"
 #include "wps/wps.h"
@@ -337,6 +338,35 @@ struct wpa_config {
 	 */
 	struct wpa_ssid *ssid;
 
+	/**
+	 * ssid_index - Networks indexed by network id
+	 *
+	 * This array of ssid_index_len entries maps network ids to the
+	 * entries in the ssid list (%NULL for unused ids). It is updated with
+	 * wpa_config_update_ssid_index() whenever the list is modified.
+	 */
+	struct wpa_ssid **ssid_index;
+
+	/**
+	 * ssid_index_len - Number of entries in ssid_index
+	 */
+	size_t ssid_index_len;
+
+	/**
+	 * write_hash - Content hashes of the entries in the last written file
+	 *
+	 * This is used by the text file backend to track which entries
+	 * (global parameters, credentials, networks, blobs) have changed
+	 * since the configuration was last written so that updates without
+	 * changes can be skipped.
+	 */
+	u64 *write_hash;
+
+	/**
+	 * write_hash_len - Number of entries in write_hash
+	 */
+	size_t write_hash_len;
+
 	/**
 	 * pssid - Per-priority network lists (in priority order)
 	 */
@@ -1091,6 +1121,20 @@ struct wpa_config {
 	 * 2 = like 1, but maintain OUI (with local admin bit set)
 	 */
 	int preassoc_mac_addr;
+
+	/**
+	 * stats_file - Shared memory statistics region or %NULL if not used
+	 *
+	 * If set (and wpa_supplicant is built with CONFIG_STATS_SHM=y), the
+	 * interface statistics are maintained in this file in the format
+	 * described in wpas_stats.h.
+	 */
+	char *stats_file;
+
+	/**
+	 * stats_interval - Seconds between updates of stats_file
+	 */
+	int stats_interval;
 };
 
 
@@ -1103,6 +1147,7 @@ void wpa_config_foreach_network(struct wpa_config *config,
 				void *arg);
 struct wpa_ssid * wpa_config_get_network(struct wpa_config *config, int id);
 struct wpa_ssid * wpa_config_add_network(struct wpa_config *config);
+int wpa_config_update_ssid_index(struct wpa_config *config);
 int wpa_config_remove_network(struct wpa_config *config, int id);
 void wpa_config_set_network_defaults(struct wpa_ssid *ssid);
 int wpa_config_set(struct wpa_ssid *ssid, const char *var, const char *value,
@@ -1178,4 +1223,35 @@ struct wpa_config * wpa_config_read(const char *name, struct wpa_config *cfgp);
  */
 int wpa_config_write(const char *name, struct wpa_config *config);
 
+#if defined(CONFIG_ASYNC_CONFIG_WRITE) && !defined(CONFIG_NO_CONFIG_WRITE)
+/**
+ * wpa_config_write_async - Update configuration data in the background
+ * @name: Name of the configuration (e.g., path and file name for the
+ * configuration file)
+ * @config: Configuration data from wpa_config_read()
+ * Returns: 0 if the update was started or queued, 1 if the configuration
+ * was not changed since it was last written, -1 on failure
+ *
+ * The configuration is rendered before this function returns, i.e., config
+ * can be modified or freed immediately. The file is replaced atomically
+ * once the new contents have been written to stable storage.
+ */
+int wpa_config_write_async(const char *name, struct wpa_config *config);
+
+/**
+ * wpa_config_write_flush - Complete all background configuration updates
+ */
+void wpa_config_write_flush(void);
+#else /* CONFIG_ASYNC_CONFIG_WRITE && !CONFIG_NO_CONFIG_WRITE */
+static inline int wpa_config_write_async(const char *name,
+					 struct wpa_config *config)
+{
+	return wpa_config_write(name, config);
+}
+
+static inline void wpa_config_write_flush(void)
+{
+}
+#endif /* CONFIG_ASYNC_CONFIG_WRITE && !CONFIG_NO_CONFIG_WRITE */
+
 #endif /* CONFIG_H */
@@ -23,6 +23,11 @@
 #ifdef ANDROID
 #include <sys/stat.h>
 #endif
+#ifdef CONFIG_ASYNC_CONFIG_WRITE
+#include <pthread.h>
+#include "eloop.h"
+#include "list.h"
+#endif /* CONFIG_ASYNC_CONFIG_WRITE */
 
 static int newline_terminated(const char *buf, size_t buflen)
 {
@@ -445,6 +450,10 @@ struct wpa_config * wpa_config_read(const char *name, struct wpa_config *cfgp)
 	fclose(f);
 
 	config->ssid = head;
+	if (wpa_config_update_ssid_index(config) < 0) {
+		wpa_printf(MSG_ERROR, "Failed to index network blocks");
+		errors++;
+	}
 	wpa_config_debug_dump_networks(config);
 	config->cred = cred_head;
 
@@ -1197,40 +1206,108 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 
 	if (config->preassoc_mac_addr)
 		fprintf(f, "preassoc_mac_addr=%d\n", config->preassoc_mac_addr);
+
+	if (config->stats_file)
+		fprintf(f, "stats_file=%s\n", config->stats_file);
+	if (config->stats_interval != DEFAULT_STATS_INTERVAL)
+		fprintf(f, "stats_interval=%d\n", config->stats_interval);
 }
 
-#endif /* CONFIG_NO_CONFIG_WRITE */
 
+#ifdef CONFIG_ASYNC_CONFIG_WRITE
 
-int wpa_config_write(const char *name, struct wpa_config *config)
-{
-#ifndef CONFIG_NO_CONFIG_WRITE
+/*
+ * Configuration file contents are rendered into memory on the event loop
+ * thread and a hash of each entry (global parameters, credentials, networks,
+ * and blobs) is compared against the entries of the previously written file.
+ * This allows deferred updates that do not change anything to be skipped
+ * without touching the file system. The actual file update (write, fsync,
+ * rename) is done by a separate writer thread per configuration file. Only
+ * the rendered buffer and the file name are shared with the writer thread.
+ */
+
+struct wpa_config_render {
 	FILE *f;
+	char *data;
+	size_t len;
+	size_t pos;
+	u64 *hash;
+	size_t num_hash;
+	size_t hash_size;
+};
+
+struct wpa_config_writer {
+	struct dl_list list;
+	char *name;
+	pthread_t thread;
+	int running;
+	int res;
+	int failed;
+	struct wpabuf *buf; /* being written by the writer thread */
+	struct wpabuf *pending; /* to be written once the thread completes */
+};
+
+static struct dl_list wpa_config_writers =
+	{ &wpa_config_writers, &wpa_config_writers };
+static int wpa_config_writer_pipe[2] = { -1, -1 };
+
+
+static u64 wpa_config_entry_hash(const char *data, size_t len)
+{
+	u64 hash = 0xcbf29ce484222325ULL;
+	size_t i;
+
+	/* FNV-1a */
+	for (i = 0; i < len; i++) {
+		hash ^= (u8) data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+
+static void wpa_config_render_entry(struct wpa_config_render *r)
+{
+	u64 *n;
+
+	if (fflush(r->f) != 0)
+		return;
+	if (r->num_hash == r->hash_size) {
+		n = os_realloc_array(r->hash, r->hash_size + 16, sizeof(u64));
+		if (n == NULL)
+			return;
+		r->hash = n;
+		r->hash_size += 16;
+	}
+	r->hash[r->num_hash++] = wpa_config_entry_hash(r->data + r->pos,
+						       r->len - r->pos);
+	r->pos = r->len;
+}
+
+#else /* CONFIG_ASYNC_CONFIG_WRITE */
+
+struct wpa_config_render;
+
+static void wpa_config_render_entry(struct wpa_config_render *r)
+{
+}
+
+#endif /* CONFIG_ASYNC_CONFIG_WRITE */
+
+
+static int wpa_config_write_contents(FILE *f, struct wpa_config *config,
+				     struct wpa_config_render *r)
+{
 	struct wpa_ssid *ssid;
 	struct wpa_cred *cred;
 #ifndef CONFIG_NO_CONFIG_BLOBS
 	struct wpa_config_blob *blob;
 #endif /* CONFIG_NO_CONFIG_BLOBS */
 	int ret = 0;
-	int tmp_len = os_strlen(name) + 5;       /* allow space for .tmp suffix */
-	char *tmp_name = os_malloc(tmp_len);
-
-	if (tmp_name == NULL)
-		tmp_name = (char *)name;
-	else
-		os_snprintf(tmp_name, tmp_len, "%s.tmp", name);
-
-	wpa_printf(MSG_DEBUG, "Writing configuration file '%s'", tmp_name);
-
-	f = fopen(tmp_name, "w");
-	if (f == NULL) {
-		wpa_printf(MSG_DEBUG, "Failed to open '%s' for writing", tmp_name);
-		if (tmp_name != name)
-			os_free(tmp_name);
-		return -1;
-	}
 
 	wpa_config_write_global(f, config);
+	if (r)
+		wpa_config_render_entry(r);
 
 	for (cred = config->cred; cred; cred = cred->next) {
 		if (cred->temporary)
@@ -1238,6 +1315,8 @@ int wpa_config_write(const char *name, struct wpa_config *config)
 		fprintf(f, "\ncred={\n");
 		wpa_config_write_cred(f, cred);
 		fprintf(f, "}\n");
+		if (r)
+			wpa_config_render_entry(r);
 	}
 
 	for (ssid = config->ssid; ssid; ssid = ssid->next) {
@@ -1249,6 +1328,8 @@ int wpa_config_write(const char *name, struct wpa_config *config)
 		fprintf(f, "\nnetwork={\n");
 		wpa_config_write_network(f, ssid);
 		fprintf(f, "}\n");
+		if (r)
+			wpa_config_render_entry(r);
 	}
 
 #ifndef CONFIG_NO_CONFIG_BLOBS
@@ -1256,22 +1337,426 @@ int wpa_config_write(const char *name, struct wpa_config *config)
 		ret = wpa_config_write_blob(f, blob);
 		if (ret)
 			break;
+		if (r)
+			wpa_config_render_entry(r);
 	}
 #endif /* CONFIG_NO_CONFIG_BLOBS */
 
-	fclose(f);
+	return ret;
+}
+
+
+static int wpa_config_write_commit(FILE *f, const char *tmp_name,
+				   const char *name)
+{
+	int ret = 0;
+
+	/*
+	 * Make sure the new contents are on stable storage before the rename
+	 * replaces the old file so that a power loss cannot leave an empty or
+	 * truncated configuration file behind.
+	 */
+	if (fflush(f) != 0)
+		ret = -1;
+#ifndef _WIN32
+	if (ret == 0 && fsync(fileno(f)) != 0) {
+		wpa_printf(MSG_DEBUG, "fsync(%s) failed: %s",
+			   tmp_name, strerror(errno));
+		ret = -1;
+	}
+#endif /* _WIN32 */
+	if (fclose(f) != 0)
+		ret = -1;
 
 	if (tmp_name != name) {
 		int chmod_ret = 0;
 #ifdef ANDROID
 		chmod_ret = chmod(tmp_name, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
 #endif
-		if (chmod_ret != 0 || rename(tmp_name, name) != 0)
+		if (ret || chmod_ret != 0 || rename(tmp_name, name) != 0) {
+			unlink(tmp_name);
 			ret = -1;
+		}
+	}
+
+	return ret;
+}
+
+
+static char * wpa_config_tmp_name(const char *name)
+{
+	int tmp_len = os_strlen(name) + 5;       /* allow space for .tmp suffix */
+	char *tmp_name = os_malloc(tmp_len);
 
+	if (tmp_name)
+		os_snprintf(tmp_name, tmp_len, "%s.tmp", name);
+	return tmp_name;
+}
+
+
+#ifdef CONFIG_ASYNC_CONFIG_WRITE
+
+static void wpa_config_buf_free(struct wpabuf *buf)
+{
+	if (buf == NULL)
+		return;
+	/* The rendered file may contain passphrases and other secrets */
+	os_memset(wpabuf_mhead(buf), 0, wpabuf_len(buf));
+	wpabuf_free(buf);
+}
+
+
+/**
+ * wpa_config_render - Render configuration file contents into memory
+ * @config: Configuration data
+ * @changed: Set to 1 if the contents differ from the previous rendering
+ * Returns: Rendered file contents or %NULL on failure
+ *
+ * The per-entry content hashes in config->write_hash are updated to match
+ * the returned contents.
+ */
+static struct wpabuf * wpa_config_render(struct wpa_config *config,
+					 int *changed)
+{
+	struct wpa_config_render r;
+	struct wpabuf *buf = NULL;
+	size_t i, dirty = 0;
+	int ret;
+
+	os_memset(&r, 0, sizeof(r));
+	r.f = open_memstream(&r.data, &r.len);
+	if (r.f == NULL)
+		return NULL;
+
+	ret = wpa_config_write_contents(r.f, config, &r);
+	if (fclose(r.f) != 0)
+		ret = -1;
+	if (ret == 0 && r.data)
+		buf = wpabuf_alloc_copy(r.data, r.len);
+	if (r.data) {
+		os_memset(r.data, 0, r.len);
+		free(r.data); /* allocated by open_memstream() */
+	}
+	if (buf == NULL) {
+		os_free(r.hash);
+		return NULL;
+	}
+
+	for (i = 0; i < r.num_hash; i++) {
+		if (i >= config->write_hash_len ||
+		    r.hash[i] != config->write_hash[i])
+			dirty++;
+	}
+	*changed = dirty > 0 || r.num_hash != config->write_hash_len;
+	wpa_printf(MSG_DEBUG, "Configuration has %u/%u changed entries%s",
+		   (unsigned int) dirty, (unsigned int) r.num_hash,
+		   r.num_hash < config->write_hash_len ? " (entries removed)" :
+		   "");
+
+	os_free(config->write_hash);
+	config->write_hash = r.hash;
+	config->write_hash_len = r.num_hash;
+
+	return buf;
+}
+
+
+static int wpa_config_write_buf(const char *name, const struct wpabuf *buf)
+{
+	FILE *f;
+	char *tmp_name;
+	int ret = 0;
+
+	tmp_name = wpa_config_tmp_name(name);
+	if (tmp_name == NULL)
+		return -1;
+
+	f = fopen(tmp_name, "w");
+	if (f == NULL) {
 		os_free(tmp_name);
+		return -1;
+	}
+
+	if (fwrite(wpabuf_head(buf), 1, wpabuf_len(buf), f) != wpabuf_len(buf))
+		ret = -1;
+	if (wpa_config_write_commit(f, tmp_name, name) < 0)
+		ret = -1;
+	os_free(tmp_name);
+
+	return ret;
+}
+
+
+static void * wpa_config_writer_thread(void *arg)
+{
+	struct wpa_config_writer *w = arg;
+
+	w->res = wpa_config_write_buf(w->name, w->buf);
+	if (write(wpa_config_writer_pipe[1], &w, sizeof(w)) != sizeof(w)) {
+		/* Nothing to do here; the writer is joined on flush */
+	}
+	return NULL;
+}
+
+
+static struct wpa_config_writer * wpa_config_writer_get(const char *name)
+{
+	struct wpa_config_writer *w;
+
+	dl_list_for_each(w, &wpa_config_writers, struct wpa_config_writer,
+			 list) {
+		if (os_strcmp(w->name, name) == 0)
+			return w;
+	}
+	return NULL;
+}
+
+
+static void wpa_config_writer_free(struct wpa_config_writer *w)
+{
+	dl_list_del(&w->list);
+	wpa_config_buf_free(w->buf);
+	wpa_config_buf_free(w->pending);
+	os_free(w->name);
+	os_free(w);
+}
+
+
+/* Join a running writer thread and process its result */
+static void wpa_config_writer_join(struct wpa_config_writer *w)
+{
+	if (!w->running)
+		return;
+
+	pthread_join(w->thread, NULL);
+	w->running = 0;
+	w->failed = w->res < 0;
+	wpa_config_buf_free(w->buf);
+	w->buf = NULL;
+	wpa_printf(MSG_DEBUG, "Configuration file '%s' written %ssuccessfully",
+		   w->name, w->failed ? "un" : "");
+}
+
+
+static int wpa_config_writer_start(struct wpa_config_writer *w,
+				   struct wpabuf *buf)
+{
+	w->buf = buf;
+	if (pthread_create(&w->thread, NULL, wpa_config_writer_thread, w) ==
+	    0) {
+		w->running = 1;
+		return 0;
+	}
+
+	wpa_printf(MSG_DEBUG, "Could not start configuration writer thread - "
+		   "write '%s' synchronously", w->name);
+	w->res = wpa_config_write_buf(w->name, buf);
+	w->failed = w->res < 0;
+	wpa_config_buf_free(w->buf);
+	w->buf = NULL;
+	return w->res;
+}
+
+
+static void wpa_config_writer_done(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct wpa_config_writer *w, *done;
+	struct wpabuf *pending;
+
+	if (read(sock, &done, sizeof(done)) != sizeof(done))
+		return;
+
+	dl_list_for_each(w, &wpa_config_writers, struct wpa_config_writer,
+			 list) {
+		if (w == done)
+			break;
+	}
+	if (w != done || !w->running)
+		return;
+
+	wpa_config_writer_join(w);
+	pending = w->pending;
+	w->pending = NULL;
+	if (pending)
+		wpa_config_writer_start(w, pending);
+	else if (!w->failed)
+		wpa_config_writer_free(w);
+}
+
+
+static struct wpa_config_writer * wpa_config_writer_add(const char *name)
+{
+	struct wpa_config_writer *w;
+
+	if (wpa_config_writer_pipe[0] < 0) {
+		if (pipe(wpa_config_writer_pipe) < 0)
+			return NULL;
+		if (eloop_register_read_sock(wpa_config_writer_pipe[0],
+					     wpa_config_writer_done, NULL,
+					     NULL) < 0) {
+			close(wpa_config_writer_pipe[0]);
+			close(wpa_config_writer_pipe[1]);
+			wpa_config_writer_pipe[0] = -1;
+			wpa_config_writer_pipe[1] = -1;
+			return NULL;
+		}
+	}
+
+	w = os_zalloc(sizeof(*w));
+	if (w == NULL)
+		return NULL;
+	w->name = os_strdup(name);
+	if (w->name == NULL) {
+		os_free(w);
+		return NULL;
+	}
+	dl_list_add(&wpa_config_writers, &w->list);
+	return w;
+}
+
+
+/*
+ * Wait for an ongoing background update of the named file to complete. Any
+ * queued update is dropped since the caller is about to write a newer
+ * version of the configuration.
+ */
+static void wpa_config_writer_wait(const char *name)
+{
+	struct wpa_config_writer *w;
+
+	w = wpa_config_writer_get(name);
+	if (w == NULL)
+		return;
+	wpa_config_writer_join(w);
+	wpa_config_writer_free(w);
+}
+
+
+int wpa_config_write_async(const char *name, struct wpa_config *config)
+{
+	struct wpa_config_writer *w;
+	struct wpabuf *buf;
+	int changed = 0;
+
+	buf = wpa_config_render(config, &changed);
+	if (buf == NULL) {
+		wpa_printf(MSG_DEBUG, "Failed to render configuration for '%s'",
+			   name);
+		return -1;
+	}
+
+	w = wpa_config_writer_get(name);
+	if (!changed && (w == NULL || !w->failed)) {
+		wpa_printf(MSG_DEBUG, "Configuration file '%s' is up to date",
+			   name);
+		wpa_config_buf_free(buf);
+		return 1;
 	}
 
+	if (w == NULL)
+		w = wpa_config_writer_add(name);
+	if (w == NULL) {
+		int ret = wpa_config_write_buf(name, buf);
+		wpa_config_buf_free(buf);
+		return ret;
+	}
+
+	if (w->running) {
+		wpa_printf(MSG_DEBUG, "Queue update of configuration file '%s'",
+			   name);
+		wpa_config_buf_free(w->pending);
+		w->pending = buf;
+		return 0;
+	}
+
+	wpa_printf(MSG_DEBUG, "Writing configuration file '%s' in background",
+		   name);
+	return wpa_config_writer_start(w, buf);
+}
+
+
+void wpa_config_write_flush(void)
+{
+	struct wpa_config_writer *w, *tmp;
+
+	dl_list_for_each_safe(w, tmp, &wpa_config_writers,
+			      struct wpa_config_writer, list) {
+		wpa_config_writer_join(w);
+		if (w->pending) {
+			wpa_printf(MSG_DEBUG,
+				   "Writing queued update of configuration file '%s'",
+				   w->name);
+			if (wpa_config_write_buf(w->name, w->pending) < 0)
+				wpa_printf(MSG_INFO,
+					   "Failed to update configuration file '%s'",
+					   w->name);
+		}
+		wpa_config_writer_free(w);
+	}
+
+	if (wpa_config_writer_pipe[0] >= 0) {
+		eloop_unregister_read_sock(wpa_config_writer_pipe[0]);
+		close(wpa_config_writer_pipe[0]);
+		close(wpa_config_writer_pipe[1]);
+		wpa_config_writer_pipe[0] = -1;
+		wpa_config_writer_pipe[1] = -1;
+	}
+}
+
+#endif /* CONFIG_ASYNC_CONFIG_WRITE */
+
+#endif /* CONFIG_NO_CONFIG_WRITE */
+
+
+int wpa_config_write(const char *name, struct wpa_config *config)
+{
+#ifndef CONFIG_NO_CONFIG_WRITE
+#ifdef CONFIG_ASYNC_CONFIG_WRITE
+	struct wpabuf *buf;
+	int changed;
+	int ret;
+
+	wpa_config_writer_wait(name);
+
+	wpa_printf(MSG_DEBUG, "Writing configuration file '%s'", name);
+	buf = wpa_config_render(config, &changed);
+	if (buf == NULL)
+		ret = -1;
+	else
+		ret = wpa_config_write_buf(name, buf);
+	wpa_config_buf_free(buf);
+	if (ret) {
+		/* Make sure the next deferred update is not skipped */
+		os_free(config->write_hash);
+		config->write_hash = NULL;
+		config->write_hash_len = 0;
+	}
+#else /* CONFIG_ASYNC_CONFIG_WRITE */
+	FILE *f;
+	int ret = 0;
+	char *tmp_name = wpa_config_tmp_name(name);
+
+	if (tmp_name == NULL)
+		tmp_name = (char *)name;
+
+	wpa_printf(MSG_DEBUG, "Writing configuration file '%s'", tmp_name);
+
+	f = fopen(tmp_name, "w");
+	if (f == NULL) {
+		wpa_printf(MSG_DEBUG, "Failed to open '%s' for writing", tmp_name);
+		if (tmp_name != name)
+			os_free(tmp_name);
+		return -1;
+	}
+
+	ret = wpa_config_write_contents(f, config, NULL);
+	if (wpa_config_write_commit(f, tmp_name, name) < 0)
+		ret = -1;
+
+	if (tmp_name != name)
+		os_free(tmp_name);
+#endif /* CONFIG_ASYNC_CONFIG_WRITE */
+
 	wpa_printf(MSG_DEBUG, "Configuration file '%s' written %ssuccessfully",
 		   name, ret ? "un" : "");
 	return ret;
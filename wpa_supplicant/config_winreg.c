@@ -430,6 +430,8 @@ static int wpa_config_read_networks(struct wpa_config *config, HKEY hk)
 	RegCloseKey(nhk);
 
 	config->ssid = head;
+	if (wpa_config_update_ssid_index(config) < 0)
+		errors++;
 
 	return errors ? -1 : 0;
 }
@@ -5973,6 +5973,8 @@ static int wpas_ctrl_radio_work(struct wpa_supplicant *wpa_s, char *cmd,
 {
 	if (os_strcmp(cmd, "show") == 0)
 		return wpas_ctrl_radio_work_show(wpa_s, buf, buflen);
+	if (os_strcmp(cmd, "stats") == 0)
+		return radio_work_stats(wpa_s, buf, buflen);
 	if (os_strncmp(cmd, "add ", 4) == 0)
 		return wpas_ctrl_radio_work_add(wpa_s, cmd + 4, buf, buflen);
 	if (os_strncmp(cmd, "done ", 5) == 0)
@@ -20,6 +20,7 @@
 #include "utils/common.h"
 #include "utils/eloop.h"
 #include "utils/list.h"
+#include "common/ctrl_iface_common.h"
 #include "eapol_supp/eapol_supp_sm.h"
 #include "config.h"
 #include "wpa_supplicant_i.h"
@@ -40,6 +41,7 @@ struct wpa_ctrl_dst {
 	socklen_t addrlen;
 	int debug_level;
 	int errors;
+	struct ctrl_mon_queue queue;
 };
 
 
@@ -59,8 +61,7 @@ struct ctrl_iface_global_priv {
 };
 
 
-static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
-					   const char *ifname, int sock,
+static void wpa_supplicant_ctrl_iface_send(const char *ifname,
 					   struct dl_list *ctrl_dst,
 					   int level, const char *buf,
 					   size_t len,
@@ -70,6 +71,12 @@ static int wpas_ctrl_iface_reinit(struct wpa_supplicant *wpa_s,
 				  struct ctrl_iface_priv *priv);
 static int wpas_ctrl_iface_global_reinit(struct wpa_global *global,
 					 struct ctrl_iface_global_priv *priv);
+static int wpas_ctrl_iface_send_pending(int sock, struct dl_list *ctrl_dst,
+					struct ctrl_iface_priv *priv,
+					struct ctrl_iface_global_priv *gp);
+static void wpas_ctrl_iface_pending_timeout(void *eloop_ctx, void *timeout_ctx);
+static void wpas_global_ctrl_iface_pending_timeout(void *eloop_ctx,
+						 void *timeout_ctx);
 
 
 static int wpa_supplicant_ctrl_iface_attach(struct dl_list *ctrl_dst,
@@ -110,9 +117,10 @@ static int wpa_supplicant_ctrl_iface_detach(struct dl_list *ctrl_dst,
 				      (u8 *) from->sun_path,
 				      fromlen -
 				      offsetof(struct sockaddr_un, sun_path));
-			wpa_printf(MSG_DEBUG, "CTRL_IFACE monitor detached %s",
-				   addr_txt);
+			wpa_printf(MSG_DEBUG, "CTRL_IFACE monitor detached %s (%u dropped events)",
+				   addr_txt, dst->queue.dropped_total);
 			dl_list_del(&dst->list);
+			ctrl_mon_queue_clear(&dst->queue);
 			os_free(dst);
 			return 0;
 		}
@@ -150,30 +158,37 @@ static int wpa_supplicant_ctrl_iface_level(struct ctrl_iface_priv *priv,
 }
 
 
-static void wpa_supplicant_ctrl_iface_receive(int sock, void *eloop_ctx,
-					      void *sock_ctx)
+/*
+ * Commands that do not change any state; more than one of these can be
+ * processed per wakeup and identical requests are answered from a snapshot
+ */
+static const char * const wpas_ctrl_read_only_cmds[] = {
+	"PING", "MIB", "STATUS", "STATUS-", "GET ", "LIST_NETWORKS",
+	"LIST_NETWORKS ", "GET_NETWORK ", "GET_CAPABILITY ", "SCAN_RESULTS",
+	"BSS ", "INTERFACES", "STA-FIRST", "STA ", "STA-NEXT ", NULL
+};
+
+
+/*
+ * Returns 1 if the next pending request can be processed within the same
+ * batch or 0 if the request may have changed the state (or even removed the
+ * interface).
+ */
+static int wpa_supplicant_ctrl_iface_request(struct wpa_supplicant *wpa_s,
+					     struct ctrl_iface_priv *priv,
+					     int sock, char *buf,
+					     struct sockaddr_un *from,
+					     socklen_t fromlen,
+					     struct ctrl_iface_snapshot *snap)
 {
-	struct wpa_supplicant *wpa_s = eloop_ctx;
-	struct ctrl_iface_priv *priv = sock_ctx;
-	char buf[4096];
-	int res;
-	struct sockaddr_un from;
-	socklen_t fromlen = sizeof(from);
-	char *reply = NULL, *reply_buf = NULL;
+	char *reply = NULL, *reply_buf = NULL, *cmd;
+	const struct wpabuf *cached;
 	size_t reply_len = 0;
 	int new_attached = 0;
-
-	res = recvfrom(sock, buf, sizeof(buf) - 1, 0,
-		       (struct sockaddr *) &from, &fromlen);
-	if (res < 0) {
-		wpa_printf(MSG_ERROR, "recvfrom(ctrl_iface): %s",
-			   strerror(errno));
-		return;
-	}
-	buf[res] = '\0';
+	int batch = 0;
 
 	if (os_strcmp(buf, "ATTACH") == 0) {
-		if (wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst, &from,
+		if (wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst, from,
 						     fromlen))
 			reply_len = 1;
 		else {
@@ -181,17 +196,38 @@ static void wpa_supplicant_ctrl_iface_receive(int sock, void *eloop_ctx,
 			reply_len = 2;
 		}
 	} else if (os_strcmp(buf, "DETACH") == 0) {
-		if (wpa_supplicant_ctrl_iface_detach(&priv->ctrl_dst, &from,
+		if (wpa_supplicant_ctrl_iface_detach(&priv->ctrl_dst, from,
 						     fromlen))
 			reply_len = 1;
 		else
 			reply_len = 2;
+		batch = 1;
 	} else if (os_strncmp(buf, "LEVEL ", 6) == 0) {
-		if (wpa_supplicant_ctrl_iface_level(priv, &from, fromlen,
+		if (wpa_supplicant_ctrl_iface_level(priv, from, fromlen,
 						    buf + 6))
 			reply_len = 1;
 		else
 			reply_len = 2;
+		batch = 1;
+	} else if (ctrl_iface_cmd_match(buf, wpas_ctrl_read_only_cmds)) {
+		batch = 1;
+		cached = ctrl_iface_snapshot_get(snap, buf);
+		if (cached) {
+			wpa_hexdump_ascii(MSG_MSGDUMP,
+					  "RX ctrl_iface (from snapshot)",
+					  (const u8 *) buf, os_strlen(buf));
+			reply = (char *) wpabuf_head(cached);
+			reply_len = wpabuf_len(cached);
+		} else {
+			cmd = os_strdup(buf);
+			reply_buf = wpa_supplicant_ctrl_iface_process(
+				wpa_s, buf, &reply_len);
+			reply = reply_buf;
+			if (cmd && reply)
+				ctrl_iface_snapshot_add(snap, cmd, reply,
+							reply_len);
+			os_free(cmd);
+		}
 	} else {
 		reply_buf = wpa_supplicant_ctrl_iface_process(wpa_s, buf,
 							      &reply_len);
@@ -207,7 +243,7 @@ static void wpa_supplicant_ctrl_iface_receive(int sock, void *eloop_ctx,
 	}
 
 	if (reply) {
-		if (sendto(sock, reply, reply_len, 0, (struct sockaddr *) &from,
+		if (sendto(sock, reply, reply_len, 0, (struct sockaddr *) from,
 			   fromlen) < 0) {
 			int _errno = errno;
 			wpa_dbg(wpa_s, MSG_DEBUG,
@@ -226,12 +262,13 @@ static void wpa_supplicant_ctrl_iface_receive(int sock, void *eloop_ctx,
 				if (sock < 0) {
 					wpa_dbg(wpa_s, MSG_DEBUG, "Failed to reinitialize ctrl_iface socket");
 				}
+				batch = 0;
 			}
 			if (new_attached) {
 				wpa_dbg(wpa_s, MSG_DEBUG, "Failed to send response to ATTACH - detaching");
 				new_attached = 0;
 				wpa_supplicant_ctrl_iface_detach(
-					&priv->ctrl_dst, &from, fromlen);
+					&priv->ctrl_dst, from, fromlen);
 			}
 		}
 	}
@@ -239,6 +276,46 @@ static void wpa_supplicant_ctrl_iface_receive(int sock, void *eloop_ctx,
 
 	if (new_attached)
 		eapol_sm_notify_ctrl_attached(wpa_s->eapol);
+
+	return batch;
+}
+
+
+static void wpa_supplicant_ctrl_iface_receive(int sock, void *eloop_ctx,
+					      void *sock_ctx)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+	struct ctrl_iface_priv *priv = sock_ctx;
+	struct ctrl_iface_snapshot snap;
+	char buf[4096];
+	int res, count = 0;
+	struct sockaddr_un from;
+	socklen_t fromlen;
+
+	/*
+	 * Process pending requests in a batch for as long as they do not
+	 * change the state so that a burst of status queries from monitoring
+	 * programs does not need a separate eloop iteration for each request.
+	 */
+	os_memset(&snap, 0, sizeof(snap));
+	do {
+		fromlen = sizeof(from);
+		res = recvfrom(sock, buf, sizeof(buf) - 1,
+			       count ? MSG_DONTWAIT : 0,
+			       (struct sockaddr *) &from, &fromlen);
+		if (res < 0) {
+			if (count == 0)
+				wpa_printf(MSG_ERROR,
+					   "recvfrom(ctrl_iface): %s",
+					   strerror(errno));
+			break;
+		}
+		buf[res] = '\0';
+		count++;
+	} while (wpa_supplicant_ctrl_iface_request(wpa_s, priv, sock, buf,
+						   &from, fromlen, &snap) &&
+		 count < CTRL_IFACE_MAX_BATCH);
+	ctrl_iface_snapshot_clear(&snap);
 }
 
 
@@ -305,9 +382,8 @@ static void wpa_supplicant_ctrl_iface_msg_cb(void *ctx, int level, int global,
 	if (global != 2 && wpa_s->global->ctrl_iface) {
 		struct ctrl_iface_global_priv *priv = wpa_s->global->ctrl_iface;
 		if (!dl_list_empty(&priv->ctrl_dst)) {
-			wpa_supplicant_ctrl_iface_send(wpa_s, global ? NULL :
+			wpa_supplicant_ctrl_iface_send(global ? NULL :
 						       wpa_s->ifname,
-						       priv->sock,
 						       &priv->ctrl_dst,
 						       level, txt, len, NULL,
 						       priv);
@@ -316,8 +392,7 @@ static void wpa_supplicant_ctrl_iface_msg_cb(void *ctx, int level, int global,
 
 	if (wpa_s->ctrl_iface == NULL)
 		return;
-	wpa_supplicant_ctrl_iface_send(wpa_s, NULL, wpa_s->ctrl_iface->sock,
-				       &wpa_s->ctrl_iface->ctrl_dst,
+	wpa_supplicant_ctrl_iface_send(NULL, &wpa_s->ctrl_iface->ctrl_dst,
 				       level, txt, len, wpa_s->ctrl_iface,
 				       NULL);
 }
@@ -584,10 +659,13 @@ void wpa_supplicant_ctrl_iface_deinit(struct ctrl_iface_priv *priv)
 {
 	struct wpa_ctrl_dst *dst, *prev;
 
+	eloop_cancel_timeout(wpas_ctrl_iface_pending_timeout, priv, NULL);
 	if (priv->sock > -1) {
 		char *fname;
 		char *buf, *dir = NULL;
 		eloop_unregister_read_sock(priv->sock);
+		wpas_ctrl_iface_send_pending(priv->sock, &priv->ctrl_dst, NULL,
+					     NULL);
 		if (!dl_list_empty(&priv->ctrl_dst)) {
 			/*
 			 * Wait before closing the control socket if
@@ -636,87 +714,62 @@ void wpa_supplicant_ctrl_iface_deinit(struct ctrl_iface_priv *priv)
 
 free_dst:
 	dl_list_for_each_safe(dst, prev, &priv->ctrl_dst, struct wpa_ctrl_dst,
-			      list)
+			      list) {
+		ctrl_mon_queue_clear(&dst->queue);
 		os_free(dst);
+	}
 	os_free(priv);
 }
 
 
+/* Retry interval for monitors that could not receive all pending events */
+#define CTRL_IFACE_RETRY_MS 100
+
 /**
- * wpa_supplicant_ctrl_iface_send - Send a control interface packet to monitors
- * @ifname: Interface name for global control socket or %NULL
+ * wpas_ctrl_iface_send_pending - Send pending events to attached monitors
  * @sock: Local socket fd
  * @ctrl_dst: List of attached listeners
- * @level: Priority level of the message
- * @buf: Message data
- * @len: Message length
+ * @priv: Per-interface control interface or %NULL
+ * @gp: Global control interface or %NULL
+ * Returns: 1 if some events could not be sent, 0 otherwise
  *
- * Send a packet to all monitor programs attached to the control interface.
+ * If neither priv nor gp is given, the socket is not reinitialized on
+ * errors and no monitors are detached (used when shutting down).
  */
-static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
-					   const char *ifname, int sock,
-					   struct dl_list *ctrl_dst,
-					   int level, const char *buf,
-					   size_t len,
-					   struct ctrl_iface_priv *priv,
-					   struct ctrl_iface_global_priv *gp)
+static int wpas_ctrl_iface_send_pending(int sock, struct dl_list *ctrl_dst,
+					struct ctrl_iface_priv *priv,
+					struct ctrl_iface_global_priv *gp)
 {
 	struct wpa_ctrl_dst *dst, *next;
-	char levelstr[10];
-	int idx, res;
-	struct msghdr msg;
-	struct iovec io[5];
-
-	if (sock < 0 || dl_list_empty(ctrl_dst))
-		return;
-
-	res = os_snprintf(levelstr, sizeof(levelstr), "<%d>", level);
-	if (res < 0 || (size_t) res >= sizeof(levelstr))
-		return;
-	idx = 0;
-	if (ifname) {
-		io[idx].iov_base = "IFNAME=";
-		io[idx].iov_len = 7;
-		idx++;
-		io[idx].iov_base = (char *) ifname;
-		io[idx].iov_len = os_strlen(ifname);
-		idx++;
-		io[idx].iov_base = " ";
-		io[idx].iov_len = 1;
-		idx++;
-	}
-	io[idx].iov_base = levelstr;
-	io[idx].iov_len = os_strlen(levelstr);
-	idx++;
-	io[idx].iov_base = (char *) buf;
-	io[idx].iov_len = len;
-	idx++;
-	os_memset(&msg, 0, sizeof(msg));
-	msg.msg_iov = io;
-	msg.msg_iovlen = idx;
+	int pending = 0;
 
 	dl_list_for_each_safe(dst, next, ctrl_dst, struct wpa_ctrl_dst, list) {
-		int _errno;
+		int _errno, res;
 		char addr_txt[200];
 
-		if (level < dst->debug_level)
+		if (sock < 0)
+			break;
+		if (dst->queue.count == 0 && dst->queue.dropped == 0)
 			continue;
 
 		printf_encode(addr_txt, sizeof(addr_txt),
 			      (u8 *) dst->addr.sun_path, dst->addrlen -
 			      offsetof(struct sockaddr_un, sun_path));
-		msg.msg_name = (void *) &dst->addr;
-		msg.msg_namelen = dst->addrlen;
-		if (sendmsg(sock, &msg, MSG_DONTWAIT) >= 0) {
-			wpa_printf(MSG_DEBUG, "CTRL_IFACE monitor sent successfully to %s",
-				   addr_txt);
+		res = ctrl_mon_queue_send(&dst->queue, sock, &dst->addr,
+					  dst->addrlen);
+		if (res >= 0) {
+			wpa_printf(MSG_DEBUG, "CTRL_IFACE monitor sent %d message(s) successfully to %s",
+				   res, addr_txt);
 			dst->errors = 0;
 			continue;
 		}
 
 		_errno = errno;
-		wpa_printf(MSG_DEBUG, "CTRL_IFACE monitor[%s]: %d - %s",
-			   addr_txt, errno, strerror(errno));
+		wpa_printf(MSG_DEBUG, "CTRL_IFACE monitor[%s]: %d - %s (%u pending, %u dropped)",
+			   addr_txt, errno, strerror(errno), dst->queue.count,
+			   dst->queue.dropped_total);
+		if (priv == NULL && gp == NULL)
+			continue;
 		dst->errors++;
 
 		if (dst->errors > 10 || _errno == ENOENT || _errno == EPERM) {
@@ -724,7 +777,9 @@ static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
 				addr_txt);
 			wpa_supplicant_ctrl_iface_detach(ctrl_dst, &dst->addr,
 							 dst->addrlen);
+			continue;
 		}
+		pending = 1;
 
 		if (_errno == ENOBUFS || _errno == EAGAIN) {
 			/*
@@ -735,19 +790,101 @@ static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
 			 * responses.
 			 */
 			if (priv)
-				sock = wpas_ctrl_iface_reinit(wpa_s, priv);
-			else if (gp)
-				sock = wpas_ctrl_iface_global_reinit(
-					wpa_s->global, gp);
+				sock = wpas_ctrl_iface_reinit(priv->wpa_s,
+							      priv);
 			else
-				break;
+				sock = wpas_ctrl_iface_global_reinit(
+					gp->global, gp);
 			if (sock < 0) {
-				wpa_dbg(wpa_s, MSG_DEBUG,
-					"Failed to reinitialize ctrl_iface socket");
+				wpa_printf(MSG_DEBUG,
+					   "Failed to reinitialize ctrl_iface socket");
 				break;
 			}
 		}
 	}
+
+	return pending;
+}
+
+
+static void wpas_ctrl_iface_pending_timeout(void *eloop_ctx,
+					    void *timeout_ctx)
+{
+	struct ctrl_iface_priv *priv = eloop_ctx;
+
+	if (wpas_ctrl_iface_send_pending(priv->sock, &priv->ctrl_dst, priv,
+					 NULL))
+		eloop_register_timeout(0, CTRL_IFACE_RETRY_MS * 1000,
+				       wpas_ctrl_iface_pending_timeout, priv,
+				       NULL);
+}
+
+
+static void wpas_global_ctrl_iface_pending_timeout(void *eloop_ctx,
+						   void *timeout_ctx)
+{
+	struct ctrl_iface_global_priv *gp = eloop_ctx;
+
+	if (wpas_ctrl_iface_send_pending(gp->sock, &gp->ctrl_dst, NULL,
+					 gp))
+		eloop_register_timeout(0, CTRL_IFACE_RETRY_MS * 1000,
+				       wpas_global_ctrl_iface_pending_timeout,
+				       gp, NULL);
+}
+
+
+/**
+ * wpa_supplicant_ctrl_iface_send - Send a control interface packet to monitors
+ * @ifname: Interface name for global control socket or %NULL
+ * @ctrl_dst: List of attached listeners
+ * @level: Priority level of the message
+ * @buf: Message data
+ * @len: Message length
+ * @priv: Per-interface control interface or %NULL
+ * @gp: Global control interface or %NULL
+ *
+ * Queue a packet for all monitor programs attached to the control interface.
+ * The queued packets are sent from the event loop once the current event has
+ * been processed so that bursts of events are sent in batches.
+ */
+static void wpa_supplicant_ctrl_iface_send(const char *ifname,
+					   struct dl_list *ctrl_dst,
+					   int level, const char *buf,
+					   size_t len,
+					   struct ctrl_iface_priv *priv,
+					   struct ctrl_iface_global_priv *gp)
+{
+	struct wpa_ctrl_dst *dst;
+	struct wpabuf *msg;
+	int queued = 0;
+
+	if ((priv ? priv->sock : gp->sock) < 0 || dl_list_empty(ctrl_dst))
+		return;
+
+	msg = ctrl_mon_msg_build(ifname, level, buf, len);
+	if (msg == NULL)
+		return;
+
+	dl_list_for_each(dst, ctrl_dst, struct wpa_ctrl_dst, list) {
+		if (level < dst->debug_level)
+			continue;
+		ctrl_mon_queue_add(&dst->queue, msg);
+		queued = 1;
+	}
+	wpabuf_free(msg);
+
+	if (!queued)
+		return;
+	if (priv &&
+	    !eloop_is_timeout_registered(wpas_ctrl_iface_pending_timeout, priv,
+					 NULL))
+		eloop_register_timeout(0, 0, wpas_ctrl_iface_pending_timeout,
+				       priv, NULL);
+	else if (gp && !eloop_is_timeout_registered(
+			 wpas_global_ctrl_iface_pending_timeout, gp, NULL))
+		eloop_register_timeout(0, 0,
+				       wpas_global_ctrl_iface_pending_timeout,
+				       gp, NULL);
 }
 
 
@@ -807,39 +944,67 @@ void wpa_supplicant_ctrl_iface_wait(struct ctrl_iface_priv *priv)
 
 /* Global ctrl_iface */
 
-static void wpa_supplicant_global_ctrl_iface_receive(int sock, void *eloop_ctx,
-						     void *sock_ctx)
+static const char * const wpas_global_ctrl_read_only_cmds[] = {
+	"PING", "INTERFACES", "INTERFACE_LIST", "STATUS", NULL
+};
+
+
+static int wpas_global_ctrl_cmd_read_only(const char *cmd)
 {
-	struct wpa_global *global = eloop_ctx;
-	struct ctrl_iface_global_priv *priv = sock_ctx;
-	char buf[4096];
-	int res;
-	struct sockaddr_un from;
-	socklen_t fromlen = sizeof(from);
-	char *reply = NULL, *reply_buf = NULL;
-	size_t reply_len;
+	const char *pos;
 
-	res = recvfrom(sock, buf, sizeof(buf) - 1, 0,
-		       (struct sockaddr *) &from, &fromlen);
-	if (res < 0) {
-		wpa_printf(MSG_ERROR, "recvfrom(ctrl_iface): %s",
-			   strerror(errno));
-		return;
+	if (os_strncmp(cmd, "IFNAME=", 7) == 0) {
+		pos = os_strchr(cmd + 7, ' ');
+		return pos &&
+			ctrl_iface_cmd_match(pos + 1, wpas_ctrl_read_only_cmds);
 	}
-	buf[res] = '\0';
+
+	return ctrl_iface_cmd_match(cmd, wpas_global_ctrl_read_only_cmds);
+}
+
+
+static int wpa_supplicant_global_ctrl_iface_request(
+	struct wpa_global *global, struct ctrl_iface_global_priv *priv,
+	int sock, char *buf, struct sockaddr_un *from, socklen_t fromlen,
+	struct ctrl_iface_snapshot *snap)
+{
+	char *reply = NULL, *reply_buf = NULL, *cmd;
+	const struct wpabuf *cached;
+	size_t reply_len;
+	int batch = 0;
 
 	if (os_strcmp(buf, "ATTACH") == 0) {
-		if (wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst, &from,
+		if (wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst, from,
 						     fromlen))
 			reply_len = 1;
 		else
 			reply_len = 2;
+		batch = 1;
 	} else if (os_strcmp(buf, "DETACH") == 0) {
-		if (wpa_supplicant_ctrl_iface_detach(&priv->ctrl_dst, &from,
+		if (wpa_supplicant_ctrl_iface_detach(&priv->ctrl_dst, from,
 						     fromlen))
 			reply_len = 1;
 		else
 			reply_len = 2;
+		batch = 1;
+	} else if (wpas_global_ctrl_cmd_read_only(buf)) {
+		batch = 1;
+		cached = ctrl_iface_snapshot_get(snap, buf);
+		if (cached) {
+			reply = (char *) wpabuf_head(cached);
+			reply_len = wpabuf_len(cached);
+		} else {
+			/* The command buffer may be modified during
+			 * processing */
+			cmd = os_strdup(buf);
+			reply_buf = wpa_supplicant_global_ctrl_iface_process(
+				global, buf, &reply_len);
+			reply = reply_buf;
+			if (cmd && reply)
+				ctrl_iface_snapshot_add(snap, cmd, reply,
+							reply_len);
+			os_free(cmd);
+		}
 	} else {
 		reply_buf = wpa_supplicant_global_ctrl_iface_process(
 			global, buf, &reply_len);
@@ -855,13 +1020,49 @@ static void wpa_supplicant_global_ctrl_iface_receive(int sock, void *eloop_ctx,
 	}
 
 	if (reply) {
-		if (sendto(sock, reply, reply_len, 0, (struct sockaddr *) &from,
+		if (sendto(sock, reply, reply_len, 0, (struct sockaddr *) from,
 			   fromlen) < 0) {
 			wpa_printf(MSG_DEBUG, "ctrl_iface sendto failed: %s",
 				strerror(errno));
 		}
 	}
 	os_free(reply_buf);
+
+	return batch;
+}
+
+
+static void wpa_supplicant_global_ctrl_iface_receive(int sock, void *eloop_ctx,
+						     void *sock_ctx)
+{
+	struct wpa_global *global = eloop_ctx;
+	struct ctrl_iface_global_priv *priv = sock_ctx;
+	struct ctrl_iface_snapshot snap;
+	char buf[4096];
+	int res, count = 0;
+	struct sockaddr_un from;
+	socklen_t fromlen;
+
+	os_memset(&snap, 0, sizeof(snap));
+	do {
+		fromlen = sizeof(from);
+		res = recvfrom(sock, buf, sizeof(buf) - 1,
+			       count ? MSG_DONTWAIT : 0,
+			       (struct sockaddr *) &from, &fromlen);
+		if (res < 0) {
+			if (count == 0)
+				wpa_printf(MSG_ERROR,
+					   "recvfrom(ctrl_iface): %s",
+					   strerror(errno));
+			break;
+		}
+		buf[res] = '\0';
+		count++;
+	} while (wpa_supplicant_global_ctrl_iface_request(global, priv, sock,
+							  buf, &from, fromlen,
+							  &snap) &&
+		 count < CTRL_IFACE_MAX_BATCH);
+	ctrl_iface_snapshot_clear(&snap);
 }
 
 
@@ -1105,14 +1306,20 @@ wpa_supplicant_global_ctrl_iface_deinit(struct ctrl_iface_global_priv *priv)
 {
 	struct wpa_ctrl_dst *dst, *prev;
 
+	eloop_cancel_timeout(wpas_global_ctrl_iface_pending_timeout, priv,
+			     NULL);
 	if (priv->sock >= 0) {
 		eloop_unregister_read_sock(priv->sock);
+		wpas_ctrl_iface_send_pending(priv->sock, &priv->ctrl_dst, NULL,
+					     NULL);
 		close(priv->sock);
 	}
 	if (priv->global->params.ctrl_interface)
 		unlink(priv->global->params.ctrl_interface);
 	dl_list_for_each_safe(dst, prev, &priv->ctrl_dst, struct wpa_ctrl_dst,
-			      list)
+			      list) {
+		ctrl_mon_queue_clear(&dst->queue);
 		os_free(dst);
+	}
 	os_free(priv);
 }
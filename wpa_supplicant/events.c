@@ -737,9 +737,160 @@ static int bss_is_ess(struct wpa_bss *bss)
 }
 
 
+/*
+ * Enabled networks of a priority group indexed by SSID. A network with an SSID
+ * can only match a BSS with the same SSID, so only those and the networks
+ * without an SSID (wildcard matches) need to be tested for each BSS.
+ */
+#define WPAS_SSID_INDEX_HASH_SIZE 64
+
+struct wpas_ssid_index {
+	struct wpa_ssid **nets; /* enabled networks in priority list order */
+	int *next; /* next entry on the same hash chain or wildcard list */
+	int heads[WPAS_SSID_INDEX_HASH_SIZE];
+	int wildcard;
+};
+
+struct wpas_candidate_iter {
+	struct wpas_ssid_index *index;
+	struct wpa_bss *bss;
+	struct wpa_ssid *ssid;
+	int only_first_ssid;
+	int chain;
+	int wildcard;
+};
+
+
+static unsigned int wpas_ssid_hash(const u8 *ssid, size_t ssid_len)
+{
+	unsigned int hash = 5381;
+	size_t i;
+
+	for (i = 0; i < ssid_len; i++)
+		hash = hash * 33 + ssid[i];
+
+	return hash & (WPAS_SSID_INDEX_HASH_SIZE - 1);
+}
+
+
+static struct wpas_ssid_index *
+wpas_ssid_index_build(struct wpa_supplicant *wpa_s, struct wpa_ssid *group)
+{
+	struct wpas_ssid_index *index;
+	struct wpa_ssid *ssid;
+	size_t count = 0;
+	int i, n = 0;
+
+	for (ssid = group; ssid; ssid = ssid->pnext)
+		count++;
+
+	index = os_zalloc(sizeof(*index));
+	if (index == NULL)
+		return NULL;
+	index->nets = os_calloc(count, sizeof(struct wpa_ssid *));
+	index->next = os_calloc(count, sizeof(int));
+	if (count && (index->nets == NULL || index->next == NULL)) {
+		os_free(index->nets);
+		os_free(index->next);
+		os_free(index);
+		return NULL;
+	}
+
+	for (ssid = group; ssid; ssid = ssid->pnext) {
+		if (!wpas_network_disabled(wpa_s, ssid))
+			index->nets[n++] = ssid;
+	}
+
+	for (i = 0; i < WPAS_SSID_INDEX_HASH_SIZE; i++)
+		index->heads[i] = -1;
+	index->wildcard = -1;
+
+	/* Add in reverse order to keep the lists in priority list order */
+	for (i = n - 1; i >= 0; i--) {
+		ssid = index->nets[i];
+		if (ssid->ssid_len == 0) {
+			index->next[i] = index->wildcard;
+			index->wildcard = i;
+		} else {
+			unsigned int h = wpas_ssid_hash(ssid->ssid,
+							ssid->ssid_len);
+			index->next[i] = index->heads[h];
+			index->heads[h] = i;
+		}
+	}
+
+	return index;
+}
+
+
+static void wpas_ssid_index_free(struct wpas_ssid_index *index)
+{
+	if (index == NULL)
+		return;
+	os_free(index->nets);
+	os_free(index->next);
+	os_free(index);
+}
+
+
+static struct wpa_ssid * wpas_candidate_next(struct wpas_candidate_iter *iter)
+{
+	struct wpas_ssid_index *index = iter->index;
+	int a, w;
+
+	if (index == NULL) {
+		/* No index; go through the priority group */
+		struct wpa_ssid *ssid = iter->ssid;
+		if (ssid)
+			iter->ssid = iter->only_first_ssid ? NULL :
+				ssid->pnext;
+		return ssid;
+	}
+
+	/* Skip hash collisions */
+	a = iter->chain;
+	while (a >= 0 &&
+	       (index->nets[a]->ssid_len != iter->bss->ssid_len ||
+		os_memcmp(index->nets[a]->ssid, iter->bss->ssid,
+			  iter->bss->ssid_len) != 0))
+		a = index->next[a];
+	w = iter->wildcard;
+
+	if (a < 0 && w < 0)
+		return NULL;
+	if (w < 0 || (a >= 0 && a < w)) {
+		iter->chain = index->next[a];
+		return index->nets[a];
+	}
+	iter->chain = a;
+	iter->wildcard = index->next[w];
+	return index->nets[w];
+}
+
+
+static struct wpa_ssid *
+wpas_candidate_first(struct wpas_candidate_iter *iter,
+		     struct wpas_ssid_index *index, struct wpa_ssid *group,
+		     struct wpa_bss *bss, int only_first_ssid)
+{
+	os_memset(iter, 0, sizeof(*iter));
+	iter->index = only_first_ssid ? NULL : index;
+	iter->bss = bss;
+	iter->ssid = group;
+	iter->only_first_ssid = only_first_ssid;
+	if (iter->index) {
+		iter->chain = index->heads[wpas_ssid_hash(bss->ssid,
+							  bss->ssid_len)];
+		iter->wildcard = index->wildcard;
+	}
+	return wpas_candidate_next(iter);
+}
+
+
 static struct wpa_ssid * wpa_scan_res_match(struct wpa_supplicant *wpa_s,
 					    int i, struct wpa_bss *bss,
 					    struct wpa_ssid *group,
+					    struct wpas_ssid_index *index,
 					    int only_first_ssid)
 {
 	u8 wpa_ie_len, rsn_ie_len;
@@ -747,6 +898,7 @@ static struct wpa_ssid * wpa_scan_res_match(struct wpa_supplicant *wpa_s,
 	struct wpa_blacklist *e;
 	const u8 *ie;
 	struct wpa_ssid *ssid;
+	struct wpas_candidate_iter iter;
 	int osen;
 
 	ie = wpa_bss_get_vendor_ie(bss, WPA_IE_VENDOR_TYPE);
@@ -806,7 +958,9 @@ static struct wpa_ssid * wpa_scan_res_match(struct wpa_supplicant *wpa_s,
 
 	wpa = wpa_ie_len > 0 || rsn_ie_len > 0;
 
-	for (ssid = group; ssid; ssid = only_first_ssid ? NULL : ssid->pnext) {
+	for (ssid = wpas_candidate_first(&iter, index, group, bss,
+					 only_first_ssid);
+	     ssid; ssid = wpas_candidate_next(&iter)) {
 		int check_ssid = wpa ? 1 : (ssid->ssid_len != 0);
 		int res;
 
@@ -965,6 +1119,7 @@ wpa_supplicant_select_bss(struct wpa_supplicant *wpa_s,
 			  int only_first_ssid)
 {
 	unsigned int i;
+	struct wpas_ssid_index *index = NULL;
 
 	if (only_first_ssid)
 		wpa_dbg(wpa_s, MSG_DEBUG, "Try to find BSS matching pre-selected network id=%d",
@@ -973,19 +1128,24 @@ wpa_supplicant_select_bss(struct wpa_supplicant *wpa_s,
 		wpa_dbg(wpa_s, MSG_DEBUG, "Selecting BSS from priority group %d",
 			group->priority);
 
+	if (!only_first_ssid)
+		index = wpas_ssid_index_build(wpa_s, group);
+
 	for (i = 0; i < wpa_s->last_scan_res_used; i++) {
 		struct wpa_bss *bss = wpa_s->last_scan_res[i];
 		*selected_ssid = wpa_scan_res_match(wpa_s, i, bss, group,
-						    only_first_ssid);
+						    index, only_first_ssid);
 		if (!*selected_ssid)
 			continue;
 		wpa_dbg(wpa_s, MSG_DEBUG, "   selected BSS " MACSTR
 			" ssid='%s'",
 			MAC2STR(bss->bssid),
 			wpa_ssid_txt(bss->ssid, bss->ssid_len));
+		wpas_ssid_index_free(index);
 		return bss;
 	}
 
+	wpas_ssid_index_free(index);
 	return NULL;
 }
 
@@ -3423,6 +3583,15 @@ void wpa_supplicant_event(void *ctx, enum wpa_event_type event,
 							  data->low_ack.addr);
 #endif /* CONFIG_TDLS */
 		break;
+	case EVENT_STATION_LIST:
+#ifdef CONFIG_AP
+		if (wpa_s->ap_iface && data)
+			hostapd_event_station_list(
+				wpa_s->ap_iface->bss[0],
+				data->station_list.addr,
+				data->station_list.num);
+#endif /* CONFIG_AP */
+		break;
 	case EVENT_IBSS_PEER_LOST:
 #ifdef CONFIG_IBSS_RSN
 		ibss_rsn_stop(wpa_s->ibss_rsn, data->ibss_peer_lost.peer);
@@ -741,10 +741,8 @@ static int wpas_p2p_store_persistent_group(struct wpa_supplicant *wpa_s,
 		changed = 1;
 	}
 
-	if (changed && wpa_s->conf->update_config &&
-	    wpa_config_write(wpa_s->confname, wpa_s->conf)) {
-		wpa_printf(MSG_DEBUG, "P2P: Failed to update configuration");
-	}
+	if (changed)
+		wpas_config_write_deferred(wpa_s);
 
 	return s->id;
 }
@@ -812,9 +810,7 @@ static void wpas_p2p_add_persistent_group_client(struct wpa_supplicant *wpa_s,
 			  addr, ETH_ALEN);
 	}
 
-	if (wpa_s->parent->conf->update_config &&
-	    wpa_config_write(wpa_s->parent->confname, wpa_s->parent->conf))
-		wpa_printf(MSG_DEBUG, "P2P: Failed to update configuration");
+	wpas_config_write_deferred(wpa_s->parent);
 }
 
 
@@ -3253,9 +3249,7 @@ static void wpas_remove_persistent_peer(struct wpa_supplicant *wpa_s,
 		   ssid->p2p_client_list + (i + 1) * ETH_ALEN,
 		   (ssid->num_p2p_clients - i - 1) * ETH_ALEN);
 	ssid->num_p2p_clients--;
-	if (wpa_s->parent->conf->update_config &&
-	    wpa_config_write(wpa_s->parent->confname, wpa_s->parent->conf))
-		wpa_printf(MSG_DEBUG, "P2P: Failed to update configuration");
+	wpas_config_write_deferred(wpa_s->parent);
 }
 
 
@@ -7153,9 +7147,7 @@ void wpas_p2p_new_psk_cb(struct wpa_supplicant *wpa_s, const u8 *mac_addr,
 	}
 	dl_list_add(&persistent->psk_list, &p->list);
 
-	if (wpa_s->parent->conf->update_config &&
-	    wpa_config_write(wpa_s->parent->confname, wpa_s->parent->conf))
-		wpa_printf(MSG_DEBUG, "P2P: Failed to update configuration");
+	wpas_config_write_deferred(wpa_s->parent);
 }
 
 
@@ -7166,10 +7158,8 @@ static void wpas_p2p_remove_psk(struct wpa_supplicant *wpa_s,
 	int res;
 
 	res = wpas_p2p_remove_psk_entry(wpa_s, s, addr, iface_addr);
-	if (res > 0 && wpa_s->conf->update_config &&
-	    wpa_config_write(wpa_s->confname, wpa_s->conf))
-		wpa_dbg(wpa_s, MSG_DEBUG,
-			"P2P: Failed to update configuration");
+	if (res > 0)
+		wpas_config_write_deferred(wpa_s);
 }
 
 
@@ -198,12 +198,22 @@ int wpa_supplicant_trigger_scan(struct wpa_supplicant *wpa_s,
 				struct wpa_driver_scan_params *params)
 {
 	struct wpa_driver_scan_params *ctx;
+	struct wpa_radio_work *work;
 
 	if (wpa_s->scan_work) {
 		wpa_dbg(wpa_s, MSG_INFO, "Reject scan trigger since one is already pending");
 		return -1;
 	}
 
+	work = radio_work_pending(wpa_s, "scan");
+	if (work && !work->started && work->ctx &&
+	    wpa_scan_merge_params(work->ctx, params,
+				  wpa_s->max_scan_ssids) == 0) {
+		wpa_dbg(wpa_s, MSG_DEBUG,
+			"Merged scan trigger into pending scan radio work");
+		return 0;
+	}
+
 	ctx = wpa_scan_clone_params(params);
 	if (ctx == NULL)
 		return -1;
@@ -1544,28 +1554,71 @@ struct wpabuf * wpa_scan_get_vendor_ie_multi(const struct wpa_scan_res *res,
  */
 #define GREAT_SNR 30
 
+/*
+ * Sort key for a scan result. The values that need IE parsing are determined
+ * once per scan result instead of in each comparison during the sort.
+ */
+struct wpa_scan_res_key {
+	struct wpa_scan_res *res;
+	int wpa;
+	int snr_valid;
+	int snr;
+	int maxrate;
+#ifdef CONFIG_WPS
+	int uses_wps;
+	int wps_priority;
+#endif /* CONFIG_WPS */
+};
+
+
+static void wpa_scan_res_key_init(struct wpa_scan_res_key *key,
+				  struct wpa_scan_res *res, int wps)
+{
+	key->res = res;
+
+#ifdef CONFIG_WPS
+	if (wps) {
+		struct wpabuf *buf;
+
+		key->uses_wps = wpa_scan_get_vendor_ie(res,
+						       WPS_IE_VENDOR_TYPE) !=
+			NULL;
+		if (key->uses_wps) {
+			buf = wpa_scan_get_vendor_ie_multi(res,
+							   WPS_IE_VENDOR_TYPE);
+			key->wps_priority = wps_ap_priority(buf);
+			wpabuf_free(buf);
+		}
+		return;
+	}
+#endif /* CONFIG_WPS */
+
+	key->wpa = wpa_scan_get_vendor_ie(res, WPA_IE_VENDOR_TYPE) != NULL ||
+		wpa_scan_get_ie(res, WLAN_EID_RSN) != NULL;
+	key->snr_valid = (res->flags & WPA_SCAN_LEVEL_DBM) &&
+		!(res->flags & WPA_SCAN_NOISE_INVALID);
+	key->snr = res->level - res->noise;
+	if (key->snr > GREAT_SNR)
+		key->snr = GREAT_SNR;
+	key->maxrate = wpa_scan_get_max_rate(res);
+}
+
+
 /* Compare function for sorting scan results. Return >0 if @b is considered
  * better. */
 static int wpa_scan_result_compar(const void *a, const void *b)
 {
 #define IS_5GHZ(n) (n > 4000)
-#define MIN(a,b) a < b ? a : b
-	struct wpa_scan_res **_wa = (void *) a;
-	struct wpa_scan_res **_wb = (void *) b;
-	struct wpa_scan_res *wa = *_wa;
-	struct wpa_scan_res *wb = *_wb;
-	int wpa_a, wpa_b, maxrate_a, maxrate_b;
+	const struct wpa_scan_res_key *ka = a;
+	const struct wpa_scan_res_key *kb = b;
+	struct wpa_scan_res *wa = ka->res;
+	struct wpa_scan_res *wb = kb->res;
 	int snr_a, snr_b;
 
 	/* WPA/WPA2 support preferred */
-	wpa_a = wpa_scan_get_vendor_ie(wa, WPA_IE_VENDOR_TYPE) != NULL ||
-		wpa_scan_get_ie(wa, WLAN_EID_RSN) != NULL;
-	wpa_b = wpa_scan_get_vendor_ie(wb, WPA_IE_VENDOR_TYPE) != NULL ||
-		wpa_scan_get_ie(wb, WLAN_EID_RSN) != NULL;
-
-	if (wpa_b && !wpa_a)
+	if (kb->wpa && !ka->wpa)
 		return 1;
-	if (!wpa_b && wpa_a)
+	if (!kb->wpa && ka->wpa)
 		return -1;
 
 	/* privacy support preferred */
@@ -1576,10 +1629,9 @@ static int wpa_scan_result_compar(const void *a, const void *b)
 	    (wb->caps & IEEE80211_CAP_PRIVACY) == 0)
 		return -1;
 
-	if ((wa->flags & wb->flags & WPA_SCAN_LEVEL_DBM) &&
-	    !((wa->flags | wb->flags) & WPA_SCAN_NOISE_INVALID)) {
-		snr_a = MIN(wa->level - wa->noise, GREAT_SNR);
-		snr_b = MIN(wb->level - wb->noise, GREAT_SNR);
+	if (ka->snr_valid && kb->snr_valid) {
+		snr_a = ka->snr;
+		snr_b = kb->snr;
 	} else {
 		/* Not suitable information to calculate SNR, so use level */
 		snr_a = wa->level;
@@ -1589,10 +1641,8 @@ static int wpa_scan_result_compar(const void *a, const void *b)
 	/* best/max rate preferred if SNR close enough */
         if ((snr_a && snr_b && abs(snr_b - snr_a) < 5) ||
 	    (wa->qual && wb->qual && abs(wb->qual - wa->qual) < 10)) {
-		maxrate_a = wpa_scan_get_max_rate(wa);
-		maxrate_b = wpa_scan_get_max_rate(wb);
-		if (maxrate_a != maxrate_b)
-			return maxrate_b - maxrate_a;
+		if (ka->maxrate != kb->maxrate)
+			return kb->maxrate - ka->maxrate;
 		if (IS_5GHZ(wa->freq) ^ IS_5GHZ(wb->freq))
 			return IS_5GHZ(wa->freq) ? -1 : 1;
 	}
@@ -1605,7 +1655,6 @@ static int wpa_scan_result_compar(const void *a, const void *b)
 	if (snr_b == snr_a)
 		return wb->qual - wa->qual;
 	return snr_b - snr_a;
-#undef MIN
 #undef IS_5GHZ
 }
 
@@ -1615,31 +1664,24 @@ static int wpa_scan_result_compar(const void *a, const void *b)
  * provisioning. Return >0 if @b is considered better. */
 static int wpa_scan_result_wps_compar(const void *a, const void *b)
 {
-	struct wpa_scan_res **_wa = (void *) a;
-	struct wpa_scan_res **_wb = (void *) b;
-	struct wpa_scan_res *wa = *_wa;
-	struct wpa_scan_res *wb = *_wb;
-	int uses_wps_a, uses_wps_b;
-	struct wpabuf *wps_a, *wps_b;
-	int res;
-
-	/* Optimization - check WPS IE existence before allocated memory and
-	 * doing full reassembly. */
-	uses_wps_a = wpa_scan_get_vendor_ie(wa, WPS_IE_VENDOR_TYPE) != NULL;
-	uses_wps_b = wpa_scan_get_vendor_ie(wb, WPS_IE_VENDOR_TYPE) != NULL;
-	if (uses_wps_a && !uses_wps_b)
+	const struct wpa_scan_res_key *ka = a;
+	const struct wpa_scan_res_key *kb = b;
+	struct wpa_scan_res *wa = ka->res;
+	struct wpa_scan_res *wb = kb->res;
+
+	if (ka->uses_wps && !kb->uses_wps)
 		return -1;
-	if (!uses_wps_a && uses_wps_b)
+	if (!ka->uses_wps && kb->uses_wps)
 		return 1;
 
-	if (uses_wps_a && uses_wps_b) {
-		wps_a = wpa_scan_get_vendor_ie_multi(wa, WPS_IE_VENDOR_TYPE);
-		wps_b = wpa_scan_get_vendor_ie_multi(wb, WPS_IE_VENDOR_TYPE);
-		res = wps_ap_priority_compar(wps_a, wps_b);
-		wpabuf_free(wps_a);
-		wpabuf_free(wps_b);
-		if (res)
-			return res;
+	if (ka->uses_wps && kb->uses_wps) {
+		/* Same ordering as wps_ap_priority_compar() */
+		if (ka->wps_priority < 0)
+			return 1;
+		if (kb->wps_priority < 0)
+			return -1;
+		if (ka->wps_priority != kb->wps_priority)
+			return kb->wps_priority - ka->wps_priority;
 	}
 
 	/*
@@ -1658,6 +1700,38 @@ static int wpa_scan_result_wps_compar(const void *a, const void *b)
 #endif /* CONFIG_WPS */
 
 
+static void wpa_scan_res_sort(struct wpa_scan_results *scan_res, int wps)
+{
+	int (*compar)(const void *, const void *) = wpa_scan_result_compar;
+	struct wpa_scan_res_key *keys;
+	size_t i;
+
+	if (scan_res->num < 2)
+		return;
+
+	keys = os_calloc(scan_res->num, sizeof(*keys));
+	if (keys == NULL) {
+		wpa_printf(MSG_DEBUG, "Could not allocate memory for sorting "
+			   "scan results");
+		return;
+	}
+
+	for (i = 0; i < scan_res->num; i++)
+		wpa_scan_res_key_init(&keys[i], scan_res->res[i], wps);
+
+#ifdef CONFIG_WPS
+	if (wps)
+		compar = wpa_scan_result_wps_compar;
+#endif /* CONFIG_WPS */
+
+	qsort(keys, scan_res->num, sizeof(*keys), compar);
+
+	for (i = 0; i < scan_res->num; i++)
+		scan_res->res[i] = keys[i].res;
+	os_free(keys);
+}
+
+
 static void dump_scan_res(struct wpa_scan_results *scan_res)
 {
 #ifndef CONFIG_NO_STDOUT_DEBUG
@@ -1769,7 +1843,7 @@ wpa_supplicant_get_scan_results(struct wpa_supplicant *wpa_s,
 {
 	struct wpa_scan_results *scan_res;
 	size_t i;
-	int (*compar)(const void *, const void *) = wpa_scan_result_compar;
+	int wps = 0;
 
 	scan_res = wpa_drv_get_scan_results2(wpa_s);
 	if (scan_res == NULL) {
@@ -1789,12 +1863,11 @@ wpa_supplicant_get_scan_results(struct wpa_supplicant *wpa_s,
 	if (wpas_wps_searching(wpa_s)) {
 		wpa_dbg(wpa_s, MSG_DEBUG, "WPS: Order scan results with WPS "
 			"provisioning rules");
-		compar = wpa_scan_result_wps_compar;
+		wps = 1;
 	}
 #endif /* CONFIG_WPS */
 
-	qsort(scan_res->res, scan_res->num, sizeof(struct wpa_scan_res *),
-	      compar);
+	wpa_scan_res_sort(scan_res, wps);
 	dump_scan_res(scan_res);
 
 	wpa_bss_update_start(wpa_s);
@@ -1927,6 +2000,113 @@ failed:
 }
 
 
+static int
+wpa_scan_params_has_ssid(const struct wpa_driver_scan_params *params,
+			 const struct wpa_driver_scan_ssid *ssid)
+{
+	size_t i;
+
+	for (i = 0; i < params->num_ssids; i++) {
+		if (ssid->ssid_len == params->ssids[i].ssid_len &&
+		    (ssid->ssid_len == 0 ||
+		     os_memcmp(ssid->ssid, params->ssids[i].ssid,
+			       ssid->ssid_len) == 0))
+			return 1;
+	}
+	return 0;
+}
+
+
+/**
+ * wpa_scan_merge_params - Merge scan parameters into a pending scan request
+ * @dst: Parameters of the pending scan (from wpa_scan_clone_params())
+ * @src: Parameters of the new scan request
+ * @max_ssids: Maximum number of SSIDs the driver can scan for
+ * Returns: 0 if src was merged into dst, -1 if the requests are not compatible
+ *
+ * The merged request covers the union of the SSIDs and frequencies of both
+ * requests. Requests with different extra IEs, P2P probe, or filtering
+ * parameters are not merged.
+ */
+int wpa_scan_merge_params(struct wpa_driver_scan_params *dst,
+			  const struct wpa_driver_scan_params *src,
+			  size_t max_ssids)
+{
+	size_t i, num_ssids;
+	int *freqs = NULL;
+
+	if (dst->p2p_probe != src->p2p_probe ||
+	    dst->filter_rssi != src->filter_rssi ||
+	    dst->extra_ies_len != src->extra_ies_len ||
+	    (src->extra_ies_len &&
+	     os_memcmp(dst->extra_ies, src->extra_ies,
+		       src->extra_ies_len) != 0) ||
+	    dst->num_filter_ssids != src->num_filter_ssids ||
+	    (src->num_filter_ssids &&
+	     os_memcmp(dst->filter_ssids, src->filter_ssids,
+		       src->num_filter_ssids *
+		       sizeof(*src->filter_ssids)) != 0))
+		return -1;
+
+	if (max_ssids > WPAS_MAX_SCAN_SSIDS)
+		max_ssids = WPAS_MAX_SCAN_SSIDS;
+	num_ssids = dst->num_ssids;
+	for (i = 0; i < src->num_ssids; i++) {
+		if (!wpa_scan_params_has_ssid(dst, &src->ssids[i]))
+			num_ssids++;
+	}
+	if (num_ssids > max_ssids)
+		return -1;
+
+	if (dst->freqs && src->freqs) {
+		freqs = os_malloc((int_array_len(dst->freqs) +
+				   int_array_len(src->freqs) + 1) *
+				  sizeof(int));
+		if (freqs == NULL)
+			return -1;
+		os_memcpy(freqs, dst->freqs,
+			  int_array_len(dst->freqs) * sizeof(int));
+		os_memcpy(freqs + int_array_len(dst->freqs), src->freqs,
+			  (int_array_len(src->freqs) + 1) * sizeof(int));
+		int_array_sort_unique(freqs);
+	}
+
+	for (i = 0; i < src->num_ssids; i++) {
+		u8 *n = NULL;
+
+		if (wpa_scan_params_has_ssid(dst, &src->ssids[i]))
+			continue;
+		if (src->ssids[i].ssid) {
+			n = os_malloc(src->ssids[i].ssid_len);
+			if (n == NULL) {
+				/* Already added SSIDs only extend the scan */
+				os_free(freqs);
+				return -1;
+			}
+			os_memcpy(n, src->ssids[i].ssid,
+				  src->ssids[i].ssid_len);
+		}
+		dst->ssids[dst->num_ssids].ssid = n;
+		dst->ssids[dst->num_ssids].ssid_len = src->ssids[i].ssid_len;
+		dst->num_ssids++;
+	}
+
+	/* No frequency list means all channels */
+	if (dst->freqs && !src->freqs) {
+		os_free(dst->freqs);
+		dst->freqs = NULL;
+	} else if (freqs) {
+		os_free(dst->freqs);
+		dst->freqs = freqs;
+	}
+
+	dst->only_new_results |= src->only_new_results;
+	dst->low_priority &= src->low_priority;
+
+	return 0;
+}
+
+
 void wpa_scan_free_params(struct wpa_driver_scan_params *params)
 {
 	size_t i;
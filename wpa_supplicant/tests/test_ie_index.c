@@ -0,0 +1,319 @@
+/*
+ * Test program for element index lookups against linear IE parsing
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * Usage: test-ie_index [dump file..]
+ *
+ * Each dump file is scanned for ie=<hex> and beacon_ie=<hex> lines (e.g., the
+ * output of "wpa_cli bss <id>" collected for all BSSes in a scan). Without
+ * arguments, a built-in set of IEs is used.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/wpabuf.h"
+#include "common/ieee802_11_defs.h"
+#include "common/ieee802_11_common.h"
+
+#define TEST_DURATION 1
+#define MAX_IE_SETS 1000
+
+
+/* Probe Response IEs of a typical dual-band AP with WPS and Hotspot 2.0 */
+static const char *builtin_ies[] = {
+	"0008746573742d6e6574010882848b960c12182403010b050400010000"
+	"2a0100301401000010ac040100000fac040100000fac020c002d1aef1903ffff"
+	"000000000000000000000000000000000000000000003d160b0804000000000000"
+	"00000000000000000000000000007f080400000000000040dd180050f202010180"
+	"0003a4000027a4000042435e0062322f00dd1e0050f204104a0001101044000102"
+	"103b00010310470010000102030405060708090a0b0c0d0e0f6b0100dd05506f9a"
+	"1000dd0a0050f208000000000000",
+	"0004686f6d65010882848b960c121824030106050400010000"
+	"dd160050f20101000050f20201000050f20201000050f202"
+	"dd180050f2020101000003a4000027a4000042435e0062322f00",
+	NULL
+};
+
+/* Element IDs and vendor types that are commonly looked up from BSS entries */
+static const u8 lookup_eids[] = {
+	WLAN_EID_SSID, WLAN_EID_SUPP_RATES, WLAN_EID_RSN, WLAN_EID_HT_CAP,
+	WLAN_EID_VHT_CAP, WLAN_EID_MOBILITY_DOMAIN, WLAN_EID_INTERWORKING,
+	WLAN_EID_ROAMING_CONSORTIUM, WLAN_EID_EXT_CAPAB, WLAN_EID_DS_PARAMS,
+	WLAN_EID_COUNTRY, WLAN_EID_BSS_LOAD, WLAN_EID_ADV_PROTO,
+};
+
+static const u32 lookup_vendor[] = {
+	WPA_IE_VENDOR_TYPE, WPS_IE_VENDOR_TYPE, P2P_IE_VENDOR_TYPE,
+	HS20_IE_VENDOR_TYPE, OSEN_IE_VENDOR_TYPE,
+};
+
+struct ie_set {
+	u8 *ies;
+	size_t len;
+	struct ieee802_11_elem_index *idx;
+};
+
+static struct ie_set sets[MAX_IE_SETS];
+static unsigned int num_sets;
+
+
+static const u8 * linear_get_ie(const u8 *ies, size_t len, u8 eid)
+{
+	const u8 *pos = ies, *end = ies + len;
+
+	while (pos + 1 < end) {
+		if (pos + 2 + pos[1] > end)
+			break;
+		if (pos[0] == eid)
+			return pos;
+		pos += 2 + pos[1];
+	}
+
+	return NULL;
+}
+
+
+static const u8 * linear_get_vendor(const u8 *ies, size_t len, u32 type)
+{
+	const u8 *pos = ies, *end = ies + len;
+
+	while (pos + 1 < end) {
+		if (pos + 2 + pos[1] > end)
+			break;
+		if (pos[0] == WLAN_EID_VENDOR_SPECIFIC && pos[1] >= 4 &&
+		    type == WPA_GET_BE32(&pos[2]))
+			return pos;
+		pos += 2 + pos[1];
+	}
+
+	return NULL;
+}
+
+
+static int add_set(const char *hex, size_t hex_len)
+{
+	struct ie_set *set;
+
+	if (num_sets == MAX_IE_SETS || hex_len & 1)
+		return -1;
+	set = &sets[num_sets];
+	set->len = hex_len / 2;
+	set->ies = os_malloc(set->len + 1);
+	if (set->ies == NULL || hexstr2bin(hex, set->ies, set->len) < 0) {
+		os_free(set->ies);
+		return -1;
+	}
+	set->idx = ieee802_11_elem_index_build(set->ies, set->len);
+	if (set->idx == NULL) {
+		os_free(set->ies);
+		return -1;
+	}
+	num_sets++;
+	return 0;
+}
+
+
+static int read_dump(const char *fname)
+{
+	FILE *f;
+	char *buf, *pos;
+	size_t len;
+	int ret = 0;
+
+	f = fopen(fname, "r");
+	if (f == NULL) {
+		printf("Could not open %s\n", fname);
+		return -1;
+	}
+
+	buf = os_malloc(65536 * 2 + 100);
+	if (buf == NULL) {
+		fclose(f);
+		return -1;
+	}
+
+	while (fgets(buf, 65536 * 2 + 100, f)) {
+		pos = buf;
+		if (os_strncmp(pos, "beacon_ie=", 10) == 0)
+			pos += 10;
+		else if (os_strncmp(pos, "ie=", 3) == 0)
+			pos += 3;
+		else
+			continue;
+		len = os_strlen(pos);
+		while (len > 0 && (pos[len - 1] == '\n' || pos[len - 1] == '\r'))
+			len--;
+		if (add_set(pos, len) < 0) {
+			printf("%s: invalid IE line ignored\n", fname);
+			ret = -1;
+		}
+	}
+
+	os_free(buf);
+	fclose(f);
+	return ret;
+}
+
+
+static int verify(void)
+{
+	unsigned int i, j, eid;
+	int errors = 0;
+	struct wpabuf *a, *b;
+
+	for (i = 0; i < num_sets; i++) {
+		const struct ie_set *set = &sets[i];
+
+		for (eid = 0; eid < 256; eid++) {
+			if (linear_get_ie(set->ies, set->len, eid) !=
+			    ieee802_11_elem_index_get(set->idx, set->ies, eid)) {
+				printf("set %u: mismatch for element %u\n",
+				       i, eid);
+				errors++;
+			}
+		}
+
+		for (j = 0; j < ARRAY_SIZE(lookup_vendor); j++) {
+			if (linear_get_vendor(set->ies, set->len,
+					      lookup_vendor[j]) !=
+			    ieee802_11_elem_index_get_vendor(
+				    set->idx, set->ies, lookup_vendor[j])) {
+				printf("set %u: mismatch for vendor type %08x\n",
+				       i, lookup_vendor[j]);
+				errors++;
+			}
+
+			a = ieee802_11_vendor_ie_concat(set->ies, set->len,
+							lookup_vendor[j]);
+			b = ieee802_11_elem_index_vendor_concat(
+				set->idx, set->ies, set->len, lookup_vendor[j]);
+			if (a && !wpabuf_len(a)) {
+				wpabuf_free(a);
+				a = NULL;
+			}
+			if ((a == NULL) != (b == NULL) ||
+			    (a && (wpabuf_len(a) != wpabuf_len(b) ||
+				   os_memcmp(wpabuf_head(a), wpabuf_head(b),
+					     wpabuf_len(a)) != 0))) {
+				printf("set %u: concat mismatch for vendor type %08x\n",
+				       i, lookup_vendor[j]);
+				errors++;
+			}
+			wpabuf_free(a);
+			wpabuf_free(b);
+		}
+	}
+
+	return errors;
+}
+
+
+static void bench(const char *name, int indexed)
+{
+	struct os_reltime start, now, diff;
+	unsigned long count = 0, found = 0;
+	unsigned int i, j, k;
+	double secs;
+
+	os_get_reltime(&start);
+	do {
+		for (k = 0; k < 100; k++) {
+			for (i = 0; i < num_sets; i++) {
+				const struct ie_set *set = &sets[i];
+
+				for (j = 0; j < ARRAY_SIZE(lookup_eids); j++) {
+					if (indexed ?
+					    ieee802_11_elem_index_get(
+						    set->idx, set->ies,
+						    lookup_eids[j]) :
+					    linear_get_ie(set->ies, set->len,
+							  lookup_eids[j]))
+						found++;
+				}
+				for (j = 0; j < ARRAY_SIZE(lookup_vendor);
+				     j++) {
+					if (indexed ?
+					    ieee802_11_elem_index_get_vendor(
+						    set->idx, set->ies,
+						    lookup_vendor[j]) :
+					    linear_get_vendor(
+						    set->ies, set->len,
+						    lookup_vendor[j]))
+						found++;
+				}
+			}
+		}
+		count += 100 * num_sets *
+			(ARRAY_SIZE(lookup_eids) + ARRAY_SIZE(lookup_vendor));
+		os_get_reltime(&now);
+	} while (!os_reltime_expired(&now, &start, TEST_DURATION));
+
+	os_reltime_sub(&now, &start, &diff);
+	secs = diff.sec + diff.usec / 1000000.0;
+	printf("%-8s %lu lookups/s (%lu found)\n", name,
+	       (unsigned long) (count / secs), found);
+}
+
+
+static void bench_build(void)
+{
+	struct os_reltime start, now, diff;
+	unsigned long count = 0;
+	unsigned int i;
+	double secs;
+
+	os_get_reltime(&start);
+	do {
+		for (i = 0; i < num_sets; i++)
+			os_free(ieee802_11_elem_index_build(sets[i].ies,
+							    sets[i].len));
+		count += num_sets;
+		os_get_reltime(&now);
+	} while (!os_reltime_expired(&now, &start, TEST_DURATION));
+
+	os_reltime_sub(&now, &start, &diff);
+	secs = diff.sec + diff.usec / 1000000.0;
+	printf("%-8s %lu index builds/s\n", "build",
+	       (unsigned long) (count / secs));
+}
+
+
+int main(int argc, char *argv[])
+{
+	int i, errors = 0;
+	unsigned int j;
+
+	if (argc > 1) {
+		for (i = 1; i < argc; i++)
+			if (read_dump(argv[i]) < 0)
+				errors++;
+	} else {
+		for (i = 0; builtin_ies[i]; i++)
+			if (add_set(builtin_ies[i],
+				    os_strlen(builtin_ies[i])) < 0)
+				errors++;
+	}
+
+	if (num_sets == 0) {
+		printf("No IEs to test\n");
+		return 1;
+	}
+	printf("%u IE sets\n", num_sets);
+
+	errors += verify();
+	if (!errors) {
+		bench("linear", 0);
+		bench("indexed", 1);
+		bench_build();
+	}
+
+	for (j = 0; j < num_sets; j++) {
+		os_free(sets[j].ies);
+		os_free(sets[j].idx);
+	}
+
+	return errors;
+}
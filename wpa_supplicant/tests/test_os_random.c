@@ -0,0 +1,75 @@
+/*
+ * Test program for os_get_random() throughput
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+
+#define NONCE_LEN 32
+#define TEST_DURATION 1
+
+
+static int urandom_stdio(unsigned char *buf, size_t len)
+{
+	FILE *f;
+	size_t rc;
+
+	f = fopen("/dev/urandom", "rb");
+	if (f == NULL)
+		return -1;
+	rc = fread(buf, 1, len, f);
+	fclose(f);
+	return rc != len ? -1 : 0;
+}
+
+
+static int test_rate(const char *name,
+		     int (*func)(unsigned char *buf, size_t len))
+{
+	struct os_reltime start, now, diff;
+	unsigned char prev[NONCE_LEN], nonce[NONCE_LEN];
+	unsigned long count = 0;
+	double secs;
+
+	os_memset(prev, 0, sizeof(prev));
+	os_get_reltime(&start);
+	do {
+		unsigned int i;
+
+		for (i = 0; i < 1000; i++) {
+			if (func(nonce, sizeof(nonce)) < 0) {
+				printf("%s: failed to get random data\n", name);
+				return 1;
+			}
+			if (os_memcmp(nonce, prev, sizeof(nonce)) == 0) {
+				printf("%s: repeated nonce\n", name);
+				return 1;
+			}
+			os_memcpy(prev, nonce, sizeof(nonce));
+		}
+		count += 1000;
+		os_get_reltime(&now);
+	} while (!os_reltime_expired(&now, &start, TEST_DURATION));
+
+	os_reltime_sub(&now, &start, &diff);
+	secs = diff.sec + diff.usec / 1000000.0;
+	printf("%-16s %lu %d-octet nonces/s\n", name,
+	       (unsigned long) (count / secs), NONCE_LEN);
+
+	return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+	int errors = 0;
+
+	errors += test_rate("fopen/fread", urandom_stdio);
+	errors += test_rate("os_get_random", os_get_random);
+
+	return errors;
+}
@@ -52,6 +52,7 @@
 #include "hs20_supplicant.h"
 #include "wnm_sta.h"
 #include "wpas_kay.h"
+#include "wpas_stats.h"
 
 const char *wpa_supplicant_version =
 "wpa_supplicant v" VERSION_STR "\n"
@@ -488,6 +489,8 @@ static void wpa_supplicant_cleanup(struct wpa_supplicant *wpa_s)
 	ext_password_deinit(wpa_s->ext_pw);
 	wpa_s->ext_pw = NULL;
 
+	wpas_stats_deinit(wpa_s);
+
 	wpabuf_free(wpa_s->last_gas_resp);
 	wpa_s->last_gas_resp = NULL;
 	wpabuf_free(wpa_s->prev_gas_resp);
@@ -738,6 +741,7 @@ void wpa_supplicant_set_state(struct wpa_supplicant *wpa_s,
 
 	if (wpa_s->wpa_state != old_state) {
 		wpas_notify_state_changed(wpa_s, wpa_s->wpa_state, old_state);
+		wpas_stats_update(wpa_s);
 
 		/*
 		 * Notify the P2P Device interface about a state change in one
@@ -817,6 +821,7 @@ int wpa_supplicant_reload_configuration(struct wpa_supplicant *wpa_s)
 
 	if (wpa_s->confname == NULL)
 		return -1;
+	wpas_config_write_flush(wpa_s);
 	conf = wpa_config_read(wpa_s->confname, NULL);
 	if (conf == NULL) {
 		wpa_msg(wpa_s, MSG_ERROR, "Failed to parse the configuration "
@@ -3354,6 +3359,158 @@ static void radio_work_free(struct wpa_radio_work *work)
 }
 
 
+/* Pending works are promoted to the highest priority after this wait (s) */
+#define RADIO_WORK_MAX_WAIT 1
+
+static const struct {
+	const char *type;
+	enum wpa_radio_work_class wclass;
+} radio_work_classes[] = {
+	{ "connect", RADIO_WORK_CLASS_CONNECT },
+	{ "sme-connect", RADIO_WORK_CLASS_CONNECT },
+	{ "p2p-send-action", RADIO_WORK_CLASS_OFFCHANNEL },
+	{ "gas-query", RADIO_WORK_CLASS_OFFCHANNEL },
+	{ "p2p-listen", RADIO_WORK_CLASS_LISTEN },
+	{ "scan", RADIO_WORK_CLASS_SCAN },
+	{ "p2p-scan", RADIO_WORK_CLASS_SCAN },
+};
+
+
+static enum wpa_radio_work_class radio_work_class(const char *type)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(radio_work_classes); i++) {
+		if (os_strcmp(type, radio_work_classes[i].type) == 0)
+			return radio_work_classes[i].wclass;
+	}
+	return RADIO_WORK_CLASS_OTHER;
+}
+
+
+static void radio_work_update_stats(struct wpa_radio *radio,
+				    struct wpa_radio_work *work,
+				    struct os_reltime *wait)
+{
+	struct wpa_radio_work_stats *stats = NULL, *n;
+	const char *type;
+	unsigned int ms, limit;
+	size_t i;
+
+	type = os_strncmp(work->type, "ext:", 4) == 0 ? "ext" : work->type;
+	for (i = 0; i < radio->num_stats; i++) {
+		if (os_strcmp(radio->stats[i].type, type) == 0) {
+			stats = &radio->stats[i];
+			break;
+		}
+	}
+	if (stats == NULL) {
+		/*
+		 * Internal work types are string constants, so the pointer
+		 * can be stored without making a copy.
+		 */
+		n = os_realloc_array(radio->stats, radio->num_stats + 1,
+				     sizeof(*radio->stats));
+		if (n == NULL)
+			return;
+		radio->stats = n;
+		stats = &radio->stats[radio->num_stats++];
+		os_memset(stats, 0, sizeof(*stats));
+		stats->type = os_strcmp(type, "ext") == 0 ? "ext" : work->type;
+	}
+
+	ms = wait->sec * 1000 + wait->usec / 1000;
+	stats->count++;
+	stats->total_wait_us += (u64) wait->sec * 1000000 + wait->usec;
+	if (ms > stats->max_wait_ms)
+		stats->max_wait_ms = ms;
+	for (i = 0, limit = 1; i < RADIO_WORK_WAIT_BUCKETS - 1;
+	     i++, limit *= 10) {
+		if (ms < limit)
+			break;
+	}
+	stats->hist[i]++;
+}
+
+
+static int radio_work_key(struct wpa_radio_work *work, struct os_reltime *now)
+{
+	if (work->next)
+		return -1;
+	if (os_reltime_expired(now, &work->time, RADIO_WORK_MAX_WAIT))
+		return RADIO_WORK_CLASS_CONNECT;
+	return work->wclass;
+}
+
+
+/*
+ * Works that are known to use a single channel may run in parallel with
+ * other such works on the same channel. Connection establishment, scans, and
+ * external works always get exclusive access to the radio.
+ */
+static int radio_work_concurrent(struct wpa_radio_work *work)
+{
+	return work->freq &&
+		(work->wclass == RADIO_WORK_CLASS_OFFCHANNEL ||
+		 work->wclass == RADIO_WORK_CLASS_LISTEN);
+}
+
+
+static struct wpa_radio_work * radio_work_get_next(struct wpa_radio *radio)
+{
+	struct wpa_radio_work *work, *next = NULL, *active = NULL;
+	struct os_reltime now;
+	int key, best = 0;
+
+	dl_list_for_each(work, &radio->work, struct wpa_radio_work, list) {
+		if (!work->started)
+			continue;
+		if (!radio_work_concurrent(work))
+			return NULL;
+		active = work;
+	}
+
+	os_get_reltime(&now);
+	dl_list_for_each(work, &radio->work, struct wpa_radio_work, list) {
+		if (work->started)
+			continue;
+		key = radio_work_key(work, &now);
+		if (active && key <= RADIO_WORK_CLASS_CONNECT &&
+		    !radio_work_concurrent(work)) {
+			/*
+			 * Do not delay a pending high priority work by starting
+			 * more parallel works.
+			 */
+			return NULL;
+		}
+		if (next && key >= best)
+			continue;
+		if (active) {
+			struct wpa_radio_work *a;
+			int ok = radio_work_concurrent(work);
+
+			dl_list_for_each(a, &radio->work, struct wpa_radio_work,
+					 list) {
+				if (!ok)
+					break;
+				if (!a->started)
+					continue;
+				if (a->freq != work->freq ||
+				    (a->wpa_s == work->wpa_s &&
+				     os_strcmp(a->type, work->type) == 0))
+					ok = 0;
+			}
+			if (!ok)
+				continue;
+		}
+		next = work;
+		best = key;
+	}
+
+	return next;
+}
+
+
 static void radio_start_next_work(void *eloop_ctx, void *timeout_ctx)
 {
 	struct wpa_radio *radio = eloop_ctx;
@@ -3361,13 +3518,6 @@ static void radio_start_next_work(void *eloop_ctx, void *timeout_ctx)
 	struct os_reltime now, diff;
 	struct wpa_supplicant *wpa_s;
 
-	work = dl_list_first(&radio->work, struct wpa_radio_work, list);
-	if (work == NULL)
-		return;
-
-	if (work->started)
-		return; /* already started and still in progress */
-
 	wpa_s = dl_list_first(&radio->ifaces, struct wpa_supplicant,
 			      radio_list);
 	if (wpa_s && wpa_s->external_scan_running) {
@@ -3375,12 +3525,22 @@ static void radio_start_next_work(void *eloop_ctx, void *timeout_ctx)
 		return;
 	}
 
+	work = radio_work_get_next(radio);
+	if (work == NULL)
+		return; /* idle or no work can be started in parallel */
+
 	os_get_reltime(&now);
 	os_reltime_sub(&now, &work->time, &diff);
 	wpa_dbg(work->wpa_s, MSG_DEBUG, "Starting radio work '%s'@%p after %ld.%06ld second wait",
 		work->type, work, diff.sec, diff.usec);
+	radio_work_update_stats(radio, work, &diff);
 	work->started = 1;
 	work->time = now;
+
+	/* Check whether another work can be started in parallel */
+	eloop_cancel_timeout(radio_start_next_work, radio, NULL);
+	eloop_register_timeout(0, 0, radio_start_next_work, radio, NULL);
+
 	work->cb(work, 0);
 }
 
@@ -3439,6 +3599,7 @@ static void radio_remove_interface(struct wpa_supplicant *wpa_s)
 
 	wpa_printf(MSG_DEBUG, "Remove radio %s", radio->name);
 	eloop_cancel_timeout(radio_start_next_work, radio, NULL);
+	os_free(radio->stats);
 	os_free(radio);
 }
 
@@ -3478,6 +3639,10 @@ void radio_work_check_next(struct wpa_supplicant *wpa_s)
  * operations to be performed in parallel if they apply for the same channel.
  * Setting this to 0 indicates that the work item may use multiple channels or
  * requires exclusive control of the radio.
+ *
+ * Pending works are started in priority order based on the class of the
+ * work @type (see enum wpa_radio_work_class) and in FIFO order within a
+ * class. Works added with @next are started before all other pending works.
  */
 int radio_add_work(struct wpa_supplicant *wpa_s, unsigned int freq,
 		   const char *type, int next,
@@ -3497,6 +3662,8 @@ int radio_add_work(struct wpa_supplicant *wpa_s, unsigned int freq,
 	work->wpa_s = wpa_s;
 	work->cb = cb;
 	work->ctx = ctx;
+	work->wclass = radio_work_class(type);
+	work->next = !!next;
 
 	was_empty = dl_list_empty(&wpa_s->radio->work);
 	if (next)
@@ -3506,6 +3673,9 @@ int radio_add_work(struct wpa_supplicant *wpa_s, unsigned int freq,
 	if (was_empty) {
 		wpa_dbg(wpa_s, MSG_DEBUG, "First radio work item in the queue - schedule start immediately");
 		radio_work_check_next(wpa_s);
+	} else if (radio_work_concurrent(work)) {
+		/* This may be able to run in parallel with the current work */
+		radio_work_check_next(wpa_s);
 	}
 
 	return 0;
@@ -3551,6 +3721,53 @@ radio_work_pending(struct wpa_supplicant *wpa_s, const char *type)
 }
 
 
+/**
+ * radio_work_stats - Get radio work queue wait statistics
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @buf: Buffer for the text output
+ * @buflen: Length of buf in octets
+ * Returns: Number of octets written to buf
+ *
+ * One line is written for each radio work type that has been started on the
+ * radio: <type> count=<n> avg_wait_ms=<ms> max_wait_ms=<ms>
+ * hist=<1ms>,<10ms>,<100ms>,<1s>,<10s>,<longer>
+ */
+int radio_work_stats(struct wpa_supplicant *wpa_s, char *buf, size_t buflen)
+{
+	struct wpa_radio *radio = wpa_s->radio;
+	char *pos = buf, *end = buf + buflen;
+	size_t i, j;
+	int ret;
+
+	for (i = 0; i < radio->num_stats; i++) {
+		struct wpa_radio_work_stats *stats = &radio->stats[i];
+
+		ret = os_snprintf(pos, end - pos,
+				  "%s count=%u avg_wait_ms=%u max_wait_ms=%u hist=",
+				  stats->type, stats->count,
+				  (unsigned int) (stats->total_wait_us /
+						  stats->count / 1000),
+				  stats->max_wait_ms);
+		if (ret < 0 || ret >= end - pos)
+			return pos - buf;
+		pos += ret;
+		for (j = 0; j < RADIO_WORK_WAIT_BUCKETS; j++) {
+			ret = os_snprintf(pos, end - pos, "%s%u",
+					  j ? "," : "", stats->hist[j]);
+			if (ret < 0 || ret >= end - pos)
+				return pos - buf;
+			pos += ret;
+		}
+		ret = os_snprintf(pos, end - pos, "\n");
+		if (ret < 0 || ret >= end - pos)
+			return pos - buf;
+		pos += ret;
+	}
+
+	return pos - buf;
+}
+
+
 static int wpas_init_driver(struct wpa_supplicant *wpa_s,
 			    struct wpa_interface *iface)
 {
@@ -3847,6 +4064,9 @@ static int wpa_supplicant_init_iface(struct wpa_supplicant *wpa_s,
 	if (wpas_init_ext_pw(wpa_s) < 0)
 		return -1;
 
+	if (wpas_stats_init(wpa_s) < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -3884,6 +4104,7 @@ static void wpa_supplicant_deinit_iface(struct wpa_supplicant *wpa_s,
 	}
 
 	if (wpa_s->conf != NULL) {
+		wpas_config_write_flush(wpa_s);
 		wpa_config_free(wpa_s->conf);
 		wpa_s->conf = NULL;
 	}
@@ -4054,6 +4275,26 @@ static const char * wpa_supplicant_msg_ifname_cb(void *ctx)
 #endif /* CONFIG_NO_WPA_MSG */
 
 
+#ifdef CONFIG_DEBUG_BUFFER
+
+#define WPAS_DEBUG_BUFFER_SIZE (256 * 1024)
+#define WPAS_DEBUG_BUFFER_FLUSH_USEC 100000
+
+static void wpas_debug_buffer_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	wpa_debug_flush_buffer();
+}
+
+
+static void wpas_debug_buffer_pending(void)
+{
+	eloop_register_timeout(0, WPAS_DEBUG_BUFFER_FLUSH_USEC,
+			       wpas_debug_buffer_timeout, NULL, NULL);
+}
+
+#endif /* CONFIG_DEBUG_BUFFER */
+
+
 /**
  * wpa_supplicant_init - Initialize %wpa_supplicant
  * @params: Parameters for %wpa_supplicant
@@ -4140,6 +4381,12 @@ struct wpa_global * wpa_supplicant_init(struct wpa_params *params)
 		return NULL;
 	}
 
+#ifdef CONFIG_DEBUG_BUFFER
+	if (wpa_debug_open_buffer(WPAS_DEBUG_BUFFER_SIZE,
+				  wpas_debug_buffer_pending) < 0)
+		wpa_printf(MSG_ERROR, "Failed to allocate debug buffer");
+#endif /* CONFIG_DEBUG_BUFFER */
+
 	random_init(params->entropy_file);
 
 	global->ctrl_iface = wpa_supplicant_global_ctrl_iface_init(global);
@@ -4250,6 +4497,12 @@ void wpa_supplicant_deinit(struct wpa_global *global)
 	os_free(global->drv_priv);
 
 	random_deinit();
+	wpabuf_pool_deinit();
+
+#ifdef CONFIG_DEBUG_BUFFER
+	eloop_cancel_timeout(wpas_debug_buffer_timeout, NULL, NULL);
+	wpa_debug_close_buffer();
+#endif /* CONFIG_DEBUG_BUFFER */
 
 	eloop_destroy();
 
@@ -4298,6 +4551,66 @@ void wpa_supplicant_update_config(struct wpa_supplicant *wpa_s)
 }
 
 
+#ifndef CONFIG_NO_CONFIG_WRITE
+
+/* Time to wait for more changes before updating the configuration file */
+#define WPAS_CONFIG_WRITE_DELAY_MS 500
+
+static void wpas_config_write_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+
+	if (wpa_s->confname == NULL || !wpa_s->conf->update_config)
+		return;
+	if (wpa_config_write_async(wpa_s->confname, wpa_s->conf) < 0)
+		wpa_dbg(wpa_s, MSG_DEBUG, "Failed to update configuration");
+}
+
+#endif /* CONFIG_NO_CONFIG_WRITE */
+
+
+/**
+ * wpas_config_write_deferred - Request configuration file update
+ * @wpa_s: Pointer to wpa_supplicant data
+ *
+ * This function can be used instead of wpa_config_write() when the caller
+ * does not need to know the result of the update. Requests are coalesced
+ * and the file is updated once after WPAS_CONFIG_WRITE_DELAY_MS. Nothing is
+ * done if update_config is not enabled.
+ */
+void wpas_config_write_deferred(struct wpa_supplicant *wpa_s)
+{
+#ifndef CONFIG_NO_CONFIG_WRITE
+	if (wpa_s->confname == NULL || !wpa_s->conf->update_config)
+		return;
+	if (eloop_is_timeout_registered(wpas_config_write_timeout, wpa_s,
+					NULL))
+		return;
+	eloop_register_timeout(0, WPAS_CONFIG_WRITE_DELAY_MS * 1000,
+			       wpas_config_write_timeout, wpa_s, NULL);
+#endif /* CONFIG_NO_CONFIG_WRITE */
+}
+
+
+/**
+ * wpas_config_write_flush - Complete pending configuration file updates
+ * @wpa_s: Pointer to wpa_supplicant data
+ *
+ * A deferred update that has not yet been started is written out
+ * synchronously and all background writes are waited for.
+ */
+void wpas_config_write_flush(struct wpa_supplicant *wpa_s)
+{
+#ifndef CONFIG_NO_CONFIG_WRITE
+	if (eloop_cancel_timeout(wpas_config_write_timeout, wpa_s, NULL) > 0 &&
+	    wpa_s->confname && wpa_s->conf && wpa_s->conf->update_config &&
+	    wpa_config_write(wpa_s->confname, wpa_s->conf) < 0)
+		wpa_dbg(wpa_s, MSG_DEBUG, "Failed to update configuration");
+	wpa_config_write_flush();
+#endif /* CONFIG_NO_CONFIG_WRITE */
+}
+
+
 static void add_freq(int *freqs, int *num_freqs, int freq)
 {
 	int i;
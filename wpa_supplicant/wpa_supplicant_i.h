@@ -42,6 +42,7 @@ struct wpa_driver_associate_params;
  */
 struct ctrl_iface_priv;
 struct ctrl_iface_global_priv;
+struct stats_shm;
 struct wpas_dbus_priv;
 
 /**
@@ -296,6 +297,22 @@ struct wpa_radio {
 			* available */
 	struct dl_list ifaces; /* struct wpa_supplicant::radio_list entries */
 	struct dl_list work; /* struct wpa_radio_work::list entries */
+	struct wpa_radio_work_stats *stats; /* queue wait statistics */
+	size_t num_stats;
+};
+
+/*
+ * Radio work classes in priority order. Pending works of a higher priority
+ * class are started before works that were queued earlier, but any work
+ * that has been waiting for more than a second is treated as if it were of
+ * the highest priority class to avoid starvation.
+ */
+enum wpa_radio_work_class {
+	RADIO_WORK_CLASS_CONNECT, /* connect, sme-connect */
+	RADIO_WORK_CLASS_OFFCHANNEL, /* p2p-send-action, gas-query */
+	RADIO_WORK_CLASS_LISTEN, /* p2p-listen */
+	RADIO_WORK_CLASS_OTHER, /* external works and unknown types */
+	RADIO_WORK_CLASS_SCAN, /* scan, p2p-scan */
 };
 
 /**
@@ -308,10 +325,26 @@ struct wpa_radio_work {
 	struct wpa_supplicant *wpa_s;
 	void (*cb)(struct wpa_radio_work *work, int deinit);
 	void *ctx;
+	enum wpa_radio_work_class wclass;
 	unsigned int started:1;
+	unsigned int next:1;
 	struct os_reltime time;
 };
 
+/* Queue wait histogram buckets: <1 ms, <10 ms, <100 ms, <1 s, <10 s, more */
+#define RADIO_WORK_WAIT_BUCKETS 6
+
+/**
+ * struct wpa_radio_work_stats - Queue wait statistics for a radio work type
+ */
+struct wpa_radio_work_stats {
+	const char *type; /* "ext" for all external radio works */
+	unsigned int count;
+	unsigned int max_wait_ms;
+	u64 total_wait_us;
+	unsigned int hist[RADIO_WORK_WAIT_BUCKETS];
+};
+
 int radio_add_work(struct wpa_supplicant *wpa_s, unsigned int freq,
 		   const char *type, int next,
 		   void (*cb)(struct wpa_radio_work *work, int deinit),
@@ -322,6 +355,7 @@ void radio_remove_works(struct wpa_supplicant *wpa_s,
 void radio_work_check_next(struct wpa_supplicant *wpa_s);
 struct wpa_radio_work *
 radio_work_pending(struct wpa_supplicant *wpa_s, const char *type);
+int radio_work_stats(struct wpa_supplicant *wpa_s, char *buf, size_t buflen);
 
 struct wpa_connect_work {
 	unsigned int sme:1;
@@ -840,6 +874,10 @@ struct wpa_supplicant {
 
 	struct ext_password_data *ext_pw;
 
+#ifdef CONFIG_STATS_SHM
+	struct stats_shm *stats;
+#endif /* CONFIG_STATS_SHM */
+
 	struct wpabuf *last_gas_resp, *prev_gas_resp;
 	u8 last_gas_addr[ETH_ALEN], prev_gas_addr[ETH_ALEN];
 	u8 last_gas_dialog_token, prev_gas_dialog_token;
@@ -951,6 +989,8 @@ void wpa_supplicant_terminate_proc(struct wpa_global *global);
 void wpa_supplicant_rx_eapol(void *ctx, const u8 *src_addr,
 			     const u8 *buf, size_t len);
 void wpa_supplicant_update_config(struct wpa_supplicant *wpa_s);
+void wpas_config_write_deferred(struct wpa_supplicant *wpa_s);
+void wpas_config_write_flush(struct wpa_supplicant *wpa_s);
 void wpa_supplicant_clear_status(struct wpa_supplicant *wpa_s);
 void wpas_connection_failed(struct wpa_supplicant *wpa_s, const u8 *bssid);
 int wpas_driver_bss_selection(struct wpa_supplicant *wpa_s);
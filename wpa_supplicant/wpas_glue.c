@@ -36,13 +36,7 @@ static void wpa_supplicant_set_config_blob(void *ctx,
 {
 	struct wpa_supplicant *wpa_s = ctx;
 	wpa_config_set_blob(wpa_s->conf, blob);
-	if (wpa_s->conf->update_config) {
-		int ret = wpa_config_write(wpa_s->confname, wpa_s->conf);
-		if (ret) {
-			wpa_printf(MSG_DEBUG, "Failed to update config after "
-				   "blob set");
-		}
-	}
+	wpas_config_write_deferred(wpa_s);
 }
 
 
@@ -830,13 +824,7 @@ static void wpa_supplicant_set_anon_id(void *ctx, const u8 *id, size_t len)
 			return;
 	}
 
-	if (wpa_s->conf->update_config) {
-		res = wpa_config_write(wpa_s->confname, wpa_s->conf);
-		if (res) {
-			wpa_printf(MSG_DEBUG, "Failed to update config after "
-				   "anonymous_id update");
-		}
-	}
+	wpas_config_write_deferred(wpa_s);
 }
 #endif /* IEEE8021X_EAPOL */
 
@@ -9,8 +9,13 @@
 #include "utils/includes.h"
 
 #include "utils/common.h"
+#include "common/wpa_ctrl.h"
+#include "common/ctrl_iface_common.h"
+#include "drivers/driver.h"
 #include "wpa_supplicant_i.h"
+#include "config.h"
 #include "blacklist.h"
+#include "scan.h"
 
 
 static int wpas_blacklist_module_tests(void)
@@ -69,6 +74,191 @@ fail:
 }
 
 
+static int wpas_config_module_tests(void)
+{
+	struct wpa_config *config;
+	struct wpa_ssid *ssid;
+	char *val;
+	char buf[50];
+	int ret = -1;
+
+	wpa_printf(MSG_INFO, "config lookup tests");
+
+	config = wpa_config_alloc_empty(NULL, NULL);
+	if (config == NULL)
+		return -1;
+	ssid = wpa_config_add_network(config);
+	if (ssid == NULL)
+		goto fail;
+
+	if (wpa_config_set(ssid, "ssid", "\"test\"", 0) < 0 ||
+	    wpa_config_set(ssid, "scan_ssid", "1", 0) < 0 ||
+	    wpa_config_set(ssid, "ss", "1", 0) == 0 ||
+	    wpa_config_set(ssid, "ssidx", "1", 0) == 0 ||
+	    wpa_config_set(ssid, "", "1", 0) == 0 ||
+	    wpa_config_set(ssid, "zzzz", "1", 0) == 0 ||
+	    ssid->scan_ssid != 1 || ssid->ssid_len != 4)
+		goto fail;
+
+	val = wpa_config_get(ssid, "scan_ssid");
+	if (val == NULL || os_strcmp(val, "1") != 0) {
+		os_free(val);
+		goto fail;
+	}
+	os_free(val);
+	if (wpa_config_get(ssid, "scan_ssi") != NULL)
+		goto fail;
+
+	if (wpa_config_add_network(config) == NULL ||
+	    wpa_config_add_network(config) == NULL ||
+	    wpa_config_get_network(config, 0) != ssid ||
+	    wpa_config_get_network(config, 2) == NULL ||
+	    wpa_config_get_network(config, 3) != NULL ||
+	    wpa_config_get_network(config, -1) != NULL ||
+	    wpa_config_remove_network(config, 1) < 0 ||
+	    wpa_config_remove_network(config, 1) == 0 ||
+	    wpa_config_get_network(config, 1) != NULL ||
+	    wpa_config_get_network(config, 2) == NULL ||
+	    wpa_config_remove_network(config, 2) < 0)
+		goto fail;
+	ssid = wpa_config_add_network(config);
+	if (ssid == NULL || ssid->id != 1 ||
+	    wpa_config_get_network(config, 1) != ssid)
+		goto fail;
+
+	os_strlcpy(buf, "ap_scan=2", sizeof(buf));
+	if (wpa_config_process_global(config, buf, -1) < 0 ||
+	    config->ap_scan != 2)
+		goto fail;
+	os_strlcpy(buf, "ap_sca=1", sizeof(buf));
+	if (wpa_config_process_global(config, buf, -1) == 0)
+		goto fail;
+	os_strlcpy(buf, "ap_scanx=1", sizeof(buf));
+	if (wpa_config_process_global(config, buf, -1) == 0)
+		goto fail;
+	os_strlcpy(buf, "ap_scan", sizeof(buf));
+	if (wpa_config_process_global(config, buf, -1) == 0 ||
+	    config->ap_scan != 2)
+		goto fail;
+
+	ret = 0;
+fail:
+	wpa_config_free(config);
+
+	if (ret)
+		wpa_printf(MSG_ERROR, "config lookup module test failure");
+
+	return ret;
+}
+
+
+static int wpas_scan_merge_module_tests(void)
+{
+	struct wpa_driver_scan_params a, b, *dst;
+	int freqs_a[] = { 2412, 2437, 0 };
+	int freqs_b[] = { 2437, 5180, 0 };
+	int ret = -1;
+
+	wpa_printf(MSG_INFO, "scan parameter merge tests");
+
+	os_memset(&a, 0, sizeof(a));
+	os_memset(&b, 0, sizeof(b));
+	a.ssids[0].ssid = (const u8 *) "test";
+	a.ssids[0].ssid_len = 4;
+	a.num_ssids = 1;
+	a.freqs = freqs_a;
+	b.ssids[0].ssid = (const u8 *) "test";
+	b.ssids[0].ssid_len = 4;
+	b.ssids[1].ssid_len = 0; /* wildcard */
+	b.num_ssids = 2;
+	b.freqs = freqs_b;
+
+	dst = wpa_scan_clone_params(&a);
+	if (dst == NULL)
+		return -1;
+
+	if (wpa_scan_merge_params(dst, &b, 1) == 0 ||
+	    wpa_scan_merge_params(dst, &b, 4) < 0 ||
+	    dst->num_ssids != 2 ||
+	    dst->ssids[1].ssid_len != 0 ||
+	    int_array_len(dst->freqs) != 3 ||
+	    dst->freqs[0] != 2412 || dst->freqs[1] != 2437 ||
+	    dst->freqs[2] != 5180)
+		goto fail;
+
+	b.freqs = NULL;
+	if (wpa_scan_merge_params(dst, &b, 4) < 0 || dst->freqs ||
+	    dst->num_ssids != 2)
+		goto fail;
+
+	b.p2p_probe = 1;
+	if (wpa_scan_merge_params(dst, &b, 4) == 0)
+		goto fail;
+
+	ret = 0;
+fail:
+	if (ret)
+		wpa_printf(MSG_INFO, "scan parameter merge test failed");
+	wpa_scan_free_params(dst);
+	return ret;
+}
+
+
+#ifdef CONFIG_CTRL_IFACE_UNIX
+static int wpas_ctrl_mon_queue_module_tests(void)
+{
+	struct ctrl_mon_queue q;
+	struct wpabuf *msg;
+	char buf[100];
+	int sv[2] = { -1, -1 };
+	int i, res, ret = -1;
+
+	wpa_printf(MSG_INFO, "ctrl_iface monitor queue tests");
+
+	os_memset(&q, 0, sizeof(q));
+	msg = ctrl_mon_msg_build("wlan0", MSG_INFO, "TEST", 4);
+	if (msg == NULL ||
+	    wpabuf_len(msg) != 20 ||
+	    os_memcmp(wpabuf_head(msg), "IFNAME=wlan0 <3>TEST", 20) != 0)
+		goto fail;
+
+	for (i = 0; i < CTRL_MON_QUEUE_LEN + 5; i++)
+		ctrl_mon_queue_add(&q, msg);
+	if (q.count != CTRL_MON_QUEUE_LEN || q.dropped != 5 ||
+	    q.dropped_total != 5)
+		goto fail;
+
+	if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sv) < 0)
+		goto fail;
+	res = ctrl_mon_queue_send(&q, sv[0], NULL, 0);
+	if (res != CTRL_MON_QUEUE_LEN + 1 || q.count != 0 || q.dropped != 0 ||
+	    q.dropped_total != 5)
+		goto fail;
+	res = recv(sv[1], buf, sizeof(buf) - 1, 0);
+	if (res < 0)
+		goto fail;
+	buf[res] = '\0';
+	if (os_strcmp(buf, "<4>" WPA_EVENT_MONITOR_DROPPED "count=5") != 0)
+		goto fail;
+	res = recv(sv[1], buf, sizeof(buf), 0);
+	if (res != 20 || os_memcmp(buf, wpabuf_head(msg), 20) != 0)
+		goto fail;
+
+	ret = 0;
+fail:
+	if (ret)
+		wpa_printf(MSG_INFO, "ctrl_iface monitor queue test failed");
+	ctrl_mon_queue_clear(&q);
+	wpabuf_free(msg);
+	if (sv[0] >= 0) {
+		close(sv[0]);
+		close(sv[1]);
+	}
+	return ret;
+}
+#endif /* CONFIG_CTRL_IFACE_UNIX */
+
+
 int wpas_module_tests(void)
 {
 	int ret = 0;
@@ -78,6 +268,17 @@ int wpas_module_tests(void)
 	if (wpas_blacklist_module_tests() < 0)
 		ret = -1;
 
+	if (wpas_config_module_tests() < 0)
+		ret = -1;
+
+	if (wpas_scan_merge_module_tests() < 0)
+		ret = -1;
+
+#ifdef CONFIG_CTRL_IFACE_UNIX
+	if (wpas_ctrl_mon_queue_module_tests() < 0)
+		ret = -1;
+#endif /* CONFIG_CTRL_IFACE_UNIX */
+
 #ifdef CONFIG_WPS
 	{
 		int wps_module_tests(void);
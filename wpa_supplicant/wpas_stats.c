@@ -0,0 +1,113 @@
+/*
+ * WPA Supplicant - Shared memory statistics
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "config.h"
+#include "wpa_supplicant_i.h"
+#include "driver_i.h"
+#include "bss.h"
+#include "wpas_stats.h"
+
+
+static void wpas_stats_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+
+	wpas_stats_update(wpa_s);
+	eloop_register_timeout(wpa_s->conf->stats_interval, 0,
+			       wpas_stats_timeout, wpa_s, NULL);
+}
+
+
+/**
+ * wpas_stats_update - Update the shared memory statistics region
+ * @wpa_s: Pointer to wpa_supplicant data
+ */
+void wpas_stats_update(struct wpa_supplicant *wpa_s)
+{
+	struct wpas_stats_iface tmp, *region;
+	struct wpa_signal_info si;
+	struct hostap_sta_driver_data sta;
+
+	if (wpa_s->stats == NULL)
+		return;
+
+	/* Collect everything first so that the driver calls are not done while
+	 * readers are kept waiting */
+	os_memset(&tmp, 0, sizeof(tmp));
+	tmp.wpa_state = wpa_s->wpa_state;
+	tmp.num_bss = wpa_s->num_bss;
+	tmp.disconnect_reason = wpa_s->disconnect_reason;
+	if (wpa_s->wpa_state >= WPA_ASSOCIATED) {
+		os_memcpy(tmp.bssid, wpa_s->bssid, ETH_ALEN);
+		tmp.freq = wpa_s->assoc_freq;
+
+		os_memset(&si, 0, sizeof(si));
+		if (wpa_drv_signal_poll(wpa_s, &si) == 0) {
+			if (si.frequency)
+				tmp.freq = si.frequency;
+			tmp.signal = si.current_signal;
+			tmp.noise = si.current_noise;
+			tmp.txrate = si.current_txrate;
+		} else if (wpa_s->current_bss) {
+			tmp.signal = wpa_s->current_bss->level;
+			tmp.noise = wpa_s->current_bss->noise;
+		}
+
+		os_memset(&sta, 0, sizeof(sta));
+		if (wpa_drv_pktcnt_poll(wpa_s, &sta) == 0) {
+			tmp.rx_packets = sta.rx_packets;
+			tmp.tx_packets = sta.tx_packets;
+			tmp.tx_retry_failed = sta.tx_retry_failed;
+		}
+	}
+
+	region = stats_shm_update_begin(wpa_s->stats);
+	os_memcpy((u8 *) region + sizeof(region->hdr),
+		  (u8 *) &tmp + sizeof(tmp.hdr), sizeof(tmp) - sizeof(tmp.hdr));
+	stats_shm_update_end(wpa_s->stats);
+}
+
+
+/**
+ * wpas_stats_init - Initialize the shared memory statistics region
+ * @wpa_s: Pointer to wpa_supplicant data
+ * Returns: 0 on success (or if not configured) or -1 on failure
+ */
+int wpas_stats_init(struct wpa_supplicant *wpa_s)
+{
+	if (wpa_s->conf->stats_file == NULL)
+		return 0;
+
+	wpa_s->stats = stats_shm_create(wpa_s->conf->stats_file,
+					STATS_SHM_TYPE_WPA_SUPPLICANT,
+					sizeof(struct wpas_stats_iface));
+	if (wpa_s->stats == NULL)
+		return -1;
+
+	wpas_stats_timeout(wpa_s, NULL);
+
+	return 0;
+}
+
+
+/**
+ * wpas_stats_deinit - Remove the shared memory statistics region
+ * @wpa_s: Pointer to wpa_supplicant data
+ */
+void wpas_stats_deinit(struct wpa_supplicant *wpa_s)
+{
+	if (wpa_s->stats == NULL)
+		return;
+
+	eloop_cancel_timeout(wpas_stats_timeout, wpa_s, NULL);
+	stats_shm_destroy(wpa_s->stats);
+	wpa_s->stats = NULL;
+}
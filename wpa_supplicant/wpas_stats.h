@@ -0,0 +1,60 @@
+/*
+ * WPA Supplicant - Shared memory statistics
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef WPAS_STATS_H
+#define WPAS_STATS_H
+
+#include "utils/stats_shm.h"
+
+/*
+ * Layout of a STATS_SHM_TYPE_WPA_SUPPLICANT region (see utils/stats_shm.h for
+ * the common header and the locking rules). Offsets are from the beginning of
+ * the region. The link fields are zero when not connected or if the driver
+ * does not report them.
+ */
+struct wpas_stats_iface {
+	struct stats_shm_hdr hdr; /* 0 */
+	u32 wpa_state; /* 32: enum wpa_states */
+	u32 num_bss; /* 36: number of entries in the BSS table */
+	u8 bssid[6]; /* 40: current BSSID */
+	u16 reserved; /* 46 */
+	u32 freq; /* 48: operating frequency in MHz */
+	s32 signal; /* 52: dBm */
+	s32 noise; /* 56: dBm */
+	u32 txrate; /* 60: kbps */
+	u64 rx_packets; /* 64 */
+	u64 tx_packets; /* 72 */
+	u32 tx_retry_failed; /* 80 */
+	s32 disconnect_reason; /* 84: last WLAN_REASON_* (negative if local) */
+};
+
+struct wpa_supplicant;
+
+#ifdef CONFIG_STATS_SHM
+
+int wpas_stats_init(struct wpa_supplicant *wpa_s);
+void wpas_stats_deinit(struct wpa_supplicant *wpa_s);
+void wpas_stats_update(struct wpa_supplicant *wpa_s);
+
+#else /* CONFIG_STATS_SHM */
+
+static inline int wpas_stats_init(struct wpa_supplicant *wpa_s)
+{
+	return 0;
+}
+
+static inline void wpas_stats_deinit(struct wpa_supplicant *wpa_s)
+{
+}
+
+static inline void wpas_stats_update(struct wpa_supplicant *wpa_s)
+{
+}
+
+#endif /* CONFIG_STATS_SHM */
+
+#endif /* WPAS_STATS_H */
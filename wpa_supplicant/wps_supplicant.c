@@ -540,13 +540,7 @@ static int wpa_supplicant_wps_cred(void *ctx,
 
 	wpas_wps_remove_dup_network(wpa_s, ssid);
 
-#ifndef CONFIG_NO_CONFIG_WRITE
-	if (wpa_s->conf->update_config &&
-	    wpa_config_write(wpa_s->confname, wpa_s->conf)) {
-		wpa_printf(MSG_DEBUG, "WPS: Failed to update configuration");
-		return -1;
-	}
-#endif /* CONFIG_NO_CONFIG_WRITE */
+	wpas_config_write_deferred(wpa_s);
 
 	/*
 	 * Optimize the post-WPS scan based on the channel used during
@@ -647,15 +641,8 @@ static void wpas_wps_reenable_networks(struct wpa_supplicant *wpa_s)
 		}
 	}
 
-	if (changed) {
-#ifndef CONFIG_NO_CONFIG_WRITE
-		if (wpa_s->conf->update_config &&
-		    wpa_config_write(wpa_s->confname, wpa_s->conf)) {
-			wpa_printf(MSG_DEBUG, "WPS: Failed to update "
-				   "configuration");
-		}
-#endif /* CONFIG_NO_CONFIG_WRITE */
-	}
+	if (changed)
+		wpas_config_write_deferred(wpa_s);
 }
 
 